@@ -0,0 +1,268 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#include <QScopedPointer>
+#include <QtConcurrentRun>
+#include <QDebug>
+
+#include "global.h"
+#include "autosaver.h"
+#include "datareadwriter.h"
+#include "treesnapshot.h"
+
+/**
+ * @class AutoSaveJob
+ *
+ * @brief One automatic save of a TreeSnapshot.
+ *
+ * The job contains everything that is needed to write the data file, so run() doesn't need
+ * to access the settings or the tree and can be executed in a worker thread. The result is
+ * read in the GUI thread after the job has finished.
+ *
+ * @ingroup gui
+ * @author Bernhard Walle
+ */
+
+/**
+ * @brief Creates a new job.
+ *
+ * @param snapshot the data to write, the job takes ownership
+ * @param password the password that is used for encryption
+ * @param config the configuration with the data file and the cipher algorithm
+ * @param serial a number that identifies the modification state of the data at the time of
+ *        the snapshot, it's not interpreted by the job
+ */
+AutoSaveJob::AutoSaveJob(TreeSnapshot* snapshot, const QString& password,
+                         const VaultConfig& config, quint32 serial)
+    : m_snapshot(snapshot)
+    , m_password(password)
+    , m_config(config)
+    , m_serial(serial)
+    , m_success(false)
+{}
+
+
+/**
+ * @brief Deletes the job and the snapshot.
+ */
+AutoSaveJob::~AutoSaveJob()
+{
+    delete m_snapshot;
+}
+
+
+/**
+ * @brief Builds the document from the snapshot, encrypts it and writes it to the data file.
+ *
+ * This is called in a worker thread. Errors are not reported with an exception but can be
+ * retrieved with isSuccessful() and getErrorMessage().
+ */
+void AutoSaveJob::run()
+{
+    try {
+        DataReadWriter writer(m_config);
+        QScopedPointer<StringEncryptor> encryptor(writer.createEncryptor(m_password));
+        m_document = writer.createSkeletonDocument();
+        m_snapshot->appendXML(m_document, encryptor.data());
+        writer.writeXML(m_document, m_password, true);
+        m_success = true;
+    } catch (const ReadWriteException& e) {
+        m_errorMessage = e.getMessage();
+    }
+}
+
+
+/**
+ * @brief Returns whether the data file has been written successfully.
+ *
+ * @return @c true on success, @c false otherwise
+ */
+bool AutoSaveJob::isSuccessful() const
+{
+    return m_success;
+}
+
+
+/**
+ * @brief Returns the error message if the job was not successful.
+ *
+ * @return the localized error message, may contain HTML tags
+ */
+QString AutoSaveJob::getErrorMessage() const
+{
+    return m_errorMessage;
+}
+
+
+/**
+ * @brief Returns the document that has been written, see Journal::attach().
+ *
+ * @return the document
+ */
+QDomDocument AutoSaveJob::getDocument() const
+{
+    return m_document;
+}
+
+
+/**
+ * @brief Returns the snapshot that has been written.
+ *
+ * @return the snapshot, it's owned by the job
+ */
+const TreeSnapshot* AutoSaveJob::getSnapshot() const
+{
+    return m_snapshot;
+}
+
+
+/**
+ * @brief Returns the password that has been used for encryption.
+ *
+ * @return the password
+ */
+QString AutoSaveJob::getPassword() const
+{
+    return m_password;
+}
+
+
+/**
+ * @brief Returns the name of the data file.
+ *
+ * @return the file name
+ */
+QString AutoSaveJob::getDataFile() const
+{
+    return m_config.getDataFile();
+}
+
+
+/**
+ * @brief Returns the serial that has been passed to the constructor.
+ *
+ * @return the serial
+ */
+quint32 AutoSaveJob::getSerial() const
+{
+    return m_serial;
+}
+
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * @class AutoSaver
+ *
+ * @brief Runs an AutoSaveJob in a worker thread.
+ *
+ * Only one job runs at a time. Encryption and writing the file happens in the thread pool of
+ * QtConcurrent, so the GUI is not blocked. When the job has finished, finished() is emitted
+ * in the GUI thread and the job is deleted afterwards.
+ *
+ * @ingroup gui
+ * @author Bernhard Walle
+ */
+
+/**
+ * @fn AutoSaver::finished(AutoSaveJob*)
+ *
+ * @brief Emitted in the GUI thread if a job has finished.
+ *
+ * The job is deleted after the signal has been delivered, so use a direct connection.
+ *
+ * @param job the job
+ */
+
+/**
+ * @brief Creates a new AutoSaver.
+ *
+ * @param parent the parent object
+ */
+AutoSaver::AutoSaver(QObject* parent)
+    : QObject(parent)
+    , m_job(0)
+{
+    connect(&m_watcher, SIGNAL(finished()), SLOT(jobFinished()));
+}
+
+
+/**
+ * @brief Waits for a running job and deletes the AutoSaver.
+ */
+AutoSaver::~AutoSaver()
+{
+    m_watcher.waitForFinished();
+    delete m_job;
+}
+
+
+/**
+ * @brief Starts a job in a worker thread.
+ *
+ * No job must be running.
+ *
+ * @param job the job, the AutoSaver takes ownership
+ */
+void AutoSaver::start(AutoSaveJob* job)
+{
+    Q_ASSERT(!isRunning());
+
+    qDebug() << CURRENT_FUNCTION << "Starting autosave to" << job->getDataFile();
+    m_job = job;
+    m_watcher.setFuture(QtConcurrent::run(job, &AutoSaveJob::run));
+}
+
+
+/**
+ * @brief Checks if a job has been started and finished() has not been emitted yet.
+ *
+ * @return @c true if a job is running, @c false otherwise
+ */
+bool AutoSaver::isRunning() const
+{
+    return m_job != 0;
+}
+
+
+/**
+ * @brief Blocks until the running job has finished and emits finished().
+ *
+ * This is used before the data is saved manually or the user logs out. If no job is
+ * running, nothing happens.
+ */
+void AutoSaver::waitForFinished()
+{
+    if (!m_job)
+        return;
+
+    m_watcher.waitForFinished();
+    jobFinished();
+}
+
+
+/**
+ * @brief Emits finished() and deletes the job.
+ */
+void AutoSaver::jobFinished()
+{
+    // the notification of the watcher may arrive after waitForFinished()
+    if (!m_job || !m_watcher.isFinished())
+        return;
+
+    QScopedPointer<AutoSaveJob> job(m_job);
+    m_job = 0;
+    emit finished(job.data());
+}
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
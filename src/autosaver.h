@@ -0,0 +1,83 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#ifndef AUTOSAVER_H
+#define AUTOSAVER_H
+
+#include <QObject>
+#include <QString>
+#include <QDomDocument>
+#include <QFutureWatcher>
+
+#include "vaultconfig.h"
+
+class TreeSnapshot;
+
+class AutoSaveJob
+{
+    public:
+        AutoSaveJob(TreeSnapshot* snapshot, const QString& password, const VaultConfig& config,
+            quint32 serial);
+        ~AutoSaveJob();
+
+        void run();
+
+        bool isSuccessful() const;
+        QString getErrorMessage() const;
+        QDomDocument getDocument() const;
+        const TreeSnapshot* getSnapshot() const;
+        QString getPassword() const;
+        QString getDataFile() const;
+        quint32 getSerial() const;
+
+    private:
+        TreeSnapshot*       m_snapshot;
+        const QString       m_password;
+        const VaultConfig   m_config;
+        const quint32       m_serial;
+        QDomDocument        m_document;
+        QString             m_errorMessage;
+        bool                m_success;
+
+    private:
+        AutoSaveJob(const AutoSaveJob&);
+        AutoSaveJob& operator=(const AutoSaveJob&);
+};
+
+class AutoSaver : public QObject
+{
+    Q_OBJECT
+
+    public:
+        AutoSaver(QObject* parent = 0);
+        ~AutoSaver();
+
+        void start(AutoSaveJob* job);
+        bool isRunning() const;
+        void waitForFinished();
+
+    signals:
+        void finished(AutoSaveJob* job);
+
+    private slots:
+        void jobFinished();
+
+    private:
+        QFutureWatcher<void>    m_watcher;
+        AutoSaveJob*            m_job;
+};
+
+#endif // AUTOSAVER_H
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
@@ -0,0 +1,572 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#include <cstdio>
+#include <algorithm>
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QDir>
+#include <QTime>
+#include <QDateTime>
+#include <QRegExp>
+#include <QDebug>
+
+#include "datareadwriter.h"
+#include "security/symmetricencryptor.h"
+#include "security/hybridpasswordchecker.h"
+#include "security/encodinghelper.h"
+#include "security/vaultkey.h"
+#include "util/trace.h"
+#include "bench/qpamatbench.h"
+
+/**
+ * @brief The size of the block for the encryption and the Base64 benchmarks.
+ */
+static const int BLOCK_SIZE = 1024 * 1024;
+
+/**
+ * @brief The password of a generated data file.
+ */
+static const char GENERATED_PASSWORD[] = "benchmark";
+
+
+/**
+ * @class QpamatBench
+ *
+ * @brief The benchmarks <tt>qpamat-bench</tt>.
+ *
+ * Measures the operations that get slow with big data files: loading and saving the data
+ * file, the cipher, the Base64 encoding, the password strength and the search. The data
+ * file is generated by VaultGenerator, or a copy of an existing data file is used. Each
+ * benchmark runs a number of iterations, the results are written as JSON so they can be
+ * compared between releases.
+ *
+ * The tree of the main window needs a display, so the benchmarks use the XML document that
+ * DataReadWriter returns, like the command line client. \c parse is the time to build that
+ * document from the file, \c search searches it in the same way as <tt>qpamat-cli search</tt>.
+ *
+ * The existing data file is never written. Its password is read from the first line of the
+ * standard input.
+ *
+ * @ingroup bench
+ * @author Bernhard Walle
+ */
+
+/**
+ * @brief Creates a new benchmark run.
+ *
+ * @param arguments the command line arguments, including the name of the program
+ */
+QpamatBench::QpamatBench(const QStringList& arguments)
+    : m_arguments(arguments)
+    , m_help(false)
+    , m_version(false)
+    , m_iterations(5)
+    , m_algorithm(SymmetricEncryptor::getSuggestedAlgorithm())
+    , m_entryCount(0)
+    , m_categoryCount(0)
+    , m_sink(0)
+{
+    const QString basePath = QDir(QCoreApplication::applicationDirPath() +
+        (RUNNING_ON_MAC ? "/../Resources/" : "/../")).canonicalPath();
+    m_dictionaryFile = QDir(basePath + "/share/qpamat/dicts").canonicalPath() + "/default.txt";
+}
+
+
+/**
+ * @brief Deletes the copy of the data file.
+ */
+QpamatBench::~QpamatBench()
+{
+    if (!m_fileName.isEmpty())
+        QFile::remove(m_fileName);
+}
+
+
+/**
+ * @brief Runs the benchmarks.
+ *
+ * @return the exit code of the program, see QpamatBench::ExitCode
+ */
+int QpamatBench::exec()
+{
+    QTextStream err(stderr, QIODevice::WriteOnly);
+
+    if (!parseArguments()) {
+        printUsage();
+        return ExitUsage;
+    }
+    if (m_help) {
+        printUsage();
+        return ExitSuccess;
+    }
+    if (m_version) {
+        QTextStream(stdout, QIODevice::WriteOnly) << "qpamat-bench version " << VERSION_STRING
+            << endl;
+        return ExitSuccess;
+    }
+
+    try {
+        prepareVault();
+        prepareCases();
+
+        measure("save", &QpamatBench::save, m_entryCount, m_fileContents.size());
+        measure("load", &QpamatBench::load, m_entryCount, m_fileContents.size());
+        measure("load-lazy", &QpamatBench::loadLazy, m_entryCount, m_fileContents.size());
+        measure("parse", &QpamatBench::parse, m_entryCount, m_fileContents.size());
+        measure("encrypt", &QpamatBench::encrypt, 1, BLOCK_SIZE);
+        measure("decrypt", &QpamatBench::decrypt, 1, BLOCK_SIZE);
+        measure("base64-encode", &QpamatBench::encodeBase64, 1, BLOCK_SIZE);
+        measure("base64-decode", &QpamatBench::decodeBase64, 1, BLOCK_SIZE);
+        if (m_checker)
+            measure("strength", &QpamatBench::checkStrength, m_passwords.size(), 0);
+        else
+            m_skipped << "strength: " + m_checkerError;
+        measure("search", &QpamatBench::search, m_searchTerms.size() * m_entryCount, 0);
+        QpamatTrace::instance()->save();
+
+    } catch (const ReadWriteException& e) {
+        QString message = e.getMessage();
+        message.remove(QRegExp("<[^>]*>"));
+        err << "qpamat-bench: " << message << endl;
+        return ExitError;
+    } catch (const std::exception& e) {
+        err << "qpamat-bench: " << e.what() << endl;
+        return ExitError;
+    }
+
+    if (m_outputFile.isEmpty()) {
+        QTextStream out(stdout, QIODevice::WriteOnly);
+        writeResults(out);
+    } else {
+        QFile file(m_outputFile);
+        if (!file.open(QIODevice::WriteOnly)) {
+            err << "qpamat-bench: " << m_outputFile << ": " << file.errorString() << endl;
+            return ExitError;
+        }
+        QTextStream out(&file);
+        writeResults(out);
+    }
+
+    return ExitSuccess;
+}
+
+
+/**
+ * @brief Parses the command line.
+ *
+ * @return @c true on success, @c false if the usage should be printed
+ */
+bool QpamatBench::parseArguments()
+{
+    for (int i = 1; i < m_arguments.size(); ++i) {
+        const QString argument = m_arguments[i];
+        const bool hasValue = i + 1 < m_arguments.size();
+        const QString value = m_arguments.value(i + 1);
+        bool ok = true;
+
+        if (argument == "-h" || argument == "--help")
+            m_help = true;
+        else if (argument == "-v" || argument == "--version")
+            m_version = true;
+        else if (!hasValue)
+            return false;
+        else {
+            if (argument == "-n" || argument == "--entries")
+                m_generator.setEntries(value.toInt(&ok));
+            else if (argument == "--depth")
+                m_generator.setDepth(value.toInt(&ok));
+            else if (argument == "--properties")
+                m_generator.setProperties(value.toInt(&ok));
+            else if (argument == "--weak")
+                m_generator.setWeakPasswordRatio(value.toInt(&ok) / 100.0);
+            else if (argument == "--seed")
+                m_generator.setSeed(value.toUInt(&ok));
+            else if (argument == "-i" || argument == "--iterations")
+                m_iterations = value.toInt(&ok);
+            else if (argument == "-f" || argument == "--file")
+                m_vaultFile = value;
+            else if (argument == "-a" || argument == "--algorithm")
+                m_algorithm = value;
+            else if (argument == "--dictionary")
+                m_dictionaryFile = value;
+            else if (argument == "-o" || argument == "--output")
+                m_outputFile = value;
+            else if (argument == "--trace")
+                QpamatTrace::instance()->setOutputFile(value);
+            else
+                return false;
+            ++i;
+        }
+
+        if (!ok)
+            return false;
+    }
+
+    return m_iterations > 0 && m_generator.getEntries() >= 0 && m_generator.getDepth() >= 0;
+}
+
+
+/**
+ * @brief Prints the usage on stderr.
+ */
+void QpamatBench::printUsage()
+{
+    QTextStream(stderr, QIODevice::WriteOnly)
+        << "\n"
+        << "qpamat-bench " << VERSION_STRING << ", the benchmarks of QPaMaT\n\n"
+        << "Usage: qpamat-bench [options]\n\n"
+        << "Options: -n, --entries N        generate N entries (default: 1000)\n"
+        << "         --depth N              generate N levels of categories (default: 3)\n"
+        << "         --properties N         generate N properties per entry (default: 4)\n"
+        << "         --weak PERCENT         generate PERCENT weak passwords (default: 30)\n"
+        << "         --seed N               seed of the generator (default: 42)\n"
+        << "         -f, --file FILE        use a copy of the data file FILE instead, its\n"
+        << "                                password is read from the standard input\n"
+        << "         -a, --algorithm ALGO   use ALGO for the data file and the cipher\n"
+        << "         --dictionary FILE      the dictionary for the password strength\n"
+        << "         -i, --iterations N     run each benchmark N times (default: 5)\n"
+        << "         -o, --output FILE      write the JSON results to FILE, not to stdout\n"
+        << "         --trace FILE           write the spans for chrome://tracing to FILE\n"
+        << "         -h, --help             prints this help\n"
+        << "         -v, --version          prints the version\n"
+        << endl;
+}
+
+
+/**
+ * @brief Generates or reads the data file and writes it to a temporary file.
+ *
+ * @exception ReadWriteException if the data file cannot be read or written
+ */
+void QpamatBench::prepareVault()
+{
+    m_fileName = QDir::tempPath() + QString("/qpamat-bench-%1.xml")
+        .arg(QCoreApplication::applicationPid());
+
+    if (m_vaultFile.isEmpty()) {
+        m_password = GENERATED_PASSWORD;
+        DataReadWriter writer(m_fileName, m_algorithm);
+        m_document = writer.createSkeletonDocument();
+        m_generator.generate(m_document);
+    } else {
+        m_password = QTextStream(stdin, QIODevice::ReadOnly).readLine();
+        QDomDocument document = DataReadWriter(m_vaultFile, m_algorithm).readXML(m_password);
+        QDomElement appData = document.documentElement().namedItem("app-data").toElement();
+        m_algorithm = appData.namedItem("crypt-algorithm").toElement().text();
+
+        // the password hash of the copy is written again
+        DataReadWriter writer(m_fileName, m_algorithm);
+        m_document = writer.createSkeletonDocument();
+        QDomElement root = m_document.documentElement();
+        root.replaceChild(m_document.importNode(document.documentElement().namedItem("passwords"),
+            true), root.namedItem("passwords"));
+    }
+
+    DataReadWriter(m_fileName, m_algorithm).writeXML(m_document, m_password);
+
+    QFile file(m_fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        throw ReadWriteException(file.errorString(), ReadWriteException::CIOError);
+    m_fileContents = file.readAll();
+
+    // statistics
+    QDomNodeList entries = m_document.elementsByTagName("entry");
+    m_entryCount = entries.count();
+    m_categoryCount = m_document.elementsByTagName("category").count();
+
+    QDomNodeList properties = m_document.elementsByTagName("property");
+    for (int i = 0; i < properties.count(); ++i) {
+        QDomElement property = properties.item(i).toElement();
+        if (property.attribute("type") == "PASSWORD")
+            m_passwords << property.attribute("value");
+    }
+
+    // a common word, a name of an entry and a text that doesn't exist
+    m_searchTerms << "ma";
+    if (m_entryCount > 0)
+        m_searchTerms << entries.item(m_entryCount / 2).toElement().attribute("name");
+    m_searchTerms << "no such entry";
+}
+
+
+/**
+ * @brief Creates the input of the other benchmarks.
+ */
+void QpamatBench::prepareCases()
+{
+    m_block.resize(BLOCK_SIZE);
+    for (int i = 0; i < BLOCK_SIZE; ++i)
+        m_block[i] = static_cast<unsigned char>(i * 31 + 7);
+
+    m_encryptor.reset(new SymmetricEncryptor(m_algorithm, m_password));
+    m_encryptedBlock = m_encryptor->encrypt(m_block);
+    m_base64Block = EncodingHelper::toBase64(m_block);
+
+    try {
+        m_checker.reset(new HybridPasswordChecker(m_dictionaryFile));
+    } catch (const PasswordCheckException& e) {
+        m_checkerError = e.what();
+    }
+}
+
+
+/**
+ * @brief Runs @p operation and stores the time of each iteration.
+ *
+ * @param name the name of the benchmark in the results
+ * @param operation the operation
+ * @param items the number of items (entries, passwords, ...) that one iteration processes
+ * @param bytes the number of bytes that one iteration processes
+ */
+void QpamatBench::measure(const QString& name, Operation operation, qint64 items,
+                          qint64 bytes)
+{
+    qDebug() << CURRENT_FUNCTION << name;
+
+    Result result;
+    result.name = name;
+    result.items = items;
+    result.bytes = bytes;
+
+    for (int i = 0; i < m_iterations; ++i) {
+        QTime time;
+        time.start();
+        (this->*operation)();
+        result.msecs << time.elapsed();
+    }
+
+    m_results << result;
+}
+
+
+/**
+ * @brief Writes the results as JSON.
+ *
+ * For each benchmark, the minimum, the mean and the maximum time of an iteration is written.
+ * The throughput is computed from the mean.
+ *
+ * @param stream the stream
+ */
+void QpamatBench::writeResults(QTextStream& stream) const
+{
+    stream << "{\n"
+        << "  \"version\": " << jsonString(VERSION_STRING) << ",\n"
+        << "  \"date\": "
+        << jsonString(QDateTime::currentDateTime(Qt::UTC).toString(Qt::ISODate)) << ",\n"
+        << "  \"algorithm\": " << jsonString(m_algorithm) << ",\n"
+        << "  \"iterations\": " << m_iterations << ",\n"
+        << "  \"vault\": {\n"
+        << "    \"file\": " << (m_vaultFile.isEmpty() ? "null" : jsonString(m_vaultFile))
+        << ",\n"
+        << "    \"seed\": " << m_generator.getSeed() << ",\n"
+        << "    \"entries\": " << m_entryCount << ",\n"
+        << "    \"categories\": " << m_categoryCount << ",\n"
+        << "    \"passwords\": " << m_passwords.size() << ",\n"
+        << "    \"bytes\": " << m_fileContents.size() << "\n"
+        << "  },\n"
+        << "  \"results\": [";
+
+    for (int i = 0; i < m_results.size(); ++i) {
+        const Result& result = m_results[i];
+
+        QList<int> msecs = result.msecs;
+        std::sort(msecs.begin(), msecs.end());
+        qint64 sum = 0;
+        for (int j = 0; j < msecs.size(); ++j)
+            sum += msecs[j];
+        const double mean = double(sum) / msecs.size();
+
+        stream << (i == 0 ? "\n" : ",\n")
+            << "    { \"name\": " << jsonString(result.name)
+            << ", \"min_ms\": " << msecs.first()
+            << ", \"mean_ms\": " << mean
+            << ", \"max_ms\": " << msecs.last()
+            << ", \"items\": " << result.items
+            << ", \"bytes\": " << result.bytes;
+        if (mean > 0 && result.items > 0)
+            stream << ", \"items_per_s\": " << qRound64(result.items * 1000.0 / mean);
+        if (mean > 0 && result.bytes > 0)
+            stream << ", \"mb_per_s\": " << result.bytes / 1024.0 / 1024.0 * 1000.0 / mean;
+        stream << " }";
+    }
+
+    stream << "\n  ],\n  \"skipped\": [";
+    for (int i = 0; i < m_skipped.size(); ++i)
+        stream << (i == 0 ? " " : ", ") << jsonString(m_skipped[i]);
+    stream << (m_skipped.isEmpty() ? "]\n" : " ]\n") << "}" << endl;
+}
+
+
+/**
+ * @brief Reads the data file and decrypts all passwords.
+ */
+void QpamatBench::load()
+{
+    QDomDocument document = DataReadWriter(m_fileName, m_algorithm).readXML(m_password);
+    m_sink += document.documentElement().childNodes().count();
+}
+
+
+/**
+ * @brief Reads the data file without decrypting the passwords, see VaultConfig.
+ */
+void QpamatBench::loadLazy()
+{
+    QSharedPointer<VaultKey> vaultKey;
+    QDomDocument document = DataReadWriter(m_fileName, m_algorithm).readXML(m_password,
+        &vaultKey);
+    m_sink += document.documentElement().childNodes().count();
+}
+
+
+/**
+ * @brief Encrypts all passwords and writes the data file.
+ */
+void QpamatBench::save()
+{
+    DataReadWriter(m_fileName, m_algorithm).writeXML(m_document, m_password);
+}
+
+
+/**
+ * @brief Builds the XML document from the contents of the data file.
+ */
+void QpamatBench::parse()
+{
+    QDomDocument document;
+    document.setContent(m_fileContents);
+    m_sink += document.documentElement().childNodes().count();
+}
+
+
+/**
+ * @brief Encrypts the block.
+ */
+void QpamatBench::encrypt()
+{
+    m_sink += m_encryptor->encrypt(m_block).size();
+}
+
+
+/**
+ * @brief Decrypts the block.
+ */
+void QpamatBench::decrypt()
+{
+    m_sink += m_encryptor->decrypt(m_encryptedBlock).size();
+}
+
+
+/**
+ * @brief Encodes the block with Base64.
+ */
+void QpamatBench::encodeBase64()
+{
+    m_sink += EncodingHelper::toBase64(m_block).length();
+}
+
+
+/**
+ * @brief Decodes the block from Base64.
+ */
+void QpamatBench::decodeBase64()
+{
+    m_sink += EncodingHelper::fromBase64(m_base64Block).size();
+}
+
+
+/**
+ * @brief Computes the strength of all passwords of the data file.
+ */
+void QpamatBench::checkStrength()
+{
+    for (QStringList::const_iterator it = m_passwords.constBegin();
+            it != m_passwords.constEnd(); ++it)
+        m_sink += int(m_checker->passwordQuality(*it));
+}
+
+
+/**
+ * @brief Searches all entries for each search term.
+ */
+void QpamatBench::search()
+{
+    QDomElement passwords = m_document.documentElement().namedItem("passwords").toElement();
+    for (QStringList::const_iterator it = m_searchTerms.constBegin();
+            it != m_searchTerms.constEnd(); ++it)
+        m_sink += countMatches(passwords, *it);
+}
+
+
+/**
+ * @brief Counts the entries below @p parent that contain @p text.
+ *
+ * Like <tt>qpamat-cli search</tt>, the names and the values of the properties except
+ * passwords are searched.
+ *
+ * @param parent the category or the \c passwords element
+ * @param text the text, the case is ignored
+ * @return the number of entries
+ */
+int QpamatBench::countMatches(const QDomElement& parent, const QString& text)
+{
+    int matches = 0;
+    for (QDomElement child = parent.firstChildElement(); !child.isNull();
+            child = child.nextSiblingElement()) {
+        if (child.tagName() == "category")
+            matches += countMatches(child, text);
+        else if (child.tagName() == "entry") {
+            bool match = child.attribute("name").contains(text, Qt::CaseInsensitive);
+            for (QDomElement property = child.firstChildElement("property");
+                    !match && !property.isNull();
+                    property = property.nextSiblingElement("property")) {
+                match = property.attribute("type") != "PASSWORD" &&
+                    property.attribute("value").contains(text, Qt::CaseInsensitive);
+            }
+            if (match)
+                ++matches;
+        }
+    }
+
+    return matches;
+}
+
+
+/**
+ * @brief Quotes a string for JSON.
+ *
+ * @param string the string
+ * @return the string in double quotes, with escaped special characters
+ */
+QString QpamatBench::jsonString(const QString& string)
+{
+    QString result = "\"";
+    for (int i = 0; i < string.length(); ++i) {
+        const QChar c = string[i];
+        if (c == '"' || c == '\\')
+            result += QString("\\") + c;
+        else if (c == '\n')
+            result += "\\n";
+        else if (c.unicode() < 0x20)
+            result += QString("\\u%1").arg(c.unicode(), 4, 16, QChar('0'));
+        else
+            result += c;
+    }
+
+    return result + "\"";
+}
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
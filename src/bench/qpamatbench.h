@@ -0,0 +1,113 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#ifndef QPAMATBENCH_H
+#define QPAMATBENCH_H
+
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+#include <QDomDocument>
+#include <QScopedPointer>
+#include <QList>
+
+#include "global.h"
+#include "bench/vaultgenerator.h"
+
+class SymmetricEncryptor;
+class HybridPasswordChecker;
+
+class QpamatBench
+{
+    public:
+        enum ExitCode {
+            ExitSuccess     = 0,
+            ExitError       = 1,
+            ExitUsage       = 2
+        };
+
+    public:
+        QpamatBench(const QStringList& arguments);
+        ~QpamatBench();
+
+        int exec();
+
+    private:
+        typedef void (QpamatBench::*Operation)();
+
+        struct Result {
+            QString     name;
+            QList<int>  msecs;
+            qint64      items;
+            qint64      bytes;
+        };
+
+    private:
+        bool parseArguments();
+        void printUsage();
+
+        void prepareVault();
+        void prepareCases();
+        void measure(const QString& name, Operation operation, qint64 items, qint64 bytes);
+        void writeResults(QTextStream& stream) const;
+
+        void load();
+        void loadLazy();
+        void save();
+        void parse();
+        void encrypt();
+        void decrypt();
+        void encodeBase64();
+        void decodeBase64();
+        void checkStrength();
+        void search();
+
+    private:
+        static int countMatches(const QDomElement& parent, const QString& text);
+        static QString jsonString(const QString& string);
+
+    private:
+        QStringList                             m_arguments;
+        bool                                    m_help;
+        bool                                    m_version;
+        int                                     m_iterations;
+        VaultGenerator                          m_generator;
+        QString                                 m_vaultFile;
+        QString                                 m_algorithm;
+        QString                                 m_dictionaryFile;
+        QString                                 m_outputFile;
+
+        QString                                 m_password;
+        QString                                 m_fileName;
+        QDomDocument                            m_document;
+        QByteArray                              m_fileContents;
+        int                                     m_entryCount;
+        int                                     m_categoryCount;
+        QStringList                             m_passwords;
+        QStringList                             m_searchTerms;
+        ByteVector                              m_block;
+        ByteVector                              m_encryptedBlock;
+        QString                                 m_base64Block;
+        QScopedPointer<SymmetricEncryptor>      m_encryptor;
+        QScopedPointer<HybridPasswordChecker>   m_checker;
+        QString                                 m_checkerError;
+        int                                     m_sink;
+
+        QList<Result>                           m_results;
+        QStringList                             m_skipped;
+};
+
+#endif // QPAMATBENCH_H
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
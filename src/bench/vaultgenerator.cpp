@@ -0,0 +1,326 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#include <cstdlib>
+
+#include <QUuid>
+
+#include "global.h"
+#include "bench/vaultgenerator.h"
+
+/**
+ * @brief Syllables for the names of the entries and for weak passwords.
+ */
+static const char *const s_syllables[] = {
+    "ma", "il", "ban", "king", "shop", "net", "work", "home", "ser", "ver", "lo", "gin",
+    "web", "mail", "cloud", "pay", "stor", "age", "data", "base", "office", "print", "ro", "ter"
+};
+
+/**
+ * @brief Characters of the strong passwords.
+ */
+static const char s_passwordChars[] =
+    "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789@$#%&*+-_=!?";
+
+/**
+ * @brief The number of categories in each category.
+ */
+static const int CATEGORY_FANOUT = 4;
+
+
+/**
+ * @class VaultGenerator
+ *
+ * @brief Generates the entries of a synthetic data file for the benchmarks.
+ *
+ * The entries are created at random positions of a category tree, each with a username,
+ * an URL, a password and some further properties. A configurable part of the passwords is
+ * weak (words with a number appended), the rest is random.
+ *
+ * The random numbers are generated with a fixed seed, so the same settings always generate
+ * the same data file and the results of different releases can be compared.
+ *
+ * @ingroup bench
+ * @author Bernhard Walle
+ */
+
+/**
+ * @brief Creates a new generator.
+ *
+ * The default is a data file with 1000 entries in three levels of categories and four
+ * properties per entry, 30 % of the passwords are weak.
+ */
+VaultGenerator::VaultGenerator()
+    : m_entries(1000)
+    , m_depth(3)
+    , m_properties(4)
+    , m_weakPasswordRatio(0.3)
+    , m_seed(42)
+{}
+
+
+/**
+ * @brief Returns the number of entries.
+ *
+ * @return the number of entries, categories are not counted
+ */
+int VaultGenerator::getEntries() const
+{
+    return m_entries;
+}
+
+
+/**
+ * @brief Sets the number of entries.
+ *
+ * @param entries the number of entries, categories are not counted
+ */
+void VaultGenerator::setEntries(int entries)
+{
+    m_entries = entries;
+}
+
+
+/**
+ * @brief Returns the depth of the category tree.
+ *
+ * @return the number of categories above each entry
+ */
+int VaultGenerator::getDepth() const
+{
+    return m_depth;
+}
+
+
+/**
+ * @brief Sets the depth of the category tree.
+ *
+ * @param depth the number of categories above each entry, 0 means no categories
+ */
+void VaultGenerator::setDepth(int depth)
+{
+    m_depth = depth;
+}
+
+
+/**
+ * @brief Returns the number of properties per entry.
+ *
+ * @return the number of properties
+ */
+int VaultGenerator::getProperties() const
+{
+    return m_properties;
+}
+
+
+/**
+ * @brief Sets the number of properties per entry.
+ *
+ * Each entry has at least a password. Username and URL come next, the remaining
+ * properties are miscellaneous.
+ *
+ * @param properties the number of properties, at least 1
+ */
+void VaultGenerator::setProperties(int properties)
+{
+    m_properties = qMax(properties, 1);
+}
+
+
+/**
+ * @brief Returns the part of the passwords that are weak.
+ *
+ * @return the ratio between 0.0 and 1.0
+ */
+double VaultGenerator::getWeakPasswordRatio() const
+{
+    return m_weakPasswordRatio;
+}
+
+
+/**
+ * @brief Sets the part of the passwords that are weak.
+ *
+ * @param ratio the ratio between 0.0 and 1.0
+ */
+void VaultGenerator::setWeakPasswordRatio(double ratio)
+{
+    m_weakPasswordRatio = qBound(0.0, ratio, 1.0);
+}
+
+
+/**
+ * @brief Returns the seed of the random numbers.
+ *
+ * @return the seed
+ */
+unsigned int VaultGenerator::getSeed() const
+{
+    return m_seed;
+}
+
+
+/**
+ * @brief Sets the seed of the random numbers.
+ *
+ * @param seed the seed
+ */
+void VaultGenerator::setSeed(unsigned int seed)
+{
+    m_seed = seed;
+}
+
+
+/**
+ * @brief Appends the entries to the \c passwords element of @p document.
+ *
+ * The passwords are plain text, like in a document that has been created with
+ * Tree::appendXML() without encryptor.
+ *
+ * @param document a document created with DataReadWriter::createSkeletonDocument()
+ */
+void VaultGenerator::generate(QDomDocument& document) const
+{
+    QDomElement passwords = document.documentElement().namedItem("passwords").toElement();
+    QMap<QString, QDomElement> categories;
+
+    qsrand(m_seed);
+    for (int i = 0; i < m_entries; ++i) {
+        QStringList path;
+        for (int level = 0; level < m_depth; ++level)
+            path << QString("Category %1").arg(qrand() % CATEGORY_FANOUT);
+
+        QDomElement parent = findOrCreateCategory(document, passwords, categories, path);
+        const QString name = createWord();
+
+        QDomElement entry = document.createElement("entry");
+        if (m_properties > 1)
+            entry.appendChild(createProperty(document, "Username", name + "@example.com",
+                "USERNAME"));
+        if (m_properties > 2)
+            entry.appendChild(createProperty(document, "URL", "https://www." + name + ".com",
+                "URL"));
+        for (int p = 3; p < m_properties; ++p)
+            entry.appendChild(createProperty(document, QString("Misc %1").arg(p - 2),
+                createWord() + " " + createWord(), "MISC"));
+
+        bool weak = qrand() < m_weakPasswordRatio * RAND_MAX;
+        entry.appendChild(createProperty(document, "Password", createPassword(weak),
+            "PASSWORD"));
+
+        entry.setAttribute("name", QString("%1 %2").arg(name).arg(i));
+        entry.setAttribute("id", QUuid::createUuid().toString());
+        entry.setAttribute("isSelected", false);
+        parent.appendChild(entry);
+    }
+}
+
+
+/**
+ * @brief Returns the category element for @p path and creates it if necessary.
+ *
+ * @param document the document
+ * @param passwords the \c passwords element
+ * @param categories the categories that have already been created, by path
+ * @param path the names of the categories
+ * @return the category or @p passwords if @p path is empty
+ */
+QDomElement VaultGenerator::findOrCreateCategory(QDomDocument& document, QDomElement& passwords,
+        QMap<QString, QDomElement>& categories, const QStringList& path) const
+{
+    QDomElement parent = passwords;
+    QString key;
+    for (int i = 0; i < path.size(); ++i) {
+        key += "/" + path[i];
+
+        QMap<QString, QDomElement>::const_iterator it = categories.find(key);
+        if (it != categories.end()) {
+            parent = it.value();
+            continue;
+        }
+
+        QDomElement category = document.createElement("category");
+        category.setAttribute("wasOpen", false);
+        category.setAttribute("name", path[i]);
+        category.setAttribute("id", QUuid::createUuid().toString());
+        category.setAttribute("isSelected", false);
+        parent.appendChild(category);
+
+        categories.insert(key, category);
+        parent = category;
+    }
+
+    return parent;
+}
+
+
+/**
+ * @brief Creates a \c property element.
+ *
+ * @param document the document
+ * @param key the key of the property
+ * @param value the value of the property
+ * @param type the type, see Property::typeToString()
+ * @return the element
+ */
+QDomElement VaultGenerator::createProperty(QDomDocument& document, const QString& key,
+        const QString& value, const QString& type) const
+{
+    QDomElement property = document.createElement("property");
+    property.setAttribute("key", key);
+    property.setAttribute("value", value);
+    property.setAttribute("hidden", false);
+    property.setAttribute("encrypted", false);
+    property.setAttribute("type", type);
+
+    return property;
+}
+
+
+/**
+ * @brief Creates a random word out of two to four syllables.
+ *
+ * @return the word
+ */
+QString VaultGenerator::createWord() const
+{
+    QString word;
+    int syllables = 2 + qrand() % 3;
+    for (int i = 0; i < syllables; ++i)
+        word += s_syllables[qrand() % ARRAY_SIZE(s_syllables)];
+
+    return word;
+}
+
+
+/**
+ * @brief Creates a password.
+ *
+ * @param weak @c true for a word followed by two digits, @c false for 16 random characters
+ * @return the password
+ */
+QString VaultGenerator::createPassword(bool weak) const
+{
+    if (weak)
+        return createWord() + QString::number(10 + qrand() % 90);
+
+    QString password;
+    for (int i = 0; i < 16; ++i)
+        password += s_passwordChars[qrand() % (sizeof(s_passwordChars) - 1)];
+
+    return password;
+}
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
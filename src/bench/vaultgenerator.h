@@ -0,0 +1,63 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#ifndef VAULTGENERATOR_H
+#define VAULTGENERATOR_H
+
+#include <QString>
+#include <QStringList>
+#include <QDomDocument>
+#include <QMap>
+
+class VaultGenerator
+{
+    public:
+        VaultGenerator();
+
+        int getEntries() const;
+        void setEntries(int entries);
+
+        int getDepth() const;
+        void setDepth(int depth);
+
+        int getProperties() const;
+        void setProperties(int properties);
+
+        double getWeakPasswordRatio() const;
+        void setWeakPasswordRatio(double ratio);
+
+        unsigned int getSeed() const;
+        void setSeed(unsigned int seed);
+
+        void generate(QDomDocument& document) const;
+
+    private:
+        QDomElement findOrCreateCategory(QDomDocument& document, QDomElement& passwords,
+            QMap<QString, QDomElement>& categories, const QStringList& path) const;
+        QDomElement createProperty(QDomDocument& document, const QString& key,
+            const QString& value, const QString& type) const;
+        QString createWord() const;
+        QString createPassword(bool weak) const;
+
+    private:
+        int             m_entries;
+        int             m_depth;
+        int             m_properties;
+        double          m_weakPasswordRatio;
+        unsigned int    m_seed;
+};
+
+#endif // VAULTGENERATOR_H
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
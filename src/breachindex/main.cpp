@@ -0,0 +1,88 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QTime>
+
+#include "security/breachcorpus.h"
+
+/**
+ * @file breachindex/main.cpp
+ *
+ * @brief Builds a BreachCorpus from a SHA-1 dump of "Have I Been Pwned"
+ *
+ * Usage: <tt>qpamat-breachindex [--bits N] INPUT OUTPUT.bloom</tt>. @c INPUT is the
+ * dump ordered by hash or <tt>-</tt> for the standard input. The Bloom filter is written to
+ * @c OUTPUT.bloom and the sorted hashes to @c OUTPUT.sha1. @c N is the number of bits per
+ * hash in the Bloom filter, see BreachCorpusBuilder::setBitsPerEntry().
+ *
+ * @ingroup misc
+ */
+
+static void usage()
+{
+    std::cerr << "Usage: qpamat-breachindex [--bits N] INPUT OUTPUT.bloom" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    int bits = 10;
+    int arg = 1;
+    if (arg < argc && std::strcmp(argv[arg], "--bits") == 0) {
+        if (arg + 1 >= argc || (bits = std::atoi(argv[arg + 1])) <= 0) {
+            usage();
+            return 2;
+        }
+        arg += 2;
+    }
+    if (argc - arg != 2) {
+        usage();
+        return 2;
+    }
+
+    QFile input;
+    bool opened;
+    if (std::strcmp(argv[arg], "-") == 0)
+        opened = input.open(stdin, QIODevice::ReadOnly);
+    else {
+        input.setFileName(QFile::decodeName(argv[arg]));
+        opened = input.open(QIODevice::ReadOnly);
+    }
+    if (!opened) {
+        std::cerr << argv[arg] << ": " << input.errorString().toLocal8Bit().data() << std::endl;
+        return 1;
+    }
+
+    QTime time;
+    time.start();
+
+    BreachCorpusBuilder builder(QFile::decodeName(argv[arg + 1]));
+    builder.setBitsPerEntry(bits);
+    if (!builder.build(input)) {
+        std::cerr << argv[arg] << ": " << builder.errorString().toLocal8Bit().data() << std::endl;
+        return 1;
+    }
+
+    std::cout << builder.size() << " hashes in " << time.elapsed() / 1000.0 << " s" << std::endl;
+    return 0;
+}
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
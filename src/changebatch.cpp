@@ -0,0 +1,252 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#include <cstddef>
+
+#include "changebatch.h"
+
+/**
+ * @class BatchedNotifier
+ *
+ * @brief Base class for model objects whose change notifications can be batched.
+ *
+ * A subclass calls notifyChanged() whenever it has been modified, with a bit mask that tells
+ * what has changed. Without an active ChangeBatch, flushChanges() is called immediately and
+ * the subclass emits its signals there. Inside a ChangeBatch, the changes are accumulated
+ * and flushChanges() is called once when the outermost batch ends.
+ *
+ * The signals of the objects are meant for the model, e.g. to update cached values. Views
+ * should use ChangeNotifier::batchFlushed(), which is emitted once for all objects.
+ *
+ * The pending objects are kept in an intrusive list, so batching doesn't allocate anything.
+ *
+ * @ingroup gui
+ * @author Bernhard Walle
+ */
+
+/**
+ * @fn BatchedNotifier::flushChanges(int)
+ *
+ * @brief Called to notify the views.
+ *
+ * @param changes the accumulated change mask of all notifyChanged() calls since the last flush
+ */
+
+/**
+ * @brief Creates a new BatchedNotifier.
+ */
+BatchedNotifier::BatchedNotifier()
+    : m_prevPending(NULL)
+    , m_nextPending(NULL)
+    , m_pendingChanges(0)
+{}
+
+
+/**
+ * @brief Deletes the BatchedNotifier.
+ *
+ * If there are changes pending, they are dropped. If the batch is being flushed, the object
+ * is removed from the set that is passed to ChangeNotifier::batchFlushed().
+ */
+BatchedNotifier::~BatchedNotifier()
+{
+    unlink();
+    ChangeBatch::s_flushed.remove(this);
+}
+
+
+/**
+ * @brief Records a change.
+ *
+ * @param changes a bit mask of changes, defined by the subclass
+ */
+void BatchedNotifier::notifyChanged(int changes)
+{
+    // a change outside of a batch is a batch on its own
+    ChangeBatch batch;
+
+    if (m_pendingChanges == 0) {
+        m_prevPending = ChangeBatch::s_lastPending;
+        m_nextPending = NULL;
+        if (ChangeBatch::s_lastPending)
+            ChangeBatch::s_lastPending->m_nextPending = this;
+        else
+            ChangeBatch::s_firstPending = this;
+        ChangeBatch::s_lastPending = this;
+    }
+    m_pendingChanges |= changes;
+}
+
+
+/**
+ * @brief Removes the object from the list of pending objects.
+ */
+void BatchedNotifier::unlink()
+{
+    if (m_pendingChanges == 0)
+        return;
+
+    if (m_prevPending)
+        m_prevPending->m_nextPending = m_nextPending;
+    else
+        ChangeBatch::s_firstPending = m_nextPending;
+
+    if (m_nextPending)
+        m_nextPending->m_prevPending = m_prevPending;
+    else
+        ChangeBatch::s_lastPending = m_prevPending;
+
+    m_prevPending = NULL;
+    m_nextPending = NULL;
+    m_pendingChanges = 0;
+}
+
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * @class ChangeBatch
+ *
+ * @brief Scope in which change notifications of the model are coalesced.
+ *
+ * Create a ChangeBatch on the stack before a bulk operation:
+ *
+ * @code
+ * {
+ *     ChangeBatch batch;
+ *     property->setType(Property::PASSWORD);
+ *     property->setValue(value);
+ *     property->setKey(key);
+ * } // views get one ChangeNotifier::batchFlushed() signal here
+ * @endcode
+ *
+ * Batches can be nested, only the outermost one flushes. Each changed object gets exactly one
+ * notification with all its changes combined. Afterwards, ChangeNotifier::batchFlushed() is
+ * emitted once with all changed objects, so a view updates itself only once per batch.
+ * Batching is meant to be used in the GUI thread only.
+ *
+ * @ingroup gui
+ * @author Bernhard Walle
+ */
+
+int ChangeBatch::s_depth = 0;
+BatchedNotifier *ChangeBatch::s_firstPending = NULL;
+BatchedNotifier *ChangeBatch::s_lastPending = NULL;
+BatchedNotifierSet ChangeBatch::s_flushed;
+
+
+/**
+ * @brief Starts a batch.
+ */
+ChangeBatch::ChangeBatch()
+{
+    s_depth++;
+}
+
+
+/**
+ * @brief Ends the batch.
+ *
+ * If this is the outermost batch, all pending notifications are delivered.
+ */
+ChangeBatch::~ChangeBatch()
+{
+    if (--s_depth == 0)
+        flush();
+}
+
+
+/**
+ * @brief Checks if there's a batch active.
+ *
+ * @return @c true if notifications are currently deferred, @c false otherwise
+ */
+bool ChangeBatch::isActive()
+{
+    return s_depth > 0;
+}
+
+
+/**
+ * @brief Delivers all pending notifications in the order of the first change and emits
+ *        ChangeNotifier::batchFlushed().
+ *
+ * The receivers may delete other pending objects, that's why the head of the list is read
+ * again in each iteration. Changes that are made by the receivers are delivered in the same
+ * pass, or in another one if they are made by the receivers of the batch signal.
+ */
+void ChangeBatch::flush()
+{
+    s_depth++;
+    while (s_firstPending) {
+        while (s_firstPending) {
+            BatchedNotifier *notifier = s_firstPending;
+            int changes = notifier->m_pendingChanges;
+            notifier->unlink();
+            s_flushed.insert(notifier);
+            notifier->flushChanges(changes);
+        }
+
+        emit ChangeNotifier::instance()->batchFlushed(s_flushed);
+        s_flushed.clear();
+    }
+    s_depth--;
+}
+
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * @class ChangeNotifier
+ *
+ * @brief Emits the signal at the end of a ChangeBatch.
+ *
+ * ChangeBatch is no QObject because it lives on the stack, so its signal is emitted by this
+ * singleton.
+ *
+ * @ingroup gui
+ * @author Bernhard Walle
+ */
+
+/**
+ * @fn ChangeNotifier::batchFlushed(const BatchedNotifierSet&)
+ *
+ * @brief Emitted once when a batch ends.
+ *
+ * The objects that are deleted while the signal is delivered are removed from @p changed.
+ *
+ * @param changed all objects that have changed in the batch
+ */
+
+ChangeNotifier *ChangeNotifier::s_instance = NULL;
+
+
+/**
+ * @brief Returns the only instance of the ChangeNotifier.
+ *
+ * @return the instance, never @c NULL
+ */
+ChangeNotifier *ChangeNotifier::instance()
+{
+    if (!s_instance)
+        s_instance = new ChangeNotifier();
+    return s_instance;
+}
+
+
+/**
+ * @brief Creates the ChangeNotifier, use instance().
+ */
+ChangeNotifier::ChangeNotifier()
+{}
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
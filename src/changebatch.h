@@ -0,0 +1,96 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#ifndef CHANGEBATCH_H
+#define CHANGEBATCH_H
+
+#include <QObject>
+#include <QSet>
+
+class BatchedNotifier;
+
+typedef QSet<BatchedNotifier*> BatchedNotifierSet;
+
+class BatchedNotifier
+{
+    friend class ChangeBatch;
+
+    public:
+        BatchedNotifier();
+        virtual ~BatchedNotifier();
+
+    protected:
+        void notifyChanged(int changes);
+        virtual void flushChanges(int changes) = 0;
+
+    private:
+        void unlink();
+
+    private:
+        BatchedNotifier *m_prevPending;
+        BatchedNotifier *m_nextPending;
+        int             m_pendingChanges;
+
+    private:
+        BatchedNotifier(const BatchedNotifier&);
+        BatchedNotifier& operator=(const BatchedNotifier&);
+};
+
+class ChangeBatch
+{
+    friend class BatchedNotifier;
+
+    public:
+        ChangeBatch();
+        ~ChangeBatch();
+
+    public:
+        static bool isActive();
+
+    private:
+        static void flush();
+
+    private:
+        static int                  s_depth;
+        static BatchedNotifier      *s_firstPending;
+        static BatchedNotifier      *s_lastPending;
+        static BatchedNotifierSet   s_flushed;
+
+    private:
+        ChangeBatch(const ChangeBatch&);
+        ChangeBatch& operator=(const ChangeBatch&);
+};
+
+class ChangeNotifier : public QObject
+{
+    Q_OBJECT
+
+    friend class ChangeBatch;
+
+    public:
+        static ChangeNotifier* instance();
+
+    signals:
+        void batchFlushed(const BatchedNotifierSet& changed);
+
+    private:
+        ChangeNotifier();
+
+    private:
+        static ChangeNotifier   *s_instance;
+};
+
+#endif // CHANGEBATCH_H
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
@@ -0,0 +1,658 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#include <cstdio>
+
+#include <QCoreApplication>
+#include <QSettings>
+#include <QDir>
+#include <QFile>
+#include <QRegExp>
+#include <QUuid>
+#include <QDebug>
+#include <QScopedPointer>
+
+#include "global.h"
+#include "datareadwriter.h"
+#include "journalfile.h"
+#include "security/symmetricencryptor.h"
+#include "security/passwordcheckerfactory.h"
+#include "util/platformhelpers.h"
+#include "util/processinfo.h"
+#include "util/debug.h"
+#include "cli/qpamatcli.h"
+
+/**
+ * @class QpamatCli
+ *
+ * @brief The command line client <tt>qpamat-cli</tt>.
+ *
+ * The client reads and writes the same data file as the main window, including the Journal,
+ * but it doesn't need a display and is not linked against QtGui. It works directly on the
+ * XML document that DataReadWriter returns, so it's fast enough to be called from scripts.
+ *
+ * The VaultConfig (data file, cipher algorithm, dictionary and the limits for the password
+ * strength) is read from the settings of the main window. The data file and the algorithm
+ * can be overridden on the command line.
+ *
+ * Passwords are never passed as arguments since other users could see them in the process
+ * list. The password of the data file is read from the first line of the standard input,
+ * the password of a new entry from the second line.
+ *
+ * The data file is written completely by the \c add command. It refuses to do that while
+ * the main window is running (see SingleApplication), the main window would overwrite the
+ * change with its next save.
+ *
+ * @ingroup cli
+ * @author Bernhard Walle
+ */
+
+/**
+ * @enum QpamatCli::ExitCode
+ *
+ * @brief The exit codes of the client.
+ */
+
+/**
+ * @var QpamatCli::ExitNotFound
+ *
+ * @brief The entry or property has not been found, or the search had no result.
+ */
+
+/**
+ * @brief Creates a new client.
+ *
+ * @param arguments the command line arguments, including the name of the program
+ */
+QpamatCli::QpamatCli(const QStringList& arguments)
+    : m_arguments(arguments)
+    , m_debug(false)
+    , m_in(stdin, QIODevice::ReadOnly)
+    , m_out(stdout, QIODevice::WriteOnly)
+    , m_err(stderr, QIODevice::WriteOnly)
+{}
+
+
+/**
+ * @brief Executes the command that has been given on the command line.
+ *
+ * @return the exit code of the program, see QpamatCli::ExitCode
+ */
+int QpamatCli::exec()
+{
+    readSettings();
+    if (!parseArguments()) {
+        printUsage();
+        return ExitUsage;
+    }
+
+    if (m_debug)
+        QpamatDebug::instance()->setMessageLevel(QtDebugMsg);
+
+    try {
+        if (m_command == "help") {
+            printUsage();
+            return ExitSuccess;
+        } else if (m_command == "version") {
+            m_out << "qpamat-cli version " << VERSION_STRING << endl;
+            return ExitSuccess;
+        } else if (m_command == "get")
+            return get();
+        else if (m_command == "search")
+            return search();
+        else if (m_command == "add")
+            return add();
+        else if (m_command == "export")
+            return exportData();
+        else if (m_command == "check-strength")
+            return checkStrength();
+
+        m_err << QObject::tr("qpamat-cli: Unknown command '%1'.").arg(m_command) << endl;
+        return ExitUsage;
+
+    } catch (const ReadWriteException& e) {
+        // the messages are written for QMessageBox
+        QString message = e.getMessage();
+        message.remove(QRegExp("<[^>]*>"));
+        m_err << "qpamat-cli: " << message << endl;
+    } catch (const std::exception& e) {
+        m_err << "qpamat-cli: " << e.what() << endl;
+    }
+
+    return ExitError;
+}
+
+
+/**
+ * @brief Parses the command line.
+ *
+ * The options must come before the command, everything after the command are arguments
+ * of the command.
+ *
+ * @return @c true on success, @c false if the usage should be printed
+ */
+bool QpamatCli::parseArguments()
+{
+    for (int i = 1; i < m_arguments.size(); ++i) {
+        const QString argument = m_arguments[i];
+
+        if (!m_command.isEmpty())
+            m_commandArguments << argument;
+        else if (argument == "-f" || argument == "--file") {
+            if (++i >= m_arguments.size())
+                return false;
+            m_config.setDataFile(m_arguments[i]);
+        } else if (argument == "-a" || argument == "--algorithm") {
+            if (++i >= m_arguments.size())
+                return false;
+            m_config.setCipherAlgorithm(m_arguments[i]);
+        } else if (argument == "-d" || argument == "--debug")
+            m_debug = true;
+        else if (argument == "-h" || argument == "--help")
+            m_command = "help";
+        else if (argument == "-v" || argument == "--version")
+            m_command = "version";
+        else if (argument.startsWith("-"))
+            return false;
+        else
+            m_command = argument;
+    }
+
+    return !m_command.isEmpty();
+}
+
+
+/**
+ * @brief Reads the configuration of the main window.
+ *
+ * The default values are the same as in Settings.
+ */
+void QpamatCli::readSettings()
+{
+    QSettings settings("qpamat", "qpamat");
+
+    const QString basePath = QDir(QCoreApplication::applicationDirPath() +
+        (RUNNING_ON_MAC ? "/../Resources/" : "/../")).canonicalPath();
+
+    m_config.setDataFile(settings.value("General/Datafile",
+        QDir::homePath() + "/.qpamat").toString());
+    m_config.setCipherAlgorithm(settings.value("Security/CipherAlgorithm",
+        SymmetricEncryptor::getSuggestedAlgorithm()).toString());
+    m_config.setDictionaryFile(settings.value("Security/DictionaryFile",
+        QDir(basePath + "/share/qpamat/dicts").canonicalPath() + "/default.txt").toString());
+    m_config.setPasswordChecker(settings.value("Security/PasswordChecker",
+        PasswordCheckerFactory::HYBRID_CHECKER_STRING).toString());
+    m_config.setBreachCorpusFile(settings.value("Security/BreachCorpus").toString());
+    m_config.setWeakPasswordLimit(settings.value("Security/WeakPasswordLimit",
+        3.0).toDouble());
+    m_config.setStrongPasswordLimit(settings.value("Security/StrongPasswordLimit",
+        15.0).toDouble());
+    m_usernameKey = settings.value("AutoText/Username", "Username").toString();
+    m_passwordKey = settings.value("AutoText/Password", "Password").toString();
+    m_urlKey = settings.value("AutoText/URL", "URL").toString();
+}
+
+
+/**
+ * @brief Prints the usage on stderr.
+ */
+void QpamatCli::printUsage()
+{
+    m_err
+        << "\n"
+        << "qpamat-cli " << VERSION_STRING << ", the command line client of QPaMaT\n\n"
+        << "Usage: qpamat-cli [options] command [arguments]\n\n"
+        << "Options: -f, --file FILE        use FILE as data file\n"
+        << "         -a, --algorithm ALGO   use ALGO for writing the data file\n"
+        << "         -d, --debug            print debugging messages\n"
+        << "         -h, --help             prints this help\n"
+        << "         -v, --version          prints the version\n\n"
+        << "Commands:\n"
+        << "  get PATH [KEY]          prints the properties of the entry PATH, or only the\n"
+        << "                          value of the property KEY\n"
+        << "  search TEXT             prints the path of all entries that contain TEXT\n"
+        << "  add PATH [KEY=VALUE]... adds the entry PATH, the password of the entry is read\n"
+        << "                          from the second line of the standard input\n"
+        << "  export [FILE]           prints all entries as text, or writes them in a new\n"
+        << "                          data file FILE\n"
+        << "  check-strength          reads passwords line by line from the standard input\n"
+        << "                          and prints their strength\n\n"
+        << "The password of the data file is read from the first line of the standard input.\n"
+        << "The categories in PATH are separated by '/', e.g. 'Mail/Work/IMAP'.\n"
+        << endl;
+}
+
+
+/**
+ * @brief Reads a line from the standard input.
+ *
+ * @return the line or a null string at the end of the input
+ */
+QString QpamatCli::readLine()
+{
+    return m_in.readLine();
+}
+
+
+/**
+ * @brief Reads the password of the data file from the standard input.
+ *
+ * @return the password
+ * @exception ReadWriteException if the input is empty
+ */
+QString QpamatCli::readPassword()
+{
+    const QString password = readLine();
+    if (password.isNull())
+        throw ReadWriteException(QObject::tr("No password given on the standard input."),
+            ReadWriteException::CWrongPassword);
+
+    return password;
+}
+
+
+/**
+ * @brief Reads the data file.
+ *
+ * @param password the password of the data file
+ * @param vaultKey if not 0, the passwords in the document are not decrypted, see
+ *        DataReadWriter::readXML()
+ * @return the document
+ * @exception ReadWriteException if the file cannot be read
+ */
+QDomDocument QpamatCli::readDataFile(const QString& password, QSharedPointer<VaultKey>* vaultKey)
+{
+    DataReadWriter reader(m_config);
+    return reader.readXML(password, vaultKey);
+}
+
+
+/**
+ * @brief Implements the \c get command.
+ *
+ * Only the passwords of the entry are decrypted.
+ *
+ * @return the exit code
+ */
+int QpamatCli::get()
+{
+    if (m_commandArguments.size() < 1 || m_commandArguments.size() > 2) {
+        printUsage();
+        return ExitUsage;
+    }
+
+    QSharedPointer<VaultKey> vaultKey;
+    QDomDocument doc = readDataFile(readPassword(), &vaultKey);
+    QDomElement passwords = doc.documentElement().namedItem("passwords").toElement();
+
+    QDomElement entry = findEntry(passwords,
+        m_commandArguments[0].split('/', QString::SkipEmptyParts));
+    if (entry.isNull() || entry.tagName() != "entry") {
+        m_err << QObject::tr("qpamat-cli: The entry '%1' does not exist.")
+            .arg(m_commandArguments[0]) << endl;
+        return ExitNotFound;
+    }
+
+    const QString wanted = m_commandArguments.value(1);
+    bool found = false;
+    for (QDomElement property = entry.firstChildElement("property"); !property.isNull();
+            property = property.nextSiblingElement("property")) {
+        const QString key = property.attribute("key");
+        if (!wanted.isNull() && key != wanted)
+            continue;
+
+        QString value = property.attribute("value");
+        if (property.attribute("type") == "PASSWORD" && !value.isEmpty())
+            value = vaultKey->decryptStrFromStr(value);
+
+        if (wanted.isNull())
+            m_out << qSetFieldWidth(20) << key + ": " << qSetFieldWidth(0) << value << "\n";
+        else
+            m_out << value << "\n";
+        found = true;
+    }
+
+    if (!wanted.isNull() && !found) {
+        m_err << QObject::tr("qpamat-cli: The entry '%1' has no property '%2'.")
+            .arg(m_commandArguments[0]).arg(wanted) << endl;
+        return ExitNotFound;
+    }
+
+    return ExitSuccess;
+}
+
+
+/**
+ * @brief Implements the \c search command.
+ *
+ * The names of the entries and the values of all properties except passwords are searched,
+ * so nothing needs to be decrypted.
+ *
+ * @return the exit code
+ */
+int QpamatCli::search()
+{
+    if (m_commandArguments.size() != 1) {
+        printUsage();
+        return ExitUsage;
+    }
+
+    QSharedPointer<VaultKey> vaultKey;
+    QDomDocument doc = readDataFile(readPassword(), &vaultKey);
+    QDomElement passwords = doc.documentElement().namedItem("passwords").toElement();
+
+    QStringList matches;
+    appendMatches(passwords, QString(), m_commandArguments[0], matches);
+    for (QStringList::const_iterator it = matches.constBegin(); it != matches.constEnd(); ++it)
+        m_out << *it << "\n";
+
+    return matches.isEmpty() ? ExitNotFound : ExitSuccess;
+}
+
+
+/**
+ * @brief Checks if the main window is running.
+ *
+ * Reads the lockfile that SingleApplication::startup() writes in the home directory.
+ *
+ * @return @c true if the process of the lockfile is running, @c false otherwise
+ */
+static bool isMainWindowRunning()
+{
+    QFile file(QDir::homePath() + "/.qpamat.lock");
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    bool ok;
+    const int pid = QString::fromLatin1(file.readAll()).trimmed().toInt(&ok);
+    return ok && ProcessInfo::isProcessRunning(pid);
+}
+
+
+/**
+ * @brief Implements the \c add command.
+ *
+ * Missing categories are created. The passwords of the other entries are not decrypted, the
+ * data file is written with the algorithm it has been encrypted with. The new password is
+ * stored hidden and encrypted, like SouthPanel::updateData() does.
+ *
+ * @return the exit code
+ */
+int QpamatCli::add()
+{
+    const QStringList path = m_commandArguments.value(0).split('/', QString::SkipEmptyParts);
+    if (path.isEmpty()) {
+        printUsage();
+        return ExitUsage;
+    }
+
+    if (isMainWindowRunning()) {
+        m_err << QObject::tr("qpamat-cli: QPaMaT is running, close it before adding entries.")
+            << endl;
+        return ExitError;
+    }
+
+    QStringList keys, values;
+    for (int i = 1; i < m_commandArguments.size(); ++i) {
+        const int pos = m_commandArguments[i].indexOf('=');
+        if (pos <= 0) {
+            printUsage();
+            return ExitUsage;
+        }
+        keys << m_commandArguments[i].left(pos);
+        values << m_commandArguments[i].mid(pos + 1);
+    }
+
+    const QString password = readPassword();
+    const QString secret = readLine();
+    if (secret.isNull())
+        throw ReadWriteException(QObject::tr("No password for the new entry given on the "
+            "standard input."));
+
+    QSharedPointer<VaultKey> vaultKey;
+    QDomDocument doc = readDataFile(password, &vaultKey);
+    QDomElement passwords = doc.documentElement().namedItem("passwords").toElement();
+
+    if (!findEntry(passwords, path).isNull()) {
+        m_err << QObject::tr("qpamat-cli: The entry '%1' already exists.")
+            .arg(path.join("/")) << endl;
+        return ExitError;
+    }
+
+    QDomElement parent = passwords;
+    for (int i = 0; i < path.size() - 1; ++i) {
+        QDomElement category = findEntry(parent, QStringList(path[i]));
+        if (category.isNull()) {
+            category = doc.createElement("category");
+            category.setAttribute("wasOpen", false);
+            category.setAttribute("name", path[i]);
+            category.setAttribute("id", QUuid::createUuid().toString());
+            category.setAttribute("isSelected", false);
+            parent.appendChild(category);
+        } else if (category.tagName() != "category") {
+            m_err << QObject::tr("qpamat-cli: '%1' is not a category.").arg(path[i]) << endl;
+            return ExitError;
+        }
+        parent = category;
+    }
+
+    QDomElement entry = doc.createElement("entry");
+    keys << m_passwordKey;
+    values << vaultKey->encryptStrToStr(secret);
+    for (int i = 0; i < keys.size(); ++i) {
+        QString type = "MISC";
+        if (i == keys.size() - 1)
+            type = "PASSWORD";
+        else if (keys[i] == m_usernameKey)
+            type = "USERNAME";
+        else if (keys[i] == m_urlKey)
+            type = "URL";
+
+        QDomElement property = doc.createElement("property");
+        property.setAttribute("key", keys[i]);
+        property.setAttribute("value", values[i]);
+        property.setAttribute("hidden", type == "PASSWORD");
+        property.setAttribute("encrypted", type == "PASSWORD");
+        property.setAttribute("type", type);
+        entry.appendChild(property);
+    }
+    entry.setAttribute("name", path.last());
+    entry.setAttribute("id", QUuid::createUuid().toString());
+    entry.setAttribute("isSelected", false);
+    parent.appendChild(entry);
+
+    // the document contains the changes of the journal, so it's obsolete afterwards
+    DataReadWriter writer(m_config.getDataFile(), vaultKey->getAlgorithm());
+    QDomDocument result = writer.createSkeletonDocument();
+    QDomElement root = result.documentElement();
+    root.replaceChild(result.importNode(passwords, true), root.namedItem("passwords"));
+    writer.writeXML(result, password, true);
+    JournalFile::discard(m_config.getDataFile());
+
+    return ExitSuccess;
+}
+
+
+/**
+ * @brief Implements the \c export command.
+ *
+ * Without argument, all entries are printed in the text format of the main window. With a
+ * file name, a new data file with the same password is written.
+ *
+ * @return the exit code
+ */
+int QpamatCli::exportData()
+{
+    if (m_commandArguments.size() > 1) {
+        printUsage();
+        return ExitUsage;
+    }
+
+    const QString password = readPassword();
+    QDomDocument doc = readDataFile(password, 0);
+    QDomElement passwords = doc.documentElement().namedItem("passwords").toElement();
+
+    if (m_commandArguments.isEmpty()) {
+        appendText(passwords, QString(""), m_out);
+        return ExitSuccess;
+    }
+
+    DataReadWriter writer(m_commandArguments[0], m_config.getCipherAlgorithm());
+    QDomDocument result = writer.createSkeletonDocument();
+    QDomElement root = result.documentElement();
+    root.replaceChild(result.importNode(passwords, true), root.namedItem("passwords"));
+    writer.writeXML(result, password);
+
+    return ExitSuccess;
+}
+
+
+/**
+ * @brief Implements the \c check-strength command.
+ *
+ * For each line of the standard input, the strength (<tt>weak</tt>, <tt>acceptable</tt> or
+ * <tt>strong</tt>) and the days to crack the password are printed, separated by a tab.
+ * The checker is selected by <tt>Security/PasswordChecker</tt>, passwords of the breach corpus
+ * (<tt>Security/BreachCorpus</tt>) are always weak.
+ * The data file is not read.
+ *
+ * @return the exit code
+ */
+int QpamatCli::checkStrength()
+{
+    if (!m_commandArguments.isEmpty()) {
+        printUsage();
+        return ExitUsage;
+    }
+
+    QScopedPointer<PasswordChecker> checker(PasswordCheckerFactory::getChecker(m_config));
+
+    QString password;
+    while (!(password = readLine()).isNull()) {
+        const double days = checker->passwordQuality(password);
+
+        QString strength;
+        if (days < m_config.getWeakPasswordLimit())
+            strength = "weak";
+        else if (days < m_config.getStrongPasswordLimit())
+            strength = "acceptable";
+        else
+            strength = "strong";
+
+        m_out << strength << "\t" << QString::number(days, 'f', 2) << "\n";
+    }
+
+    return ExitSuccess;
+}
+
+
+/**
+ * @brief Finds an entry or a category.
+ *
+ * @param parent the element where the search starts, e.g. the \c passwords element
+ * @param path the names of the categories and the name of the entry
+ * @return the \c entry or \c category element or a null element if it doesn't exist
+ */
+QDomElement QpamatCli::findEntry(const QDomElement& parent, const QStringList& path)
+{
+    if (path.isEmpty())
+        return QDomElement();
+
+    QDomElement current = parent;
+    for (int i = 0; i < path.size() && !current.isNull(); ++i) {
+        QDomElement next;
+        for (QDomElement child = current.firstChildElement(); !child.isNull();
+                child = child.nextSiblingElement()) {
+            if ((child.tagName() == "category" || child.tagName() == "entry") &&
+                    child.attribute("name") == path[i]) {
+                next = child;
+                break;
+            }
+        }
+        current = next;
+    }
+
+    return current;
+}
+
+
+/**
+ * @brief Appends the path of all entries below @p parent that contain @p text.
+ *
+ * @param parent the category or the \c passwords element
+ * @param path the path of @p parent
+ * @param text the text, the case is ignored
+ * @param matches the list where the paths are appended
+ */
+void QpamatCli::appendMatches(const QDomElement& parent, const QString& path,
+                              const QString& text, QStringList& matches)
+{
+    for (QDomElement child = parent.firstChildElement(); !child.isNull();
+            child = child.nextSiblingElement()) {
+        const QString name = child.attribute("name");
+        const QString childPath = path.isEmpty() ? name : path + "/" + name;
+
+        if (child.tagName() == "category")
+            appendMatches(child, childPath, text, matches);
+        else if (child.tagName() == "entry") {
+            bool match = name.contains(text, Qt::CaseInsensitive);
+            for (QDomElement property = child.firstChildElement("property");
+                    !match && !property.isNull();
+                    property = property.nextSiblingElement("property")) {
+                match = property.attribute("type") != "PASSWORD" &&
+                    property.attribute("value").contains(text, Qt::CaseInsensitive);
+            }
+            if (match)
+                matches << childPath;
+        }
+    }
+}
+
+
+/**
+ * @brief Appends the entries below @p parent in the same text format as
+ *        TreeExporter.
+ *
+ * @param parent the category or the \c passwords element, the passwords must be decrypted
+ * @param path the names of the categories above, each followed by <tt>": "</tt>
+ * @param stream the stream
+ */
+void QpamatCli::appendText(const QDomElement& parent, const QString& path, QTextStream& stream)
+{
+    const QString separator(80, '-');
+
+    for (QDomElement child = parent.firstChildElement(); !child.isNull();
+            child = child.nextSiblingElement()) {
+        const QString name = child.attribute("name");
+
+        if (child.tagName() == "category")
+            appendText(child, path + name + ": ", stream);
+        else if (child.tagName() == "entry") {
+            stream << separator << "\n";
+            stream << path + name << "\n";
+            stream << separator << "\n";
+            stream << "\n";
+
+            for (QDomElement property = child.firstChildElement("property");
+                    !property.isNull(); property = property.nextSiblingElement("property")) {
+                stream << qSetFieldWidth(20) << property.attribute("key") + ": "
+                       << qSetFieldWidth(0) << property.attribute("value") << "\n";
+            }
+
+            stream << "\n\n";
+        }
+    }
+}
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
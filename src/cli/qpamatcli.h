@@ -0,0 +1,80 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#ifndef QPAMATCLI_H
+#define QPAMATCLI_H
+
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+#include <QDomDocument>
+#include <QSharedPointer>
+
+#include "security/vaultkey.h"
+#include "vaultconfig.h"
+
+class QpamatCli
+{
+    public:
+        enum ExitCode {
+            ExitSuccess     = 0,
+            ExitError       = 1,
+            ExitUsage       = 2,
+            ExitNotFound    = 3
+        };
+
+    public:
+        QpamatCli(const QStringList& arguments);
+
+        int exec();
+
+    private:
+        bool parseArguments();
+        void readSettings();
+        void printUsage();
+
+        QString readLine();
+        QString readPassword();
+        QDomDocument readDataFile(const QString& password, QSharedPointer<VaultKey>* vaultKey);
+
+        int get();
+        int search();
+        int add();
+        int exportData();
+        int checkStrength();
+
+    private:
+        static QDomElement findEntry(const QDomElement& parent, const QStringList& path);
+        static void appendMatches(const QDomElement& parent, const QString& path,
+            const QString& text, QStringList& matches);
+        static void appendText(const QDomElement& parent, const QString& path,
+            QTextStream& stream);
+
+    private:
+        QStringList     m_arguments;
+        QString         m_command;
+        QStringList     m_commandArguments;
+        VaultConfig     m_config;
+        QString         m_usernameKey;
+        QString         m_passwordKey;
+        QString         m_urlKey;
+        bool            m_debug;
+        QTextStream     m_in;
+        QTextStream     m_out;
+        QTextStream     m_err;
+};
+
+#endif // QPAMATCLI_H
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
@@ -15,27 +15,20 @@
 #include <ctime>
 #include <cstdlib>
 
-#include <QThread>
 #include <QFile>
-#include <QApplication>
-#include <QCursor>
-#include <QTimer>
-#include <QEventLoop>
-#include <QMessageBox>
+#include <QCoreApplication>
 #include <QFileInfo>
-#include <QTranslator>
 #include <QDateTime>
-#include <QPixmap>
 #include <QTextStream>
 #include <QDebug>
 #include <QScopedPointer>
 
-#include "qpamatwindow.h"
-#include "qpamat.h"
 #include "datareadwriter.h"
+#include "journalfile.h"
 #include "security/passwordhash.h"
 #include "security/symmetricencryptor.h"
-#include "dialogs/waitdialog.h"
+#include "util/trace.h"
+#include "util/platformhelpers.h"
 #include "global.h"
 
 /**
@@ -174,8 +167,10 @@
  * output is a XML structure with passwords as cleartext. This class does also the
  * encryption or decryption.
  *
- * It reads the current configuration from the global Settings object. The configuration
- * is the file, the encryption algorithm and so on.
+ * The configuration (the file and the encryption algorithm) is passed to the constructor,
+ * usually as VaultConfig.
+ * The class doesn't access the settings or the main window, so it can also be used in a
+ * worker thread (see AutoSaver) and in the command line client (see QpamatCli).
  *
  * On error, a ReadWriteException is thrown and the error message is set to a sensible
  * value. It displays no error dialog itself, you have to to this on the calling part.
@@ -197,6 +192,29 @@
  */
 
 
+/**
+ * @brief Creates a DataReadWriter.
+ *
+ * @param fileName the name of the data file
+ * @param algorithm the cipher algorithm that is used for writing
+ */
+DataReadWriter::DataReadWriter(const QString& fileName, const QString& algorithm)
+    : m_fileName(fileName)
+    , m_algorithm(algorithm)
+{}
+
+
+/**
+ * @brief Creates a DataReadWriter for the data file and the cipher algorithm of @p config.
+ *
+ * @param config the configuration
+ */
+DataReadWriter::DataReadWriter(const VaultConfig& config)
+    : m_fileName(config.getDataFile())
+    , m_algorithm(config.getCipherAlgorithm())
+{}
+
+
 /**
  * @brief Creates a skeleton document that must be used for writing the XML tree to the
  *        harddisk.
@@ -227,8 +245,7 @@ QDomDocument DataReadWriter::createSkeletonDocument()
     appData.appendChild(date);
 
     QDomElement cryptAlgorithm = doc.createElement("crypt-algorithm");
-    QpamatWindow *win = Qpamat::instance()->getWindow();
-    QDomText algorithm = doc.createTextNode(win->set().readEntry("Security/CipherAlgorithm"));
+    QDomText algorithm = doc.createTextNode(m_algorithm);
     cryptAlgorithm.appendChild(algorithm);
     appData.appendChild(cryptAlgorithm);
 
@@ -250,74 +267,116 @@ QDomDocument DataReadWriter::createSkeletonDocument()
 
 
 /**
- * @brief Writes the document in the file specified in the global settings.
+ * @brief Creates the encryptor that writeXML() uses for the given password.
+ *
+ * Pass it to Tree::appendXML() to get a document whose passwords are already encrypted, and
+ * write that with writeXML() and @p passwordsEncrypted set. That way, the passwords never
+ * exist as plain text in the document.
+ *
+ * @param password the password which is used for encryption
+ * @return the encryptor, the caller takes ownership
+ * @exception ReadWriteException if the configured cipher algorithm is not available
+ */
+StringEncryptor* DataReadWriter::createEncryptor(const QString& password)
+{
+    try {
+        return new VaultKey(m_algorithm, password);
+    }
+    catch (const NoSuchAlgorithmException&)
+    {
+        throw ReadWriteException(QObject::tr("The algorithm '%1' is not avaible on "
+            "your system.\nChoose another crypto algorithm in the settings.\nThe data "
+            "is not saved!").arg(m_algorithm), ReadWriteException::CNoAlgorithm);
+    }
+}
+
+
+/**
+ * @brief Writes the document in the data file.
  *
  * Encryption is done before writing with the specified password. If something went wrong,
- * a ReadWriteException is thrown.
+ * a ReadWriteException is thrown. The document is written to a temporary file next to the
+ * data file which replaces the data file only if it has been written completely.
  *
  * @param document the XML document to write
  * @param password the password which is used for encryption
+ * @param passwordsEncrypted @c true if the passwords in @p document have already been
+ *        encrypted with an encryptor from createEncryptor(), @c false if they are plain text
  * @exception ReadWriteException several reasons
  *               - file could not be opened
  *               - cipher algorithm is not available
  *               - error in communicating with the smart-card terminal
  */
-void DataReadWriter::writeXML(const QDomDocument& document, const QString& password)
+void DataReadWriter::writeXML(const QDomDocument& document, const QString& password,
+                              bool passwordsEncrypted)
 {
+    TraceSpan span("save", "Storage");
+
     QDomDocument document_cpy = document.cloneNode(true).toDocument();
-    QpamatWindow *win = Qpamat::instance()->getWindow();
-    const QString fileName = win->set().readEntry("General/Datafile");
-    const QString algorithm = win->set().readEntry("Security/CipherAlgorithm");
 
     // check if the file can be added
-    QFile file(fileName);
+    QFile file(m_fileName);
 
     if (QFileInfo(file).exists() && !QFileInfo(file).isWritable())
         throw ReadWriteException(QObject::tr("<qt><nobr>The data file is not writable. Change "
             "the file in</nobr> the configuration dialog or change the permission of the file!"
             "</qt>"), ReadWriteException::CIOError);
 
-    // set up the needed encryptors
-    QScopedPointer<StringEncryptor> enc;
-    QScopedPointer<Encryptor> realEncryptor;
-    try {
-        enc.reset(new SymmetricEncryptor(algorithm, password));
-    }
-    catch (const NoSuchAlgorithmException&)
-    {
-        throw ReadWriteException(QObject::tr("The algorithm '%1' is not avaible on "
-            "your system.\nChoose another crypto algorithm in the settings.\nThe data "
-            "is not saved!").arg(algorithm), ReadWriteException::CNoAlgorithm);
-    }
-
     // encrypt
-    QDomElement pwData = document_cpy.documentElement().namedItem("passwords").toElement();
     QDomElement appData = document_cpy.documentElement().namedItem("app-data").toElement();
-    crypt(pwData, *enc, true);
+    if (!passwordsEncrypted) {
+        QScopedPointer<StringEncryptor> enc(createEncryptor(password));
+        QDomElement pwData = document_cpy.documentElement().namedItem("passwords").toElement();
+        crypt(pwData, *enc, true);
+    }
 
     // write the password hash
     const QString hash = PasswordHash::generateHashString(password);
     QDomText text = document_cpy.createTextNode(hash);
     appData.namedItem("passwordhash").toElement().appendChild(text);
 
-    if (!file.open(QIODevice::WriteOnly))
+    // a crash while writing must not destroy the only copy of the data
+    QFile tempFile(m_fileName + ".tmp");
+    if (!tempFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
         throw ReadWriteException(QObject::tr("The data could not be saved. There "
-            "was an\nerror while creating the file:\n%1").arg( qApp->translate("QFile",
-            file.errorString())), ReadWriteException::CIOError);
+            "was an\nerror while creating the file:\n%1").arg( QCoreApplication::translate("QFile",
+            tempFile.errorString())), ReadWriteException::CIOError);
 
-    QTextStream stream(&file);
-    stream.setEncoding(QTextStream::UnicodeUTF8);
+    QTextStream stream(&tempFile);
+    stream.setCodec("UTF-8");
     stream << document_cpy.toString();
+    stream.flush();
+    tempFile.close();
+
+    if (stream.status() != QTextStream::Ok || tempFile.error() != QFile::NoError) {
+        const QString error = tempFile.errorString();
+        tempFile.remove();
+        throw ReadWriteException(QObject::tr("The data could not be saved. There "
+            "was an\nerror while writing the file:\n%1").arg( QCoreApplication::translate("QFile",
+            error)), ReadWriteException::CIOError);
+    }
+
+    if (!PlatformHelpers::replaceFile(tempFile.fileName(), m_fileName)) {
+        tempFile.remove();
+        throw ReadWriteException(QObject::tr("The data could not be saved. The file %1 "
+            "could not be replaced.").arg(m_fileName), ReadWriteException::CIOError);
+    }
 }
 
 
 /**
- * @brief Reads the document from the specified XML (global settings) file and decrypts the
+ * @brief Reads the document from the data file and decrypts the
  *        passwords using the given \p password.
  *
- * It does also a password check.
+ * It does also a password check. The changes from the Journal are applied.
+ *
+ * If @p vaultKey is not 0, the passwords are not decrypted. Instead, the key is stored in
+ * @p vaultKey and the passwords are decrypted on demand, see Tree::readFromXML(). That
+ * makes reading independent from the number of passwords.
  *
  * @param password the decryption password
+ * @param vaultKey if not 0, the key for the passwords is stored there and the passwords
+ *        are not decrypted
  * @return the document
  * @exception ReadWriteException several reasons
  *               - cannot open the XML file
@@ -328,25 +387,27 @@ void DataReadWriter::writeXML(const QDomDocument& document, const QString& passw
  *               - algorithm does not exist in this OpenSSL configuration
  *               - error with communicating with the card terminal
  */
-QDomDocument DataReadWriter::readXML(const QString& password)
+QDomDocument DataReadWriter::readXML(const QString& password, QSharedPointer<VaultKey>* vaultKey)
 {
     qDebug() << CURRENT_FUNCTION;
 
-    QpamatWindow *win = Qpamat::instance()->getWindow();
-    const QString& fileName = win->set().readEntry("General/Datafile");
+    const QString& fileName = m_fileName;
 
     // load the XML structure
     QFile file(fileName);
     if (!file.open(QIODevice::ReadOnly))
         throw ReadWriteException(QObject::tr("The file %1 could not be opened:\n%2.").
-            arg(fileName).arg(qApp->translate("QFile", file.errorString())),
+            arg(fileName).arg(QCoreApplication::translate("QFile", file.errorString())),
             ReadWriteException::CIOError);
 
     QDomDocument doc;
-    if (!doc.setContent(&file))
-        throw ReadWriteException(QObject::tr("The XML file (%1) may be corrupted "
-            "and\ncould not be read. Check the file with a text editor.").arg(fileName),
-            ReadWriteException::CInvalidData);
+    {
+        TraceSpan span("parse", "Storage");
+        if (!doc.setContent(&file))
+            throw ReadWriteException(QObject::tr("The XML file (%1) may be corrupted "
+                "and\ncould not be read. Check the file with a text editor.").arg(fileName),
+                ReadWriteException::CInvalidData);
+    }
 
     file.close();
     QDomElement appData = doc.documentElement().namedItem("app-data").toElement();
@@ -363,10 +424,9 @@ QDomDocument DataReadWriter::readXML(const QString& password)
             ReadWriteException::CWrongPassword);
 
     QString algorithm = appData.namedItem("crypt-algorithm").toElement().text();
-    QScopedPointer<StringEncryptor> enc;
-    QScopedPointer<Encryptor> realEncryptor;
+    QSharedPointer<VaultKey> enc;
     try {
-        enc.reset(new SymmetricEncryptor(algorithm, password));
+        enc = QSharedPointer<VaultKey>(new VaultKey(algorithm, password));
     } catch (const NoSuchAlgorithmException& ex) {
         UNUSED(ex);
         throw ReadWriteException(QObject::tr("The algorithm '%1' is not avaible on "
@@ -374,8 +434,16 @@ QDomDocument DataReadWriter::readXML(const QString& password)
                 "update your OpenSSL library.").arg(algorithm), ReadWriteException::CNoAlgorithm);
     }
 
-    QDomElement pwData = doc.documentElement().namedItem("passwords").toElement();
-    crypt(pwData, *enc, false);
+    // the records of the journal contain encrypted passwords, too
+    JournalFile::replay(doc, fileName, *enc);
+
+    if (vaultKey)
+        *vaultKey = enc;
+    else {
+        TraceSpan span("decrypt", "Storage");
+        QDomElement pwData = doc.documentElement().namedItem("passwords").toElement();
+        crypt(pwData, *enc, false);
+    }
 
     return doc;
 }
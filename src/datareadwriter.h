@@ -19,11 +19,13 @@
 
 #include <QObject>
 #include <QString>
-#include <QWidget>
 #include <QDomDocument>
+#include <QSharedPointer>
 
 #include "global.h"
 #include "security/encryptor.h"
+#include "security/vaultkey.h"
+#include "vaultconfig.h"
 
 class ReadWriteException : public std::runtime_error
 {
@@ -45,7 +47,7 @@ class ReadWriteException : public std::runtime_error
 
     public:
         ReadWriteException(const QString& error, Category category = COtherError,
-            Severity severity = WARNING) : std::runtime_error(error.isNull() ? "" : error.latin1()),
+            Severity severity = WARNING) : std::runtime_error(error.toLatin1().constData()),
             m_message(error), m_severity(severity), m_category(category)
             {  }
 
@@ -75,14 +77,25 @@ class ReadWriteException : public std::runtime_error
 class DataReadWriter
 {
     public:
-        void writeXML(const QDomDocument& document, const QString& password);
+        DataReadWriter(const QString& fileName, const QString& algorithm);
+        explicit DataReadWriter(const VaultConfig& config);
 
-        QDomDocument readXML(const QString& password);
+        void writeXML(const QDomDocument& document, const QString& password,
+            bool passwordsEncrypted = false);
+
+        StringEncryptor* createEncryptor(const QString& password);
+
+        QDomDocument readXML(const QString& password,
+            QSharedPointer<VaultKey>* vaultKey = 0);
 
         QDomDocument createSkeletonDocument();
 
     private:
         void crypt(QDomElement& n, StringEncryptor& enc, bool encrypt);
+
+    private:
+        QString m_fileName;
+        QString m_algorithm;
 };
 
 #endif // DATAREADWRITER_H
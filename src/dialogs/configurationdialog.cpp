@@ -51,6 +51,7 @@
 #include "qpamat.h"
 #include "widgets/filelineedit.h"
 #include "security/passwordgeneratorfactory.h"
+#include "security/passwordcheckerfactory.h"
 #include "security/symmetricencryptor.h"
 #include "security/hybridpasswordchecker.h"
 
@@ -192,6 +193,7 @@ void ConfDlgGeneralTab::createAndLayout()
     QVBoxLayout* mainLayout = new QVBoxLayout(this, 0, 6);
     Q3GroupBox* startupGroup = new Q3GroupBox(1, Qt::Vertical, tr("Startup"), this);
     Q3GroupBox* locationsGroup = new Q3GroupBox(4, Qt::Vertical, tr("Locations"), this);
+    Q3GroupBox* savingGroup = new Q3GroupBox(1, Qt::Vertical, tr("Saving"), this);
     Q3GroupBox* autoTextGroup = new Q3GroupBox(4, Qt::Vertical, tr("AutoText"), this);
 
     // auto login
@@ -200,6 +202,12 @@ void ConfDlgGeneralTab::createAndLayout()
     QLabel* datafileLabel = new QLabel(tr("&Data File:"), locationsGroup);
     m_datafileEdit = new FileLineEdit(locationsGroup, true);
 
+    // autosave
+    QLabel* autoSaveLabel = new QLabel(tr("Save &automatically every:"), savingGroup);
+    m_autoSaveSpinner = new QSpinBox(0, 120, 5, savingGroup, "AutoSaveSpinner");
+    m_autoSaveSpinner->setSuffix(tr(" min"));
+    m_autoSaveSpinner->setSpecialValueText(tr("Disabled"));
+
     // auto text
     QLabel* miscLabel = new QLabel(tr("&Misc"), autoTextGroup);
     m_miscEdit = new QLineEdit(autoTextGroup);
@@ -212,6 +220,7 @@ void ConfDlgGeneralTab::createAndLayout()
 
     // set buddys
     datafileLabel->setBuddy(m_datafileEdit);
+    autoSaveLabel->setBuddy(m_autoSaveSpinner);
     miscLabel->setBuddy(m_miscEdit);
     usernameLabel->setBuddy(m_usernameEdit);
     passwordLabel->setBuddy(m_passwordEdit);
@@ -219,6 +228,7 @@ void ConfDlgGeneralTab::createAndLayout()
 
     mainLayout->addWidget(startupGroup);
     mainLayout->addWidget(locationsGroup);
+    mainLayout->addWidget(savingGroup);
     mainLayout->addWidget(autoTextGroup);
     mainLayout->addStretch(5);
 
@@ -237,12 +247,13 @@ void ConfDlgGeneralTab::fillSettings()
 {
     QpamatWindow *win = Qpamat::instance()->getWindow();
 
-    m_autoLoginCheckbox->setChecked(win->set().readBoolEntry("General/AutoLogin"));
-    m_datafileEdit->setContent(win->set().readEntry("General/Datafile"));
-    m_miscEdit->setText(win->set().readEntry("AutoText/Misc"));
-    m_usernameEdit->setText(win->set().readEntry("AutoText/Username"));
-    m_passwordEdit->setText(win->set().readEntry("AutoText/Password"));
-    m_urlEdit->setText(win->set().readEntry("AutoText/URL"));
+    m_autoLoginCheckbox->setChecked(win->set().readBoolEntry(Settings::GeneralAutoLogin));
+    m_datafileEdit->setContent(win->set().readEntry(Settings::GeneralDatafile));
+    m_autoSaveSpinner->setValue(win->set().readNumEntry(Settings::GeneralAutoSaveInterval));
+    m_miscEdit->setText(win->set().readEntry(Settings::AutoTextMisc));
+    m_usernameEdit->setText(win->set().readEntry(Settings::AutoTextUsername));
+    m_passwordEdit->setText(win->set().readEntry(Settings::AutoTextPassword));
+    m_urlEdit->setText(win->set().readEntry(Settings::AutoTextURL));
 }
 
 
@@ -255,12 +266,13 @@ void ConfDlgGeneralTab::applySettings()
 {
     QpamatWindow *win = Qpamat::instance()->getWindow();
 
-    win->set().writeEntry("General/AutoLogin", m_autoLoginCheckbox->isChecked() );
-    win->set().writeEntry("General/Datafile", m_datafileEdit->getContent() );
-    win->set().writeEntry("AutoText/Misc", m_miscEdit->text() );
-    win->set().writeEntry("AutoText/Username", m_usernameEdit->text() );
-    win->set().writeEntry("AutoText/Password", m_passwordEdit->text() );
-    win->set().writeEntry("AutoText/URL", m_urlEdit->text() );
+    win->set().writeEntry(Settings::GeneralAutoLogin, m_autoLoginCheckbox->isChecked() );
+    win->set().writeEntry(Settings::GeneralDatafile, m_datafileEdit->getContent() );
+    win->set().writeEntry(Settings::GeneralAutoSaveInterval, m_autoSaveSpinner->value() );
+    win->set().writeEntry(Settings::AutoTextMisc, m_miscEdit->text() );
+    win->set().writeEntry(Settings::AutoTextUsername, m_usernameEdit->text() );
+    win->set().writeEntry(Settings::AutoTextPassword, m_passwordEdit->text() );
+    win->set().writeEntry(Settings::AutoTextURL, m_urlEdit->text() );
 }
 
 
@@ -294,6 +306,7 @@ ConfDlgPasswordTab::ConfDlgPasswordTab(QWidget* parent, const char* name)
     , m_externalEdit(0)
     , m_allowedCharsEdit(0)
     , m_useExternalCB(0)
+    , m_checkerCombo(0)
     , m_weakSlider(0)
     , m_strongSlider(0)
     , m_weakLabel(0)
@@ -317,7 +330,7 @@ void ConfDlgPasswordTab::createAndLayout()
     // create layouts
     QVBoxLayout* mainLayout = new QVBoxLayout(this, 0, 6);
     Q3GroupBox* passwordGroup = new Q3GroupBox(5, Qt::Vertical, tr("Generated Passwords"), this);
-    Q3GroupBox* checkerGroup = new Q3GroupBox(6, Qt::Vertical, tr("Password checker"), this);
+    Q3GroupBox* checkerGroup = new Q3GroupBox(10, Qt::Vertical, tr("Password checker"), this);
 
     QWidget* ensureGrid = new QWidget(passwordGroup, "EnsureGrid");
     QGridLayout* ensureGridLayout = new QGridLayout(ensureGrid, 2, 3, 0, 6, "EnsureGridLayout");
@@ -341,6 +354,11 @@ void ConfDlgPasswordTab::createAndLayout()
     m_externalEdit = new FileLineEdit(passwordGroup, "ExternalEdit");
 
     // checker stuff
+    QLabel* checkerLabel = new QLabel(tr("Strength &estimation:"), checkerGroup, "CheckerLabel");
+    m_checkerCombo = new QComboBox(false, checkerGroup, "CheckerCombo");
+    m_checkerCombo->insertItem(tr("Dictionary and character classes"));
+    m_checkerCombo->insertItem(tr("Pattern matching (words, keyboard walks, dates)"));
+
     new QLabel(tr("Limits for weak - acceptable - strong (cracking days):"), checkerGroup, "WeakLabel");
     Q3HBox* weakSliderBox = new Q3HBox(checkerGroup, "WeakSliderBox");
     weakSliderBox->setSpacing(4);
@@ -368,10 +386,16 @@ void ConfDlgPasswordTab::createAndLayout()
     QWidget* dummy = new QWidget(box);
     box->setStretchFactor(dummy, 10);
 
+    QLabel* corpusLabel = new QLabel(tr("&Breached passwords (Bloom filter, optional):"),
+            checkerGroup, "CorpusLabel");
+    m_breachCorpusEdit = new FileLineEdit(checkerGroup, false, "CorpusEdit");
+
     // buddys
     lengthLabel->setBuddy(m_lengthSpinner);
     allowedLabel->setBuddy(m_allowedCharsEdit);
+    checkerLabel->setBuddy(m_checkerCombo);
     dictLabel->setBuddy(m_dictionaryEdit);
+    corpusLabel->setBuddy(m_breachCorpusEdit);
 
     mainLayout->addWidget(passwordGroup);
     mainLayout->addWidget(checkerGroup);
@@ -381,6 +405,13 @@ void ConfDlgPasswordTab::createAndLayout()
     Q3WhatsThis::add(m_sortButton, tr("<qt>For performance reasons, the dictionary file needs "
         "to be sorted by the length of the words. This function does that!<p>It saves also a "
         "copy of the old file by <i>filename.old</i>.</qt>"));
+    Q3WhatsThis::add(m_checkerCombo, tr("<qt>The <i>dictionary</i> checker counts the character "
+        "classes and rejects words of the dictionary. The <i>pattern</i> checker splits the "
+        "password into words, keyboard walks, repeats, sequences and dates and estimates the "
+        "number of guesses an attacker needs.</qt>"));
+    Q3WhatsThis::add(m_breachCorpusEdit, tr("<qt>Passwords that have been published in a "
+        "data breach are rated as weak. Build the <i>.bloom</i> file from a SHA-1 dump of "
+        "<i>Have I Been Pwned</i> with <tt>qpamat-breachindex</tt>.</qt>"));
 }
 
 
@@ -406,13 +437,19 @@ void ConfDlgPasswordTab::fillSettings()
 {
     QpamatWindow *win = Qpamat::instance()->getWindow();
 
-    m_lengthSpinner->setValue(win->set().readNumEntry("Security/Length"));
-    m_allowedCharsEdit->setText(win->set().readEntry("Security/AllowedCharacters"));
-    m_weakSlider->setValue(int(win->set().readDoubleEntry("Security/WeakPasswordLimit")*2));
-    m_strongSlider->setValue(int(win->set().readDoubleEntry("Security/StrongPasswordLimit")*2));
-    m_useExternalCB->setChecked(win->set().readEntry("Security/PasswordGenerator") =="EXTERNAL");
-    m_externalEdit->setContent(win->set().readEntry("Security/PasswordGenAdditional"));
-    m_dictionaryEdit->setContent(win->set().readEntry("Security/DictionaryFile"));
+    m_lengthSpinner->setValue(win->set().readNumEntry(Settings::SecurityLength));
+    m_allowedCharsEdit->setText(win->set().readEntry(Settings::SecurityAllowedCharacters));
+    m_weakSlider->setValue(int(win->set().readDoubleEntry(Settings::SecurityWeakPasswordLimit)*2));
+    m_strongSlider->setValue(
+        int(win->set().readDoubleEntry(Settings::SecurityStrongPasswordLimit)*2));
+    m_useExternalCB->setChecked(
+        win->set().readEntry(Settings::SecurityPasswordGenerator) == "EXTERNAL");
+    m_externalEdit->setContent(win->set().readEntry(Settings::SecurityPasswordGenAdditional));
+    m_dictionaryEdit->setContent(win->set().readEntry(Settings::SecurityDictionaryFile));
+    m_breachCorpusEdit->setContent(win->set().readEntry(Settings::SecurityBreachCorpus));
+    m_checkerCombo->setCurrentItem(
+        win->set().readEntry(Settings::SecurityPasswordChecker) ==
+            PasswordCheckerFactory::PATTERN_CHECKER_STRING ? 1 : 0);
 
     checkboxHandler(m_useExternalCB->isChecked());
     weakSliderHandler(m_weakSlider->value());
@@ -429,13 +466,17 @@ void ConfDlgPasswordTab::applySettings()
     QString passGen = m_useExternalCB->isChecked() ? "EXTERNAL" : "RANDOM";
     QpamatWindow *win = Qpamat::instance()->getWindow();
 
-    win->set().writeEntry("Security/PasswordGenerator", passGen);
-    win->set().writeEntry("Security/PasswordGenAdditional", m_externalEdit->getContent());
-    win->set().writeEntry("Security/WeakPasswordLimit", m_weakSlider->value()/2.0);
-    win->set().writeEntry("Security/StrongPasswordLimit", m_strongSlider->value()/2.0);
-    win->set().writeEntry("Security/Length", m_lengthSpinner->value());
-    win->set().writeEntry("Security/AllowedCharacters", m_allowedCharsEdit->text());
-    win->set().writeEntry("Security/DictionaryFile", m_dictionaryEdit->getContent());
+    win->set().writeEntry(Settings::SecurityPasswordGenerator, passGen);
+    win->set().writeEntry(Settings::SecurityPasswordGenAdditional, m_externalEdit->getContent());
+    win->set().writeEntry(Settings::SecurityWeakPasswordLimit, m_weakSlider->value()/2.0);
+    win->set().writeEntry(Settings::SecurityStrongPasswordLimit, m_strongSlider->value()/2.0);
+    win->set().writeEntry(Settings::SecurityLength, m_lengthSpinner->value());
+    win->set().writeEntry(Settings::SecurityAllowedCharacters, m_allowedCharsEdit->text());
+    win->set().writeEntry(Settings::SecurityDictionaryFile, m_dictionaryEdit->getContent());
+    win->set().writeEntry(Settings::SecurityBreachCorpus, m_breachCorpusEdit->getContent());
+    win->set().writeEntry(Settings::SecurityPasswordChecker, m_checkerCombo->currentItem() == 1
+        ? PasswordCheckerFactory::PATTERN_CHECKER_STRING
+        : PasswordCheckerFactory::HYBRID_CHECKER_STRING);
 }
 
 
@@ -559,6 +600,7 @@ const int ConfDlgSecurityTab::m_minuteMap[] = {
 ConfDlgSecurityTab::ConfDlgSecurityTab(QWidget* parent, const char* name)
     : ListBoxDialogPage(parent, name)
     , m_algorithmCombo(0)
+    , m_lazyDecryptionCheckbox(0)
 {
     createAndLayout();
 }
@@ -571,15 +613,17 @@ void ConfDlgSecurityTab::createAndLayout()
 {
     // create layouts
     QVBoxLayout* mainLayout = new QVBoxLayout(this, 0, 6);
-    Q3GroupBox* encryptionGroup = new Q3GroupBox(1, Qt::Vertical, tr("Encryption"), this);
+    Q3GroupBox* encryptionGroup = new Q3GroupBox(2, Qt::Horizontal, tr("Encryption"), this);
     Q3GroupBox* logoutGroup = new Q3GroupBox(1, Qt::Vertical, tr("Logout"), this);
 
     // algorithm stuff
     m_algorithmLabel = new QLabel(tr("Cipher &algorithm:"), encryptionGroup);
     m_algorithmCombo = new QComboBox(false, encryptionGroup);
+    m_lazyDecryptionCheckbox = new QCheckBox(tr("&Decrypt passwords only when they are used"),
+        encryptionGroup);
 
     // logout
-    m_logoutLabel = new QLabel(tr("Auto &logout after inactivity:"), logoutGroup);
+    m_logoutLabel = new QLabel(tr("Auto &lock after inactivity:"), logoutGroup);
     m_logoutCombo = new QComboBox(false, logoutGroup);
 
     // buddys
@@ -603,7 +647,9 @@ void ConfDlgSecurityTab::fillSettings()
     QpamatWindow *win = Qpamat::instance()->getWindow();
 
     m_algorithmCombo->insertStringList(SymmetricEncryptor::getAlgorithms());
-    m_algorithmCombo->setCurrentText( win->set().readEntry( "Security/CipherAlgorithm" ));
+    m_algorithmCombo->setCurrentText( win->set().readEntry(Settings::SecurityCipherAlgorithm));
+    m_lazyDecryptionCheckbox->setChecked(
+        win->set().readBoolEntry(Settings::SecurityLazyDecryption));
 
     // Combo box
     m_logoutCombo->insertItem(tr("Disabled"));
@@ -612,7 +658,7 @@ void ConfDlgSecurityTab::fillSettings()
     m_logoutCombo->insertItem(tr("1 hour"));
     m_logoutCombo->insertItem(tr("2 hours"));
 
-    int logout = win->set().readNumEntry( "Security/AutoLogout" );
+    int logout = win->set().readNumEntry(Settings::SecurityAutoLogout);
     int size = sizeof(ConfDlgSecurityTab::m_minuteMap)/sizeof(int);
     const int* val = qFind(
         ConfDlgSecurityTab::m_minuteMap,
@@ -630,9 +676,10 @@ void ConfDlgSecurityTab::fillSettings()
 void ConfDlgSecurityTab::applySettings()
 {
     QpamatWindow *win = Qpamat::instance()->getWindow();
-    int min = ConfDlgSecurityTab::m_minuteMap[m_algorithmCombo->currentItem()];
-    win->set().writeEntry("Security/CipherAlgorithm", m_algorithmCombo->currentText() );
-    win->set().writeEntry("Security/AutoLogout", min);
+    int min = ConfDlgSecurityTab::m_minuteMap[m_logoutCombo->currentItem()];
+    win->set().writeEntry(Settings::SecurityCipherAlgorithm, m_algorithmCombo->currentText() );
+    win->set().writeEntry(Settings::SecurityAutoLogout, min);
+    win->set().writeEntry(Settings::SecurityLazyDecryption, m_lazyDecryptionCheckbox->isChecked());
 }
 
 
@@ -720,14 +767,14 @@ void ConfDlgPresentationTab::fillSettings()
 {
     QFont font;
     QpamatWindow *win = Qpamat::instance()->getWindow();
-    font.fromString(win->set().readEntry( "Presentation/NormalFont"));
+    font.fromString(win->set().readEntry(Settings::PresentationNormalFont));
     m_normalFontEdit->setFont(font);
-    font.fromString(win->set().readEntry( "Presentation/FooterFont"));
+    font.fromString(win->set().readEntry(Settings::PresentationFooterFont));
     m_footerFontEdit->setFont(font);
-    m_hidePasswordCB->setChecked(win->set().readBoolEntry("Presentation/HideRandomPass"));
-    m_nograbCB->setChecked(win->set().readBoolEntry("Password/NoGrabbing"));
-    m_systrayCB->setChecked(win->set().readBoolEntry("Presentation/SystemTrayIcon"));
-    m_hiddenCB->setChecked(win->set().readBoolEntry("Presentation/StartHidden"));
+    m_hidePasswordCB->setChecked(win->set().readBoolEntry(Settings::PresentationHideRandomPass));
+    m_nograbCB->setChecked(win->set().readBoolEntry(Settings::PasswordNoGrabbing));
+    m_systrayCB->setChecked(win->set().readBoolEntry(Settings::PresentationSystemTrayIcon));
+    m_hiddenCB->setChecked(win->set().readBoolEntry(Settings::PresentationStartHidden));
     m_hiddenCB->setEnabled(m_systrayCB->isChecked());
 }
 
@@ -741,12 +788,12 @@ void ConfDlgPresentationTab::applySettings()
 {
     QpamatWindow *win = Qpamat::instance()->getWindow();
 
-    win->set().writeEntry("Presentation/HideRandomPass", m_hidePasswordCB->isChecked());
-    win->set().writeEntry("Password/NoGrabbing", m_nograbCB->isChecked());
-    win->set().writeEntry("Presentation/NormalFont", m_normalFontEdit->getFont().toString());
-    win->set().writeEntry("Presentation/FooterFont", m_footerFontEdit->getFont().toString());
-    win->set().writeEntry("Presentation/SystemTrayIcon", m_systrayCB->isChecked());
-    win->set().writeEntry("Presentation/StartHidden", m_hiddenCB->isChecked());
+    win->set().writeEntry(Settings::PresentationHideRandomPass, m_hidePasswordCB->isChecked());
+    win->set().writeEntry(Settings::PasswordNoGrabbing, m_nograbCB->isChecked());
+    win->set().writeEntry(Settings::PresentationNormalFont, m_normalFontEdit->getFont().toString());
+    win->set().writeEntry(Settings::PresentationFooterFont, m_footerFontEdit->getFont().toString());
+    win->set().writeEntry(Settings::PresentationSystemTrayIcon, m_systrayCB->isChecked());
+    win->set().writeEntry(Settings::PresentationStartHidden, m_hiddenCB->isChecked());
 }
 
 
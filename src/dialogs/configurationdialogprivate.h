@@ -50,6 +50,7 @@ class ConfDlgGeneralTab : public ListBoxDialogPage
     private:
         QCheckBox*      m_autoLoginCheckbox;
         FileLineEdit*   m_datafileEdit;
+        QSpinBox*       m_autoSaveSpinner;
         QLineEdit*      m_miscEdit;
         QLineEdit*      m_usernameEdit;
         QLineEdit*      m_passwordEdit;
@@ -89,11 +90,13 @@ class ConfDlgPasswordTab : public ListBoxDialogPage
         QLineEdit*      m_allowedCharsEdit;
         QCheckBox*      m_useExternalCB;
         // checker
+        QComboBox*      m_checkerCombo;
         QSlider*        m_weakSlider;
         QSlider*        m_strongSlider;
         QLCDNumber*     m_weakLabel;
         QLCDNumber*     m_strongLabel;
         FileLineEdit*   m_dictionaryEdit;
+        FileLineEdit*   m_breachCorpusEdit;
         QPushButton*    m_sortButton;
 };
 
@@ -125,6 +128,8 @@ class ConfDlgSecurityTab : public ListBoxDialogPage
         // logout
         QComboBox*      m_logoutCombo;
         QLabel*         m_logoutLabel;
+        // decryption
+        QCheckBox*      m_lazyDecryptionCheckbox;
 };
 
 
@@ -28,8 +28,10 @@
 #include "newpassworddialog.h"
 #include "qpamatwindow.h"
 #include "security/masterpasswordchecker.h"
+#include "strengthevaluator.h"
 #include "settings.h"
 #include "qpamat.h"
+#include "util/stringdisplay.h"
 
 /**
  * @class NewPasswordDialog
@@ -45,6 +47,9 @@
  * dictionary at this time and because here the user cannot use a random
  * password but must memorize the password.
  *
+ * The strength of the first password is shown while the user types it. It's computed by a
+ * StrengthEvaluator, so the final check when Ok is pressed should not be a surprise.
+ *
  * @ingroup dialogs
  * @author Bernhard Walle
  */
@@ -60,6 +65,7 @@
 NewPasswordDialog::NewPasswordDialog(QWidget* parent, const QString& oldPassword)
     : QDialog(parent)
     , m_oldPassword(oldPassword)
+    , m_strengthEvaluator(new StrengthEvaluator(this))
 {
     setCaption("QPaMaT");
 
@@ -70,14 +76,19 @@ NewPasswordDialog::NewPasswordDialog(QWidget* parent, const QString& oldPassword
     m_firstPasswordEdit->setValidator(validator);
     m_secondPasswordEdit->setValidator(validator);
 
+    // strength meter
+    m_strengthEvaluator->setChecker(new MasterPasswordChecker);
+
     // communication
     connect(m_okButton, SIGNAL(clicked()), SLOT(accept()));
     connect(m_cancelButton, SIGNAL(clicked()), SLOT(reject()));
     connect(m_firstPasswordEdit, SIGNAL(textChanged(const QString&)), SLOT(checkOkEnabled()));
     connect(m_secondPasswordEdit, SIGNAL(textChanged(const QString&)), SLOT(checkOkEnabled()));
+    connect(m_firstPasswordEdit, SIGNAL(textChanged(const QString&)), SLOT(evaluateStrength()));
+    connect(m_strengthEvaluator, SIGNAL(evaluated(double)), SLOT(showStrength(double)));
 
     QpamatWindow *win = Qpamat::instance()->getWindow();
-    if (!win->set().readBoolEntry("Password/NoGrabbing")) {
+    if (!win->set().readBoolEntry(Settings::PasswordNoGrabbing)) {
         if (!m_oldPassword.isNull()) {
             connect(m_oldPasswordEdit, SIGNAL(gotFocus()), SLOT(grabOldPassword()));
             connect(m_oldPasswordEdit, SIGNAL(lostFocus()), SLOT(release()));
@@ -129,6 +140,8 @@ void NewPasswordDialog::createAndLayout()
     first->setBuddy(m_firstPasswordEdit);
     QLabel* second = new QLabel(tr("&Verification:"), this);
     second->setBuddy(m_secondPasswordEdit);
+    QLabel* strength = new QLabel(tr("Strength:"), this);
+    m_strengthLabel = new QLabel(this);
 
 
     // buttons
@@ -156,6 +169,8 @@ void NewPasswordDialog::createAndLayout()
     textfields->addWidget(m_firstPasswordEdit, i+0, 1);
     textfields->addWidget(second, i+1, 0);
     textfields->addWidget(m_secondPasswordEdit, i+1, 1);
+    textfields->addWidget(strength, i+2, 0);
+    textfields->addWidget(m_strengthLabel, i+2, 1);
 
     layout->addWidget(label);
     layout->addLayout(textfields);
@@ -197,7 +212,7 @@ void NewPasswordDialog::accept()
     try {
         QpamatWindow *win = Qpamat::instance()->getWindow();
         double quality = checker.passwordQuality(password);
-        ok = quality > win->set().readDoubleEntry("Security/StrongPasswordLimit");
+        ok = quality > win->set().readDoubleEntry(Settings::SecurityStrongPasswordLimit);
     } catch (const std::exception& exc) {
         QMessageBox::warning(this, "QPaMaT",
             ("<qt>"+tr("An error occurred while checking the password:<br>%1")+"</qt>").
@@ -268,6 +283,48 @@ void NewPasswordDialog::release()
 }
 
 
+/**
+ * @brief Checks the first password in the background.
+ *
+ * This slot is called always if the users changes the first password.
+ */
+void NewPasswordDialog::evaluateStrength()
+{
+    if (m_firstPasswordEdit->text().isEmpty()) {
+        m_strengthEvaluator->cancel();
+        m_strengthLabel->clear();
+    } else
+        m_strengthEvaluator->evaluate(m_firstPasswordEdit->text());
+}
+
+
+/**
+ * @brief Shows the strength of the first password.
+ *
+ * Only passwords that are rated as strong are accepted, see accept().
+ *
+ * @param days the days to crack the first password
+ */
+void NewPasswordDialog::showStrength(double days)
+{
+    QpamatWindow *win = Qpamat::instance()->getWindow();
+    QString image, text;
+    if (days < win->set().readDoubleEntry(Settings::SecurityWeakPasswordLimit)) {
+        image = ":/images/traffic_red_16.png";
+        text = tr("too simple");
+    } else if (days <= win->set().readDoubleEntry(Settings::SecurityStrongPasswordLimit)) {
+        image = ":/images/traffic_yellow_16.png";
+        text = tr("still too simple");
+    } else {
+        image = ":/images/traffic_green_16.png";
+        text = tr("good");
+    }
+
+    m_strengthLabel->setText(QString("<qt><nobr><img src=\"%1\"> %2 (%3)</nobr></qt>")
+        .arg(image, text, tr("crack time: %1").arg(StringDisplay::displayTimeSuitable(days))));
+}
+
+
 /**
  * @brief Returns the (new) password the user has entered.
  *
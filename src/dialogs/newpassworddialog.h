@@ -20,6 +20,9 @@
 
 #include "widgets/focuslineedit.h"
 
+class QLabel;
+class StrengthEvaluator;
+
 class NewPasswordDialog : public QDialog
 {
     Q_OBJECT
@@ -37,6 +40,8 @@ class NewPasswordDialog : public QDialog
         void grabFirstPassword();
         void grabSecondPassword();
         void release();
+        void evaluateStrength();
+        void showStrength(double days);
 
     private:
         void createAndLayout();
@@ -48,6 +53,8 @@ class NewPasswordDialog : public QDialog
         FocusLineEdit*  m_firstPasswordEdit;
         FocusLineEdit*  m_secondPasswordEdit;
         FocusLineEdit*  m_oldPasswordEdit;
+        QLabel*         m_strengthLabel;
+        StrengthEvaluator* m_strengthEvaluator;
 };
 
 #endif // NEWPASSWORDDIALOG_H
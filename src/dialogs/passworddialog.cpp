@@ -76,7 +76,7 @@ PasswordDialog::PasswordDialog(QWidget* parent, const char* name)
     connect(dialogButtons, SIGNAL(rejected()), SLOT(reject()));
 
     QpamatWindow *win = Qpamat::instance()->getWindow();
-    if (!win->set().readBoolEntry("Password/NoGrabbing")) {
+    if (!win->set().readBoolEntry(Settings::PasswordNoGrabbing)) {
         connect(m_passwordEdit, SIGNAL(gotFocus()), SLOT(grab()));
         connect(m_passwordEdit, SIGNAL(lostFocus()), SLOT(release()));
     }
@@ -85,7 +85,8 @@ ShowPasswordDialog::ShowPasswordDialog(QWidget* parent, DialogType type, const c
     QLabel* label = new QLabel(labelText, this);
 
     QpamatWindow *win = Qpamat::instance()->getWindow();
-    m_passwordEdit = new CopyLabel(win->set().readBoolEntry("Presentation/HideRandomPass"), this);
+    m_passwordEdit = new CopyLabel(
+        win->set().readBoolEntry(Settings::PresentationHideRandomPass), this);
     m_passwordEdit->setMinimumWidth(250);
     m_passwordEdit->setFocusPolicy(Qt::NoFocus);
 
@@ -0,0 +1,323 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#include <QObject>
+#include <QIODevice>
+
+#include "datareadwriter.h"
+#include "import/csvimporter.h"
+
+/**
+ * @class CsvImporter
+ *
+ * @brief Reads CSV files (RFC 4180) as they are written by most password managers.
+ *
+ * The first row must contain the names of the columns. Well-known names are recognised
+ * case-insensitively, for example <tt>Group</tt>, <tt>Folder</tt> or <tt>Category</tt> for
+ * the category, <tt>Title</tt> or <tt>Name</tt> for the name of the entry, and
+ * <tt>Username</tt>, <tt>Password</tt>, <tt>URL</tt> and <tt>Notes</tt>. Each row is one
+ * entry. The other columns become properties with the column name as key. Subcategories
+ * are separated with a slash.
+ *
+ * If the file has the columns <tt>Key</tt> and <tt>Value</tt> like the CSV export of
+ * TreeExporter, each row is one property and consecutive rows with the same category and
+ * name form one entry.
+ *
+ * The file is read row by row, only one row (and one row ahead for the property rows) is
+ * kept in memory.
+ *
+ * @ingroup import
+ * @author Bernhard Walle
+ */
+
+/**
+ * @brief Creates a new CsvImporter.
+ */
+CsvImporter::CsvImporter()
+    : m_propertyRows(false)
+    , m_line(0)
+{}
+
+
+/**
+ * @copydoc Importer::fileFilter()
+ */
+QString CsvImporter::fileFilter() const
+{
+    return QObject::tr("CSV files (*.csv)");
+}
+
+
+/**
+ * @copydoc Importer::open()
+ */
+void CsvImporter::open(QIODevice* device)
+{
+    m_stream.setDevice(device);
+    m_stream.setCodec("UTF-8");
+    m_line = 0;
+    m_pendingRow.clear();
+
+    if (!readRow(m_header))
+        throw ReadWriteException(QObject::tr("The CSV file is empty."),
+            ReadWriteException::CInvalidData);
+
+    m_columns.clear();
+    m_columnIndex.fill(-1, ColumnOther);
+    for (int i = 0; i < m_header.size(); ++i) {
+        Column column = columnFromHeader(m_header[i]);
+        m_columns.append(column);
+        if (column != ColumnOther && m_columnIndex[column] < 0)
+            m_columnIndex[column] = i;
+    }
+
+    m_propertyRows = m_columnIndex[ColumnKey] >= 0 && m_columnIndex[ColumnValue] >= 0;
+    if (!m_propertyRows && m_columnIndex[ColumnName] < 0 && m_columnIndex[ColumnPassword] < 0)
+        throw ReadWriteException(QObject::tr("The first row of the CSV file must contain the "
+            "column names, at least the name or the password."),
+            ReadWriteException::CInvalidData);
+}
+
+
+/**
+ * @copydoc Importer::readRecord()
+ */
+bool CsvImporter::readRecord(ImportRecord& record)
+{
+    record.clear();
+
+    if (m_propertyRows)
+        return readPropertyRows(record);
+
+    QStringList fields;
+    if (!readRow(fields))
+        return false;
+
+    fillRecord(fields, record);
+    return true;
+}
+
+
+/**
+ * @brief Reads one row, empty lines are skipped.
+ *
+ * A quoted field may contain line breaks, then the row spans several lines.
+ *
+ * @param fields the fields of the row
+ * @return @c true on success, @c false at the end of the file
+ * @exception ReadWriteException if a quoted field is not terminated
+ */
+bool CsvImporter::readRow(QStringList& fields)
+{
+    QString line;
+    do {
+        line = m_stream.readLine();
+        if (line.isNull())
+            return false;
+        m_line++;
+    } while (line.isEmpty());
+
+    fields.clear();
+    QString current;
+    bool quoted = false;
+
+    for (;;) {
+        const int length = line.length();
+        for (int i = 0; i < length; ++i) {
+            const QChar c = line[i];
+            if (quoted) {
+                if (c != '"')
+                    current += c;
+                else if (i + 1 < length && line[i + 1] == '"') {
+                    current += c;
+                    ++i;
+                } else
+                    quoted = false;
+            } else if (c == ',') {
+                fields << current;
+                current.clear();
+            } else if (c == '"' && current.isEmpty())
+                quoted = true;
+            else
+                current += c;
+        }
+
+        if (!quoted)
+            break;
+
+        // a line break in a quoted field
+        line = m_stream.readLine();
+        if (line.isNull())
+            throw ReadWriteException(QObject::tr("Line %1 of the CSV file: a quoted field "
+                "is not terminated.").arg(m_line), ReadWriteException::CInvalidData);
+        m_line++;
+        current += '\n';
+    }
+
+    fields << current;
+    return true;
+}
+
+
+/**
+ * @brief Reads the rows of one entry if each row is one property.
+ *
+ * @param record the record
+ * @return @c true if an entry has been read, @c false at the end of the file
+ */
+bool CsvImporter::readPropertyRows(ImportRecord& record)
+{
+    QStringList row;
+    if (!m_pendingRow.isEmpty()) {
+        row = m_pendingRow;
+        m_pendingRow.clear();
+    } else if (!readRow(row))
+        return false;
+
+    const QString category = field(row, ColumnCategory);
+    record.category = splitCategory(category);
+    record.name = field(row, ColumnName);
+
+    do {
+        const QString key = field(row, ColumnKey);
+        const QString value = field(row, ColumnValue);
+        if (!key.isEmpty() || !value.isEmpty())
+            record.addProperty(key, value, Property::typeFromString(field(row, ColumnType)));
+
+        if (!readRow(row))
+            break;
+        if (field(row, ColumnCategory) != category || field(row, ColumnName) != record.name) {
+            m_pendingRow = row;
+            break;
+        }
+    } while (true);
+
+    if (record.name.isEmpty())
+        record.name = QObject::tr("Unnamed");
+
+    return true;
+}
+
+
+/**
+ * @brief Fills @p record from a row that contains one entry.
+ *
+ * @param fields the row
+ * @param record the record
+ */
+void CsvImporter::fillRecord(const QStringList& fields, ImportRecord& record) const
+{
+    record.category = splitCategory(field(fields, ColumnCategory));
+    record.name = field(fields, ColumnName);
+
+    for (int i = 0; i < m_columns.size() && i < fields.size(); ++i) {
+        const QString& value = fields[i];
+        if (value.isEmpty())
+            continue;
+
+        switch (m_columns[i]) {
+            case ColumnUsername:
+                record.addProperty(QObject::tr("Username"), value, Property::USERNAME);
+                break;
+            case ColumnPassword:
+                record.addProperty(QObject::tr("Password"), value, Property::PASSWORD);
+                break;
+            case ColumnUrl:
+                record.addProperty(QObject::tr("URL"), value, Property::URL);
+                break;
+            case ColumnNotes:
+                record.addProperty(QObject::tr("Notes"), value);
+                break;
+            case ColumnOther:
+                record.addProperty(m_header[i], value);
+                break;
+            default:
+                break;
+        }
+    }
+
+    if (record.name.isEmpty())
+        record.name = field(fields, ColumnUrl);
+    if (record.name.isEmpty())
+        record.name = QObject::tr("Unnamed");
+}
+
+
+/**
+ * @brief Returns the field of a column.
+ *
+ * @param fields the row
+ * @param column the column
+ * @return the field of the first column of that kind or an empty string
+ */
+QString CsvImporter::field(const QStringList& fields, Column column) const
+{
+    const int index = m_columnIndex[column];
+    return index >= 0 ? fields.value(index) : QString("");
+}
+
+
+/**
+ * @brief Recognises the name of a column.
+ *
+ * @param header the name in the first row
+ * @return the kind of the column
+ */
+CsvImporter::Column CsvImporter::columnFromHeader(const QString& header)
+{
+    const QString name = header.trimmed().toLower();
+
+    if (name == "category" || name == "group" || name == "folder" || name == "grouping" ||
+            name == "path")
+        return ColumnCategory;
+    else if (name == "entry" || name == "name" || name == "title" || name == "account")
+        return ColumnName;
+    else if (name == "username" || name == "user name" || name == "user" || name == "login" ||
+            name == "login_username")
+        return ColumnUsername;
+    else if (name == "password" || name == "login_password")
+        return ColumnPassword;
+    else if (name == "url" || name == "website" || name == "web site" || name == "uri" ||
+            name == "login_uri")
+        return ColumnUrl;
+    else if (name == "notes" || name == "note" || name == "comment" || name == "comments" ||
+            name == "extra")
+        return ColumnNotes;
+    else if (name == "key")
+        return ColumnKey;
+    else if (name == "value")
+        return ColumnValue;
+    else if (name == "type")
+        return ColumnType;
+    else
+        return ColumnOther;
+}
+
+
+/**
+ * @brief Splits the category path at the slashes.
+ *
+ * @param category the path
+ * @return the names of the categories
+ */
+QStringList CsvImporter::splitCategory(const QString& category)
+{
+    QStringList names = category.split('/', QString::SkipEmptyParts);
+    for (QStringList::iterator it = names.begin(); it != names.end(); ++it)
+        *it = it->trimmed();
+    names.removeAll(QString(""));
+    return names;
+}
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
@@ -0,0 +1,68 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#ifndef CSVIMPORTER_H
+#define CSVIMPORTER_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QTextStream>
+
+#include "import/importer.h"
+
+class CsvImporter : public Importer
+{
+    public:
+        CsvImporter();
+
+        QString fileFilter() const;
+        void open(QIODevice* device);
+        bool readRecord(ImportRecord& record);
+
+    private:
+        enum Column {
+            ColumnCategory,
+            ColumnName,
+            ColumnUsername,
+            ColumnPassword,
+            ColumnUrl,
+            ColumnNotes,
+            ColumnKey,
+            ColumnValue,
+            ColumnType,
+            ColumnOther
+        };
+
+    private:
+        bool readRow(QStringList& fields);
+        bool readPropertyRows(ImportRecord& record);
+        void fillRecord(const QStringList& fields, ImportRecord& record) const;
+        QString field(const QStringList& fields, Column column) const;
+        static Column columnFromHeader(const QString& header);
+        static QStringList splitCategory(const QString& category);
+
+    private:
+        QTextStream     m_stream;
+        QStringList     m_header;
+        QVector<Column> m_columns;
+        QVector<int>    m_columnIndex;
+        bool            m_propertyRows;
+        QStringList     m_pendingRow;
+        int             m_line;
+};
+
+#endif // CSVIMPORTER_H
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
@@ -0,0 +1,242 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#include "import/importer.h"
+#include "import/csvimporter.h"
+#include "import/keepassimporter.h"
+
+/**
+ * @struct ImportProperty
+ *
+ * @brief One property of an ImportRecord.
+ *
+ * @ingroup import
+ * @author Bernhard Walle
+ */
+
+/**
+ * @struct ImportRecord
+ *
+ * @brief One entry read by an Importer.
+ *
+ * The record is reused for all entries of a file, so the importer doesn't allocate a new
+ * one for each entry.
+ *
+ * @ingroup import
+ * @author Bernhard Walle
+ */
+
+/**
+ * @brief Removes the category, the name and the properties.
+ */
+void ImportRecord::clear()
+{
+    category.clear();
+    name = QString();
+    properties.clear();
+}
+
+
+/**
+ * @brief Appends a property.
+ *
+ * Passwords are hidden and encrypted like the passwords that are entered in the GUI.
+ *
+ * @param key the key of the property
+ * @param value the value
+ * @param type the type
+ */
+void ImportRecord::addProperty(const QString& key, const QString& value, Property::Type type)
+{
+    ImportProperty property;
+    property.key = key;
+    property.value = value;
+    property.type = type;
+    properties.append(property);
+}
+
+
+/**
+ * @brief Returns the value of the first Property::USERNAME property.
+ *
+ * @return the user name or an empty string
+ */
+QString ImportRecord::username() const
+{
+    for (QList<ImportProperty>::const_iterator it = properties.begin();
+            it != properties.end(); ++it) {
+        if (it->type == Property::USERNAME)
+            return it->value;
+    }
+
+    return QString("");
+}
+
+
+/**
+ * @class Importer
+ *
+ * @brief Interface for the readers of other file formats.
+ *
+ * An importer reads one record after the other with readRecord(), so the file is never
+ * kept in memory. TreeImporter creates the entries from the records. New formats are added
+ * with ImporterFactory::registerImporter().
+ *
+ * @ingroup import
+ * @author Bernhard Walle
+ */
+
+/**
+ * @fn Importer::fileFilter()
+ *
+ * @brief Returns the filter for the file dialog, for example <tt>CSV files (*.csv)</tt>.
+ *
+ * @return the translated filter
+ */
+
+/**
+ * @fn Importer::open(QIODevice*)
+ *
+ * @brief Starts reading from @p device.
+ *
+ * @param device the device which must be open for reading and must be valid until the
+ *        importer is deleted
+ * @exception ReadWriteException if the header of the file is invalid
+ */
+
+/**
+ * @fn Importer::readRecord(ImportRecord&)
+ *
+ * @brief Reads the next entry.
+ *
+ * @param record the record which is overwritten
+ * @return @c true if an entry has been read, @c false at the end of the file
+ * @exception ReadWriteException if the file is invalid
+ */
+
+/**
+ * @brief Creates a CsvImporter.
+ *
+ * @return the new importer
+ */
+static Importer* createCsvImporter()
+{
+    return new CsvImporter;
+}
+
+
+/**
+ * @brief Creates a KeePassImporter.
+ *
+ * @return the new importer
+ */
+static Importer* createKeePassImporter()
+{
+    return new KeePassImporter;
+}
+
+
+/**
+ * @class ImporterFactory
+ *
+ * @brief Factory for the importers.
+ *
+ * QPaMaT provides following importers:
+ *
+ *   - @c CSV: CsvImporter
+ *   - @c KEEPASS2: KeePassImporter
+ *
+ * Other importers can be registered with registerImporter().
+ *
+ * @ingroup import
+ * @author Bernhard Walle
+ */
+
+/**
+ * @brief Registers an importer.
+ *
+ * An importer with the same name is replaced.
+ *
+ * @param name the name, used in create()
+ * @param creator the function which creates a new importer
+ */
+void ImporterFactory::registerImporter(const QString& name, Creator creator)
+{
+    QList<Registration>& list = registrations();
+    for (QList<Registration>::iterator it = list.begin(); it != list.end(); ++it) {
+        if (it->name == name) {
+            it->creator = creator;
+            return;
+        }
+    }
+
+    Registration registration;
+    registration.name = name;
+    registration.creator = creator;
+    list.append(registration);
+}
+
+
+/**
+ * @brief Returns the names of the importers in the order of registration.
+ *
+ * @return the names
+ */
+QStringList ImporterFactory::names()
+{
+    QStringList result;
+    const QList<Registration>& list = registrations();
+    for (QList<Registration>::const_iterator it = list.begin(); it != list.end(); ++it)
+        result << it->name;
+    return result;
+}
+
+
+/**
+ * @brief Creates an importer.
+ *
+ * @param name the name of the importer, see names()
+ * @return the new importer which must be deleted by the caller, or @c 0 if there's no
+ *         importer with that name
+ */
+Importer* ImporterFactory::create(const QString& name)
+{
+    const QList<Registration>& list = registrations();
+    for (QList<Registration>::const_iterator it = list.begin(); it != list.end(); ++it) {
+        if (it->name == name)
+            return it->creator();
+    }
+
+    return 0;
+}
+
+
+/**
+ * @brief Returns the registered importers, the built-in ones are registered on first use.
+ *
+ * @return the list
+ */
+QList<ImporterFactory::Registration>& ImporterFactory::registrations()
+{
+    static QList<Registration> list;
+    if (list.isEmpty()) {
+        Registration csv = { "CSV", createCsvImporter };
+        Registration keePass = { "KEEPASS2", createKeePassImporter };
+        list << csv << keePass;
+    }
+
+    return list;
+}
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
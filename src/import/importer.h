@@ -0,0 +1,76 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#ifndef IMPORTER_H
+#define IMPORTER_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+
+#include "property.h"
+
+class QIODevice;
+
+struct ImportProperty
+{
+    QString         key;
+    QString         value;
+    Property::Type  type;
+};
+
+struct ImportRecord
+{
+    QStringList             category;
+    QString                 name;
+    QList<ImportProperty>   properties;
+
+    void clear();
+    void addProperty(const QString& key, const QString& value,
+        Property::Type type = Property::MISC);
+    QString username() const;
+};
+
+class Importer
+{
+    public:
+        virtual ~Importer() {}
+
+        virtual QString fileFilter() const = 0;
+        virtual void open(QIODevice* device) = 0;
+        virtual bool readRecord(ImportRecord& record) = 0;
+};
+
+class ImporterFactory
+{
+    public:
+        typedef Importer* (*Creator)();
+
+    public:
+        static void registerImporter(const QString& name, Creator creator);
+        static QStringList names();
+        static Importer* create(const QString& name);
+
+    private:
+        struct Registration {
+            QString name;
+            Creator creator;
+        };
+
+        static QList<Registration>& registrations();
+};
+
+#endif // IMPORTER_H
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
@@ -0,0 +1,221 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#include <QObject>
+#include <QIODevice>
+
+#include "datareadwriter.h"
+#include "import/keepassimporter.h"
+
+/**
+ * @class KeePassImporter
+ *
+ * @brief Reads the XML export of KeePass 2 and KeePassXC.
+ *
+ * The groups become categories, the top-level group (the database) is omitted. The
+ * strings <tt>UserName</tt>, <tt>Password</tt>, <tt>URL</tt> and <tt>Notes</tt> are mapped
+ * to the properties of QPaMaT, other strings are imported with their key. The history, the
+ * attachments and the recycle bin are skipped.
+ *
+ * The file is parsed with QXmlStreamReader, so it is never kept in memory.
+ *
+ * @ingroup import
+ * @author Bernhard Walle
+ */
+
+/**
+ * @brief Creates a new KeePassImporter.
+ */
+KeePassImporter::KeePassImporter()
+{}
+
+
+/**
+ * @copydoc Importer::fileFilter()
+ */
+QString KeePassImporter::fileFilter() const
+{
+    return QObject::tr("KeePass 2 XML files (*.xml)");
+}
+
+
+/**
+ * @copydoc Importer::open()
+ */
+void KeePassImporter::open(QIODevice* device)
+{
+    m_reader.setDevice(device);
+    m_groups.clear();
+    m_recycleBin.clear();
+
+    if (!m_reader.readNextStartElement()) {
+        if (m_reader.hasError())
+            throwError();
+        throw ReadWriteException(QObject::tr("The file is empty."),
+            ReadWriteException::CInvalidData);
+    }
+
+    if (m_reader.name() != "KeePassFile")
+        throw ReadWriteException(QObject::tr("The file is not a KeePass 2 XML file."),
+            ReadWriteException::CInvalidData);
+}
+
+
+/**
+ * @copydoc Importer::readRecord()
+ */
+bool KeePassImporter::readRecord(ImportRecord& record)
+{
+    record.clear();
+
+    while (!m_reader.atEnd()) {
+        const QXmlStreamReader::TokenType token = m_reader.readNext();
+
+        if (token == QXmlStreamReader::EndElement && m_reader.name() == "Group" &&
+                !m_groups.isEmpty()) {
+            m_groups.removeLast();
+        } else if (token == QXmlStreamReader::StartElement) {
+            if (m_reader.name() == "Meta" || m_reader.name() == "Root") {
+                // read the children
+            } else if (m_reader.name() == "RecycleBinUUID") {
+                m_recycleBin = m_reader.readElementText();
+            } else if (m_reader.name() == "Group") {
+                Group group;
+                group.skipped = false;
+                m_groups.append(group);
+            } else if (m_reader.name() == "Entry" && !m_groups.isEmpty()) {
+                readEntry(record);
+                if (!isSkipped())
+                    return true;
+                record.clear();
+            } else if (!m_groups.isEmpty()) {
+                readGroupChild();
+            } else
+                m_reader.skipCurrentElement();
+        }
+    }
+
+    if (m_reader.hasError())
+        throwError();
+
+    return false;
+}
+
+
+/**
+ * @brief Reads the name and the UUID of the current group, skips the other children.
+ */
+void KeePassImporter::readGroupChild()
+{
+    Group& group = m_groups.last();
+
+    if (m_reader.name() == "Name")
+        group.name = m_reader.readElementText().trimmed();
+    else if (m_reader.name() == "UUID") {
+        const QString uuid = m_reader.readElementText();
+        if (!m_recycleBin.isEmpty() && uuid == m_recycleBin)
+            group.skipped = true;
+    } else
+        m_reader.skipCurrentElement();
+}
+
+
+/**
+ * @brief Reads the current \c Entry element.
+ *
+ * @param record the record
+ */
+void KeePassImporter::readEntry(ImportRecord& record)
+{
+    // the top-level group is the database itself
+    for (int i = 1; i < m_groups.size(); ++i) {
+        if (!m_groups[i].name.isEmpty())
+            record.category << m_groups[i].name;
+    }
+
+    while (m_reader.readNextStartElement()) {
+        if (m_reader.name() == "String")
+            readString(record);
+        else
+            m_reader.skipCurrentElement();
+    }
+
+    if (record.name.isEmpty())
+        record.name = QObject::tr("Unnamed");
+}
+
+
+/**
+ * @brief Reads one \c String element of an entry.
+ *
+ * @param record the record
+ */
+void KeePassImporter::readString(ImportRecord& record)
+{
+    QString key, value;
+    while (m_reader.readNextStartElement()) {
+        if (m_reader.name() == "Key")
+            key = m_reader.readElementText();
+        else if (m_reader.name() == "Value")
+            value = m_reader.readElementText();
+        else
+            m_reader.skipCurrentElement();
+    }
+
+    if (key == "Title")
+        record.name = value;
+    else if (value.isEmpty())
+        return;
+    else if (key == "UserName")
+        record.addProperty(QObject::tr("Username"), value, Property::USERNAME);
+    else if (key == "Password")
+        record.addProperty(QObject::tr("Password"), value, Property::PASSWORD);
+    else if (key == "URL")
+        record.addProperty(QObject::tr("URL"), value, Property::URL);
+    else if (key == "Notes")
+        record.addProperty(QObject::tr("Notes"), value);
+    else
+        record.addProperty(key, value);
+}
+
+
+/**
+ * @brief Checks if the current group is in the recycle bin.
+ *
+ * @return @c true if the entries of the current group are not imported
+ */
+bool KeePassImporter::isSkipped() const
+{
+    for (QList<Group>::const_iterator it = m_groups.begin(); it != m_groups.end(); ++it) {
+        if (it->skipped)
+            return true;
+    }
+
+    return false;
+}
+
+
+/**
+ * @brief Throws the error of the XML reader.
+ *
+ * @exception ReadWriteException always
+ */
+void KeePassImporter::throwError() const
+{
+    throw ReadWriteException(QObject::tr("Line %1 of the KeePass file: %2")
+        .arg(m_reader.lineNumber()).arg(m_reader.errorString()),
+        ReadWriteException::CInvalidData);
+}
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
@@ -0,0 +1,54 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#ifndef KEEPASSIMPORTER_H
+#define KEEPASSIMPORTER_H
+
+#include <QString>
+#include <QList>
+#include <QXmlStreamReader>
+
+#include "import/importer.h"
+
+class KeePassImporter : public Importer
+{
+    public:
+        KeePassImporter();
+
+        QString fileFilter() const;
+        void open(QIODevice* device);
+        bool readRecord(ImportRecord& record);
+
+    private:
+        struct Group {
+            QString name;
+            bool    skipped;
+        };
+
+    private:
+        void readGroupChild();
+        void readEntry(ImportRecord& record);
+        void readString(ImportRecord& record);
+        bool isSkipped() const;
+        void throwError() const;
+
+    private:
+        QXmlStreamReader    m_reader;
+        QList<Group>        m_groups;
+        QString             m_recycleBin;
+};
+
+#endif // KEEPASSIMPORTER_H
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
@@ -0,0 +1,315 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#include <QFile>
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QTextStream>
+#include <Q3ListView>
+#include <QDebug>
+
+#include "global.h"
+#include "journal.h"
+#include "journalfile.h"
+#include "datareadwriter.h"
+#include "tree.h"
+#include "treeentry.h"
+
+#define JOURNAL_MIN_COMPACT_SIZE    (64*1024)
+
+/**
+ * @class Journal
+ *
+ * @brief Append-only journal of the changes since the data file has been written.
+ *
+ * Saving the whole data file means encrypting all passwords and writing all data, even if
+ * only one property has been changed. Instead, QpamatWindow::save() appends only the
+ * entries that have been changed since the last save to the journal
+ * <tt><i>datafile</i>.journal</tt>.
+ *
+ * The first line of the journal contains a header that identifies the data file the
+ * journal belongs to (date and size). Each following line is one record, encrypted with
+ * the password of the data file and encoded in base64:
+ *
+ *  - <tt>\<upsert parent="id"\>\<entry .../\>\</upsert\></tt> sets an entry (or a category,
+ *    without its children) to the given state. The passwords inside are encrypted once more,
+ *    like in the data file.
+ *  - <tt>\<remove id="id"/\></tt> removes an entry with all children.
+ *
+ * Records are applied in order when the data file is read (see JournalFile::replay()). A
+ * record that cannot be decrypted or parsed (e.g. a line that has not been written
+ * completely) ends the replay. If the journal gets too large compared to the data file, or
+ * if the password or the algorithm has changed, the data file is written completely and the
+ * journal is deleted (compaction).
+ *
+ * Entries are identified by TreeEntry::getId(). Changes are detected with
+ * TreeEntry::getGeneration(), moves and deletions by comparing the parent of each entry
+ * with the state of the last save. The open and selection state of the entries is only
+ * written on compaction.
+ *
+ * @ingroup gui
+ * @author Bernhard Walle
+ */
+
+/**
+ * @brief Checks if there's an entry without ID below @p element.
+ *
+ * @param element the element
+ * @return @c true if an ID is missing, @c false otherwise
+ */
+static bool hasMissingIds(const QDomElement& element)
+{
+    for (QDomElement child = element.firstChildElement(); !child.isNull();
+            child = child.nextSiblingElement()) {
+        if (child.tagName() == "category" || child.tagName() == "entry") {
+            if (!child.hasAttribute("id") || hasMissingIds(child))
+                return true;
+        }
+    }
+
+    return false;
+}
+
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Creates a new Journal that is not attached to any data file.
+ */
+Journal::Journal()
+    : m_baseSize(0)
+    , m_journalSize(0)
+    , m_savedGeneration(0)
+    , m_compactionRequested(false)
+{}
+
+
+/**
+ * @brief Attaches the journal to a data file.
+ *
+ * Must be called after the data file has been read (including the journal) and after it
+ * has been written completely. The current state of @p tree is the reference for the next
+ * append().
+ *
+ * @param dataFile the name of the data file
+ * @param base the document that has been read or written
+ * @param tree the tree that contains the data of @p base
+ */
+void Journal::attach(const QString& dataFile, const QDomDocument& base, Tree* tree)
+{
+    QHash<QString, QString> parents;
+    for (Q3ListViewItemIterator it(tree); it.current(); ++it) {
+        TreeEntry* entry = dynamic_cast<TreeEntry*>(it.current());
+        TreeEntry* parent = dynamic_cast<TreeEntry*>(entry->Q3ListViewItem::parent());
+        parents.insert(entry->getId(), parent ? parent->getId() : QString(""));
+    }
+    attach(dataFile, base, parents, TreeEntry::lastGeneration());
+}
+
+
+/**
+ * @brief Attaches the journal to a data file that has been written from a TreeSnapshot.
+ *
+ * Entries that have been changed after the snapshot was taken have a newer generation than
+ * @p generation, so they are appended with the next append().
+ *
+ * @param dataFile the name of the data file
+ * @param base the document that has been written
+ * @param parents the ID of the parent for each entry in @p base, see
+ *        TreeSnapshot::getParents()
+ * @param generation the value of TreeEntry::lastGeneration() when @p base was created
+ */
+void Journal::attach(const QString& dataFile, const QDomDocument& base,
+                     const QHash<QString, QString>& parents, quint64 generation)
+{
+    QDomElement root = base.documentElement();
+
+    m_fileName = JournalFile::fileName(dataFile);
+    m_header = JournalFile::header(base, dataFile);
+    m_algorithm = root.namedItem("app-data").namedItem("crypt-algorithm").toElement().text();
+    m_baseSize = QFileInfo(dataFile).size();
+    m_journalSize = 0;
+
+    // entries without IDs cannot be referenced in the journal
+    m_compactionRequested = hasMissingIds(root.namedItem("passwords").toElement());
+
+    QFile file(m_fileName);
+    if (file.open(QIODevice::ReadOnly)) {
+        if (QString::fromLatin1(file.readLine()).trimmed() == m_header) {
+            m_journalSize = file.size();
+
+            // an incomplete record at the end would hide everything that is appended
+            file.seek(m_journalSize - 1);
+            char last;
+            if (!file.getChar(&last) || last != '\n')
+                m_compactionRequested = true;
+        }
+        file.close();
+    }
+
+    m_parents = parents;
+    m_savedGeneration = generation;
+}
+
+
+/**
+ * @brief Detaches the journal, e.g. on logout.
+ */
+void Journal::detach()
+{
+    m_fileName = QString::null;
+    m_header = QString::null;
+    m_parents.clear();
+    m_journalSize = 0;
+    m_compactionRequested = false;
+}
+
+
+/**
+ * @brief Checks if the journal is attached to a data file.
+ *
+ * @return @c true if it's attached, @c false otherwise
+ */
+bool Journal::isAttached() const
+{
+    return !m_fileName.isEmpty();
+}
+
+
+/**
+ * @brief Checks if the data file must be written completely instead of calling append().
+ *
+ * @param config the current configuration
+ * @return @c true if the journal is not attached, if compaction was requested, if the
+ *         data file or the cipher algorithm of @p config is different or if the journal
+ *         is too large
+ */
+bool Journal::needsCompaction(const VaultConfig& config) const
+{
+    if (!isAttached() || m_compactionRequested)
+        return true;
+
+    if (JournalFile::fileName(config.getDataFile()) != m_fileName ||
+            config.getCipherAlgorithm() != m_algorithm)
+        return true;
+
+    return m_journalSize > qMax(qint64(JOURNAL_MIN_COMPACT_SIZE), m_baseSize / 4);
+}
+
+
+/**
+ * @brief Requests that the next save writes the data file completely.
+ *
+ * Must be called if the password has been changed, because the journal is encrypted with
+ * the old password.
+ */
+void Journal::requestCompaction()
+{
+    m_compactionRequested = true;
+}
+
+
+/**
+ * @brief Appends the changes since the last attach() or append() to the journal.
+ *
+ * If writing fails, the journal is truncated to its old size and the next save writes the
+ * data file completely.
+ *
+ * @param tree the tree
+ * @param encryptor the encryptor for the data file, see DataReadWriter::createEncryptor()
+ * @exception ReadWriteException if the journal could not be written
+ */
+void Journal::append(Tree* tree, StringEncryptor& encryptor)
+{
+    Q_ASSERT(isAttached());
+
+    QFile file(m_fileName);
+    QIODevice::OpenMode mode = m_journalSize == 0
+        ? QIODevice::WriteOnly | QIODevice::Truncate
+        : QIODevice::WriteOnly | QIODevice::Append;
+
+    if (!file.open(mode))
+        throw ReadWriteException(QObject::tr("The data could not be saved. There "
+            "was an\nerror while opening the journal file:\n%1").arg( QCoreApplication::translate("QFile",
+            file.errorString())), ReadWriteException::CIOError);
+
+    try {
+        writeRecords(file, tree, encryptor);
+    } catch (...) {
+        // an incomplete record would end the replay and hide all following records
+        file.resize(m_journalSize);
+        m_compactionRequested = true;
+        throw;
+    }
+}
+
+
+/**
+ * @brief Writes the records of append() to @p file.
+ *
+ * @param file the journal, opened for writing at the end
+ * @param tree the tree
+ * @param encryptor the encryptor for the data file
+ * @exception ReadWriteException if the journal could not be written
+ */
+void Journal::writeRecords(QFile& file, Tree* tree, StringEncryptor& encryptor)
+{
+    QTextStream stream(&file);
+    if (m_journalSize == 0)
+        stream << m_header << "\n";
+
+    // changed, new and moved entries in preorder, so parents come before their children
+    QHash<QString, QString> parents;
+    for (Q3ListViewItemIterator it(tree); it.current(); ++it) {
+        TreeEntry* entry = dynamic_cast<TreeEntry*>(it.current());
+        TreeEntry* parent = dynamic_cast<TreeEntry*>(entry->Q3ListViewItem::parent());
+        const QString id = entry->getId();
+        const QString parentId = parent ? parent->getId() : QString("");
+        parents.insert(id, parentId);
+
+        QHash<QString, QString>::const_iterator old = m_parents.constFind(id);
+        if (entry->getGeneration() > m_savedGeneration || old == m_parents.constEnd() ||
+                old.value() != parentId) {
+            QDomDocument record;
+            QDomElement upsert = record.createElement("upsert");
+            upsert.setAttribute("parent", parentId);
+            record.appendChild(upsert);
+            entry->appendXML(record, upsert, &encryptor, false);
+            stream << encryptor.encryptStrToStr(record.toString()) << "\n";
+        }
+    }
+
+    // removed entries
+    for (QHash<QString, QString>::const_iterator it = m_parents.constBegin();
+            it != m_parents.constEnd(); ++it) {
+        if (!parents.contains(it.key())) {
+            QDomDocument record;
+            QDomElement remove = record.createElement("remove");
+            remove.setAttribute("id", it.key());
+            record.appendChild(remove);
+            stream << encryptor.encryptStrToStr(record.toString()) << "\n";
+        }
+    }
+
+    stream.flush();
+    if (stream.status() != QTextStream::Ok || file.error() != QFile::NoError)
+        throw ReadWriteException(QObject::tr("The data could not be saved. There "
+            "was an\nerror while writing the journal file:\n%1").arg( QCoreApplication::translate("QFile",
+            file.errorString())), ReadWriteException::CIOError);
+
+    m_journalSize = file.size();
+    m_parents = parents;
+    m_savedGeneration = TreeEntry::lastGeneration();
+}
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
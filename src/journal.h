@@ -0,0 +1,60 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <QString>
+#include <QFile>
+#include <QHash>
+#include <QDomDocument>
+
+#include "security/encryptor.h"
+#include "vaultconfig.h"
+
+class Tree;
+
+class Journal
+{
+    public:
+        Journal();
+
+        void attach(const QString& dataFile, const QDomDocument& base, Tree* tree);
+        void attach(const QString& dataFile, const QDomDocument& base,
+            const QHash<QString, QString>& parents, quint64 generation);
+        void detach();
+        bool isAttached() const;
+
+        bool needsCompaction(const VaultConfig& config) const;
+        void requestCompaction();
+
+        void append(Tree* tree, StringEncryptor& encryptor);
+
+    private:
+        void writeRecords(QFile& file, Tree* tree, StringEncryptor& encryptor);
+
+    private:
+        QString                 m_fileName;
+        QString                 m_header;
+        QString                 m_algorithm;
+        qint64                  m_baseSize;
+        qint64                  m_journalSize;
+        quint64                 m_savedGeneration;
+        QHash<QString, QString> m_parents;
+        bool                    m_compactionRequested;
+};
+
+#endif // JOURNAL_H
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
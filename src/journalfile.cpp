@@ -0,0 +1,215 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QTextStream>
+#include <QDebug>
+
+#include "global.h"
+#include "journalfile.h"
+
+#define JOURNAL_MAGIC               "QPAMAT-JOURNAL 1"
+
+/**
+ * @class JournalFile
+ *
+ * @brief The file format of the Journal.
+ *
+ * This class contains the part of the journal that doesn't need the Tree: the name of the
+ * journal, the header that identifies the data file and the replay of the records on a
+ * document that has been read from the data file. DataReadWriter uses it when reading, so
+ * the command line client sees the same data as the main window. See Journal for the
+ * format of the file.
+ *
+ * @ingroup gui
+ * @author Bernhard Walle
+ */
+
+/**
+ * @brief Adds @p element and all its child entries to @p index.
+ *
+ * @param element the element
+ * @param index the map from the ID to the element
+ */
+static void indexEntries(const QDomElement& element, QHash<QString, QDomElement>& index)
+{
+    for (QDomElement child = element.firstChildElement(); !child.isNull();
+            child = child.nextSiblingElement()) {
+        if (child.tagName() == "category" || child.tagName() == "entry") {
+            index.insert(child.attribute("id"), child);
+            if (child.tagName() == "category")
+                indexEntries(child, index);
+        }
+    }
+}
+
+
+/**
+ * @brief Removes all child entries of @p element from @p index.
+ *
+ * @param element the element
+ * @param index the map from the ID to the element
+ */
+static void unindexEntries(const QDomElement& element, QHash<QString, QDomElement>& index)
+{
+    for (QDomElement child = element.firstChildElement(); !child.isNull();
+            child = child.nextSiblingElement()) {
+        if (child.tagName() == "category" || child.tagName() == "entry") {
+            index.remove(child.attribute("id"));
+            if (child.tagName() == "category")
+                unindexEntries(child, index);
+        }
+    }
+}
+
+
+/**
+ * @brief Applies one record to the document.
+ *
+ * @param record the \c upsert or \c remove element
+ * @param base the document
+ * @param passwords the \c passwords element of @p base
+ * @param index the map from the ID to the element, gets updated
+ */
+static void applyRecord(const QDomElement& record, QDomDocument& base, QDomElement& passwords,
+                        QHash<QString, QDomElement>& index)
+{
+    if (record.tagName() == "remove") {
+        QDomElement element = index.take(record.attribute("id"));
+        if (!element.isNull()) {
+            // the children are removed with the category, a later upsert must not find them
+            unindexEntries(element, index);
+            element.parentNode().removeChild(element);
+        }
+        return;
+    }
+
+    QDomElement data = record.firstChildElement();
+    const QString id = data.attribute("id");
+    const QString parentId = record.attribute("parent");
+    if (record.tagName() != "upsert" || id.isEmpty())
+        return;
+
+    QDomElement parent = parentId.isEmpty() ? passwords : index.value(parentId);
+    if (parent.isNull()) {
+        qDebug() << CURRENT_FUNCTION << "Parent" << parentId << "of" << id << "not found";
+        return;
+    }
+
+    QDomElement element = base.importNode(data, true).toElement();
+    QDomElement existing = index.value(id);
+    if (!existing.isNull()) {
+        // the children of a category are not part of the record
+        if (data.tagName() == "category") {
+            QDomElement child;
+            while (!(child = existing.firstChildElement()).isNull())
+                element.appendChild(child);
+        }
+        existing.parentNode().removeChild(existing);
+    }
+
+    parent.appendChild(element);
+    index.insert(id, element);
+}
+
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Returns the name of the journal for a data file.
+ *
+ * @param dataFile the name of the data file
+ * @return the name of the journal
+ */
+QString JournalFile::fileName(const QString& dataFile)
+{
+    return dataFile + ".journal";
+}
+
+
+/**
+ * @brief Applies the journal of @p dataFile to the document that has been read from it.
+ *
+ * The journal is ignored if it doesn't belong to the current version of the data file.
+ * Must be called before the passwords in @p base are decrypted since the passwords in the
+ * records are encrypted.
+ *
+ * @param base the document that has been read from @p dataFile
+ * @param dataFile the name of the data file
+ * @param encryptor the encryptor for the data file
+ */
+void JournalFile::replay(QDomDocument& base, const QString& dataFile, StringEncryptor& encryptor)
+{
+    QFile file(fileName(dataFile));
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+
+    QTextStream stream(&file);
+    if (stream.readLine() != header(base, dataFile)) {
+        qDebug() << CURRENT_FUNCTION << "Ignoring stale journal" << file.fileName();
+        return;
+    }
+
+    QDomElement passwords = base.documentElement().namedItem("passwords").toElement();
+    QHash<QString, QDomElement> index;
+    indexEntries(passwords, index);
+
+    int records = 0;
+    while (!stream.atEnd()) {
+        const QString line = stream.readLine();
+        QDomDocument record;
+        if (line.isEmpty() || line.length() % 4 != 0 ||
+                !record.setContent(encryptor.decryptStrFromStr(line))) {
+            qWarning() << CURRENT_FUNCTION << "Invalid record" << records << "in" << file.fileName();
+            break;
+        }
+
+        applyRecord(record.documentElement(), base, passwords, index);
+        ++records;
+    }
+
+    qDebug() << CURRENT_FUNCTION << "Replayed" << records << "records";
+}
+
+
+/**
+ * @brief Deletes the journal of @p dataFile.
+ *
+ * Must be called after the data file has been written completely.
+ *
+ * @param dataFile the name of the data file
+ */
+void JournalFile::discard(const QString& dataFile)
+{
+    QFile::remove(fileName(dataFile));
+}
+
+
+/**
+ * @brief Returns the header that identifies the data file.
+ *
+ * @param base the document of the data file
+ * @param dataFile the name of the data file
+ * @return the header line
+ */
+QString JournalFile::header(const QDomDocument& base, const QString& dataFile)
+{
+    const QString date = base.documentElement().namedItem("app-data").namedItem("date")
+        .toElement().text();
+
+    return QString("%1 %2 %3").arg(JOURNAL_MAGIC).arg(date).arg(QFileInfo(dataFile).size());
+}
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
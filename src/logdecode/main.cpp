@@ -0,0 +1,64 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#include <iostream>
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QTextStream>
+
+#include "util/binarylog.h"
+
+/**
+ * @file logdecode/main.cpp
+ *
+ * @brief Converts a binary log of QpamatDebug::redirectBinaryFile() to text
+ *
+ * Usage: <tt>qpamat-logdecode FILE</tt>. The lines are printed on standard
+ * output in the format of the text log.
+ *
+ * @ingroup misc
+ */
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    if (argc != 2) {
+        std::cerr << "Usage: qpamat-logdecode FILE" << std::endl;
+        return 2;
+    }
+
+    BinaryLogReader reader(QFile::decodeName(argv[1]));
+    if (!reader.open()) {
+        std::cerr << argv[1] << ": " << reader.errorString().toLocal8Bit().data() << std::endl;
+        return 1;
+    }
+
+    QTextStream out(stdout);
+    QString line;
+    while (reader.readRecord(line)) {
+        out << line << '\n';
+    }
+    out.flush();
+
+    if (!reader.errorString().isEmpty()) {
+        std::cerr << argv[1] << ": " << reader.errorString().toLocal8Bit().data() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
@@ -33,6 +33,7 @@
 #include "settings.h"
 #include "util/singleapplication.h"
 #include "util/timeoutapplication.h"
+#include "util/trace.h"
 #include "qpamatadaptor.h"
 
 
@@ -55,12 +56,14 @@ int main(int argc, char** argv)
         qpamat->registerDBus();
 
         QObject::connect(qpamat->getWindow(), SIGNAL(quit()), &app, SLOT(quit()));
-        if (!(win->set().readBoolEntry("Presentation/StartHidden")
-              && win->set().readBoolEntry("Presentation/SystemTrayIcon"))) {
+        if (!(win->set().readBoolEntry(Settings::PresentationStartHidden)
+              && win->set().readBoolEntry(Settings::PresentationSystemTrayIcon))) {
             win->show();
         }
 
-        return app.exec();
+        int ret = app.exec();
+        QpamatTrace::instance()->save();
+        return ret;
 
     } catch (const std::bad_alloc&) {
         QMessageBox::warning(0, QObject::tr("QPaMaT"),
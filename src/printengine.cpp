@@ -0,0 +1,454 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#include <QPrinter>
+#include <QTimer>
+#include <QDate>
+#include <QTime>
+#include <QFontMetrics>
+#include <QTextLayout>
+
+#include "printengine.h"
+
+/**
+ * @brief The number of entries that are printed before the event loop continues
+ */
+static const int PRINT_BATCH_SIZE = 32;
+
+/**
+ * @class PrintEngine
+ *
+ * @brief Prints the entries of a TreeSnapshot page by page.
+ *
+ * Each entry is laid out and painted directly on the printer when it's its turn, so there
+ * is never more than one entry in memory apart from the snapshot. The title of an entry is
+ * kept together with its first property, the other properties are wrapped to the next
+ * page if necessary. A value that doesn't fit on a page at all is continued line by line on
+ * the next page. A page range of the QPrinter is respected, the pages before the range
+ * are only laid out.
+ *
+ * Printing doesn't block the GUI: start() returns immediately, the entries are printed in
+ * batches from the event loop. progress() is emitted after each batch and finished() at
+ * the end. The copy of the entries contains the passwords, so it's destroyed when printing
+ * has finished. Deleting the engine while it prints aborts the job.
+ *
+ * @ingroup gui
+ * @author Bernhard Walle
+ */
+
+/**
+ * @fn PrintEngine::progress(int, int)
+ *
+ * @brief Emitted after each batch of entries.
+ *
+ * @param printed the number of entries that have been printed
+ * @param total the number of entries
+ */
+
+/**
+ * @fn PrintEngine::finished(bool)
+ *
+ * @brief Emitted when printing has finished or has been cancelled.
+ *
+ * @param successful @c false if printing has been cancelled or the printer could not be
+ *        opened
+ */
+
+/**
+ * @brief Creates a new PrintEngine.
+ *
+ * @param printer the printer which has been set up already, the engine takes the ownership
+ * @param snapshot the entries to print, they are copied
+ * @param parent the parent object
+ */
+PrintEngine::PrintEngine(QPrinter* printer, const TreeSnapshot& snapshot, QObject* parent)
+    : QObject(parent)
+    , m_printer(printer)
+    , m_entries(snapshot.getEntries(": "))
+    , m_programString(tr("QPaMaT - Password managing tool for Unix, Windows and MacOS X"))
+    , m_dateString(QDate::currentDate().toString(Qt::ISODate) + " / " +
+        QTime::currentTime().toString("hh:mm"))
+    , m_y(0)
+    , m_next(0)
+    , m_page(0)
+    , m_printedPages(0)
+    , m_cancelled(false)
+    , m_running(false)
+{
+    m_titleFont.setBold(true);
+}
+
+
+/**
+ * @brief Deletes the engine and the printer.
+ *
+ * If printing is still running, the job is aborted.
+ */
+PrintEngine::~PrintEngine()
+{
+    if (m_running)
+        m_printer->abort();
+    if (m_painter.isActive())
+        m_painter.end();
+    wipeEntries();
+    delete m_printer;
+}
+
+
+/**
+ * @brief Sets the fonts.
+ *
+ * @param normalFont the font of the entries, the titles are printed in bold
+ * @param footerFont the font of the footer
+ */
+void PrintEngine::setFonts(const QFont& normalFont, const QFont& footerFont)
+{
+    m_normalFont = normalFont;
+    m_titleFont = normalFont;
+    m_titleFont.setBold(true);
+    m_footerFont = footerFont;
+}
+
+
+/**
+ * @brief Returns the number of entries to print.
+ *
+ * @return the number of entries
+ */
+int PrintEngine::getEntryCount() const
+{
+    return m_entries.size();
+}
+
+
+/**
+ * @brief Starts printing.
+ *
+ * The function returns immediately, the pages are printed from the event loop.
+ */
+void PrintEngine::start()
+{
+    if (m_running)
+        return;
+
+    if (!m_painter.begin(m_printer)) {
+        emit finished(false);
+        return;
+    }
+
+    // 2 cm margins, the footer is printed in the bottom margin
+    const qreal margin = mm(20);
+    m_painter.translate(margin, margin);
+    m_body = QRectF(0, 0, m_printer->width() - 2*margin, m_printer->height() - 2*margin);
+
+    m_running = true;
+    beginPage();
+    QTimer::singleShot(0, this, SLOT(printBatch()));
+}
+
+
+/**
+ * @brief Cancels printing, the pages that have not been sent to the printer are discarded.
+ */
+void PrintEngine::cancel()
+{
+    m_cancelled = true;
+}
+
+
+/**
+ * @brief Prints the next PRINT_BATCH_SIZE entries.
+ */
+void PrintEngine::printBatch()
+{
+    if (m_cancelled) {
+        m_printer->abort();
+        finish(false);
+        return;
+    }
+
+    const int end = qMin(m_next + PRINT_BATCH_SIZE, m_entries.size());
+    for (; m_next < end; ++m_next)
+        printEntry(m_entries[m_next]);
+
+    emit progress(m_next, m_entries.size());
+
+    const bool pastRange = m_printer->printRange() == QPrinter::PageRange &&
+        m_printer->toPage() > 0 && m_page > m_printer->toPage();
+    if (m_next < m_entries.size() && !pastRange) {
+        QTimer::singleShot(0, this, SLOT(printBatch()));
+        return;
+    }
+
+    endPage();
+    finish(true);
+}
+
+
+/**
+ * @brief Lays out and paints one entry.
+ *
+ * @param entry the entry
+ */
+void PrintEngine::printEntry(const TreeSnapshot::Entry& entry)
+{
+    const QString title = entry.category.isEmpty()
+        ? entry.name
+        : entry.category + ": " + entry.name;
+
+    const qreal padding = mm(1.5);
+    const QRectF titleRect(padding, 0, m_body.width() - 2*padding, 0);
+    const QRectF keyRect(padding, 0, m_body.width() / 4 - 2*padding, 0);
+    const QRectF valueRect(m_body.width() / 4, 0, m_body.width() * 3 / 4 - padding, 0);
+
+    m_painter.setFont(m_titleFont);
+    const qreal titleHeight = textHeight(titleRect, title) + 2*padding;
+
+    // keep the title together with the first property
+    m_painter.setFont(m_normalFont);
+    qreal firstRowHeight = 0;
+    if (!entry.properties.isEmpty()) {
+        const TreeSnapshot::PropertyData& first = entry.properties.first();
+        firstRowHeight = qMax(textHeight(keyRect, first.key),
+            textHeight(valueRect, first.value.get()));
+    }
+    if (titleHeight + padding + firstRowHeight > m_body.height())
+        firstRowHeight = 0;
+    ensureSpace(titleHeight + padding + firstRowHeight);
+
+    if (isPagePrinted())
+        m_painter.fillRect(QRectF(0, m_y, m_body.width(), titleHeight), Qt::lightGray);
+    m_painter.setFont(m_titleFont);
+    drawText(titleRect.translated(0, m_y + padding), title);
+    m_y += titleHeight + padding;
+
+    m_painter.setFont(m_normalFont);
+    for (QList<TreeSnapshot::PropertyData>::const_iterator it = entry.properties.begin();
+            it != entry.properties.end(); ++it)
+        drawRow(keyRect, it->key, valueRect, it->value.get());
+
+    m_y += mm(6);
+}
+
+
+/**
+ * @brief Draws one property in the current font.
+ *
+ * The row is kept together if it fits on a page. Otherwise, it's continued on the next page
+ * at the first line that doesn't fit any more, so nothing gets cut off.
+ *
+ * @param keyRect the rectangle of the key, only the x position and the width are used
+ * @param key the key
+ * @param valueRect the rectangle of the value, only the x position and the width are used
+ * @param value the value
+ */
+void PrintEngine::drawRow(const QRectF& keyRect, const QString& key, const QRectF& valueRect,
+                          const QString& value)
+{
+    QString keyText(key);
+    QString valueText(value);
+    keyText.replace('\n', QChar::LineSeparator);
+    valueText.replace('\n', QChar::LineSeparator);
+
+    QTextLayout keyLayout(keyText, m_painter.font(), m_printer);
+    QTextLayout valueLayout(valueText, m_painter.font(), m_printer);
+    const qreal height = qMax(layoutText(keyLayout, keyRect.width()),
+        layoutText(valueLayout, valueRect.width()));
+    if (height <= m_body.height())
+        ensureSpace(height);
+
+    const int lines = qMax(keyLayout.lineCount(), valueLayout.lineCount());
+    for (int i = 0; i < lines; ++i) {
+        QTextLine keyLine = keyLayout.lineAt(i);
+        QTextLine valueLine = valueLayout.lineAt(i);
+        const qreal lineHeight = qMax(keyLine.isValid() ? keyLine.height() : 0.0,
+            valueLine.isValid() ? valueLine.height() : 0.0);
+        ensureSpace(lineHeight);
+
+        if (isPagePrinted()) {
+            if (keyLine.isValid())
+                keyLine.draw(&m_painter, QPointF(keyRect.x(), m_y - keyLine.y()));
+            if (valueLine.isValid())
+                valueLine.draw(&m_painter, QPointF(valueRect.x(), m_y - valueLine.y()));
+        }
+        m_y += lineHeight;
+    }
+}
+
+
+/**
+ * @brief Wraps the text of @p layout at @p width.
+ *
+ * @param layout the layout with the text and the font
+ * @param width the width
+ * @return the height of all lines
+ */
+qreal PrintEngine::layoutText(QTextLayout& layout, qreal width)
+{
+    QTextOption option(Qt::AlignLeft);
+    option.setWrapMode(QTextOption::WrapAtWordBoundaryOrAnywhere);
+    layout.setTextOption(option);
+
+    qreal height = 0;
+    layout.beginLayout();
+    for (;;) {
+        QTextLine line = layout.createLine();
+        if (!line.isValid())
+            break;
+        line.setLineWidth(width);
+        line.setPosition(QPointF(0, height));
+        height += line.height();
+    }
+    layout.endLayout();
+
+    return height;
+}
+
+
+/**
+ * @brief Returns the height of @p text wrapped at the width of @p rect in the current font.
+ *
+ * @param rect the rectangle, the height is ignored
+ * @param text the text
+ * @return the height
+ */
+qreal PrintEngine::textHeight(const QRectF& rect, const QString& text)
+{
+    const QRectF bounds(0, 0, rect.width(), m_body.height());
+    return m_painter.boundingRect(bounds, Qt::TextWordWrap, text).height();
+}
+
+
+/**
+ * @brief Draws @p text in the current font if the page is printed.
+ *
+ * @param rect the rectangle, the height is extended to the bottom of the page
+ * @param text the text
+ */
+void PrintEngine::drawText(const QRectF& rect, const QString& text)
+{
+    if (!isPagePrinted())
+        return;
+
+    QRectF target(rect);
+    target.setBottom(m_body.bottom());
+    m_painter.drawText(target, Qt::TextWordWrap, text);
+}
+
+
+/**
+ * @brief Starts a new page unless @p height fits on the current page.
+ *
+ * @param height the height of the next block
+ */
+void PrintEngine::ensureSpace(qreal height)
+{
+    if (m_y > 0 && m_y + height > m_body.height()) {
+        endPage();
+        beginPage();
+    }
+}
+
+
+/**
+ * @brief Starts the next page.
+ */
+void PrintEngine::beginPage()
+{
+    m_page++;
+    m_y = 0;
+
+    if (isPagePrinted() && m_printedPages++ > 0)
+        m_printer->newPage();
+}
+
+
+/**
+ * @brief Prints the footer of the current page.
+ */
+void PrintEngine::endPage()
+{
+    if (!isPagePrinted())
+        return;
+
+    m_painter.setFont(m_footerFont);
+    const QFontMetrics metrics = m_painter.fontMetrics();
+    const QString pageString = tr("page") + " " + QString::number(m_page);
+
+    const qreal lineY = m_body.bottom() + mm(3);
+    const qreal textY = lineY + metrics.ascent();
+    const qreal dateX = (m_body.left() + metrics.width(m_programString) + m_body.right() -
+        metrics.width(pageString) - metrics.width(m_dateString)) / 2.0;
+
+    m_painter.drawLine(QPointF(m_body.left(), lineY), QPointF(m_body.right(), lineY));
+    m_painter.drawText(QPointF(m_body.left(), textY), m_programString);
+    m_painter.drawText(QPointF(dateX, textY), m_dateString);
+    m_painter.drawText(QPointF(m_body.right() - metrics.width(pageString), textY), pageString);
+}
+
+
+/**
+ * @brief Checks if the current page is in the page range of the printer.
+ *
+ * @return @c true if the page is printed, @c false if it's only laid out
+ */
+bool PrintEngine::isPagePrinted() const
+{
+    if (m_printer->printRange() != QPrinter::PageRange || m_printer->fromPage() <= 0)
+        return true;
+
+    return m_page >= m_printer->fromPage() &&
+        (m_printer->toPage() <= 0 || m_page <= m_printer->toPage());
+}
+
+
+/**
+ * @brief Ends the painter and emits finished().
+ *
+ * @param successful @c true if all pages have been printed
+ */
+void PrintEngine::finish(bool successful)
+{
+    m_running = false;
+    if (m_painter.isActive())
+        m_painter.end();
+    wipeEntries();
+
+    emit finished(successful);
+}
+
+
+/**
+ * @brief Destroys the copy of the entries.
+ *
+ * The values that are stored secure are given back to the SecureArena, which zeroes them.
+ */
+void PrintEngine::wipeEntries()
+{
+    m_entries.clear();
+}
+
+
+/**
+ * @brief Converts millimeters to device pixels of the printer.
+ *
+ * @param millimeters the length in millimeters
+ * @return the length in pixels
+ */
+qreal PrintEngine::mm(qreal millimeters) const
+{
+    return millimeters / 25.4 * m_printer->logicalDpiY();
+}
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
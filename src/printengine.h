@@ -0,0 +1,87 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#ifndef PRINTENGINE_H
+#define PRINTENGINE_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QFont>
+#include <QRectF>
+#include <QPainter>
+
+#include "treesnapshot.h"
+
+class QPrinter;
+class QTextLayout;
+
+class PrintEngine : public QObject
+{
+    Q_OBJECT
+
+    public:
+        PrintEngine(QPrinter* printer, const TreeSnapshot& snapshot, QObject* parent = 0);
+        ~PrintEngine();
+
+        void setFonts(const QFont& normalFont, const QFont& footerFont);
+        int getEntryCount() const;
+
+    public slots:
+        void start();
+        void cancel();
+
+    signals:
+        void progress(int printed, int total);
+        void finished(bool successful);
+
+    private slots:
+        void printBatch();
+
+    private:
+        void printEntry(const TreeSnapshot::Entry& entry);
+        qreal textHeight(const QRectF& rect, const QString& text);
+        void drawText(const QRectF& rect, const QString& text);
+        void drawRow(const QRectF& keyRect, const QString& key, const QRectF& valueRect,
+            const QString& value);
+        qreal layoutText(QTextLayout& layout, qreal width);
+        void ensureSpace(qreal height);
+        void beginPage();
+        void endPage();
+        bool isPagePrinted() const;
+        void finish(bool successful);
+        void wipeEntries();
+        qreal mm(qreal millimeters) const;
+
+    private:
+        QPrinter*                       m_printer;
+        QPainter                        m_painter;
+        QVector<TreeSnapshot::Entry>    m_entries;
+        QFont                           m_normalFont;
+        QFont                           m_titleFont;
+        QFont                           m_footerFont;
+        QRectF                          m_body;
+        QString                         m_programString;
+        QString                         m_dateString;
+        qreal                           m_y;
+        int                             m_next;
+        int                             m_page;
+        int                             m_printedPages;
+        bool                            m_cancelled;
+        bool                            m_running;
+};
+
+#endif // PRINTENGINE_H
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
@@ -17,14 +17,40 @@
 #include <Q3ListView>
 #include <QMessageBox>
 #include <QTextStream>
+#include <QScopedPointer>
 
-#include "qpamatwindow.h"
-#include "qpamat.h"
+#include "global.h"
 #include "util/securestring.h"
-#include "security/hybridpasswordchecker.h"
+#include "util/stringpool.h"
+#include "security/passwordcheckerfactory.h"
 #include "property.h"
+#include "reuseindex.h"
 #include "security/encodinghelper.h"
+#include "security/encryptor.h"
 #include "treeentry.h"
+#include "security/vaultkey.h"
+
+/**
+ * @brief Reads a value and encrypts it.
+ */
+class EncryptingReader : public SecureStringReader
+{
+    public:
+        EncryptingReader(StringEncryptor &encryptor)
+            : m_encryptor(encryptor) {}
+
+        void read(const char *utf8, size_t size)
+            { m_ciphertext = m_encryptor.encryptUtf8ToStr(utf8, size); }
+
+        QString ciphertext() const
+            { return m_ciphertext; }
+
+    private:
+        StringEncryptor &m_encryptor;
+        QString m_ciphertext;
+};
+
+// -------------------------------------------------------------------------------------------------
 
 /**
  * @class PropertyValue
@@ -33,6 +59,10 @@
  *
  * This is some kind of union class for a QString and a SecureString.
  *
+ * A value can also be kept as it is stored in the data file, i.e. encrypted, see
+ * setCiphertext(). Then it's decrypted each time it's read, and the plain text is never
+ * stored in the value itself.
+ *
  * @ingroup gui
  * @author Bernhard Walle
  */
@@ -59,7 +89,8 @@ PropertyValue::PropertyValue(const QString &string, bool storeSecure)
 /**
  * @brief Sets a value to a PropertyValue
  *
- * Sets a value.
+ * Sets a value. The representation that is not used is cleared, so a secret doesn't stay in
+ * memory when the value is changed to be stored insecure.
  *
  * @param[in] string the value as string
  * @param[in] storeSecure @c true if the string should be stored as SecureString,
@@ -67,13 +98,51 @@ PropertyValue::PropertyValue(const QString &string, bool storeSecure)
  */
 void PropertyValue::set(const QString &string, bool storeSecure)
 {
+    // swap() instead of an assignment: the new value is not copied again and the old
+    // one gets smashed with the temporary
     if (storeSecure) {
-        m_secureString = SecureString(string);
+        SecureString(string).swap(m_secureString);
+        m_string = QString::null;
         m_isSecureString = true;
     } else {
+        SecureString().swap(m_secureString);
         m_string = string;
         m_isSecureString = false;
     }
+    m_ciphertext = QString::null;
+    m_key.clear();
+}
+
+
+/**
+ * @brief Sets a value that is still encrypted.
+ *
+ * The value is decrypted with @p key each time it's needed, e.g. by get() or borrow().
+ *
+ * @param[in] ciphertext the encrypted value as it is stored in the data file
+ * @param[in] key the key that decrypts @p ciphertext
+ * @param[in] storeSecure @c true if the value should be treated as secret, i.e.
+ *                        getVisible() doesn't display it
+ */
+void PropertyValue::setCiphertext(const QString &ciphertext, const QSharedPointer<VaultKey> &key,
+                                  bool storeSecure)
+{
+    SecureString().swap(m_secureString);
+    m_string = QString::null;
+    m_isSecureString = storeSecure;
+    m_ciphertext = ciphertext;
+    m_key = key;
+}
+
+
+/**
+ * @brief Checks if the value is still encrypted, see setCiphertext().
+ *
+ * @return @c true if the value is encrypted, @c false otherwise
+ */
+bool PropertyValue::hasCiphertext() const
+{
+    return !m_key.isNull();
 }
 
 
@@ -86,7 +155,9 @@ void PropertyValue::set(const QString &string, bool storeSecure)
  */
 QString PropertyValue::get() const
 {
-    if (m_isSecureString) {
+    if (hasCiphertext()) {
+        return m_key->decryptStrFromStr(m_ciphertext);
+    } else if (m_isSecureString) {
         return m_secureString.qString();
     } else {
         return m_string;
@@ -98,7 +169,8 @@ QString PropertyValue::get() const
  * @brief Returns the visible value
  *
  * The same as get(), but in case the string is stored secure, all characters are replaced
- * with stars <tt>(*)</tt>.
+ * with stars <tt>(*)</tt>. An encrypted value is not decrypted to count the characters,
+ * so it always gets eight stars.
  *
  * @return the visible value as string
  */
@@ -106,14 +178,192 @@ QString PropertyValue::getVisible() const
 {
     if (m_isSecureString) {
         QString s;
-        s.fill('*', m_secureString.length());
+        s.fill('*', hasCiphertext() ? 8 : m_secureString.length());
         return s;
     } else {
-        return m_string;
+        return get();
+    }
+}
+
+
+/**
+ * @brief Estimates the memory that is used by the value.
+ *
+ * That's the payload of the representation that is used, not only the number of characters.
+ *
+ * @return the size in bytes
+ */
+size_t PropertyValue::memorySize() const
+{
+    size_t size = sizeof(PropertyValue);
+    if (hasCiphertext())
+        size += m_ciphertext.capacity() * sizeof(QChar);
+    else if (m_isSecureString)
+        size += m_secureString.size() + 1;
+    else
+        size += m_string.capacity() * sizeof(QChar);
+    return size;
+}
+
+
+/**
+ * @brief Compares two values.
+ *
+ * Values are only equal if they are stored in the same way. If only one value is encrypted,
+ * the other one is encrypted with the same key and the ciphertexts are compared. Only values
+ * that are encrypted with different keys are decrypted, into secure memory.
+ *
+ * @param[in] other the other value
+ * @return @c true if both values are equal, @c false otherwise
+ */
+bool PropertyValue::operator==(const PropertyValue &other) const
+{
+    if (m_isSecureString != other.m_isSecureString)
+        return false;
+
+    if (hasCiphertext() && other.hasCiphertext()) {
+        if (m_key->hasSameKey(*other.m_key))
+            return m_ciphertext == other.m_ciphertext;
+        return decrypt() == other.decrypt();
+    } else if (hasCiphertext()) {
+        return m_ciphertext == other.encrypt(*m_key);
+    } else if (other.hasCiphertext()) {
+        return encrypt(*other.m_key) == other.m_ciphertext;
+    }
+
+    return m_isSecureString
+        ? m_secureString == other.m_secureString
+        : m_string == other.m_string;
+}
+
+
+/**
+ * @brief Compares two values.
+ *
+ * @param[in] other the other value
+ * @return @c true if the values differ, @c false otherwise
+ */
+bool PropertyValue::operator!=(const PropertyValue &other) const
+{
+    return !(*this == other);
+}
+
+
+/**
+ * @brief Hands the value to @p reader without creating a QString.
+ *
+ * If the value is stored as SecureString, @p reader reads the locked memory directly. An
+ * encrypted value is decrypted into secure memory, see decrypt().
+ *
+ * @param[in] reader the reader
+ */
+void PropertyValue::borrow(SecureStringReader &reader) const
+{
+    if (hasCiphertext()) {
+        decrypt().borrow(reader);
+    } else if (m_isSecureString) {
+        m_secureString.borrow(reader);
+    } else {
+        QByteArray utf8 = m_string.toUtf8();
+        reader.read(utf8.constData(), utf8.size());
+    }
+}
+
+
+/**
+ * @brief Hands the value to @p reader as QString.
+ *
+ * Values that are not stored secure are passed directly, without a round trip through UTF-8.
+ *
+ * @param[in] reader the reader
+ */
+void PropertyValue::borrow(SecureQStringReader &reader) const
+{
+    if (hasCiphertext())
+        decrypt().borrow(reader);
+    else if (m_isSecureString)
+        m_secureString.borrow(reader);
+    else
+        reader.readString(m_string);
+}
+
+
+/**
+ * @brief Returns the value encrypted with @p encryptor.
+ *
+ * If the value is still encrypted with the same key, the ciphertext is returned without
+ * decrypting it, see VaultKey::hasSameKey().
+ *
+ * @param[in] encryptor the encryptor
+ * @return the ciphertext
+ */
+QString PropertyValue::encrypt(StringEncryptor &encryptor) const
+{
+    if (hasCiphertext()) {
+        VaultKey *key = dynamic_cast<VaultKey *>(&encryptor);
+        if (key && key->hasSameKey(*m_key))
+            return m_ciphertext;
     }
+
+    EncryptingReader reader(encryptor);
+    borrow(reader);
+    return reader.ciphertext();
 }
 
 
+/**
+ * @brief Decrypts the value into secure memory.
+ *
+ * Must only be called if hasCiphertext() returns @c true.
+ *
+ * @return the plain text, or an empty string if the key is locked
+ */
+SecureString PropertyValue::decrypt() const
+{
+    return m_key->decryptSecureFromStr(m_ciphertext);
+}
+
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Reads a password and computes its quality.
+ */
+class PasswordQualityReader : public SecureQStringReader
+{
+    public:
+        PasswordQualityReader(PasswordChecker &checker)
+            : m_checker(checker), m_days(-1.0) {}
+
+        void readString(const QString &text)
+            { m_days = m_checker.passwordQuality(text); }
+
+        double days() const
+            { return m_days; }
+
+    private:
+        PasswordChecker &m_checker;
+        double m_days;
+};
+
+
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Mapping between Property::Type and the string that is used in the XML file.
+ *
+ * Indexed by the enumeration value.
+ */
+static const struct {
+    Property::Type  type;
+    const char      *name;
+} s_typeNames[] = {
+    { Property::MISC,       "MISC"      },
+    { Property::USERNAME,   "USERNAME"  },
+    { Property::PASSWORD,   "PASSWORD"  },
+    { Property::URL,        "URL"       }
+};
+
+
 /**
  * @class Property
  *
@@ -140,11 +390,20 @@ QString PropertyValue::getVisible() const
  * the user setting. \c PUndefined is a escape value.
  */
 
+/**
+ * @enum Property::Change
+ *
+ * @brief Bits that tell what has changed, see BatchedNotifier.
+ */
+
 /**
  * @fn Property::propertyChanged(Property*)
  *
  * @brief This signal is emited if some property is changed.
  *
+ * Inside a ChangeBatch, it's emitted only once at the end of the batch, regardless how many
+ * setters have been called.
+ *
  * @param current the this pointer
  */
 
@@ -158,18 +417,28 @@ QString PropertyValue::getVisible() const
  * @param hidden whether the propertyp should be displayed as password on the screen
  */
 Property::Property(const QString& key, const QString& value, Type type, bool encrypted, bool hidden)
-    : m_key(key)
+    : m_key(StringPool::instance()->intern(key))
     , m_value(value)
     , m_type(type)
     , m_encrypted(encrypted)
     , m_hidden(hidden)
     , m_passwordStrength(PUndefined)
     , m_daysToCrack(-1.0)
+    , m_entry(0)
 {
     setValue(value);
 }
 
 
+/**
+ * @brief Deletes the Property and removes it from the ReuseIndex.
+ */
+Property::~Property()
+{
+    ReuseIndex::instance()->remove(this);
+}
+
+
 /**
  * @brief Returns the key of the property
  *
@@ -184,12 +453,19 @@ QString Property::getKey() const
 /**
  * @brief Sets the key of the property.
  *
+ * The key is interned in the StringPool, so properties with the same key share one string.
+ * The keys that are typed while editing are purged from the pool later, see
+ * StringPool::purge().
+ *
  * @param key the new key
  */
 void Property::setKey(const QString& key)
 {
-    m_key = key;
-    emit propertyChanged(this);
+    if (m_key == key)
+        return;
+
+    m_key = StringPool::instance()->intern(key);
+    notifyChanged(KeyChanged);
 }
 
 
@@ -215,6 +491,32 @@ QString Property::getVisibleValue() const
 }
 
 
+/**
+ * @brief Hands the value to @p reader.
+ *
+ * Use that instead of getValue() for passwords if you don't need a copy of the value.
+ *
+ * @param reader the reader
+ */
+void Property::borrowValue(SecureStringReader &reader) const
+{
+    m_value.borrow(reader);
+}
+
+
+/**
+ * @brief Hands the value to @p reader as QString.
+ *
+ * Use that instead of getValue() for passwords if you don't need a copy of the value.
+ *
+ * @param reader the reader
+ */
+void Property::borrowValue(SecureQStringReader &reader) const
+{
+    m_value.borrow(reader);
+}
+
+
 /**
  * @brief Sets the value of the property.
  *
@@ -223,7 +525,47 @@ QString Property::getVisibleValue() const
 void Property::setValue(const QString& value)
 {
     m_value.set(value, m_hidden);
-    emit propertyChanged(this);
+    notifyChanged(ValueChanged);
+}
+
+
+/**
+ * @brief Returns the value as it is stored.
+ *
+ * @return the value
+ */
+const PropertyValue& Property::getPropertyValue() const
+{
+    return m_value;
+}
+
+
+/**
+ * @brief Sets the value as it is stored, without converting a secure value to QString.
+ *
+ * @param value the new value
+ */
+void Property::setPropertyValue(const PropertyValue& value)
+{
+    m_value = value;
+    notifyChanged(ValueChanged);
+}
+
+
+/**
+ * @brief Replaces the value of a password or a hidden property by its ciphertext.
+ *
+ * This is used to lock the session. The value doesn't change, so nobody is notified. Other
+ * values are not touched.
+ *
+ * @param key the key, see PropertyValue::setCiphertext()
+ */
+void Property::encryptValue(const QSharedPointer<VaultKey>& key)
+{
+    if (m_type != PASSWORD && !m_hidden)
+        return;
+
+    m_value.setCiphertext(m_value.encrypt(*key), key, m_hidden);
 }
 
 
@@ -235,14 +577,15 @@ void Property::setValue(const QString& value)
  * updatePasswordStrength() function is called. There's no automatic
  * recomputation because of performance reasons.
  *
+ * @param config the configuration that is used if the strength must be computed
  * @return the password strength which is \c PUndefined if it is no password
  * @exception PasswordCheckException if the strength is updated and a PasswordCheckException
  *            is thrown
  */
-Property::PasswordStrength Property::getPasswordStrength()
+Property::PasswordStrength Property::getPasswordStrength(const VaultConfig& config)
 {
     if (m_passwordStrength == PUndefined)
-        updatePasswordStrength();
+        updatePasswordStrength(config);
     return m_passwordStrength;
 }
 
@@ -251,7 +594,7 @@ Property::PasswordStrength Property::getPasswordStrength()
  * @brief This function ony makes sense if the property represents a password.
  *
  * It returns the days a cracker needs to try to crack the password according
- * to the HybridPasswordChecker and the current settings. Recomputing takes
+ * to the configured PasswordChecker and the current settings. Recomputing takes
  * place if the updateWeakInformation() member function is called.
  *
  * @return the days or a negative value if this is no password
@@ -268,29 +611,48 @@ double Property::daysToCrack() const
  * Because updating this information may be expensive, you sometimes manually
  * must call this function.
  *
+ * @param config the configuration with the checker, the dictionary, the breach corpus and the
+ *        limits
  * @exception if the password checker threw a PasswordCheckException
  */
-void Property::updatePasswordStrength()
+void Property::updatePasswordStrength(const VaultConfig& config)
 {
     if (m_type == PASSWORD) {
-        QpamatWindow *win = Qpamat::instance()->getWindow();
-        QString ensured = win->set().readEntry("Security/EnsuredCharacters");
-        double days = -1.0;
-        HybridPasswordChecker checker(win->set().readEntry("Security/DictionaryFile"));
-        days = checker.passwordQuality(m_value.get()); // XXX
-        m_daysToCrack = days;
-        double weakLimit = win->set().readDoubleEntry("Security/WeakPasswordLimit");
-        double strongLimit = win->set().readDoubleEntry("Security/StrongPasswordLimit");
-        if (m_daysToCrack < weakLimit)
-            m_passwordStrength = PWeak;
-        else if (m_daysToCrack >= weakLimit && m_daysToCrack < strongLimit)
-            m_passwordStrength = PAcceptable;
-        else
-            m_passwordStrength = PStrong;
+        QScopedPointer<PasswordChecker> checker(PasswordCheckerFactory::getChecker(config));
+
+        PasswordQualityReader reader(*checker);
+        m_value.borrow(reader);
+        setDaysToCrack(reader.days(), config);
     }
 }
 
 
+/**
+ * @brief Sets the password strength that has been computed outside of the property.
+ *
+ * This is used by the SouthPanel which checks the password in a worker thread while the user
+ * types. The caller must make sure that @p days belongs to the current value.
+ *
+ * @param days the days to crack the current value
+ * @param config the configuration with the limits
+ */
+void Property::setDaysToCrack(double days, const VaultConfig& config)
+{
+    if (m_type != PASSWORD)
+        return;
+
+    m_daysToCrack = days;
+    double weakLimit = config.getWeakPasswordLimit();
+    double strongLimit = config.getStrongPasswordLimit();
+    if (m_daysToCrack < weakLimit)
+        m_passwordStrength = PWeak;
+    else if (m_daysToCrack >= weakLimit && m_daysToCrack < strongLimit)
+        m_passwordStrength = PAcceptable;
+    else
+        m_passwordStrength = PStrong;
+}
+
+
 /**
  * @brief Returns the type of the value.
  *
@@ -309,8 +671,11 @@ Property::Type Property::getType() const
  */
 void Property::setType(Property::Type type)
 {
+    if (m_type == type)
+        return;
+
     m_type = type;
-    emit propertyChanged(this);
+    notifyChanged(TypeChanged);
 }
 
 
@@ -332,8 +697,11 @@ bool Property::isHidden() const
  */
 void Property::setHidden(bool hidden)
 {
+    if (m_hidden == hidden)
+        return;
+
     m_hidden = hidden;
-    emit propertyChanged(this);
+    notifyChanged(HiddenChanged);
 }
 
 
@@ -357,76 +725,99 @@ bool Property::isEncrypted()
  */
 void Property::setEncrypted(bool encrypted)
 {
+    if (m_encrypted == encrypted)
+        return;
+
     m_encrypted = encrypted;
-    emit propertyChanged(this);
+    notifyChanged(EncryptedChanged);
 }
 
 
 /**
- * @brief Converts the property to rich text which is used to printing.
- *
- * One property represents a row in a table, so it begins with an \c \<tr\>
- * tag end ends with an \c \</tr\> tag.
+ * @brief Returns the entry that holds the property.
  *
- * @return the rich text
+ * @return the entry or @c NULL if the property is not attached to an entry
  */
-QString Property::toRichTextForPrint() const
+TreeEntry* Property::getEntry() const
 {
-    return QString("<tr><td width=\"25%\">%1</td><td width=\"75%\">%2</td></tr>")
-        .arg(m_key, getValue());
+    return m_entry;
 }
 
 
 /**
- * @brief Appends the tree entry as text representation to the given stream.
+ * @brief Estimates the memory that is used by the property including key and value.
  *
- * The text is formatted for export.
+ * @return the size in bytes
+ */
+size_t Property::memorySize() const
+{
+    return sizeof(Property) - sizeof(PropertyValue) + m_key.capacity() * sizeof(QChar) +
+        m_value.memorySize();
+}
+
+
+/**
+ * @brief Updates the ReuseIndex and emits propertyChanged().
  *
- * @param stream the stream where the text is appended
+ * @param changes the combined Property::Change bits
  */
-void Property::appendTextForExport(QTextStream& stream)
+void Property::flushChanges(int changes)
 {
-    stream << qSetFieldWidth(20) << m_key + ": " << qSetFieldWidth(0) << getValue() << "\n";
+    if (changes & (ValueChanged | TypeChanged))
+        ReuseIndex::instance()->invalidate(this);
+    emit propertyChanged(this);
 }
 
 
 /**
  * @brief Appends the property as \c property tag in the XML structure.
  *
- * No encryption is done, the XML structure must be encrypted afterwards.
+ * If @p encryptor is not @c NULL, passwords are encrypted with it and the result must be
+ * written with DataReadWriter::writeXML() with @c passwordsEncrypted set. The plain text is
+ * never copied then. Without @p encryptor, no encryption is done, the XML structure must be
+ * encrypted afterwards.
  *
  * @param document the document needed to create new elements
  * @param parent the parent to which the new created element should be attached
+ * @param encryptor the encryptor for passwords or @c NULL
  */
-void Property::appendXML(QDomDocument& document, QDomNode& parent) const
+void Property::appendXML(QDomDocument& document, QDomNode& parent,
+                         StringEncryptor* encryptor) const
+{
+    appendXML(document, parent, m_key, m_value, m_type, m_hidden, m_encrypted, encryptor);
+}
+
+
+/**
+ * @brief Appends a \c property tag with the given data in the XML structure.
+ *
+ * This is the serialization of Property::appendXML() without a Property, TreeSnapshot uses
+ * it for the copied values.
+ *
+ * @param document the document needed to create new elements
+ * @param parent the parent to which the new created element should be attached
+ * @param key the key
+ * @param value the value
+ * @param type the type
+ * @param hidden whether the value is hidden
+ * @param encrypted whether the value is encrypted
+ * @param encryptor the encryptor for passwords or @c NULL
+ */
+void Property::appendXML(QDomDocument& document, QDomNode& parent, const QString& key,
+                         const PropertyValue& value, Type type, bool hidden, bool encrypted,
+                         StringEncryptor* encryptor)
 {
     QDomElement property = document.createElement("property");
-    QString value = getValue();
-
-    property.setAttribute("key", m_key);
-    property.setAttribute("value", value);
-    property.setAttribute("hidden", m_hidden);
-    property.setAttribute("encrypted", m_encrypted);
-
-    QString type;
-    switch (m_type) {
-        case MISC    :
-            type = "MISC";
-            break;
-
-        case PASSWORD:
-            type = "PASSWORD";
-            break;
-
-        case USERNAME:
-            type = "USERNAME";
-            break;
-
-        case URL:
-            type = "URL";
-            break;
-    }
-    property.setAttribute("type", type);
+
+    property.setAttribute("key", key);
+    if (encryptor && type == PASSWORD)
+        property.setAttribute("value", value.encrypt(*encryptor));
+    else
+        property.setAttribute("value", value.get());
+    property.setAttribute("hidden", hidden);
+    property.setAttribute("encrypted", encrypted);
+
+    property.setAttribute("type", typeToString(type));
 
     parent.appendChild(property);
 }
@@ -435,10 +826,15 @@ void Property::appendXML(QDomDocument& document, QDomNode& parent) const
 /**
  * @brief Creates a Propery element from a XML \c property tag.
  *
+ * If @p vaultKey is not null, the value of a password has not been decrypted by
+ * DataReadWriter::readXML(). It's kept encrypted and decrypted on demand with @p vaultKey.
+ *
  * @param parent the parent
  * @param element the \c property tag
+ * @param vaultKey the key for passwords that are still encrypted or a null pointer
  */
-void Property::appendFromXML(TreeEntry* parent, QDomElement& element)
+void Property::appendFromXML(TreeEntry* parent, QDomElement& element,
+                             const QSharedPointer<VaultKey>& vaultKey)
 {
     Q_ASSERT( element.tagName() == "property" );
 
@@ -448,17 +844,45 @@ void Property::appendFromXML(TreeEntry* parent, QDomElement& element)
     bool encrypted = element.attribute("encrypted") == "1";
     QString typeString = element.attribute("type");
 
-    Property::Type type;
-    if (typeString == "USERNAME")
-        type = USERNAME;
-    else if (typeString == "PASSWORD")
-        type = PASSWORD;
-    else if (typeString == "URL")
-        type = URL;
-    else
-        type = MISC;
+    Property::Type type = typeFromString(typeString);
+
+    if (!vaultKey.isNull() && type == PASSWORD) {
+        Property* property = new Property(key, QString::null, type, encrypted, hidden);
+        property->m_value.setCiphertext(value, vaultKey, hidden);
+        parent->appendProperty(property);
+    } else
+        parent->appendProperty(new Property(key, value, type, encrypted, hidden));
+}
+
+
+/**
+ * @brief Converts a property type to the string that is used in the XML file.
+ *
+ * @param type the type
+ * @return the string representation, e.g. <tt>"PASSWORD"</tt>
+ */
+QString Property::typeToString(Type type)
+{
+    Q_ASSERT(s_typeNames[type].type == type);
+
+    return QLatin1String(s_typeNames[type].name);
+}
+
+
+/**
+ * @brief Converts the string representation of a type back to the Property::Type.
+ *
+ * @param string the string as written by typeToString()
+ * @return the type, Property::MISC for unknown strings
+ */
+Property::Type Property::typeFromString(const QString &string)
+{
+    for (unsigned int i = 0; i < ARRAY_SIZE(s_typeNames); i++) {
+        if (string == QLatin1String(s_typeNames[i].name))
+            return s_typeNames[i].type;
+    }
 
-    parent->appendProperty(new Property(key, value, type, encrypted, hidden));
+    return MISC;
 }
 
 // vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
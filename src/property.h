@@ -19,33 +19,53 @@
 #include <QDomDocument>
 #include <QObject>
 #include <QTextStream>
+#include <QSharedPointer>
 
 #include "util/securestring.h"
 #include "security/passwordchecker.h"
+#include "changebatch.h"
+#include "vaultconfig.h"
 
 class TreeEntry;
+class StringEncryptor;
+class VaultKey;
 
 class PropertyValue
 {
     public:
-        PropertyValue(const QString &string, bool storeSecure=false);
+        PropertyValue(const QString &string = QString::null, bool storeSecure=false);
 
     public:
         void set(const QString &string, bool storeSecure=false);
+        void setCiphertext(const QString &ciphertext, const QSharedPointer<VaultKey> &key,
+            bool storeSecure=false);
+        bool hasCiphertext() const;
         QString get() const;
         QString getVisible() const;
+        size_t memorySize() const;
+        bool operator==(const PropertyValue &other) const;
+        bool operator!=(const PropertyValue &other) const;
+        void borrow(SecureStringReader &reader) const;
+        void borrow(SecureQStringReader &reader) const;
+        QString encrypt(StringEncryptor &encryptor) const;
 
     private:
-        QString         m_string;
-        SecureString    m_secureString;
-        bool            m_isSecureString;
+        SecureString decrypt() const;
+
+    private:
+        QString                     m_string;
+        SecureString                m_secureString;
+        bool                        m_isSecureString;
+        QString                     m_ciphertext;
+        QSharedPointer<VaultKey>    m_key;
 };
 
-class Property : public QObject
+class Property : public QObject, public BatchedNotifier
 {
     Q_OBJECT
 
     friend class Tree;
+    friend class TreeEntry;
 
     public:
         enum Type {
@@ -62,19 +82,34 @@ class Property : public QObject
             PUndefined
         };
 
+        enum Change {
+            KeyChanged          = 1 << 0,
+            ValueChanged        = 1 << 1,
+            TypeChanged         = 1 << 2,
+            HiddenChanged       = 1 << 3,
+            EncryptedChanged    = 1 << 4
+        };
+
     public:
         Property(const QString& key = QString::null, const QString& value = QString::null,
             Type type = MISC, bool encrypted = false, bool hidden = false);
+        ~Property();
 
         QString getKey() const;
         void setKey(const QString& key);
 
         QString getValue() const;
         void setValue(const QString& value);
+        const PropertyValue& getPropertyValue() const;
+        void setPropertyValue(const PropertyValue& value);
+        void encryptValue(const QSharedPointer<VaultKey>& key);
         QString getVisibleValue() const;
+        void borrowValue(SecureStringReader &reader) const;
+        void borrowValue(SecureQStringReader &reader) const;
 
-        PasswordStrength getPasswordStrength();
-        void updatePasswordStrength();
+        PasswordStrength getPasswordStrength(const VaultConfig& config);
+        void updatePasswordStrength(const VaultConfig& config);
+        void setDaysToCrack(double days, const VaultConfig& config);
         double daysToCrack() const;
 
         Type getType() const;
@@ -86,18 +121,27 @@ class Property : public QObject
         bool isEncrypted();
         void setEncrypted(bool encrypted);
 
-        QString toRichTextForPrint() const;
-        void appendTextForExport(QTextStream& stream);
-
+        TreeEntry* getEntry() const;
+        size_t memorySize() const;
 
-        void appendXML(QDomDocument& document, QDomNode& parent) const;
+        void appendXML(QDomDocument& document, QDomNode& parent,
+            StringEncryptor* encryptor = 0) const;
 
     public:
-        static void appendFromXML(TreeEntry* parent, QDomElement& elem);
+        static void appendXML(QDomDocument& document, QDomNode& parent, const QString& key,
+            const PropertyValue& value, Type type, bool hidden, bool encrypted,
+            StringEncryptor* encryptor);
+        static void appendFromXML(TreeEntry* parent, QDomElement& elem,
+            const QSharedPointer<VaultKey>& vaultKey = QSharedPointer<VaultKey>());
+        static QString typeToString(Type type);
+        static Type typeFromString(const QString &string);
 
     signals:
         void propertyChanged(Property* current);
 
+    protected:
+        void flushChanges(int changes);
+
     private:
         QString          m_key;
         PropertyValue    m_value;
@@ -106,6 +150,7 @@ class Property : public QObject
         bool             m_hidden;
         PasswordStrength m_passwordStrength;
         double           m_daysToCrack;
+        TreeEntry*       m_entry;
 };
 
 #endif // PROPERTY_H
@@ -20,8 +20,11 @@
 #include <QTextCodec>
 #include <QApplication>
 #include <QDir>
+#include <QFile>
 
 #include "util/platformhelpers.h"
+#include "util/trace.h"
+#include "util/debug.h"
 #include "qpamat.h"
 #include "qpamatwindow.h"
 #include "qpamatadaptor.h"
@@ -124,6 +127,12 @@ void Qpamat::parseCommandLine(int argc, char **argv)
         } else if (string == "v" || string == "--version" || string == "-version") {
             printVersion();
             std::exit(0);
+        } else if ((string == "--trace" || string == "-trace") && i + 1 < argc) {
+            QpamatTrace::instance()->setOutputFile(QFile::decodeName(argv[++i]));
+        } else if ((string == "--binary-log" || string == "-binary-log") && i + 1 < argc) {
+            qInstallMsgHandler(QpamatDebug::msgHandler);
+            QpamatDebug::instance()->setMessageLevel(QtDebugMsg);
+            QpamatDebug::instance()->redirectBinaryFile(QFile::decodeName(argv[++i]));
         }
     }
 }
@@ -138,6 +147,11 @@ void Qpamat::printCommandlineOptions()
         << "This is QPaMaT " << VERSION_STRING << ", a password managing tool for Unix, MacOS X\n"
         << "and Windows using the Qt programming library from Trolltech.\n\n"
         << "Options: -h            prints this help\n"
+        << "         --trace FILE  writes the time of login, save, etc. to FILE, which\n"
+        << "                       can be loaded in chrome://tracing\n"
+        << "         --binary-log FILE\n"
+        << "                       writes the debug messages to FILE in binary form,\n"
+        << "                       use qpamat-logdecode to read it\n"
         << std::endl;
 }
 
@@ -14,7 +14,6 @@
  */
 #include <QDebug>
 #include <QApplication>
-#include <QTextDocument>
 #include <QAction>
 #include <QShortcut>
 #include <QKeySequence>
@@ -25,21 +24,21 @@
 #include <QIcon>
 #include <QDesktopWidget>
 #include <QPixmap>
-#include <QAbstractTextDocumentLayout>
 #include <QStatusBar>
 #include <QMessageBox>
 #include <QLabel>
 #include <QSettings>
 #include <QDockWidget>
 #include <QPrinter>
-#include <QPainter>
 #include <QClipboard>
 #include <QFont>
-#include <QEventLoop>
 #include <QCursor>
 #include <QFileDialog>
+#include <QPrintDialog>
+#include <QProgressDialog>
 #include <QCloseEvent>
 #include <QScopedPointer>
+#include <QRegExp>
 
 #include "qpamatwindow.h"
 
@@ -51,8 +50,17 @@
 #include "dialogs/configurationdialog.h"
 #include "util/timeoutapplication.h"
 #include "util/platformhelpers.h"
+#include "util/trace.h"
 #include "rightpanel.h"
 #include "tree.h"
+#include "treesnapshot.h"
+#include "treeexporter.h"
+#include "treeimporter.h"
+#include "printengine.h"
+#include "reuseindex.h"
+#include "import/importer.h"
+#include "journalfile.h"
+#include "security/vaultkey.h"
 
 #if defined(Q_WS_WIN)
 #  define TRAY_ICON_FILE_NAME ":/images/qpamat_16.png"
@@ -62,8 +70,6 @@
 #  define TRAY_ICON_FILE_NAME ":/images/qpamat_34.png"
 #endif
 
-#define CON_MM(x)( int( ( (x)/25.4)*dpiy ) )
-
 /**
  * @class QpamatWindow
  *
@@ -93,9 +99,11 @@
  */
 
 /**
- * @fn QpamatWindow::settingsChanged()
+ * @fn QpamatWindow::settingsChanged(const Settings::KeySet&)
  *
  * This signals is emitted if the settings have changed.
+ *
+ * @param keys the settings that have a new value
  */
 
 
@@ -119,6 +127,10 @@ QpamatWindow::QpamatWindow()
     , m_randomPassword(0)
     , m_trayIcon(0)
     , m_lastGeometry(0, 0, 0, 0)
+    , m_autoSaveTimer(0)
+    , m_autoSavePending(false)
+    , m_modificationSerial(0)
+    , m_locked(false)
 {
     QRect geometry;
 
@@ -154,34 +166,42 @@ QpamatWindow::QpamatWindow()
     initMenubar();
     initToolbar();
 
+    // autosave
+    m_autoSaveTimer = new QTimer(this);
+    updateAutoSaveTimer();
+
     // display statusbar
     statusBar();
     m_message.reset(new TimerStatusmessage(statusBar()));
     setLogin(false);
 
     // restore history
-    QStringList list = QStringList::split (" | ", set().readEntry("Main Window/SearchHistory") );
+    QStringList list = QStringList::split(" | ",
+        set().readEntry(Settings::MainWindowSearchHistory));
     m_searchCombo->insertStringList(list);
     m_searchCombo->clearEdit();
 
     // restore the layout
-    restoreState(set().readByteArrayEntry("Main Window/layout"));
-    if (set().readBoolEntry("Main Window/maximized"))
+    restoreState(set().readByteArrayEntry(Settings::MainWindowLayout));
+    if (set().readBoolEntry(Settings::MainWindowMaximized))
         showMaximized();
-    else
+    else {
+        int width = set().readNumEntry(Settings::MainWindowWidth);
+        int height = set().readNumEntry(Settings::MainWindowHeight);
         resize(
-            set().readNumEntry("Main Window/width", int(geometry.width() * 0.6) ),
-            set().readNumEntry("Main Window/height", int(geometry.height() / 2.0) )
+            width > 0 ? width : int(geometry.width() * 0.6),
+            height > 0 ? height : int(geometry.height() / 2.0)
         );
+    }
 
-    QString rightpanel = set().readEntry("Main Window/rightpanelLayout");
+    QString rightpanel = set().readEntry(Settings::MainWindowRightPanelLayout);
     if (!rightpanel.isNull()) {
         QTextStream rightpanelStream(&rightpanel, QIODevice::ReadOnly);
         rightpanelStream >> *m_rightPanel;
     }
 
     // tray icon
-    if (set().readBoolEntry("Presentation/SystemTrayIcon") &&
+    if (set().readBoolEntry(Settings::PresentationSystemTrayIcon) &&
             QSystemTrayIcon::isSystemTrayAvailable()) {
         QMenu* trayPopup = new QMenu(this);
         trayPopup->addAction(m_actions.showHideAction);
@@ -199,10 +219,11 @@ QpamatWindow::QpamatWindow()
                 SLOT(handleTrayiconClick(QSystemTrayIcon::ActivationReason)));
     }
 
+    readVaultConfig();
     connectSignalsAndSlots();
 
-    if (set().readBoolEntry("General/AutoLogin")) {
-        if (QFile::exists(set().readEntry("General/Datafile")) )
+    if (set().readBoolEntry(Settings::GeneralAutoLogin)) {
+        if (QFile::exists(m_vaultConfig.getDataFile()))
             QTimer::singleShot( 0, this, SLOT(login()) );
         else
             QTimer::singleShot( 0, this, SLOT(newFile()) );
@@ -236,6 +257,71 @@ Settings& QpamatWindow::set()
 }
 
 
+/**
+ * @brief Returns the configuration of the data file and of the password checks.
+ *
+ * It's read from the settings at startup and each time the settings have been changed.
+ *
+ * @return a reference to the configuration
+ */
+const VaultConfig& QpamatWindow::getVaultConfig() const
+{
+    return m_vaultConfig;
+}
+
+
+/**
+ * @brief Reads the configuration of the data file and of the password checks again.
+ *
+ * Must be called before the other receivers of settingsChanged() are notified.
+ */
+void QpamatWindow::readVaultConfig()
+{
+    m_vaultConfig = set().vaultConfig();
+    m_tree->setVaultConfig(m_vaultConfig);
+}
+
+
+/**
+ * @brief Applies changed settings.
+ *
+ * Only the work that depends on the changed settings is done, i.e. the password strength
+ * of all entries is only computed again if the checker, the dictionary, the breach corpus or
+ * the limits have changed.
+ *
+ * @param keys the changed settings
+ */
+void QpamatWindow::applySettings(const Settings::KeySet& keys)
+{
+    readVaultConfig();
+
+    if (keys.contains(Settings::SecurityDictionaryFile) ||
+            keys.contains(Settings::SecurityPasswordChecker) ||
+            keys.contains(Settings::SecurityBreachCorpus) ||
+            keys.contains(Settings::SecurityWeakPasswordLimit) ||
+            keys.contains(Settings::SecurityStrongPasswordLimit)) {
+        m_rightPanel->resetPasswordChecker();
+        m_tree->recomputePasswordStrength();
+    }
+
+    if (keys.contains(Settings::GeneralAutoSaveInterval))
+        updateAutoSaveTimer();
+}
+
+
+/**
+ * @brief Returns the undo stack.
+ *
+ * All changes of the data should be pushed as UndoCommand to that stack.
+ *
+ * @return a reference to the object
+ */
+UndoStack& QpamatWindow::undoStack()
+{
+    return m_undoStack;
+}
+
+
 /**
  * @brief Prints a message in the statusbar.
  *
@@ -307,11 +393,17 @@ void QpamatWindow::initMenubar()
      fileMenu->addAction(m_actions.loginLogoutAction);
      fileMenu->addAction(m_actions.saveAction);
      fileMenu->addAction(m_actions.exportAction);
+     fileMenu->addAction(m_actions.importAction);
      fileMenu->addAction(m_actions.printAction);
      fileMenu->insertSeparator();
      fileMenu->addAction(m_actions.quitAction);
 
      // ----- Options ------------------------------------------------------------------------------
+     // ----- Edit ---------------------------------------------------------------------------------
+     QMenu* editMenu = menuBar()->addMenu(tr("&Edit"));
+     editMenu->addAction(m_actions.undoAction);
+     editMenu->addAction(m_actions.redoAction);
+
      QMenu* optionsMenu = menuBar()->addMenu(tr("&Options"));
      optionsMenu->addAction(m_actions.changePasswordAction);
      optionsMenu->addAction(m_actions.settingsAction);
@@ -320,6 +412,7 @@ void QpamatWindow::initMenubar()
      QMenu* extrasMenu = menuBar()->addMenu(tr("&Extras"));
      extrasMenu->addAction(m_actions.randomPasswordAction);
      extrasMenu->addAction(m_actions.passwordStrengthAction);
+     extrasMenu->addAction(m_actions.reuseReportAction);
      extrasMenu->addAction(m_actions.clearClipboardAction);
 
      // ----- Help ---------------------------------------------------------------------------------
@@ -347,17 +440,17 @@ void QpamatWindow::exitHandler()
     int max = QMIN(m_searchCombo->count(), 10);
     for (int i = 0; i < max; ++i)
         list.append(m_searchCombo->text(i));
-    set().writeEntry("Main Window/SearchHistory", list.join(" | "));
+    set().writeEntry(Settings::MainWindowSearchHistory, list.join(" | "));
 
     // write window layout
     QString rightpanelLayout;
     QTextStream rightpanelStream(&rightpanelLayout, QIODevice::WriteOnly);
     rightpanelStream << *m_rightPanel;
-    set().writeEntry("Main Window/layout", saveState());
-    set().writeEntry("Main Window/width", size().width());
-    set().writeEntry("Main Window/height", size().height());
-    set().writeEntry("Main Window/maximized", isMaximized());
-    set().writeEntry("Main Window/rightpanelLayout", rightpanelLayout);
+    set().writeEntry(Settings::MainWindowLayout, saveState());
+    set().writeEntry(Settings::MainWindowWidth, size().width());
+    set().writeEntry(Settings::MainWindowHeight, size().height());
+    set().writeEntry(Settings::MainWindowMaximized, isMaximized());
+    set().writeEntry(Settings::MainWindowRightPanelLayout, rightpanelLayout);
 
     emit quit();
 }
@@ -391,10 +484,66 @@ void QpamatWindow::closeEvent(QCloseEvent* e)
  */
 void QpamatWindow::setModified(bool modified)
 {
+    if (modified)
+        ++m_modificationSerial;
     m_modified = modified;
     m_actions.saveAction->setEnabled(modified);
 }
 
+/**
+ * @brief Undoes the last change and updates the view.
+ */
+void QpamatWindow::undo()
+{
+    m_undoStack.undo();
+    updateViewAfterUndo();
+}
+
+
+/**
+ * @brief Redoes the last change that was undone and updates the view.
+ */
+void QpamatWindow::redo()
+{
+    m_undoStack.redo();
+    updateViewAfterUndo();
+}
+
+
+/**
+ * @brief Updates the view after undo() or redo().
+ *
+ * The command may have changed or removed the entry that is displayed on the right.
+ */
+void QpamatWindow::updateViewAfterUndo()
+{
+    Q3ListViewItem* item = m_tree->selectedItem();
+    if (item)
+        m_rightPanel->setItem(item);
+    else
+        m_rightPanel->clear();
+    m_tree->updatePasswordStrengthView();
+    setModified();
+}
+
+
+/**
+ * @brief Updates the text and the state of the undo and redo actions.
+ */
+void QpamatWindow::updateUndoActions()
+{
+    m_actions.undoAction->setEnabled(m_loggedIn && !m_locked && m_undoStack.canUndo());
+    m_actions.undoAction->setMenuText(m_undoStack.canUndo()
+        ? tr("&Undo %1").arg(m_undoStack.undoText())
+        : tr("&Undo"));
+
+    m_actions.redoAction->setEnabled(m_loggedIn && !m_locked && m_undoStack.canRedo());
+    m_actions.redoAction->setMenuText(m_undoStack.canRedo()
+        ? tr("&Redo %1").arg(m_undoStack.redoText())
+        : tr("&Redo"));
+}
+
+
 /**
  * @brief Toggles the show status of the main window
  *
@@ -438,18 +587,24 @@ void QpamatWindow::login()
 
     QScopedPointer<PasswordDialog> dlg(new PasswordDialog(this));
     QDomDocument doc;
+    QSharedPointer<VaultKey> vaultKey;
+    bool lazy = m_vaultConfig.isLazyDecryption();
     bool ok = false;
 
+    // from the password to the tree, without the time in the dialog
+    QScopedPointer<TraceSpan> span;
+
     while (!ok) {
         if (dlg->exec() == QDialog::Accepted)
             m_password = dlg->getPassword();
         else
             return;
+        span.reset(new TraceSpan("login", "Session"));
 
-        DataReadWriter reader;
+        DataReadWriter reader(m_vaultConfig);
         while (!ok) {
             try {
-                doc = reader.readXML(m_password);
+                doc = reader.readXML(m_password, lazy ? &vaultKey : 0);
                 ok = true;
             } catch (const ReadWriteException& e) {
                 // type of the message
@@ -482,7 +637,8 @@ void QpamatWindow::login()
         }
     }
 
-    m_tree->readFromXML(doc.documentElement().namedItem("passwords").toElement());
+    m_tree->readFromXML(doc.documentElement().namedItem("passwords").toElement(), vaultKey);
+    m_journal.attach(m_vaultConfig.getDataFile(), doc, m_tree);
 
     setLogin(true);
 }
@@ -496,11 +652,53 @@ void QpamatWindow::login()
 void QpamatWindow::setLogin(bool loggedIn)
 {
     qDebug() << CURRENT_FUNCTION << "Caling setLogin =" << loggedIn;
+
+    // the running autosave and print job belong to the old session
+    waitForAutoSave();
+    cancelPrinting();
+    m_snapshotCache.clear();
     m_loggedIn = loggedIn;
 
+    // a locked session ends, too
+    m_locked = false;
+    m_lockKey.clear();
+
+    // the history refers to items of the old tree
+    m_undoStack.clear();
+    updateSessionActions();
+    if (!loggedIn)
+        m_journal.detach();
+
+    if (loggedIn) {
+        dynamic_cast<TimeoutApplication*>(qApp)->setTimeout(
+            set().readNumEntry(Settings::SecurityAutoLogout)
+        );
+    } else {
+        m_actions.passwordStrengthAction->setOn(false);
+        m_tree->clear();
+        m_rightPanel->clear();
+        this->setFocus();
+    }
+
+    setModified(false);
+}
+
+
+/**
+ * @brief Updates the actions and widgets according to the login and the lock status.
+ */
+void QpamatWindow::updateSessionActions()
+{
+    bool active = m_loggedIn && !m_locked;
+
     // toggle action
     disconnect(m_actions.loginLogoutAction, SIGNAL(activated()), 0, 0 );
-    if (loggedIn) {
+    if (m_locked) {
+        m_actions.loginLogoutAction->setIconSet(createIcon("login"));
+        m_actions.loginLogoutAction->setMenuText(tr("&Unlock"));
+        m_actions.loginLogoutAction->setToolTip(tr("Unlock"));
+        connect(m_actions.loginLogoutAction, SIGNAL(activated()), SLOT(unlock()));
+    } else if (m_loggedIn) {
         m_actions.loginLogoutAction->setIcon(createIcon("logout"));
         m_actions.loginLogoutAction->setMenuText(tr("&Logout"));
         m_actions.loginLogoutAction->setToolTip(tr("Logout"));
@@ -512,30 +710,100 @@ void QpamatWindow::setLogin(bool loggedIn)
         connect(m_actions.loginLogoutAction, SIGNAL(activated()), SLOT(login()));
     }
 
-    m_actions.saveAction->setEnabled(loggedIn);
-    m_actions.changePasswordAction->setEnabled(loggedIn);
-    m_actions.printAction->setEnabled(loggedIn);
-    m_searchCombo->setEnabled(loggedIn);
-    m_actions.searchAction->setEnabled(loggedIn);
-    m_searchLabel->setEnabled(loggedIn);
-    m_actions.addItemAction->setEnabled(loggedIn);
-    m_actions.removeItemAction->setEnabled(loggedIn);
-    m_actions.passwordStrengthAction->setEnabled(loggedIn);
-    m_actions.exportAction->setEnabled(loggedIn);
+    m_actions.saveAction->setEnabled(active && m_modified);
+    m_actions.changePasswordAction->setEnabled(active);
+    m_actions.printAction->setEnabled(active);
+    m_searchCombo->setEnabled(active);
+    m_actions.searchAction->setEnabled(active);
+    m_searchLabel->setEnabled(active);
+    m_actions.addItemAction->setEnabled(active);
+    m_actions.removeItemAction->setEnabled(active);
+    m_actions.passwordStrengthAction->setEnabled(active);
+    m_actions.reuseReportAction->setEnabled(active);
+    m_actions.exportAction->setEnabled(active);
+    m_actions.importAction->setEnabled(active);
+    updateUndoActions();
+
+    m_tree->setEnabled(active);
+    m_tree->setVisible(!m_locked);
+}
 
-    if (loggedIn) {
-        dynamic_cast<TimeoutApplication*>(qApp)->setTimeout(
-            set().readNumEntry("Security/AutoLogout")
-        );
-    } else {
-        m_actions.passwordStrengthAction->setOn(false);
-        m_tree->clear();
-        m_rightPanel->clear();
-        this->setFocus();
+
+/**
+ * @brief Locks the session, e.g. after some time of inactivity.
+ *
+ * Contrary to logout(), the tree is kept. Only the secret values are encrypted with a key
+ * that is destroyed until unlock() is called with the password. So nothing has to be read
+ * again, and there's no need to save modified data before.
+ *
+ * @return \c true if the session has been locked or logged out, \c false otherwise
+ */
+bool QpamatWindow::lock()
+{
+    if (!m_loggedIn || m_locked)
+        return true;
+
+    qDebug() << CURRENT_FUNCTION << "Locking the session";
+    waitForAutoSave();
+
+    try {
+        m_lockKey = QSharedPointer<VaultKey>(
+            new VaultKey(m_vaultConfig.getCipherAlgorithm(), m_password));
+    } catch (const NoSuchAlgorithmException&) {
+        return logout();
     }
 
-    m_tree->setEnabled(loggedIn);
-    setModified(false);
+    m_rightPanel->clear();
+    // the cached snapshot data and the print job contain the secret values
+    cancelPrinting();
+    m_snapshotCache.clear();
+    m_tree->encryptSecrets(m_lockKey);
+    m_lockKey->lock();
+    m_password = QString::null;
+
+    // the history contains the old values in plain text
+    m_undoStack.clear();
+
+    m_locked = true;
+    updateSessionActions();
+    message(tr("The session has been locked."));
+
+    return true;
+}
+
+
+/**
+ * @brief Unlocks a session that has been locked with lock().
+ *
+ * The user has to enter the password.
+ *
+ * @return \c true if the session is not locked any more, \c false if the user cancelled
+ */
+bool QpamatWindow::unlock()
+{
+    if (!m_locked)
+        return true;
+
+    QScopedPointer<PasswordDialog> dlg(new PasswordDialog(this));
+    while (dlg->exec() == QDialog::Accepted) {
+        const QString password = dlg->getPassword();
+
+        if (m_lockKey->unlock(password)) {
+            m_password = password;
+            m_lockKey.clear();
+            m_locked = false;
+            updateSessionActions();
+            dynamic_cast<TimeoutApplication*>(qApp)->setTimeout(
+                set().readNumEntry(Settings::SecurityAutoLogout)
+            );
+            return true;
+        }
+
+        QMessageBox::warning(this, "QPaMaT", tr("The password is incorrect."),
+            QMessageBox::Ok | QMessageBox::Default, QMessageBox::NoButton);
+    }
+
+    return false;
 }
 
 
@@ -544,7 +812,8 @@ void QpamatWindow::setLogin(bool loggedIn)
  */
 void QpamatWindow::save()
 {
-    if (m_loggedIn && exportOrSave()) {
+    waitForAutoSave();
+    if (m_loggedIn && exportOrSave(m_vaultConfig, true)) {
         setModified(false);
         message(tr("Wrote data successfully."));
     }
@@ -554,19 +823,33 @@ void QpamatWindow::save()
 /**
  * @brief Exports or saves the data.
  *
- * The file name is determined by the global property General/Datafile is considered.
- *
+ * @param config the configuration with the data file and the cipher algorithm
+ * @param journal @c true if the data file of the session is saved, then only the changes
+ *        are appended to the Journal unless a compaction is needed
  * @return \c true if the action was successful, \c false otherwise
  */
-bool QpamatWindow::exportOrSave()
+bool QpamatWindow::exportOrSave(const VaultConfig& config, bool journal)
 {
-    DataReadWriter writer;
-    QDomDocument doc = writer.createSkeletonDocument();
-    m_tree->appendXML(doc);
+    const QString dataFile = config.getDataFile();
+    DataReadWriter writer(config);
     bool success = false;
     while (!success) {
         try {
-            writer.writeXML(doc, m_password);
+            // encrypt while building the document, so that the passwords are not
+            // copied as plain text
+            QScopedPointer<StringEncryptor> encryptor(writer.createEncryptor(m_password));
+            if (journal && !m_journal.needsCompaction(config))
+                m_journal.append(m_tree, *encryptor);
+            else {
+                QDomDocument doc = writer.createSkeletonDocument();
+                m_tree->appendXML(doc, encryptor.data());
+                writer.writeXML(doc, m_password, true);
+
+                if (journal) {
+                    JournalFile::discard(dataFile);
+                    m_journal.attach(dataFile, doc, m_tree);
+                }
+            }
             success = true;
         } catch (const ReadWriteException& e) {
             QMessageBox::Icon icon = e.getSeverity() == ReadWriteException::WARNING
@@ -594,11 +877,12 @@ bool QpamatWindow::exportOrSave()
  */
 void QpamatWindow::exportData()
 {
-    QString oldFilename = set().readEntry("General/Datafile");
     QString fileName;
 
     QFileDialog* fd = new QFileDialog(this, tr("QPaMaT"), QDir::homeDirPath(),
-        tr("QPaMaT XML files (*.xml);;Text files with cleartext password (*.txt)"));
+        tr("QPaMaT XML files (*.xml);;Text files with cleartext password (*.txt);;"
+           "CSV files with cleartext password (*.csv);;"
+           "JSON files with cleartext password (*.json)"));
     fd->setMode(QFileDialog::AnyFile);
 
     if (fd->exec() == QDialog::Accepted)
@@ -615,21 +899,91 @@ void QpamatWindow::exportData()
 
     // XML or text?
     if (fd->selectedFilter().endsWith("(*.xml)")) {
-        set().writeEntry("General/Datafile", fileName);
-        if (m_loggedIn && exportOrSave())
+        VaultConfig config = m_vaultConfig;
+        config.setDataFile(fileName);
+        if (m_loggedIn && exportOrSave(config))
             message(tr("Wrote data successfully."));
-        set().writeEntry("General/Datafile", oldFilename);
     } else {
+        TreeExporter::Format format = TreeExporter::Text;
+        if (fd->selectedFilter().endsWith("(*.csv)"))
+            format = TreeExporter::Csv;
+        else if (fd->selectedFilter().endsWith("(*.json)"))
+            format = TreeExporter::Json;
+
         QFile file(fileName);
-        if (file.open(QIODevice::WriteOnly)) {
-            QTextStream stream(&file);
-            m_tree->appendTextForExport(stream);
-            file.close();
-            message(tr("Wrote data successfully."));
-        } else
+        if (!file.open(QIODevice::WriteOnly)) {
             QMessageBox::warning(this, tr("QPaMaT"),
                tr("An error occured while saving the file."),
                QMessageBox::Ok | QMessageBox::Default, QMessageBox::NoButton);
+            return;
+        }
+
+        QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+        try {
+            TreeExporter(TreeSnapshot(m_tree), format).write(&file);
+            file.close();
+            QApplication::restoreOverrideCursor();
+            message(tr("Wrote data successfully."));
+        } catch (const ReadWriteException& e) {
+            QApplication::restoreOverrideCursor();
+            QMessageBox::warning(this, tr("QPaMaT"), e.getMessage(),
+               QMessageBox::Ok | QMessageBox::Default, QMessageBox::NoButton);
+        }
+    }
+}
+
+
+/**
+ * @brief Imports the export of another password manager, see ImporterFactory.
+ */
+void QpamatWindow::importData()
+{
+    const QStringList names = ImporterFactory::names();
+    QStringList filters;
+    for (QStringList::const_iterator it = names.begin(); it != names.end(); ++it) {
+        QScopedPointer<Importer> importer(ImporterFactory::create(*it));
+        filters << importer->fileFilter();
+    }
+
+    QFileDialog* fd = new QFileDialog(this, tr("QPaMaT"), QDir::homeDirPath(),
+        filters.join(";;"));
+    fd->setMode(QFileDialog::ExistingFile);
+
+    QString fileName;
+    if (fd->exec() == QDialog::Accepted)
+        fileName = fd->selectedFile();
+    else
+        return;
+
+    const int index = filters.indexOf(fd->selectedFilter());
+    QScopedPointer<Importer> importer(ImporterFactory::create(names.value(qMax(index, 0))));
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        QMessageBox::warning(this, tr("QPaMaT"),
+           tr("An error occured while reading the file."),
+           QMessageBox::Ok | QMessageBox::Default, QMessageBox::NoButton);
+        return;
+    }
+
+    TreeImporter treeImporter(m_tree);
+    QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+    try {
+        importer->open(&file);
+        treeImporter.import(*importer);
+        QApplication::restoreOverrideCursor();
+        message(tr("Imported %1 entries, skipped %2 existing entries.")
+            .arg(treeImporter.getImportedCount()).arg(treeImporter.getDuplicateCount()));
+    } catch (const ReadWriteException& e) {
+        QApplication::restoreOverrideCursor();
+        QMessageBox::warning(this, tr("QPaMaT"), e.getMessage(),
+           QMessageBox::Ok | QMessageBox::Default, QMessageBox::NoButton);
+    }
+
+    if (treeImporter.getImportedCount() > 0) {
+        if (m_actions.passwordStrengthAction->isOn())
+            passwordStrengthHandler(true);
+        setModified();
     }
 }
 
@@ -641,6 +995,32 @@ void QpamatWindow::exportData()
  */
 bool QpamatWindow::logout()
 {
+    // the autosave may have saved everything already
+    waitForAutoSave();
+
+    // the data can only be saved with the password
+    if (m_locked && m_modified) {
+        int ret = QMessageBox::question(this, "QPaMaT", tr("The session is locked and there is "
+            "modified data that was not saved.\nDo you want to unlock the session and save it "
+            "now?"), QMessageBox::Yes | QMessageBox::Default, QMessageBox::No,
+            QMessageBox::Cancel);
+
+        switch (ret) {
+            case QMessageBox::Yes:
+                if (!unlock())
+                    return false;
+                save();
+                break;
+
+            case QMessageBox::Cancel:
+                return false;
+
+            default:
+                setModified(false);
+                break;
+        }
+    }
+
     // save the data
     if (m_modified) {
         qDebug() << CURRENT_FUNCTION << "Disable timeout action temporary";
@@ -698,6 +1078,8 @@ void QpamatWindow::changePassword()
     QScopedPointer<NewPasswordDialog> dlg(new NewPasswordDialog(this, m_password));
     if (dlg->exec() == QDialog::Accepted) {
         m_password = dlg->getPassword();
+        // the journal is encrypted with the old password
+        m_journal.requestCompaction();
         setModified();
     }
 }
@@ -709,8 +1091,94 @@ void QpamatWindow::changePassword()
 void QpamatWindow::configure()
 {
     QScopedPointer<ConfigurationDialog> dlg(new ConfigurationDialog(this));
-    if (dlg->exec() == QDialog::Accepted)
-        emit settingsChanged();
+    if (dlg->exec() == QDialog::Accepted) {
+        Settings::KeySet keys = set().takeChangedKeys();
+        if (!keys.isEmpty())
+            emit settingsChanged(keys);
+    }
+}
+
+
+/**
+ * @brief Saves the data in the background if it has been modified.
+ *
+ * Only the snapshot of the data is taken here, encryption and writing happens in the
+ * AutoSaver. If an autosave is still running, another one is started after it has finished,
+ * so that overlapping triggers result in only one additional save.
+ */
+void QpamatWindow::autoSave()
+{
+    if (!m_loggedIn || m_locked || !m_modified)
+        return;
+
+    if (m_autoSaver.isRunning()) {
+        m_autoSavePending = true;
+        return;
+    }
+
+    m_autoSaver.start(new AutoSaveJob(new TreeSnapshot(m_tree, &m_snapshotCache), m_password,
+        m_vaultConfig, m_modificationSerial));
+}
+
+
+/**
+ * @brief Processes the result of an autosave and reports it in the status bar.
+ *
+ * @param job the job that has finished
+ */
+void QpamatWindow::autoSaveFinished(AutoSaveJob* job)
+{
+    if (!job->isSuccessful()) {
+        QString error = job->getErrorMessage();
+        error.replace(QRegExp("<[^>]*>"), "");
+        message(tr("Autosave failed: %1").arg(error.simplifyWhiteSpace()));
+    } else if (m_loggedIn) {
+        // the journal refers to the old file
+        JournalFile::discard(job->getDataFile());
+        m_journal.attach(job->getDataFile(), job->getDocument(),
+            job->getSnapshot()->getParents(), job->getSnapshot()->getGeneration());
+        if (job->getPassword() != m_password)
+            m_journal.requestCompaction();
+
+        // only if nothing has been changed since the snapshot
+        if (job->getSerial() == m_modificationSerial)
+            setModified(false);
+        message(tr("Saved data automatically."));
+    }
+
+    if (m_autoSavePending) {
+        m_autoSavePending = false;
+        autoSave();
+    }
+}
+
+
+/**
+ * @brief Waits until a running autosave has finished and processes its result.
+ *
+ * Must be called before the data is saved in the GUI thread or the session ends.
+ */
+void QpamatWindow::waitForAutoSave()
+{
+    m_autoSavePending = false;
+    if (m_autoSaver.isRunning()) {
+        QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+        m_autoSaver.waitForFinished();
+        QApplication::restoreOverrideCursor();
+    }
+}
+
+
+/**
+ * @brief Applies the autosave interval of the settings.
+ */
+void QpamatWindow::updateAutoSaveTimer()
+{
+    int minutes = set().readNumEntry(Settings::GeneralAutoSaveInterval);
+    if (minutes > 0)
+        m_autoSaveTimer->start(minutes * 60 * 1000);
+    else
+        m_autoSaveTimer->stop();
 }
 
 
@@ -749,89 +1217,109 @@ void QpamatWindow::passwordStrengthHandler(bool enabled)
 }
 
 
+/**
+ * @brief Shows which passwords are used in more than one entry.
+ *
+ * The passwords themselves are not shown, only the entries that share one.
+ */
+void QpamatWindow::showReuseReport()
+{
+    QList<PropertyList> reused = ReuseIndex::instance()->reusedPasswords();
+    if (reused.isEmpty()) {
+        QMessageBox::information(this, "QPaMaT",
+            tr("No password is used in more than one entry."), QMessageBox::Ok);
+        return;
+    }
+
+    QString details;
+    QTextStream stream(&details, QIODevice::WriteOnly);
+    for (int i = 0; i < reused.size(); i++) {
+        stream << tr("Password %1 is used in:").arg(i + 1) << "\n";
+        foreach (Property* property, reused[i])
+            stream << "    " << property->getEntry()->getFullName() << "\n";
+        stream << "\n";
+    }
+    stream.flush();
+
+    QString text = reused.size() == 1
+        ? tr("One password is used in more than one entry.")
+        : tr("%1 passwords are used in more than one entry.").arg(reused.size());
+    QMessageBox box(QMessageBox::Warning, "QPaMaT", text, QMessageBox::Ok, this);
+    box.setDetailedText(details);
+    box.exec();
+}
+
+
 /**
  * @brief Prints the current document.
  *
- * Displayes the print dialog for that reason.
+ * Displayes the print dialog for that reason. If "Selection" is chosen there, only the
+ * selected entry or category is printed. The pages are printed by a PrintEngine from the
+ * event loop while a progress dialog is shown.
  */
 void QpamatWindow::print()
 {
-    QPrinter printer(QPrinter::HighResolution);
-    printer.setFullPage( TRUE );
-    if ( printer.setup( this ) ) {
-        QPainter p(&printer);
-        // Check that there is a valid device to print to.
-        if (!p.device())
-            return;
+    if (m_printEngine) {
+        message(tr("Printing is still in progress."));
+        return;
+    }
 
-        QFont serifFont;
-        QFont sansSerifFont;
-        serifFont.fromString(set().readEntry("Presentation/NormalFont"));
-        sansSerifFont.fromString(set().readEntry("Presentation/FooterFont"));
-        p.setFont(sansSerifFont);
-
-        qApp->setOverrideCursor( QCursor( Qt::WaitCursor ) );
-        qApp->processEvents( QEventLoop::ExcludeUserInput );
-
-        const int dpiy = p.device()->logicalDpiY();
-        const int margin = (int) ((2/2.54)*dpiy); // 2 cm margins
-
-        QRectF body(margin, margin, p.device()->width() - 2*margin, p.device()->height() - 2*margin);
-
-        QTextDocument* doc = new QTextDocument();
-        doc->setHtml(m_tree->toRichTextForPrint());
-        doc->setDefaultFont(serifFont);
-        QAbstractTextDocumentLayout* layout = doc->documentLayout();
-        layout->setPaintDevice(&printer);
-        doc->setPageSize(body.size());
-
-        QRectF view(0, 0, body.width(), body.height());
-        p.translate(body.left(), body.top());
-
-        QString programString = tr("QPaMaT - Password managing tool for Unix, Windows and MacOS X");
-        QString dateString = QDate::currentDate().toString(Qt::ISODate) + " / " +
-            QTime::currentTime().toString("hh:mm");
-
-        int page = 1;
-        do {
-            qApp->processEvents( QEventLoop::ExcludeUserInput );
-            QString pageS = tr("page") + " " + QString::number(page);
-
-            QAbstractTextDocumentLayout::PaintContext ctx;
-            p.setClipRect(view);
-            ctx.clip = view;
-            layout->draw(&p, ctx);
-
-            p.setClipping(false);
-            p.setFont(sansSerifFont);
-
-            int x_pos = qRound(( view.left() + p.fontMetrics().width(programString)
-                + view.right() - p.fontMetrics().width( pageS ) ) / 2.0
-                - p.fontMetrics().width( dateString ) / 2.0 );
-            int y_pos = qRound(view.bottom() + p.fontMetrics().ascent() + CON_MM(3));
-            p.drawLine(qRound(view.left()), qRound(view.bottom()+CON_MM(3)),
-                qRound(view.right()), qRound(view.bottom()+CON_MM(3)));
-            p.drawText( qRound(view.left()), y_pos, programString);
-            p.drawText( x_pos, y_pos, dateString );
-            p.drawText( qRound(view.right() - p.fontMetrics().width(pageS)), y_pos, pageS);
-
-            view.translate(0, body.height());
-            p.translate(0 , -body.height());
-
-            if (view.top() >= layout->documentSize().height())
-                break;
+    QPrinter* printer = new QPrinter(QPrinter::HighResolution);
+    printer->setFullPage(true);
 
-            printer.newPage();
-            page++;
-        }
-        while (true);
-        Q_ASSERT(page == doc->pageCount());
+    TreeEntry* selected = dynamic_cast<TreeEntry*>(m_tree->selectedItem());
+    QPrintDialog dialog(printer, this);
+    if (selected)
+        dialog.addEnabledOption(QAbstractPrintDialog::PrintSelection);
+    if (dialog.exec() != QDialog::Accepted) {
+        delete printer;
+        return;
+    }
 
-        delete doc;
+    QScopedPointer<TreeSnapshot> snapshot(
+        selected && printer->printRange() == QPrinter::Selection
+            ? new TreeSnapshot(selected)
+            : new TreeSnapshot(m_tree));
 
-        qApp->processEvents( QEventLoop::ExcludeUserInput );
-        qApp->restoreOverrideCursor();
+    PrintEngine* engine = new PrintEngine(printer, *snapshot, this);
+    if (engine->getEntryCount() == 0) {
+        delete engine;
+        message(tr("There are no entries to print."));
+        return;
     }
+
+    QFont serifFont;
+    QFont sansSerifFont;
+    serifFont.fromString(set().readEntry(Settings::PresentationNormalFont));
+    sansSerifFont.fromString(set().readEntry(Settings::PresentationFooterFont));
+    engine->setFonts(serifFont, sansSerifFont);
+
+    // the window stays responsive, but the data must not change while it's printed
+    QProgressDialog* progress = new QProgressDialog(tr("Printing..."), tr("&Cancel"), 0,
+        engine->getEntryCount(), this);
+    progress->setWindowModality(Qt::WindowModal);
+    progress->setMinimumDuration(500);
+    connect(engine, SIGNAL(progress(int, int)), progress, SLOT(setValue(int)));
+    connect(progress, SIGNAL(canceled()), engine, SLOT(cancel()));
+    connect(engine, SIGNAL(finished(bool)), progress, SLOT(deleteLater()));
+    connect(engine, SIGNAL(finished(bool)), engine, SLOT(deleteLater()));
+
+    m_printEngine = engine;
+    m_printProgress = progress;
+    engine->start();
+}
+
+
+/**
+ * @brief Aborts a running print job and destroys the copy of the data it holds.
+ *
+ * Called when the session is locked or ends. The pages that have not been sent to the
+ * printer are discarded.
+ */
+void QpamatWindow::cancelPrinting()
+{
+    delete m_printProgress;
+    delete m_printEngine;
 }
 
 
@@ -864,6 +1352,7 @@ void QpamatWindow::connectSignalsAndSlots()
     connect(m_actions.printAction, SIGNAL(activated()), this, SLOT(print()));
     connect(m_actions.saveAction, SIGNAL(activated()), this, SLOT(save()));
     connect(m_actions.exportAction, SIGNAL(activated()), this, SLOT(exportData()));
+    connect(m_actions.importAction, SIGNAL(activated()), this, SLOT(importData()));
 
     connect(m_actions.changePasswordAction, SIGNAL(activated()), this, SLOT(changePassword()));
     connect(m_actions.settingsAction, SIGNAL(activated()), this, SLOT(configure()));
@@ -876,9 +1365,13 @@ void QpamatWindow::connectSignalsAndSlots()
         m_randomPassword, SLOT(requestPassword()));
     connect(m_actions.clearClipboardAction, SIGNAL(activated()), SLOT(clearClipboard()));
 
+    // the configuration must be up to date for all other receivers
+    connect(this, SIGNAL(settingsChanged(const Settings::KeySet&)),
+        SLOT(applySettings(const Settings::KeySet&)));
+
     // password strength
     connect(m_actions.passwordStrengthAction, SIGNAL(toggled(bool)), SLOT(passwordStrengthHandler(bool)));
-    connect(this, SIGNAL(settingsChanged()), m_tree, SLOT(recomputePasswordStrength()));
+    connect(m_actions.reuseReportAction, SIGNAL(activated()), SLOT(showReuseReport()));
     connect(m_rightPanel, SIGNAL(passwordStrengthUpdated()), m_tree, SLOT(updatePasswordStrengthView()));
 
     // edit toolbar
@@ -887,6 +1380,11 @@ void QpamatWindow::connectSignalsAndSlots()
     connect(m_actions.removeItemAction, SIGNAL(activated()), m_tree, SLOT(deleteCurrent()));
     connect(m_actions.removeItemAction, SIGNAL(activated()), m_rightPanel, SLOT(deleteCurrent()));
 
+    // undo
+    connect(m_actions.undoAction, SIGNAL(activated()), SLOT(undo()));
+    connect(m_actions.redoAction, SIGNAL(activated()), SLOT(redo()));
+    connect(&m_undoStack, SIGNAL(changed()), SLOT(updateUndoActions()));
+
     // search function
     connect(m_searchCombo, SIGNAL(activated(int)), this, SLOT(search()));
     connect(m_actions.searchAction, SIGNAL(activated()), this, SLOT(search()));
@@ -902,7 +1400,12 @@ void QpamatWindow::connectSignalsAndSlots()
         SIGNAL(insertPassword(const QString&)));
 
     // auto logout
-    connect(dynamic_cast<TimeoutApplication*>(qApp), SIGNAL(timedOut()), SLOT(logout()));
+    connect(dynamic_cast<TimeoutApplication*>(qApp), SIGNAL(timedOut()), SLOT(lock()));
+
+    // autosave
+    connect(m_autoSaveTimer, SIGNAL(timeout()), SLOT(autoSave()));
+    connect(&m_autoSaver, SIGNAL(finished(AutoSaveJob*)), SLOT(autoSaveFinished(AutoSaveJob*)),
+        Qt::DirectConnection);
 
     // previously I used a hidden action for this, but this doesn't work in Qt4 any more
     QShortcut* focusSearch = new QShortcut(QKeySequence(Qt::CTRL|Qt::Key_G), this);
@@ -957,10 +1460,17 @@ void QpamatWindow::initActions()
     m_actions.saveAction = new QAction(createIcon("stock_save", "document-save"), tr("&Save"), this);
     m_actions.saveAction->setShortcut(QKeySequence(Qt::CTRL|Qt::Key_S));
     m_actions.exportAction = new QAction(tr("&Export..."), this);
+    m_actions.importAction = new QAction(tr("&Import..."), this);
     m_actions.printAction = new QAction(createIcon("stock_print", "document-print"),
                                         tr("&Print..."), this);
     m_actions.printAction->setShortcut(QKeySequence(Qt::CTRL|Qt::Key_P));
 
+    // ----- Edit ----------------------------------------------------------------------------------
+    m_actions.undoAction = new QAction(createIcon("stock_undo", "edit-undo"), tr("&Undo"), this);
+    m_actions.undoAction->setShortcut(QKeySequence::Undo);
+    m_actions.redoAction = new QAction(createIcon("stock_redo", "edit-redo"), tr("&Redo"), this);
+    m_actions.redoAction->setShortcut(QKeySequence::Redo);
+
     // ----- Options -------------------------------------------------------------------------------
     m_actions.changePasswordAction = new QAction(tr("&Change Password..."), this);
     m_actions.settingsAction = new QAction(createIcon("stock_preferences", "preferences-other"),
@@ -975,6 +1485,8 @@ void QpamatWindow::initActions()
     m_actions.passwordStrengthAction->setShortcut(QKeySequence(Qt::CTRL|Qt::Key_W));
     m_actions.passwordStrengthAction->setToggleAction(true);
 
+    m_actions.reuseReportAction = new QAction(tr("Password r&euse report..."), this);
+
     m_actions.clearClipboardAction = new QAction(tr("&Clear clipboard"), this);
     m_actions.clearClipboardAction->setShortcut(QKeySequence(Qt::CTRL|Qt::Key_E));
 
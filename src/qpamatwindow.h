@@ -24,15 +24,25 @@
 #include <QLabel>
 #include <QSystemTrayIcon>
 #include <QScopedPointer>
+#include <QTimer>
+#include <QSharedPointer>
+#include <QPointer>
+#include <QProgressDialog>
 
 #include "settings.h"
 #include "randompassword.h"
 #include "help.h"
+#include "undostack.h"
+#include "journal.h"
+#include "autosaver.h"
+#include "treesnapshot.h"
+#include "printengine.h"
 
 // forward declarations
 class Tree;
 class RightPanel;
 class TimerStatusmessage;
+class VaultKey;
 
 class QpamatWindow : public QMainWindow
 {
@@ -45,6 +55,8 @@ class QpamatWindow : public QMainWindow
         ~QpamatWindow();
 
         Settings& set();
+        const VaultConfig& getVaultConfig() const;
+        UndoStack& undoStack();
 
     public:
         static QIcon createIcon(const QString &qpamatName, const QString &freedesktopName = QString::null);
@@ -61,15 +73,26 @@ class QpamatWindow : public QMainWindow
         void clearClipboard();
         void setModified(bool modified = true);
         void passwordStrengthHandler(bool enabled);
+        void showReuseReport();
         void exportData();
-        bool exportOrSave();
+        void importData();
         void showHideWindow();
         void handleTrayiconClick(QSystemTrayIcon::ActivationReason reason);
         void exitHandler();
+        void undo();
+        void redo();
+        void updateUndoActions();
+        void autoSave();
+        void autoSaveFinished(AutoSaveJob* job);
+        void updateAutoSaveTimer();
+        bool lock();
+        bool unlock();
+        void readVaultConfig();
+        void applySettings(const Settings::KeySet& keys);
 
     signals:
         void insertPassword(const QString& password);
-        void settingsChanged();
+        void settingsChanged(const Settings::KeySet& keys);
         void quit();
 
     public slots:
@@ -82,6 +105,11 @@ class QpamatWindow : public QMainWindow
         void initActions();
         void connectSignalsAndSlots();
         void setLogin(bool login);
+        void updateViewAfterUndo();
+        void waitForAutoSave();
+        void cancelPrinting();
+        bool exportOrSave(const VaultConfig& config, bool journal = false);
+        void updateSessionActions();
 
     private:
         struct Actions
@@ -90,6 +118,7 @@ class QpamatWindow : public QMainWindow
             QAction* loginLogoutAction;
             QAction* saveAction;
             QAction* exportAction;
+            QAction* importAction;
             QAction* viewTreeAction;
             QAction* quitAction;
             QAction* quitActionNoKeyboardShortcut;
@@ -105,13 +134,17 @@ class QpamatWindow : public QMainWindow
             QAction* removeItemAction;
             QAction* randomPasswordAction;
             QAction* passwordStrengthAction;
+            QAction* reuseReportAction;
             QAction* clearClipboardAction;
             QAction* focusSearch;
+            QAction* undoAction;
+            QAction* redoAction;
         };
 
     private:
         QLabel*                            m_searchLabel;
         Settings                           m_settings;
+        VaultConfig                        m_vaultConfig;
         Tree*                              m_tree;
         QString                            m_password;
         Help                               m_help;
@@ -124,6 +157,17 @@ class QpamatWindow : public QMainWindow
         Actions                            m_actions;
         QSystemTrayIcon*                   m_trayIcon;
         QRect                              m_lastGeometry;
+        UndoStack                          m_undoStack;
+        Journal                            m_journal;
+        AutoSaver                          m_autoSaver;
+        QTimer*                            m_autoSaveTimer;
+        bool                               m_autoSavePending;
+        TreeSnapshot::Cache                m_snapshotCache;
+        quint32                            m_modificationSerial;
+        bool                               m_locked;
+        QSharedPointer<VaultKey>           m_lockKey;
+        QPointer<PrintEngine>              m_printEngine;
+        QPointer<QProgressDialog>          m_printProgress;
 
     private:
         QpamatWindow(const QpamatWindow&);
@@ -83,13 +83,13 @@ void RandomPassword::requestPassword()
 {
     PasswordGenerator* passwordgen = 0;
     QpamatWindow *win = Qpamat::instance()->getWindow();
-    QString allowed = win->set().readEntry("Security/AllowedCharacters");
+    QString allowed = win->set().readEntry(Settings::SecurityAllowedCharacters);
     PasswordChecker* checker = 0;
     try {
-        checker = new HybridPasswordChecker(win->set().readEntry("Security/DictionaryFile"));
+        checker = new HybridPasswordChecker(win->set().readEntry(Settings::SecurityDictionaryFile));
         passwordgen = PasswordGeneratorFactory::getGenerator(
-            win->set().readEntry( "Security/PasswordGenerator" ),
-            win->set().readEntry( "Security/PasswordGenAdditional" )
+            win->set().readEntry(Settings::SecurityPasswordGenerator),
+            win->set().readEntry(Settings::SecurityPasswordGenAdditional)
         );
     } catch (const std::exception& exc) {
         QMessageBox::warning(m_parent, "QPaMaT",
@@ -110,11 +110,11 @@ void RandomPassword::requestPassword()
 
         try {
             password = passwordgen->getPassword(
-                win->set().readNumEntry("Security/Length"),
-                win->set().readEntry("Security/AllowedCharacters")
+                win->set().readNumEntry(Settings::SecurityLength),
+                win->set().readEntry(Settings::SecurityAllowedCharacters)
             );
             double quality = checker->passwordQuality(password);
-            ok = quality > win->set().readDoubleEntry("StrongPasswordLimit");
+            ok = quality > win->set().readDoubleEntry(Settings::SecurityStrongPasswordLimit);
 
         } catch (const std::exception& exc) {
             if (passwordgen->isSlow())
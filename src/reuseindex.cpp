@@ -0,0 +1,277 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#include <QDebug>
+#include <QtAlgorithms>
+
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+
+#include "reuseindex.h"
+#include "property.h"
+#include "treeentry.h"
+#include "util/securestring.h"
+
+// -------------------------------------------------------------------------------------------------
+
+class KeyedHashReader : public SecureStringReader
+{
+    public:
+        KeyedHashReader(const QByteArray &key)
+            : m_key(key) {}
+
+        void read(const char *utf8, size_t size);
+
+        QByteArray hash() const
+            { return m_hash; }
+
+    private:
+        const QByteArray &m_key;
+        QByteArray m_hash;
+};
+
+
+void KeyedHashReader::read(const char *utf8, size_t size)
+{
+    if (size == 0)
+        return;
+
+    unsigned char md[EVP_MAX_MD_SIZE];
+    unsigned int length = 0;
+    HMAC(EVP_sha256(), m_key.constData(), m_key.size(),
+         reinterpret_cast<const unsigned char *>(utf8), size, md, &length);
+    m_hash = QByteArray(reinterpret_cast<const char *>(md), length);
+}
+
+// -------------------------------------------------------------------------------------------------
+
+static bool hasMoreProperties(const PropertyList &a, const PropertyList &b)
+{
+    return a.size() > b.size();
+}
+
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * @class ReuseIndex
+ *
+ * @brief Finds passwords that are used in more than one entry.
+ *
+ * Each password is hashed with HMAC-SHA256 and a random key that only lives in the memory of
+ * this process. The index maps the hashes to the properties, so the lookup for one password is a
+ * single hash table access and finding all reused passwords is one pass over the table. The
+ * passwords are never compared pair by pair.
+ *
+ * Properties report their changes with invalidate() and remove(). The hash is computed lazily
+ * on the next lookup, so a password is hashed once per change and passwords that are still
+ * encrypted after loading are not decrypted before the index is used. Then they are only
+ * decrypted into secure memory (see PropertyValue::borrow()). Properties that are currently
+ * not part of the tree (e.g. held by the undo stack) are ignored by the lookups and not
+ * hashed until they are attached again.
+ *
+ * The index is a singleton. It's not thread-safe, use it only from the GUI thread.
+ *
+ * @ingroup gui
+ * @author Bernhard Walle
+ */
+
+ReuseIndex *ReuseIndex::m_instance = NULL;
+
+
+/**
+ * @brief Returns the only instance of the ReuseIndex.
+ *
+ * @return the instance, never @c NULL
+ */
+ReuseIndex *ReuseIndex::instance()
+{
+    if (!m_instance) {
+        m_instance = new ReuseIndex();
+    }
+    return m_instance;
+}
+
+
+/**
+ * @brief Creates a new ReuseIndex with a new session key.
+ *
+ * Use instance() to get the singleton.
+ */
+ReuseIndex::ReuseIndex()
+    : m_sessionKey(32, '\0')
+{
+    unsigned char *key = reinterpret_cast<unsigned char *>(m_sessionKey.data());
+    if (RAND_bytes(key, m_sessionKey.size()) != 1) {
+        // the index is still correct, only the hashes in the memory are easier to attack
+        qWarning() << "ReuseIndex: RAND_bytes() failed, using a weak session key";
+        for (int i = 0; i < m_sessionKey.size(); i++)
+            key[i] = qrand() & 0xff;
+    }
+}
+
+
+/**
+ * @brief Marks the value or the type of @p property as changed.
+ *
+ * The old hash is dropped immediately, the new one is computed on the next lookup.
+ *
+ * @param property the property
+ */
+void ReuseIndex::invalidate(Property *property)
+{
+    remove(property);
+    m_pending.insert(property);
+}
+
+
+/**
+ * @brief Removes @p property from the index.
+ *
+ * Must be called before the property is deleted.
+ *
+ * @param property the property
+ */
+void ReuseIndex::remove(Property *property)
+{
+    m_pending.remove(property);
+
+    QHash<Property *, QByteArray>::iterator it = m_hashes.find(property);
+    if (it == m_hashes.end())
+        return;
+
+    QHash<QByteArray, PropertyList>::iterator bucket = m_buckets.find(it.value());
+    if (bucket != m_buckets.end()) {
+        bucket->removeOne(property);
+        if (bucket->isEmpty())
+            m_buckets.erase(bucket);
+    }
+    m_hashes.erase(it);
+}
+
+
+/**
+ * @brief Returns in how many other entries the password of @p property is used.
+ *
+ * @param property the property
+ * @return the number of other entries of the tree, 0 if @p property is no password
+ */
+int ReuseIndex::reuseCount(Property *property)
+{
+    update();
+
+    QHash<Property *, QByteArray>::const_iterator it = m_hashes.find(property);
+    if (it == m_hashes.end() || !isAttached(property))
+        return 0;
+
+    QSet<TreeEntry *> entries;
+    foreach (Property *other, m_buckets.value(it.value()))
+        if (other->getEntry() != property->getEntry() && isAttached(other))
+            entries.insert(other->getEntry());
+
+    return entries.size();
+}
+
+
+/**
+ * @brief Returns all passwords that are used in more than one entry.
+ *
+ * @return one list of properties per password, the most reused passwords first
+ */
+QList<PropertyList> ReuseIndex::reusedPasswords()
+{
+    update();
+
+    QList<PropertyList> result;
+    QHash<QByteArray, PropertyList>::const_iterator it;
+    for (it = m_buckets.begin(); it != m_buckets.end(); ++it) {
+        if (it.value().size() < 2)
+            continue;
+
+        PropertyList attached;
+        QSet<TreeEntry *> entries;
+        foreach (Property *property, it.value()) {
+            if (isAttached(property)) {
+                attached.append(property);
+                entries.insert(property->getEntry());
+            }
+        }
+        if (entries.size() > 1)
+            result.append(attached);
+    }
+
+    qStableSort(result.begin(), result.end(), hasMoreProperties);
+    return result;
+}
+
+
+/**
+ * @brief Hashes the properties of the tree that changed since the last lookup.
+ *
+ * Properties that are not attached stay pending, so the undo stack doesn't cause their
+ * values to be decrypted.
+ */
+void ReuseIndex::update()
+{
+    QSet<Property *>::iterator it = m_pending.begin();
+    while (it != m_pending.end()) {
+        Property *property = *it;
+        if (!isAttached(property)) {
+            ++it;
+            continue;
+        }
+        it = m_pending.erase(it);
+
+        QByteArray hash = keyedHash(property);
+        if (hash.isEmpty())
+            continue;
+
+        m_hashes.insert(property, hash);
+        m_buckets[hash].append(property);
+    }
+}
+
+
+/**
+ * @brief Computes the keyed hash of the value of @p property.
+ *
+ * The value is read as UTF-8 from secure memory, no QString of the password is created.
+ *
+ * @param property the property
+ * @return the hash or an empty array if @p property is no password or the password is empty
+ */
+QByteArray ReuseIndex::keyedHash(const Property *property) const
+{
+    if (property->getType() != Property::PASSWORD)
+        return QByteArray();
+
+    KeyedHashReader reader(m_sessionKey);
+    property->borrowValue(reader);
+    return reader.hash();
+}
+
+
+/**
+ * @brief Checks if @p property belongs to an entry that is part of the tree.
+ *
+ * @param property the property
+ * @return @c true if the property is attached, @c false otherwise
+ */
+bool ReuseIndex::isAttached(const Property *property)
+{
+    const TreeEntry *entry = property->getEntry();
+    return entry && entry->listView();
+}
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
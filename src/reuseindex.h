@@ -0,0 +1,57 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#ifndef REUSEINDEX_H
+#define REUSEINDEX_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QSet>
+
+class Property;
+
+typedef QList<Property *> PropertyList;
+
+class ReuseIndex
+{
+    public:
+        static ReuseIndex *instance();
+
+    private:
+        ReuseIndex();
+
+    public:
+        void invalidate(Property *property);
+        void remove(Property *property);
+
+        int reuseCount(Property *property);
+        QList<PropertyList> reusedPasswords();
+
+    private:
+        void update();
+        QByteArray keyedHash(const Property *property) const;
+        static bool isAttached(const Property *property);
+
+    private:
+        static ReuseIndex                   *m_instance;
+        QByteArray                          m_sessionKey;
+        QSet<Property *>                    m_pending;
+        QHash<Property *, QByteArray>       m_hashes;
+        QHash<QByteArray, PropertyList>     m_buckets;
+};
+
+#endif // REUSEINDEX_H
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
@@ -29,6 +29,8 @@
 #include "qpamat.h"
 #include "global.h"
 #include "rightlistview.h"
+#include "changebatch.h"
+#include "undocommands.h"
 #include "dialogs/showpassworddialog.h"
 #include "help.h"
 
@@ -108,6 +110,8 @@ RightListView::RightListView(QWidget* parent)
     connect(this, SIGNAL(currentChanged(Q3ListViewItem*)), SLOT(setMoveStateCorrect()));
     connect(this, SIGNAL(mouseButtonClicked(int, Q3ListViewItem*, const QPoint&, int)),
         SLOT(mouseButtonClickedHandler(int, Q3ListViewItem*, const QPoint&, int)));
+    connect(ChangeNotifier::instance(), SIGNAL(batchFlushed(BatchedNotifierSet)),
+        SLOT(updateChanged(BatchedNotifierSet)));
 }
 
 
@@ -151,7 +155,8 @@ void RightListView::showContextMenu(Q3ListViewItem* item, const QPoint& point)
         case M_DELETE:
         {
             int num = item->text(2).toInt(0);
-            m_currentItem->deleteProperty(num);
+            Qpamat::instance()->getWindow()->undoStack().push(
+                new RemovePropertyCommand(m_currentItem, num));
             emit itemDeleted(num);
             break;
         }
@@ -161,7 +166,8 @@ void RightListView::showContextMenu(Q3ListViewItem* item, const QPoint& point)
             break;
 
         case M_NEW:
-            m_currentItem->appendProperty(new Property());
+            Qpamat::instance()->getWindow()->undoStack().push(
+                new InsertPropertyCommand(m_currentItem, new Property()));
             emit stateModified();
             break;
 
@@ -212,6 +218,25 @@ void RightListView::keyPressEvent(QKeyEvent* evt)
 }
 
 
+/**
+ * @brief Copies a borrowed property value into the clipboard.
+ */
+class ClipboardReader : public SecureQStringReader
+{
+    public:
+        void readString(const QString &text)
+        {
+            // the clipboard keeps the string, so it needs a deep copy
+            QString copy(text.unicode(), text.length());
+            QClipboard* clip = QApplication::clipboard();
+            clip->setText(copy, QClipboard::Clipboard);
+
+            if (clip->supportsSelection())
+                clip->setText(copy, QClipboard::Selection);
+        }
+};
+
+
 /**
  * @brief Copies a item into the clipboard.
  *
@@ -221,11 +246,8 @@ void RightListView::copyItem(Q3ListViewItem* item)
 {
     if (item != 0) {
         Property* property = m_currentItem->getProperty(item->text(2).toInt(0));
-        QClipboard* clip = QApplication::clipboard();
-        clip->setText(property->getValue(), QClipboard::Clipboard);
-
-        if (clip->supportsSelection())
-            clip->setText(property->getValue(), QClipboard::Selection);
+        ClipboardReader reader;
+        property->borrowValue(reader);
     }
 }
 
@@ -296,18 +318,26 @@ void RightListView::updateView()
 
 
 /**
- * @brief Updates the selected.
+ * @brief Updates the rows of the properties that have changed.
+ *
+ * Called once per ChangeBatch, regardless how many properties have changed.
  *
- * @param property the property
+ * @param changed the changed objects
  */
-void RightListView::updateSelected(Property* property)
+void RightListView::updateChanged(const BatchedNotifierSet& changed)
 {
-    Q3ListViewItem* item = selectedItem();
+    if (!m_currentItem || m_currentItem->isCategory())
+        return;
 
-    if (item != 0) {
-        item->setText(0, property->getKey());
-        QString value = property->getValue();
-        item->setText(1, property->getVisibleValue());
+    // the rows are in the same order as the properties, see updateView()
+    TreeEntry::PropertyIterator it = m_currentItem->propertyIterator();
+    for (Q3ListViewItem* item = firstChild(); item && it.current();
+            item = item->nextSibling(), ++it) {
+        Property* property = it.current();
+        if (changed.contains(property)) {
+            item->setText(0, property->getKey());
+            item->setText(1, property->getVisibleValue());
+        }
     }
 }
 
@@ -337,7 +367,8 @@ void RightListView::deleteCurrent()
     Q3ListViewItem* selected = selectedItem();
     if (selected) {
         int num = selected->text(2).toInt(0);
-        m_currentItem->deleteProperty(num);
+        Qpamat::instance()->getWindow()->undoStack().push(
+            new RemovePropertyCommand(m_currentItem, num));
         emit itemDeleted(num);
     } else {
         QpamatWindow *win = Qpamat::instance()->getWindow();
@@ -351,7 +382,8 @@ void RightListView::deleteCurrent()
  */
 void RightListView::insertAtCurrentPos()
 {
-    m_currentItem->appendProperty(new Property());
+    Qpamat::instance()->getWindow()->undoStack().push(
+        new InsertPropertyCommand(m_currentItem, new Property()));
 }
 
 
@@ -386,7 +418,8 @@ void RightListView::moveDown()
     if (selected) {
         int index = selected->text(2).toInt(0);
         // up in list terminology means greater index
-        m_currentItem->movePropertyOneUp(index);
+        Qpamat::instance()->getWindow()->undoStack().push(
+            new SwapPropertiesCommand(m_currentItem, index));
         updateView();
         setSelectedIndex(index+1);
         emit stateModified();
@@ -406,7 +439,8 @@ void RightListView::moveUp()
     if (selected) {
         int index = selected->text(2).toInt(0);
         // up in list terminology means greater index
-        m_currentItem->movePropertyOneDown(index);
+        Qpamat::instance()->getWindow()->undoStack().push(
+            new SwapPropertiesCommand(m_currentItem, index-1));
         updateView();
         setSelectedIndex(index-1);
         emit stateModified();
@@ -21,6 +21,7 @@
 #include <Q3PopupMenu>
 #include <QTextStream>
 #include <QKeyEvent>
+#include <QPointer>
 
 #include "property.h"
 #include "treeentry.h"
@@ -57,7 +58,7 @@ class RightListView : public Q3ListView
         void keyPressEvent(QKeyEvent* evt);
 
     private slots:
-        void updateSelected(Property* property);
+        void updateChanged(const BatchedNotifierSet& changed);
         void showContextMenu(Q3ListViewItem* item, const QPoint& point);
         void copyItem(Q3ListViewItem* item);
         void doubleClickHandler(Q3ListViewItem* item);
@@ -75,8 +76,8 @@ class RightListView : public Q3ListView
         void initContextMenu();
 
     private:
-        TreeEntry*  m_currentItem;
-        Q3PopupMenu* m_contextMenu;
+        QPointer<TreeEntry> m_currentItem;
+        Q3PopupMenu*        m_contextMenu;
 
 };
 
@@ -172,6 +172,17 @@ void RightPanel::setEnabled(bool enabled)
 }
 
 
+/**
+ * @brief Drops the password checker that rates the password while the user types it.
+ *
+ * Must be called before the password strength is computed with a changed configuration.
+ */
+void RightPanel::resetPasswordChecker()
+{
+    m_southPanel->resetPasswordChecker();
+}
+
+
 /**
  * @brief Sets the current item.
  *
@@ -202,13 +213,8 @@ void RightPanel::setItem(Q3ListViewItem* item)
  */
 void RightPanel::selectionChangeHandler(Q3ListViewItem* item)
 {
-    disconnect(m_listView, SLOT(updateSelected(Property*)));
-
     Property* currentProperty = m_currentItem->getProperty(item->text(2).toInt(0));
     m_southPanel->setItem(currentProperty);
-
-    connect(currentProperty, SIGNAL(propertyChanged(Property*)),
-        m_listView, SLOT(updateSelected(Property*)));
 }
 
 
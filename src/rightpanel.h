@@ -41,6 +41,7 @@ class RightPanel : public Q3Frame
         void setItem(Q3ListViewItem* item);
         void clear();
         void setEnabled(bool enabled);
+        void resetPasswordChecker();
         void deleteCurrent();
         void insertAtCurrentPos();
 
@@ -14,7 +14,7 @@
  */
 #include <QString>
 #include <QStringList>
-#include <Q3CString>
+#include <QByteArray>
 
 #include "global.h"
 #include "abstractencryptor.h"
@@ -38,10 +38,10 @@
  */
 ByteVector AbstractEncryptor::encryptStrToBytes(const QString& string)
 {
-    Q3CString utf8CString = string.utf8();
+    QByteArray utf8CString = string.toUtf8();
     unsigned int utf8Length = utf8CString.length();
     ByteVector vector(utf8Length);
-    const unsigned char* utf8 = (const unsigned char*)utf8CString.data();
+    const unsigned char* utf8 = (const unsigned char*)utf8CString.constData();
     qCopy(utf8, utf8 + utf8Length, vector.begin());
     return encrypt(vector);
 }
@@ -56,6 +56,21 @@ QString AbstractEncryptor::encryptStrToStr(const QString& string)
 }
 
 
+/**
+ * @copydoc StringEncryptor::encryptUtf8ToStr
+ *
+ * The temporary copy of the plain text is zeroed afterwards.
+ */
+QString AbstractEncryptor::encryptUtf8ToStr(const char* utf8, size_t size)
+{
+    ByteVector vector(size);
+    qCopy(utf8, utf8 + size, vector.begin());
+    ByteVector encrypted = encrypt(vector);
+    qFill(vector.begin(), vector.end(), 0);
+    return EncodingHelper::toBase64(encrypted);
+}
+
+
 /**
  * @copydoc Encryptor::decryptStrFromBytes
  */
@@ -82,4 +97,18 @@ QString AbstractEncryptor::decryptStrFromStr(const QString& string)
     return decryptStrFromBytes(EncodingHelper::fromBase64(string));
 }
 
+
+/**
+ * @copydoc StringEncryptor::decryptSecureFromStr
+ *
+ * The temporary copy of the plain text is zeroed afterwards.
+ */
+SecureString AbstractEncryptor::decryptSecureFromStr(const QString& string)
+{
+    ByteVector decrypted = decrypt(EncodingHelper::fromBase64(string));
+    SecureString result(reinterpret_cast<const char*>(decrypted.constData()), decrypted.size());
+    qFill(decrypted.begin(), decrypted.end(), 0);
+    return result;
+}
+
 // vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
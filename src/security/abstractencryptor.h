@@ -26,9 +26,11 @@ class AbstractEncryptor : public Encryptor
     public:
         ByteVector encryptStrToBytes(const QString& string);
         QString encryptStrToStr(const QString& string);
+        QString encryptUtf8ToStr(const char* utf8, size_t size);
 
         QString decryptStrFromBytes(const ByteVector& vector);
         QString decryptStrFromStr(const QString& string);
+        SecureString decryptSecureFromStr(const QString& string);
 };
 
 #endif // ABSTRACTENCRYPTOR_H
@@ -0,0 +1,621 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#include <cstring>
+#include <cmath>
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QVector>
+
+#include <openssl/evp.h>
+
+#include "global.h"
+#include "breachcorpus.h"
+
+// -------------------------------------------------------------------------------------------------
+//                                     Static data
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * Size of a SHA-1 hash in bytes.
+ */
+const int BreachCorpus::HASH_SIZE = 20;
+
+#define BLOOM_MAGIC             "QPBLOOM1"
+#define HASHES_MAGIC            "QPSHA1S1"
+#define CORPUS_BYTE_ORDER       quint16(0x0102)
+#define CORPUS_VERSION          quint16(1)
+#define CORPUS_HEADER_SIZE      64
+#define BLOOM_BLOCK_SIZE        64
+#define BLOOM_MAX_PROBES        7
+#define FANOUT_SIZE             (65536 + 1)
+
+static QMutex                       s_openMutex;
+static QSharedPointer<BreachCorpus> s_corpus;
+static QString                      s_corpusFileName;
+
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Computes the bits of @p sha1 in the Bloom filter.
+ *
+ * All bits of one hash are in the same block of 64 bytes, so a lookup touches only one cache
+ * line. SHA-1 is uniformly distributed, so the block and the bit positions are taken from the
+ * hash itself: the first 8 bytes select the block, the next 8 bytes provide 9 bits per probe.
+ *
+ * @param sha1 the hash
+ * @param blockCount the number of blocks in the filter
+ * @param probes the number of bits per hash
+ * @param mask receives the bits for each of the 8 words of the block
+ * @return the index of the block
+ */
+static quint64 bloomProbe(const unsigned char* sha1, quint64 blockCount, int probes,
+                          quint64 mask[8])
+{
+    quint64 h1, h2;
+    std::memcpy(&h1, sha1, sizeof(h1));
+    std::memcpy(&h2, sha1 + 8, sizeof(h2));
+
+    std::memset(mask, 0, 8 * sizeof(quint64));
+    for (int i = 0; i < probes; ++i) {
+        int bit = int(h2 >> (9 * i)) & 511;
+        mask[bit >> 6] |= Q_UINT64_C(1) << (bit & 63);
+    }
+
+    return h1 % blockCount;
+}
+
+
+/**
+ * @brief Returns the index in the fanout table for @p sha1.
+ *
+ * @param sha1 the hash
+ * @return the first two bytes as number
+ */
+static inline int fanoutIndex(const unsigned char* sha1)
+{
+    return (sha1[0] << 8) | sha1[1];
+}
+
+
+/**
+ * @brief Parses the SHA-1 at the beginning of a line of a HIBP dump.
+ *
+ * @param line the line, the hash may be followed by <tt>:count</tt>
+ * @param length the length of the line
+ * @param sha1 receives the hash
+ * @return @c true on success, @c false if the line doesn't start with 40 hex digits
+ */
+static bool parseHexHash(const char* line, qint64 length, unsigned char* sha1)
+{
+    if (length < 2 * BreachCorpus::HASH_SIZE)
+        return false;
+
+    for (int i = 0; i < 2 * BreachCorpus::HASH_SIZE; ++i) {
+        char c = line[i];
+        int nibble;
+        if (c >= '0' && c <= '9')
+            nibble = c - '0';
+        else if (c >= 'A' && c <= 'F')
+            nibble = c - 'A' + 10;
+        else if (c >= 'a' && c <= 'f')
+            nibble = c - 'a' + 10;
+        else
+            return false;
+
+        if (i % 2 == 0)
+            sha1[i / 2] = nibble << 4;
+        else
+            sha1[i / 2] |= nibble;
+    }
+
+    if (length > 2 * BreachCorpus::HASH_SIZE) {
+        char c = line[2 * BreachCorpus::HASH_SIZE];
+        return c == ':' || c == '\r' || c == '\n' || c == ' ' || c == '\t';
+    }
+    return true;
+}
+
+
+/**
+ * @brief Fills the common part of the header of both files.
+ *
+ * @param header the header with CORPUS_HEADER_SIZE bytes
+ * @param magic the magic string with 8 characters
+ * @param count the number of hashes
+ */
+static void fillHeader(uchar* header, const char* magic, quint64 count)
+{
+    quint16 byteOrder = CORPUS_BYTE_ORDER;
+    quint16 version = CORPUS_VERSION;
+
+    std::memset(header, 0, CORPUS_HEADER_SIZE);
+    std::memcpy(header, magic, 8);
+    std::memcpy(header + 8, &byteOrder, sizeof(byteOrder));
+    std::memcpy(header + 10, &version, sizeof(version));
+    std::memcpy(header + 16, &count, sizeof(count));
+}
+
+
+/**
+ * @brief Writes @p size bytes to @p file.
+ *
+ * @param file the file
+ * @param data the data
+ * @param size the number of bytes
+ * @return @c true if everything has been written, @c false otherwise
+ */
+static bool writeAll(QFile& file, const char* data, qint64 size)
+{
+    return file.write(data, size) == size;
+}
+
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * @class BreachCorpus
+ *
+ * @brief Local corpus of passwords that have been published in data breaches.
+ *
+ * The corpus is built from the SHA-1 dumps of "Have I Been Pwned" by BreachCorpusBuilder or
+ * the <tt>qpamat-breachindex</tt> tool. It consists of two files that are memory-mapped, so
+ * the memory that is used is managed by the operating system and not limited by the size of
+ * the corpus:
+ *
+ *   - the Bloom filter (<tt>*.bloom</tt>) answers most lookups of passwords that are not in
+ *     the corpus by reading a single cache line,
+ *   - the sorted hashes (<tt>*.sha1</tt>) confirm the hits of the Bloom filter. A fanout table
+ *     with the position of each 16 bit prefix limits the binary search to a few thousand
+ *     hashes even for hundreds of millions of passwords.
+ *
+ * Both files start with a header of 64 bytes: the magic, the byte order mark @c 0x0102 and the
+ * version as @c quint16, the number of Bloom filter probes as @c quint32 (only in the
+ * <tt>.bloom</tt> file) and the number of hashes as @c quint64. The Bloom filter file also
+ * stores the number of blocks as @c quint64 at offset 24. The numbers are in the byte order of
+ * the machine that built the corpus.
+ *
+ * A lookup doesn't change the object, so the same corpus can be used from several threads.
+ *
+ * @ingroup security
+ * @author Bernhard Walle
+ */
+
+/**
+ * @brief Opens the corpus.
+ *
+ * @param fileName the name of the Bloom filter, the sorted hashes are read from
+ *                 hashFileName()
+ * @exception PasswordCheckException if one of the files cannot be read
+ */
+BreachCorpus::BreachCorpus(const QString& fileName)
+    : m_bloomFile(fileName)
+    , m_hashFile(hashFileName(fileName))
+    , m_bloom(0)
+    , m_hashes(0)
+    , m_fanout(0)
+    , m_blockCount(0)
+    , m_count(0)
+    , m_probes(0)
+{
+    const uchar* bloom = map(m_bloomFile, BLOOM_MAGIC);
+    const uchar* hashes = map(m_hashFile, HASHES_MAGIC);
+
+    quint32 probes;
+    quint64 bloomCount;
+    std::memcpy(&probes, bloom + 12, sizeof(probes));
+    std::memcpy(&bloomCount, bloom + 16, sizeof(bloomCount));
+    std::memcpy(&m_blockCount, bloom + 24, sizeof(m_blockCount));
+    std::memcpy(&m_count, hashes + 16, sizeof(m_count));
+
+    // divide instead of multiplying the counts, a damaged header must not overflow
+    const quint64 fanoutEnd = CORPUS_HEADER_SIZE + FANOUT_SIZE * sizeof(quint64);
+    const quint64 bloomSize = quint64(m_bloomFile.size());
+    const quint64 hashSize = quint64(m_hashFile.size());
+    if (probes < 1 || probes > BLOOM_MAX_PROBES || m_blockCount == 0 || bloomCount != m_count ||
+            m_blockCount > (bloomSize - CORPUS_HEADER_SIZE) / BLOOM_BLOCK_SIZE ||
+            hashSize < fanoutEnd || m_count > (hashSize - fanoutEnd) / HASH_SIZE)
+        throw PasswordCheckException(QString("The breach corpus %1 is damaged.").arg(
+            fileName).latin1());
+
+    // findHash() trusts the fanout table, it must not point outside of the hashes
+    const quint64* fanout = reinterpret_cast<const quint64*>(hashes + CORPUS_HEADER_SIZE);
+    bool fanoutValid = fanout[0] == 0 && fanout[FANOUT_SIZE - 1] == m_count;
+    for (int i = 1; fanoutValid && i < FANOUT_SIZE; ++i)
+        fanoutValid = fanout[i - 1] <= fanout[i];
+    if (!fanoutValid)
+        throw PasswordCheckException(QString("The breach corpus %1 is damaged.").arg(
+            fileName).latin1());
+
+    m_probes = probes;
+    m_bloom = bloom + CORPUS_HEADER_SIZE;
+    m_fanout = fanout;
+    m_hashes = hashes + fanoutEnd;
+}
+
+
+/**
+ * @brief Unmaps the files.
+ */
+BreachCorpus::~BreachCorpus()
+{
+    m_bloomFile.close();
+    m_hashFile.close();
+}
+
+
+/**
+ * @brief Checks if @p password is in the corpus.
+ *
+ * @param password the password
+ * @return @c true if it has been published, @c false otherwise
+ */
+bool BreachCorpus::contains(const QString& password) const
+{
+    QByteArray utf8 = password.toUtf8();
+    unsigned char sha1[EVP_MAX_MD_SIZE];
+    unsigned int length = 0;
+    EVP_Digest(utf8.constData(), utf8.size(), sha1, &length, EVP_sha1(), NULL);
+    utf8.fill('\0');
+
+    return containsHash(sha1);
+}
+
+
+/**
+ * @brief Checks if the SHA-1 hash @p sha1 is in the corpus.
+ *
+ * @param sha1 the hash with HASH_SIZE bytes
+ * @return @c true if it is in the corpus, @c false otherwise
+ */
+bool BreachCorpus::containsHash(const unsigned char* sha1) const
+{
+    return mayContain(sha1) && findHash(sha1);
+}
+
+
+/**
+ * @brief Returns the number of hashes in the corpus.
+ *
+ * @return the number of hashes
+ */
+quint64 BreachCorpus::size() const
+{
+    return m_count;
+}
+
+
+/**
+ * @brief Returns the opened corpus @p fileName.
+ *
+ * The last corpus is kept open and returned again if the file name is the same, like the
+ * dictionary of the HybridPasswordChecker.
+ *
+ * @param fileName the name of the Bloom filter file
+ * @return the corpus
+ * @exception PasswordCheckException if the corpus cannot be opened
+ */
+QSharedPointer<BreachCorpus> BreachCorpus::open(const QString& fileName)
+{
+    QMutexLocker locker(&s_openMutex);
+
+    if (s_corpus.isNull() || s_corpusFileName != fileName) {
+        s_corpus.clear();
+        s_corpus = QSharedPointer<BreachCorpus>(new BreachCorpus(fileName));
+        s_corpusFileName = fileName;
+    }
+    return s_corpus;
+}
+
+
+/**
+ * @brief Returns the name of the file with the sorted hashes.
+ *
+ * @param fileName the name of the Bloom filter
+ * @return @p fileName with the suffix <tt>.sha1</tt> instead of <tt>.bloom</tt>
+ */
+QString BreachCorpus::hashFileName(const QString& fileName)
+{
+    QString name = fileName;
+    if (name.endsWith(".bloom"))
+        name.chop(6);
+    return name + ".sha1";
+}
+
+
+/**
+ * @brief Checks the Bloom filter.
+ *
+ * @param sha1 the hash
+ * @return @c false if the hash is not in the corpus, @c true if it may be
+ */
+bool BreachCorpus::mayContain(const unsigned char* sha1) const
+{
+    quint64 mask[8];
+    quint64 block = bloomProbe(sha1, m_blockCount, m_probes, mask);
+    const quint64* words = reinterpret_cast<const quint64*>(m_bloom + block * BLOOM_BLOCK_SIZE);
+
+    for (int i = 0; i < 8; ++i)
+        if ((words[i] & mask[i]) != mask[i])
+            return false;
+    return true;
+}
+
+
+/**
+ * @brief Searches @p sha1 in the sorted hashes.
+ *
+ * @param sha1 the hash
+ * @return @c true if it has been found, @c false otherwise
+ */
+bool BreachCorpus::findHash(const unsigned char* sha1) const
+{
+    int prefix = fanoutIndex(sha1);
+    quint64 low = m_fanout[prefix];
+    quint64 high = m_fanout[prefix + 1];
+
+    while (low < high) {
+        quint64 middle = low + (high - low) / 2;
+        int cmp = std::memcmp(m_hashes + middle * HASH_SIZE, sha1, HASH_SIZE);
+        if (cmp == 0)
+            return true;
+        else if (cmp < 0)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return false;
+}
+
+
+/**
+ * @brief Opens and maps @p file and checks the header.
+ *
+ * @param file the file
+ * @param magic the expected magic
+ * @return the mapped file
+ * @exception PasswordCheckException if the file cannot be mapped or the header is wrong
+ */
+const uchar* BreachCorpus::map(QFile& file, const char* magic)
+{
+    if (!file.open(QIODevice::ReadOnly))
+        throw PasswordCheckException(QString("Could not open the file %1.").arg(
+            file.fileName()).latin1());
+
+    const uchar* data = file.size() >= CORPUS_HEADER_SIZE ? file.map(0, file.size()) : 0;
+    if (!data)
+        throw PasswordCheckException(QString("Could not map the file %1.").arg(
+            file.fileName()).latin1());
+
+    quint16 byteOrder, version;
+    std::memcpy(&byteOrder, data + 8, sizeof(byteOrder));
+    std::memcpy(&version, data + 10, sizeof(version));
+    if (std::memcmp(data, magic, 8) != 0 || byteOrder != CORPUS_BYTE_ORDER ||
+            version != CORPUS_VERSION)
+        throw PasswordCheckException(QString("The file %1 is no breach corpus of this "
+            "platform.").arg(file.fileName()).latin1());
+
+    return data;
+}
+
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * @class BreachCorpusBuilder
+ *
+ * @brief Builds a BreachCorpus from a SHA-1 dump of "Have I Been Pwned".
+ *
+ * The input must be sorted by the hash ("ordered by hash" download), each line starts with
+ * the 40 hex digits of the SHA-1, optionally followed by <tt>:count</tt>. The build makes two
+ * passes: the input is read once and written to the sorted hash file, then the Bloom filter
+ * is built in a second pass over the mapped hash file, because its size depends on the number
+ * of hashes. So the input can be a pipe, it's never read twice. Both files are written through
+ * memory maps or streams, so the memory that is needed doesn't depend on the size of the
+ * input.
+ *
+ * @ingroup security
+ * @author Bernhard Walle
+ */
+
+/**
+ * @brief Creates a new builder.
+ *
+ * @param fileName the name of the Bloom filter, see BreachCorpus::hashFileName()
+ */
+BreachCorpusBuilder::BreachCorpusBuilder(const QString& fileName)
+    : m_fileName(fileName)
+    , m_bitsPerEntry(10)
+    , m_count(0)
+{}
+
+
+/**
+ * @brief Sets the size of the Bloom filter.
+ *
+ * The default of 10 bits gives about 1 % false positives, which only cost a lookup in the
+ * sorted hashes.
+ *
+ * @param bits the number of bits per hash
+ */
+void BreachCorpusBuilder::setBitsPerEntry(int bits)
+{
+    m_bitsPerEntry = qMax(bits, 1);
+}
+
+
+/**
+ * @brief Builds the corpus.
+ *
+ * @param input the HIBP dump
+ * @return @c true on success, @c false on failure, see errorString()
+ */
+bool BreachCorpusBuilder::build(QIODevice& input)
+{
+    m_error = QString::null;
+    m_count = 0;
+    return writeHashes(input) && writeBloomFilter();
+}
+
+
+/**
+ * @brief Returns the description of the last error.
+ *
+ * @return the description
+ */
+QString BreachCorpusBuilder::errorString() const
+{
+    return m_error;
+}
+
+
+/**
+ * @brief Returns the number of hashes that have been written.
+ *
+ * @return the number of distinct hashes of the input
+ */
+quint64 BreachCorpusBuilder::size() const
+{
+    return m_count;
+}
+
+
+/**
+ * @brief Writes the sorted hash file with the fanout table.
+ *
+ * @param input the HIBP dump
+ * @return @c true on success, @c false on failure
+ */
+bool BreachCorpusBuilder::writeHashes(QIODevice& input)
+{
+    QFile file(BreachCorpus::hashFileName(m_fileName));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        m_error = file.fileName() + ": " + file.errorString();
+        return false;
+    }
+
+    // the header and the fanout table are written when the counts are known
+    QVector<quint64> fanout(FANOUT_SIZE, 0);
+    const QByteArray placeholder(CORPUS_HEADER_SIZE + FANOUT_SIZE * sizeof(quint64), '\0');
+    if (!writeAll(file, placeholder.constData(), placeholder.size())) {
+        m_error = file.fileName() + ": " + file.errorString();
+        return false;
+    }
+
+    char line[256];
+    unsigned char sha1[BreachCorpus::HASH_SIZE];
+    unsigned char previous[BreachCorpus::HASH_SIZE];
+    qint64 length;
+    qint64 lineNumber = 0;
+    while ((length = input.readLine(line, sizeof(line))) > 0) {
+        ++lineNumber;
+        if (line[0] == '\n' || line[0] == '\r')
+            continue;
+
+        if (!parseHexHash(line, length, sha1)) {
+            m_error = QString("Line %1: no SHA-1 hash").arg(lineNumber);
+            return false;
+        }
+
+        if (m_count > 0) {
+            int cmp = std::memcmp(sha1, previous, BreachCorpus::HASH_SIZE);
+            if (cmp == 0)
+                continue;
+            if (cmp < 0) {
+                m_error = QString("Line %1: the input is not sorted by hash").arg(lineNumber);
+                return false;
+            }
+        }
+
+        if (!writeAll(file, reinterpret_cast<const char*>(sha1), BreachCorpus::HASH_SIZE)) {
+            m_error = file.fileName() + ": " + file.errorString();
+            return false;
+        }
+        std::memcpy(previous, sha1, BreachCorpus::HASH_SIZE);
+        ++fanout[fanoutIndex(sha1) + 1];
+        ++m_count;
+    }
+
+    for (int i = 1; i < FANOUT_SIZE; ++i)
+        fanout[i] += fanout[i - 1];
+
+    uchar header[CORPUS_HEADER_SIZE];
+    fillHeader(header, HASHES_MAGIC, m_count);
+    bool written = file.seek(0) &&
+        writeAll(file, reinterpret_cast<const char*>(header), CORPUS_HEADER_SIZE) &&
+        writeAll(file, reinterpret_cast<const char*>(fanout.constData()),
+                 FANOUT_SIZE * sizeof(quint64));
+    file.close();
+
+    if (!written || file.error() != QFile::NoError) {
+        m_error = file.fileName() + ": " + file.errorString();
+        return false;
+    }
+    return true;
+}
+
+
+/**
+ * @brief Writes the Bloom filter for the hashes written by writeHashes().
+ *
+ * @return @c true on success, @c false on failure
+ */
+bool BreachCorpusBuilder::writeBloomFilter()
+{
+    QFile hashFile(BreachCorpus::hashFileName(m_fileName));
+    QFile bloomFile(m_fileName);
+    if (!hashFile.open(QIODevice::ReadOnly)) {
+        m_error = hashFile.fileName() + ": " + hashFile.errorString();
+        return false;
+    }
+    if (!bloomFile.open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+        m_error = bloomFile.fileName() + ": " + bloomFile.errorString();
+        return false;
+    }
+
+    // k = ln 2 * bits per entry is optimal, but all bits must be taken from 63 bits of the hash
+    quint32 probes = qBound(1, qRound(m_bitsPerEntry * std::log(2.0)), BLOOM_MAX_PROBES);
+    quint64 bits = qMax(m_count, Q_UINT64_C(1)) * m_bitsPerEntry;
+    quint64 blockCount = (bits + 8 * BLOOM_BLOCK_SIZE - 1) / (8 * BLOOM_BLOCK_SIZE);
+
+    const qint64 bloomSize = CORPUS_HEADER_SIZE + blockCount * BLOOM_BLOCK_SIZE;
+    uchar* bloom = bloomFile.resize(bloomSize) ? bloomFile.map(0, bloomSize) : 0;
+    const uchar* hashes = hashFile.map(0, hashFile.size());
+    if (!bloom || !hashes) {
+        m_error = QString("Could not map the corpus files");
+        return false;
+    }
+
+    // resize() fills the file with zeros
+    fillHeader(bloom, BLOOM_MAGIC, m_count);
+    std::memcpy(bloom + 12, &probes, sizeof(probes));
+    std::memcpy(bloom + 24, &blockCount, sizeof(blockCount));
+
+    const uchar* sha1 = hashes + CORPUS_HEADER_SIZE + FANOUT_SIZE * sizeof(quint64);
+    for (quint64 i = 0; i < m_count; ++i, sha1 += BreachCorpus::HASH_SIZE) {
+        quint64 mask[8];
+        quint64 block = bloomProbe(sha1, blockCount, probes, mask);
+        quint64* words = reinterpret_cast<quint64*>(
+            bloom + CORPUS_HEADER_SIZE + block * BLOOM_BLOCK_SIZE);
+        for (int j = 0; j < 8; ++j)
+            words[j] |= mask[j];
+    }
+
+    bloomFile.unmap(bloom);
+    bloomFile.close();
+    return true;
+}
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
@@ -0,0 +1,86 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#ifndef BREACHCORPUS_H
+#define BREACHCORPUS_H
+
+#include <QString>
+#include <QFile>
+#include <QSharedPointer>
+
+#include "passwordchecker.h"
+
+class QIODevice;
+
+class BreachCorpus
+{
+    public:
+        static const int HASH_SIZE;
+
+    public:
+        BreachCorpus(const QString& fileName);
+        ~BreachCorpus();
+
+        bool contains(const QString& password) const;
+        bool containsHash(const unsigned char* sha1) const;
+        quint64 size() const;
+
+    public:
+        static QSharedPointer<BreachCorpus> open(const QString& fileName);
+        static QString hashFileName(const QString& fileName);
+
+    private:
+        bool mayContain(const unsigned char* sha1) const;
+        bool findHash(const unsigned char* sha1) const;
+        const uchar* map(QFile& file, const char* magic);
+
+    private:
+        QFile           m_bloomFile;
+        QFile           m_hashFile;
+        const uchar*    m_bloom;
+        const uchar*    m_hashes;
+        const quint64*  m_fanout;
+        quint64         m_blockCount;
+        quint64         m_count;
+        int             m_probes;
+
+    private:
+        BreachCorpus(const BreachCorpus&);
+        BreachCorpus& operator=(const BreachCorpus&);
+};
+
+class BreachCorpusBuilder
+{
+    public:
+        BreachCorpusBuilder(const QString& fileName);
+
+        void setBitsPerEntry(int bits);
+        bool build(QIODevice& input);
+        QString errorString() const;
+        quint64 size() const;
+
+    private:
+        bool writeHashes(QIODevice& input);
+        bool writeBloomFilter();
+
+    private:
+        QString     m_fileName;
+        int         m_bitsPerEntry;
+        quint64     m_count;
+        QString     m_error;
+};
+
+#endif // BREACHCORPUS_H
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
@@ -0,0 +1,64 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#include <QString>
+
+#include "global.h"
+#include "breachedpasswordchecker.h"
+
+
+/**
+ * @class BreachedPasswordChecker
+ *
+ * @brief Rates passwords from a BreachCorpus as cracked immediately.
+ *
+ * Passwords that have been published in a data breach are tried first by any cracker, so
+ * their quality is 0 days regardless of their length. All other passwords are rated by the
+ * wrapped checker.
+ *
+ * @ingroup security
+ * @author Bernhard Walle
+ */
+
+/**
+ * @brief Creates a new BreachedPasswordChecker.
+ *
+ * The corpus is opened with BreachCorpus::open(), so it is mapped only once.
+ *
+ * @param checker the checker for passwords that are not in the corpus, the object takes the
+ *                ownership, also if an exception is thrown
+ * @param corpusFileName the Bloom filter file of the corpus
+ * @exception PasswordCheckException if the corpus cannot be opened
+ */
+BreachedPasswordChecker::BreachedPasswordChecker(PasswordChecker* checker,
+                                                 const QString& corpusFileName)
+    : m_checker(checker)
+    , m_corpus(BreachCorpus::open(corpusFileName))
+{}
+
+
+/**
+ * @brief Checks the password.
+ *
+ * @param password the password to check
+ * @return 0.0 if the password is in the corpus, the quality of the wrapped checker otherwise
+ */
+double BreachedPasswordChecker::passwordQuality(const QString& password)
+{
+    if (m_corpus->contains(password))
+        return 0.0;
+    return m_checker->passwordQuality(password);
+}
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
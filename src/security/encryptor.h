@@ -21,6 +21,7 @@
 #include <QStringList>
 
 #include "global.h"
+#include "util/securestring.h"
 
 
 class NoSuchAlgorithmException : public std::runtime_error
@@ -35,7 +36,9 @@ class StringEncryptor
         virtual ~StringEncryptor() { }
 
         virtual QString encryptStrToStr(const QString& string) = 0;
+        virtual QString encryptUtf8ToStr(const char* utf8, size_t size) = 0;
         virtual QString decryptStrFromStr(const QString& string) = 0;
+        virtual SecureString decryptSecureFromStr(const QString& string) = 0;
 };
 
 class Encryptor : public StringEncryptor
@@ -0,0 +1,82 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#include <QString>
+#include <QScopedPointer>
+
+#include "global.h"
+#include "vaultconfig.h"
+#include "passwordcheckerfactory.h"
+#include "hybridpasswordchecker.h"
+#include "patternpasswordchecker.h"
+#include "breachedpasswordchecker.h"
+
+// -------------------------------------------------------------------------------------------------
+//                                     Static data
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * The HybridPasswordChecker as string, that's the default.
+ */
+const QString PasswordCheckerFactory::HYBRID_CHECKER_STRING = "HYBRID";
+
+/**
+ * The PatternPasswordChecker as string.
+ */
+const QString PasswordCheckerFactory::PATTERN_CHECKER_STRING = "PATTERN";
+
+
+/**
+ * @class PasswordCheckerFactory
+ *
+ * @brief Factory for creating the password checker of the configuration.
+ *
+ * VaultConfig::getPasswordChecker() selects the checker:
+ *
+ *   - @c HYBRID: HybridPasswordChecker
+ *   - @c PATTERN: PatternPasswordChecker
+ *
+ * Both use the dictionary of the configuration. If a breach corpus is configured, the checker
+ * is wrapped in a BreachedPasswordChecker.
+ *
+ * @ingroup security
+ * @author Bernhard Walle
+ */
+
+/**
+ * @brief Creates the password checker for @p config.
+ *
+ * The dictionaries and the breach corpus are cached, so creating a checker for each password
+ * is cheap.
+ *
+ * @param config the configuration
+ * @return the checker, it must be deleted by the caller
+ * @exception PasswordCheckException if the dictionary or the corpus cannot be read
+ */
+PasswordChecker* PasswordCheckerFactory::getChecker(const VaultConfig& config)
+{
+    QScopedPointer<PasswordChecker> checker;
+    if (config.getPasswordChecker() == PATTERN_CHECKER_STRING)
+        checker.reset(new PatternPasswordChecker(config.getDictionaryFile()));
+    else
+        checker.reset(new HybridPasswordChecker(config.getDictionaryFile()));
+
+    if (config.getBreachCorpusFile().isEmpty())
+        return checker.take();
+
+    // the member of the BreachedPasswordChecker deletes the checker if opening the corpus fails
+    return new BreachedPasswordChecker(checker.take(), config.getBreachCorpusFile());
+}
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
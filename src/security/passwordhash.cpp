@@ -19,7 +19,6 @@
 
 #include <QDebug>
 #include <QString>
-#include <Q3CString>
 
 #include <openssl/evp.h>
 
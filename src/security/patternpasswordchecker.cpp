@@ -0,0 +1,926 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+#include <QDebug>
+#include <QString>
+#include <QStringList>
+#include <QFile>
+#include <QTextStream>
+#include <QVector>
+#include <QMap>
+#include <QDate>
+#include <QMutex>
+#include <QMutexLocker>
+
+#include "global.h"
+#include "patternpasswordchecker.h"
+
+// -------------------------------------------------------------------------------------------------
+//                                     Static data
+// -------------------------------------------------------------------------------------------------
+
+PatternPasswordChecker::RankTablePtr   PatternPasswordChecker::m_loadedRanks;
+QString                                PatternPasswordChecker::m_fileName;
+
+static QMutex                          s_loadMutex;
+
+#define MAX_LENGTH                              64
+#define BRUTEFORCE_CARDINALITY                  10.0
+#define MIN_GUESSES_BEFORE_GROWING_SEQUENCE     10000.0
+#define MIN_SUBMATCH_GUESSES_SINGLE_CHAR        10.0
+#define MIN_SUBMATCH_GUESSES_MULTI_CHAR         50.0
+#define MIN_YEAR_SPACE                          20
+#define MAX_SEQUENCE_DELTA                      5
+#define MAX_L33T_COMBINATIONS                   16
+
+/**
+ * The most common passwords, ordered by frequency. They are ranked before the words of the
+ * dictionary.
+ */
+static const char* const s_commonPasswords[] = {
+    "123456", "password", "12345678", "qwerty", "123456789", "12345", "1234", "111111",
+    "1234567", "dragon", "123123", "baseball", "abc123", "football", "monkey", "letmein",
+    "696969", "shadow", "master", "666666", "qwertyuiop", "123321", "mustang", "1234567890",
+    "michael", "654321", "superman", "1qaz2wsx", "7777777", "121212", "000000", "qazwsx",
+    "123qwe", "killer", "trustno1", "jordan", "jennifer", "zxcvbnm", "asdfgh", "hunter",
+    "buster", "soccer", "harley", "batman", "andrew", "tigger", "sunshine", "iloveyou",
+    "2000", "charlie", "robert", "thomas", "hockey", "ranger", "daniel", "starwars",
+    "klaster", "112233", "george", "computer", "michelle", "jessica", "pepper", "1111",
+    "zxcvbn", "555555", "11111111", "131313", "freedom", "777777", "pass", "maggie",
+    "159753", "aaaaaa", "ginger", "princess", "joshua", "cheese", "amanda", "summer",
+    "love", "ashley", "nicole", "chelsea", "biteme", "matthew", "access", "yankees",
+    "987654321", "dallas", "austin", "thunder", "taylor", "matrix", "passwort", "hallo",
+    "geheim", "schatz", "admin", "welcome", "login", "passw0rd", "secret", "qwertz"
+};
+
+/**
+ * Characters that are commonly used instead of letters.
+ */
+static const struct {
+    char        l33t;
+    const char  *letters;
+} s_l33tTable[] = {
+    { '4', "a" }, { '@', "a" }, { '8', "b" }, { '(', "c" }, { '{', "c" }, { '[', "c" },
+    { '<', "c" }, { '3', "e" }, { '6', "g" }, { '9', "g" }, { '1', "il" }, { '!', "i" },
+    { '|', "il" }, { '0', "o" }, { '$', "s" }, { '5', "s" }, { '+', "t" }, { '7', "tl" },
+    { '%', "x" }, { '2', "z" }
+};
+
+/**
+ * Keyboard layouts for the detection of keyboard walks. Each token of a row contains the
+ * unshifted and the shifted character of a key. The QWERTY rows are slanted: a key is
+ * adjacent to the keys left and right, the two keys above (at the same and the next column)
+ * and the two keys below (at the same and the previous column).
+ */
+static const struct KeyboardGraph {
+    const char  *rows[5];
+    int         rowStart[5];
+    bool        slanted;
+    double      startingPositions;
+    double      averageDegree;
+} s_keyboardGraphs[] = {
+    {
+        { "`~ 1! 2@ 3# 4$ 5% 6^ 7& 8* 9( 0) -_ =+",
+          "qQ wW eE rR tT yY uU iI oO pP [{ ]} \\|",
+          "aA sS dD fF gG hH jJ kK lL ;: '\"",
+          "zZ xX cC vV bB nN mM ,< .> /?",
+          "" },
+        { 0, 1, 1, 1, 0 },
+        true, 94.0, 4.595
+    },
+    {
+        { "/ * -",
+          "7 8 9 +",
+          "4 5 6",
+          "1 2 3",
+          "0 ." },
+        { 1, 0, 0, 0, 1 },
+        false, 15.0, 5.066
+    }
+};
+
+#define KEYBOARD_GRAPHS int(sizeof(s_keyboardGraphs) / sizeof(s_keyboardGraphs[0]))
+
+static const int s_slantedDirections[][2] = {
+    { -1, 0 }, { 0, -1 }, { 1, -1 }, { 1, 0 }, { 0, 1 }, { -1, 1 }
+};
+
+static const int s_alignedDirections[][2] = {
+    { -1, 0 }, { -1, -1 }, { 0, -1 }, { 1, -1 }, { 1, 0 }, { 1, 1 }, { 0, 1 }, { -1, 1 }
+};
+
+// -------------------------------------------------------------------------------------------------
+
+struct KeyPosition {
+    signed char x;
+    signed char y;
+    bool        shifted;
+    bool        valid;
+};
+
+/**
+ * Position of each ASCII character on the keyboards. The table is filled from
+ * s_keyboardGraphs during the static initialization, so no estimate has to compute it.
+ */
+class KeyboardTables
+{
+    public:
+        KeyboardTables();
+
+        const KeyPosition& position(int graph, QChar c) const;
+
+    private:
+        KeyPosition m_positions[KEYBOARD_GRAPHS][128];
+};
+
+
+KeyboardTables::KeyboardTables()
+{
+    std::memset(m_positions, 0, sizeof(m_positions));
+
+    for (int graph = 0; graph < KEYBOARD_GRAPHS; ++graph) {
+        for (int y = 0; y < 5; ++y) {
+            const char* row = s_keyboardGraphs[graph].rows[y];
+            int x = s_keyboardGraphs[graph].rowStart[y];
+            int shift = 0;
+            for (const char* c = row; *c; ++c) {
+                if (*c == ' ') {
+                    ++x;
+                    shift = 0;
+                    continue;
+                }
+                KeyPosition& pos = m_positions[graph][int(*c)];
+                pos.x = x;
+                pos.y = y;
+                pos.shifted = shift++ > 0;
+                pos.valid = true;
+            }
+        }
+    }
+}
+
+
+const KeyPosition& KeyboardTables::position(int graph, QChar c) const
+{
+    static const KeyPosition invalid = { 0, 0, false, false };
+    ushort code = c.unicode();
+    return code < 128 ? m_positions[graph][code] : invalid;
+}
+
+static const KeyboardTables s_keyboardTables;
+
+// -------------------------------------------------------------------------------------------------
+
+struct PatternMatch {
+    int     i;
+    int     j;
+    double  guesses;
+    bool    bruteforce;
+};
+
+typedef QVector<PatternMatch> MatchVector;
+
+struct Candidate {
+    double  g;
+    double  pi;
+    bool    bruteforce;
+};
+
+static double estimate(const QString& password, const QHash<QString, int>& ranks,
+                       int maxWordLength);
+
+
+/**
+ * @brief Returns the binomial coefficient.
+ */
+static double nCk(int n, int k)
+{
+    if (k > n)
+        return 0.0;
+
+    double result = 1.0;
+    for (int d = 1; d <= k; ++d) {
+        result *= n--;
+        result /= d;
+    }
+    return result;
+}
+
+
+/**
+ * @brief Returns n!.
+ */
+static double factorial(int n)
+{
+    double result = 1.0;
+    for (int i = 2; i <= n; ++i)
+        result *= i;
+    return result;
+}
+
+
+/**
+ * @brief Appends a match, a part of the password has at least a few guesses.
+ */
+static void addMatch(MatchVector& matches, int i, int j, double guesses, int length)
+{
+    if (j - i + 1 < length) {
+        double minimum = i == j
+            ? MIN_SUBMATCH_GUESSES_SINGLE_CHAR
+            : MIN_SUBMATCH_GUESSES_MULTI_CHAR;
+        guesses = qMax(guesses, minimum);
+    }
+
+    PatternMatch match = { i, j, qMax(guesses, 1.0), false };
+    matches.append(match);
+}
+
+
+/**
+ * @brief Returns the number of variations of upper and lower case letters of @p word.
+ */
+static double uppercaseVariations(const QString& word)
+{
+    int upper = 0;
+    int lower = 0;
+    for (int i = 0; i < word.length(); ++i) {
+        if (word[i].isUpper())
+            ++upper;
+        else if (word[i].isLower())
+            ++lower;
+    }
+
+    if (upper == 0)
+        return 1.0;
+    if (lower == 0)
+        return 2.0;
+    if (upper == 1 && (word[0].isUpper() || word[word.length() - 1].isUpper()))
+        return 2.0;
+
+    double variations = 0.0;
+    for (int i = 1; i <= qMin(upper, lower); ++i)
+        variations += nCk(upper + lower, i);
+    return variations;
+}
+
+
+/**
+ * @brief Finds the dictionary words in @p lower.
+ *
+ * @p original is the password without the l33t substitutions, only matches that contain a
+ * substituted character are looked up if it differs from @p lower. The substrings are not
+ * copied for the lookup.
+ */
+static void addDictionaryMatches(MatchVector& matches, const QString& password,
+                                 const QString& original, const QString& lower,
+                                 const QHash<QString, int>& ranks, int maxWordLength,
+                                 bool reversed)
+{
+    const int n = lower.length();
+    const bool l33t = original != lower;
+
+    // the first substituted position at or after each position
+    QVector<int> nextSubbed(n + 1, n);
+    if (l33t)
+        for (int k = n - 1; k >= 0; --k)
+            nextSubbed[k] = original[k] != lower[k] ? k : nextSubbed[k + 1];
+
+    for (int i = 0; i < n; ++i) {
+        const int firstEnd = l33t ? qMax(i + 1, nextSubbed[i]) : i + 1;
+        for (int j = firstEnd; j < n && j - i < maxWordLength; ++j) {
+            const QString word = QString::fromRawData(lower.constData() + i, j - i + 1);
+            QHash<QString, int>::const_iterator it = ranks.find(word);
+            if (it == ranks.end())
+                continue;
+
+            // position in the password
+            int first = reversed ? n - 1 - j : i;
+            int last = reversed ? n - 1 - i : j;
+            QString token = password.mid(first, last - first + 1);
+            double guesses = it.value() * uppercaseVariations(token);
+            if (reversed)
+                guesses *= 2.0;
+
+            if (l33t) {
+                QString originalToken = original.mid(i, j - i + 1);
+                QString subbedToken = lower.mid(i, j - i + 1);
+
+                // for each substitution: the attacker tries the subsets of the positions
+                for (int k = 0; k < int(sizeof(s_l33tTable) / sizeof(s_l33tTable[0])); ++k) {
+                    int subbed = originalToken.count(QChar(s_l33tTable[k].l33t));
+                    if (subbed == 0)
+                        continue;
+
+                    // the letter that replaced the l33t character in this combination
+                    int pos = originalToken.indexOf(QChar(s_l33tTable[k].l33t));
+                    int unsubbed = originalToken.count(subbedToken[pos]);
+                    if (unsubbed == 0) {
+                        guesses *= 2.0;
+                    } else {
+                        double variations = 0.0;
+                        for (int v = 1; v <= qMin(subbed, unsubbed); ++v)
+                            variations += nCk(subbed + unsubbed, v);
+                        guesses *= variations;
+                    }
+                }
+            }
+
+            addMatch(matches, first, last, guesses, n);
+        }
+    }
+}
+
+
+/**
+ * @brief Finds dictionary words, also reversed and with l33t substitutions.
+ */
+static void addAllDictionaryMatches(MatchVector& matches, const QString& password,
+                                    const QHash<QString, int>& ranks, int maxWordLength)
+{
+    const QString lower = password.toLower();
+    QString reversed;
+    for (int i = lower.length() - 1; i >= 0; --i)
+        reversed += lower[i];
+
+    addDictionaryMatches(matches, password, lower, lower, ranks, maxWordLength, false);
+    addDictionaryMatches(matches, password, reversed, reversed, ranks, maxWordLength, true);
+
+    // l33t characters of the password and the number of letters that are tried for them,
+    // characters beyond the limit only use their first letter
+    QList<int> subs;
+    QList<int> choices;
+    int combinations = 1;
+    for (int k = 0; k < int(sizeof(s_l33tTable) / sizeof(s_l33tTable[0])); ++k) {
+        if (lower.contains(QChar(s_l33tTable[k].l33t))) {
+            int letters = qstrlen(s_l33tTable[k].letters);
+            if (combinations * letters > MAX_L33T_COMBINATIONS)
+                letters = 1;
+            combinations *= letters;
+            subs.append(k);
+            choices.append(letters);
+        }
+    }
+    if (subs.isEmpty())
+        return;
+
+    // mixed radix counter over the letters
+    for (int combination = 0; combination < combinations; ++combination) {
+        QString subbed = lower;
+        int rest = combination;
+        for (int s = 0; s < subs.size(); ++s) {
+            int k = subs[s];
+            int choice = rest % choices[s];
+            rest /= choices[s];
+            subbed.replace(QChar(s_l33tTable[k].l33t), QChar(s_l33tTable[k].letters[choice]));
+        }
+        addDictionaryMatches(matches, password, lower, subbed, ranks, maxWordLength, false);
+    }
+}
+
+
+/**
+ * @brief Returns the guesses for a keyboard walk.
+ */
+static double spatialGuesses(int graph, int length, int turns, int shifted)
+{
+    const double s = s_keyboardGraphs[graph].startingPositions;
+    const double d = s_keyboardGraphs[graph].averageDegree;
+
+    double guesses = 0.0;
+    for (int i = 2; i <= length; ++i) {
+        int possibleTurns = qMin(turns, i - 1);
+        for (int j = 1; j <= possibleTurns; ++j)
+            guesses += nCk(i - 1, j - 1) * s * std::pow(d, j);
+    }
+
+    if (shifted > 0) {
+        int unshifted = length - shifted;
+        if (unshifted == 0) {
+            guesses *= 2.0;
+        } else {
+            double variations = 0.0;
+            for (int i = 1; i <= qMin(shifted, unshifted); ++i)
+                variations += nCk(shifted + unshifted, i);
+            guesses *= variations;
+        }
+    }
+    return guesses;
+}
+
+
+/**
+ * @brief Returns the direction from @p from to @p to or -1 if the keys are not adjacent.
+ */
+static int direction(int graph, const KeyPosition& from, const KeyPosition& to)
+{
+    if (!from.valid || !to.valid)
+        return -1;
+
+    int dx = to.x - from.x;
+    int dy = to.y - from.y;
+    if (s_keyboardGraphs[graph].slanted) {
+        for (int i = 0; i < int(sizeof(s_slantedDirections) / sizeof(s_slantedDirections[0])); ++i)
+            if (s_slantedDirections[i][0] == dx && s_slantedDirections[i][1] == dy)
+                return i;
+    } else {
+        for (int i = 0; i < int(sizeof(s_alignedDirections) / sizeof(s_alignedDirections[0])); ++i)
+            if (s_alignedDirections[i][0] == dx && s_alignedDirections[i][1] == dy)
+                return i;
+    }
+    return -1;
+}
+
+
+/**
+ * @brief Finds keyboard walks like "qwert" or "zaq1".
+ */
+static void addSpatialMatches(MatchVector& matches, const QString& password)
+{
+    const int n = password.length();
+
+    for (int graph = 0; graph < KEYBOARD_GRAPHS; ++graph) {
+        int i = 0;
+        while (i < n - 1) {
+            int j = i + 1;
+            int lastDirection = -1;
+            int turns = 0;
+            int shifted = s_keyboardTables.position(graph, password[i]).shifted ? 1 : 0;
+
+            for (; j < n; ++j) {
+                const KeyPosition& cur = s_keyboardTables.position(graph, password[j]);
+                int dir = direction(graph, s_keyboardTables.position(graph, password[j - 1]), cur);
+                if (dir < 0)
+                    break;
+                if (cur.shifted)
+                    ++shifted;
+                if (dir != lastDirection) {
+                    ++turns;
+                    lastDirection = dir;
+                }
+            }
+
+            if (j - i > 2)
+                addMatch(matches, i, j - 1, spatialGuesses(graph, j - i, turns, shifted), n);
+            i = j;
+        }
+    }
+}
+
+
+/**
+ * @brief Finds repeated parts like "aaa" or "abcabc".
+ */
+static void addRepeatMatches(MatchVector& matches, const QString& password,
+                             const QHash<QString, int>& ranks, int maxWordLength)
+{
+    const int n = password.length();
+
+    int i = 0;
+    while (i < n - 1) {
+        int bestPeriod = 0;
+        int bestCount = 0;
+        for (int period = 1; i + 2 * period <= n; ++period) {
+            int count = 1;
+            while (i + (count + 1) * period <= n) {
+                int k = 0;
+                while (k < period && password[i + k] == password[i + count * period + k])
+                    ++k;
+                if (k < period)
+                    break;
+                ++count;
+            }
+            if (count >= 2 && period * count > bestPeriod * bestCount) {
+                bestPeriod = period;
+                bestCount = count;
+            }
+        }
+
+        if (bestCount >= 2) {
+            double baseGuesses = estimate(password.mid(i, bestPeriod), ranks, maxWordLength);
+            addMatch(matches, i, i + bestPeriod * bestCount - 1, baseGuesses * bestCount, n);
+            i += bestPeriod * bestCount;
+        } else
+            ++i;
+    }
+}
+
+
+/**
+ * @brief Adds a sequence match for @p i to @p j if it is one.
+ */
+static void addSequence(MatchVector& matches, const QString& password, int i, int j, int delta)
+{
+    if ((j - i > 1 || std::abs(delta) == 1) && delta != 0 &&
+            std::abs(delta) <= MAX_SEQUENCE_DELTA) {
+        QChar first = password[i];
+        double base;
+        if (QString("aAzZ019").contains(first))
+            base = 4.0;
+        else if (first.isDigit())
+            base = 10.0;
+        else
+            base = 26.0;
+        if (delta < 0)
+            base *= 2.0;
+        addMatch(matches, i, j, base * (j - i + 1), password.length());
+    }
+}
+
+
+/**
+ * @brief Finds sequences like "abcd", "9753" or "zyx".
+ */
+static void addSequenceMatches(MatchVector& matches, const QString& password)
+{
+    const int n = password.length();
+    if (n < 2)
+        return;
+
+    int i = 0;
+    int lastDelta = password[1].unicode() - password[0].unicode();
+    for (int k = 2; k < n; ++k) {
+        int delta = password[k].unicode() - password[k - 1].unicode();
+        if (delta == lastDelta)
+            continue;
+        addSequence(matches, password, i, k - 1, lastDelta);
+        i = k - 1;
+        lastDelta = delta;
+    }
+    addSequence(matches, password, i, n - 1, lastDelta);
+}
+
+
+/**
+ * @brief Returns the year if @p a, @p b and @p c can be a date or 0.
+ */
+static int dateYear(int a, int b, int c)
+{
+    if (b > 31 || b <= 0)
+        return 0;
+
+    int over12 = 0, over31 = 0, under1 = 0;
+    int values[3] = { a, b, c };
+    for (int i = 0; i < 3; ++i) {
+        if ((values[i] > 99 && values[i] < 1000) || values[i] > 2050)
+            return 0;
+        if (values[i] > 31)
+            ++over31;
+        if (values[i] > 12)
+            ++over12;
+        if (values[i] <= 0)
+            ++under1;
+    }
+    if (over31 >= 2 || over12 == 3 || under1 >= 2)
+        return 0;
+
+    // year at the end or at the beginning, day and month in any order
+    int splits[2][3] = { { c, a, b }, { a, b, c } };
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int s = 0; s < 2; ++s) {
+            int year = splits[s][0];
+            int d = splits[s][1], m = splits[s][2];
+            bool dayMonth = (d >= 1 && d <= 31 && m >= 1 && m <= 12) ||
+                            (m >= 1 && m <= 31 && d >= 1 && d <= 12);
+
+            if (pass == 0 && year >= 1000 && year <= 2050)
+                return dayMonth ? year : 0;
+            if (pass == 1 && year <= 99 && dayMonth)
+                return year > 50 ? 1900 + year : 2000 + year;
+        }
+    }
+    return 0;
+}
+
+
+/**
+ * @brief Finds years and dates like "1987", "13.5.87" or "19870513".
+ */
+static void addDateMatches(MatchVector& matches, const QString& password)
+{
+    static const int splits[9][2][2] = {
+        { { 0, 0 }, { 0, 0 } }, { { 0, 0 }, { 0, 0 } }, { { 0, 0 }, { 0, 0 } },
+        { { 0, 0 }, { 0, 0 } },
+        { { 1, 2 }, { 2, 3 } },                 // 4 digits
+        { { 1, 3 }, { 2, 3 } },                 // 5 digits
+        { { 2, 4 }, { 4, 5 } },                 // 6 digits
+        { { 2, 3 }, { 4, 5 } },                 // 7 digits
+        { { 2, 4 }, { 4, 6 } }                  // 8 digits
+    };
+
+    const int n = password.length();
+    const int referenceYear = QDate::currentDate().year();
+
+    for (int i = 0; i < n; ++i) {
+        for (int j = i + 3; j < n && j - i < 10; ++j) {
+            const QString token = password.mid(i, j - i + 1);
+            const int length = token.length();
+            int year = 0;
+            double factor = 1.0;
+
+            int digits = 0;
+            while (digits < length && token[digits].isDigit())
+                ++digits;
+
+            if (digits == length && length == 4) {
+                int value = token.toInt();
+                if (value >= 1900 && value <= 2099) {
+                    addMatch(matches, i, j,
+                             qMax(std::abs(value - referenceYear), MIN_YEAR_SPACE), n);
+                }
+            }
+
+            if (digits == length && length <= 8) {
+                // the candidate that is closest to the reference year
+                for (int s = 0; s < 2; ++s) {
+                    int k = splits[length][s][0];
+                    int l = splits[length][s][1];
+                    int candidate = dateYear(token.left(k).toInt(), token.mid(k, l - k).toInt(),
+                                             token.mid(l).toInt());
+                    if (candidate && (!year || std::abs(candidate - referenceYear) <
+                                               std::abs(year - referenceYear)))
+                        year = candidate;
+                }
+            } else if (length >= 6 && digits >= 1 && digits <= 4 && digits < length) {
+                // digits, separator, digits, the same separator, digits
+                QChar separator = token[digits];
+                if (!QString(" /\\_.-").contains(separator))
+                    continue;
+                QStringList parts = token.split(separator);
+                if (parts.size() != 3 || parts[1].isEmpty() || parts[1].length() > 2 ||
+                        parts[2].isEmpty() || parts[2].length() > 4)
+                    continue;
+                bool ok1, ok2;
+                int b = parts[1].toInt(&ok1);
+                int c = parts[2].toInt(&ok2);
+                if (!ok1 || !ok2 || !parts[1][0].isDigit() || !parts[2][0].isDigit())
+                    continue;
+                year = dateYear(parts[0].toInt(), b, c);
+                factor = 4.0;
+            }
+
+            if (year) {
+                double guesses = 365.0 * qMax(std::abs(year - referenceYear), MIN_YEAR_SPACE);
+                addMatch(matches, i, j, guesses * factor, n);
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief Updates the best sequences that end with @p match and consist of @p l matches.
+ */
+static void update(QVector< QMap<int, Candidate> >& optimal, const PatternMatch& match, int l)
+{
+    double pi = match.guesses;
+    if (l > 1)
+        pi *= optimal[match.i - 1][l - 1].pi;
+    double g = factorial(l) * pi + std::pow(MIN_GUESSES_BEFORE_GROWING_SEQUENCE, l - 1);
+
+    // a sequence with the same or fewer matches that is at least as good wins
+    QMap<int, Candidate>& candidates = optimal[match.j];
+    QMap<int, Candidate>::const_iterator it;
+    for (it = candidates.constBegin(); it != candidates.constEnd() && it.key() <= l; ++it)
+        if (it.value().g <= g)
+            return;
+
+    Candidate candidate = { g, pi, match.bruteforce };
+    candidates.insert(l, candidate);
+}
+
+
+/**
+ * @brief Returns the number of guesses for the best combination of the matches.
+ *
+ * Each position of the password that is not covered by a match is guessed by brute force.
+ * For each end position and each number of matches, the dynamic programming keeps the
+ * sequence with the fewest guesses, where a sequence of l matches needs l! times the
+ * product of the guesses of the matches.
+ */
+static double mostGuessableSequence(const QString& password, const MatchVector& matches)
+{
+    const int n = password.length();
+    if (n == 0)
+        return 1.0;
+
+    QVector<MatchVector> byEnd(n);
+    foreach (const PatternMatch& match, matches)
+        byEnd[match.j].append(match);
+
+    QVector< QMap<int, Candidate> > optimal(n);
+    for (int k = 0; k < n; ++k) {
+        foreach (const PatternMatch& match, byEnd[k]) {
+            if (match.i > 0) {
+                QList<int> lengths = optimal[match.i - 1].keys();
+                foreach (int l, lengths)
+                    update(optimal, match, l + 1);
+            } else
+                update(optimal, match, 1);
+        }
+
+        // brute force from any position up to k
+        for (int i = 0; i <= k; ++i) {
+            int length = k - i + 1;
+            double guesses = std::pow(BRUTEFORCE_CARDINALITY, length);
+            if (length < n) {
+                guesses = qMax(guesses, length == 1
+                    ? MIN_SUBMATCH_GUESSES_SINGLE_CHAR + 1
+                    : MIN_SUBMATCH_GUESSES_MULTI_CHAR + 1);
+            }
+            PatternMatch match = { i, k, guesses, true };
+
+            if (i == 0) {
+                update(optimal, match, 1);
+                continue;
+            }
+
+            // two brute force matches in a row are one brute force match
+            QMap<int, Candidate>::const_iterator it;
+            QList<int> lengths;
+            for (it = optimal[i - 1].constBegin(); it != optimal[i - 1].constEnd(); ++it)
+                if (!it.value().bruteforce)
+                    lengths.append(it.key());
+            foreach (int l, lengths)
+                update(optimal, match, l + 1);
+        }
+    }
+
+    double best = std::numeric_limits<double>::max();
+    QMap<int, Candidate>::const_iterator it;
+    for (it = optimal[n - 1].constBegin(); it != optimal[n - 1].constEnd(); ++it)
+        best = qMin(best, it.value().g);
+    return best;
+}
+
+
+/**
+ * @brief Returns the number of guesses for @p password.
+ */
+static double estimate(const QString& password, const QHash<QString, int>& ranks,
+                       int maxWordLength)
+{
+    MatchVector matches;
+    addAllDictionaryMatches(matches, password, ranks, maxWordLength);
+    addSpatialMatches(matches, password);
+    addRepeatMatches(matches, password, ranks, maxWordLength);
+    addSequenceMatches(matches, password);
+    addDateMatches(matches, password);
+
+    return mostGuessableSequence(password, matches);
+}
+
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * @class PatternPasswordChecker
+ *
+ * @brief Password checker that estimates the guesses from the patterns of the password.
+ *
+ * This is an implementation of the algorithm of zxcvbn (Dan Wheeler, "zxcvbn: Low-Budget
+ * Password Strength Estimation", USENIX Security 2016). The password is searched for
+ *
+ *   - words of the dictionary, also reversed and with l33t substitutions like "p4ssw0rd",
+ *   - keyboard walks on a QWERTY keyboard and on the keypad like "zaq12wsx",
+ *   - repeated parts like "abcabc",
+ *   - sequences like "abcd" or "9753",
+ *   - years and dates like "1987" or "13.5.87".
+ *
+ * Each match is rated with the number of guesses an attacker who knows the pattern needs.
+ * The rest of the password is guessed by brute force. A dynamic programming over all
+ * combinations of matches finds the combination with the fewest guesses.
+ *
+ * The dictionary words are ranked by their length: the attacker tries all shorter words
+ * first. A list of the most common passwords is compiled in and ranked before the
+ * dictionary. The dictionary is read once and shared by all instances like the dictionary
+ * of the HybridPasswordChecker. The table of the ranks is never modified after it has been
+ * built, a new dictionary gives a new table. Each instance holds a reference to its table,
+ * so guesses() can be called from any thread without a lock. The positions of the keys are
+ * computed during the static initialization. Passwords are only analysed up to 64
+ * characters, the rest adds 10 guesses per character. An estimate takes far less than a
+ * millisecond.
+ *
+ * @ingroup security
+ * @author Bernhard Walle
+ */
+
+/**
+ * @brief Creates a new instance of a PatternPasswordChecker.
+ *
+ * @param dictFileName the name of the dictionary, see HybridPasswordChecker
+ * @exception PasswordCheckException if the file does not exist or if the file cannot be
+ *                                   opened
+ */
+PatternPasswordChecker::PatternPasswordChecker(const QString& dictFileName)
+    : m_ranks(loadRanks(dictFileName))
+{}
+
+
+/**
+ * @brief Returns the ranks of @p dictFileName and reads the file if necessary.
+ *
+ * @param dictFileName the name of the dictionary
+ * @return the table, which is shared with the other instances that use the same dictionary
+ * @exception PasswordCheckException if the file does not exist or if the file cannot be
+ *                                   opened
+ */
+PatternPasswordChecker::RankTablePtr PatternPasswordChecker::loadRanks(
+    const QString& dictFileName)
+{
+    QMutexLocker locker(&s_loadMutex);
+
+    if (m_loadedRanks && m_fileName == dictFileName)
+        return m_loadedRanks;
+
+    if (!QFile::exists(dictFileName)) {
+        throw PasswordCheckException( QString("The file %1 does not exist.").arg(
+            dictFileName).latin1());
+    }
+
+    QFile file(dictFileName);
+    if (!file.open(QIODevice::ReadOnly))
+        throw PasswordCheckException( QString("Could not open the file %1.").arg(
+            dictFileName).latin1() );
+
+    QStringList words;
+    QMap<int, int> lengthCount;
+    QTextStream fileStream(&file);
+    while (!fileStream.atEnd()) {
+        QString word = fileStream.readLine().toLower();
+        if (word.length() < 2)
+            continue;
+        words.append(word);
+        ++lengthCount[word.length()];
+    }
+
+    // rank = number of words that are not longer
+    QMap<int, int> lengthRank;
+    int rank = int(sizeof(s_commonPasswords) / sizeof(s_commonPasswords[0]));
+    for (QMap<int, int>::const_iterator it = lengthCount.constBegin();
+            it != lengthCount.constEnd(); ++it) {
+        rank += it.value();
+        lengthRank.insert(it.key(), rank);
+    }
+
+    RankTable* table = new RankTable;
+    table->maxWordLength = 0;
+    foreach (const QString& word, words) {
+        if (!table->ranks.contains(word))
+            table->ranks.insert(word, lengthRank[word.length()]);
+        table->maxWordLength = qMax(table->maxWordLength, word.length());
+    }
+    for (int i = 0; i < int(sizeof(s_commonPasswords) / sizeof(s_commonPasswords[0])); ++i) {
+        table->ranks.insert(s_commonPasswords[i], i + 1);
+        table->maxWordLength = qMax(table->maxWordLength, int(qstrlen(s_commonPasswords[i])));
+    }
+
+    m_loadedRanks = RankTablePtr(table);
+    m_fileName = dictFileName;
+    return m_loadedRanks;
+}
+
+
+/**
+ * @brief Checks the password.
+ *
+ * @param password the password to check
+ * @return the number of days that a cracker needs to crack according to the password
+ *         checker
+ */
+double PatternPasswordChecker::passwordQuality(const QString& password)
+{
+    return guesses(password) / CRACKS_PER_SECOND / 86400;
+}
+
+
+/**
+ * @brief Estimates the number of guesses that are needed for @p password.
+ *
+ * @param password the password
+ * @return the number of guesses, at least 1
+ */
+double PatternPasswordChecker::guesses(const QString& password) const
+{
+    if (password.length() <= MAX_LENGTH)
+        return estimate(password, m_ranks->ranks, m_ranks->maxWordLength);
+
+    double rest = std::pow(BRUTEFORCE_CARDINALITY, password.length() - MAX_LENGTH);
+    return estimate(password.left(MAX_LENGTH), m_ranks->ranks, m_ranks->maxWordLength) * rest;
+}
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
@@ -0,0 +1,50 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#ifndef PATTERNPASSWORDCHECKER_H
+#define PATTERNPASSWORDCHECKER_H
+
+#include <QString>
+#include <QHash>
+#include <QSharedPointer>
+
+#include "passwordchecker.h"
+
+class PatternPasswordChecker : public PasswordChecker
+{
+    public:
+        PatternPasswordChecker(const QString& dictFileName);
+
+        double passwordQuality(const QString& password);
+        double guesses(const QString& password) const;
+
+    private:
+        struct RankTable {
+            QHash<QString, int> ranks;
+            int                 maxWordLength;
+        };
+        typedef QSharedPointer<const RankTable> RankTablePtr;
+
+        static RankTablePtr loadRanks(const QString& dictFileName);
+
+    private:
+        RankTablePtr                m_ranks;
+
+        static RankTablePtr         m_loadedRanks;
+        static QString              m_fileName;
+};
+
+#endif // PATTERNPASSWORDCHECKER_H
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
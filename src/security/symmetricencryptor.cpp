@@ -16,7 +16,7 @@
 
 #include <QString>
 #include <QStringList>
-#include <Q3CString>
+#include <QByteArray>
 
 #include <openssl/evp.h>
 #include <openssl/ssl.h>
@@ -40,6 +40,7 @@ void EVP_CIPHER_CTX_free(EVP_CIPHER_CTX *ctx)
 #include "symmetricencryptor.h"
 #include "constants.h"
 #include "encodinghelper.h"
+#include "util/securearena.h"
 
 #ifndef BUFLEN
 #define BUFLEN 512
@@ -94,6 +95,16 @@ SymmetricEncryptor::SymmetricEncryptor(const QString& algorithm, const QString&
 }
 
 
+/**
+ * @brief Deletes the encryptor and overwrites the key.
+ */
+SymmetricEncryptor::~SymmetricEncryptor()
+{
+    SecureArena::smash(reinterpret_cast<char *>(m_key), sizeof(m_key));
+    SecureArena::smash(reinterpret_cast<char *>(m_iv), sizeof(m_iv));
+}
+
+
 /**
  * @brief Returns a list of all available cipher algorithms.
  *
@@ -235,9 +246,10 @@ ByteVector SymmetricEncryptor::crypt(const ByteVector& vector, OperationType ope
  */
 void SymmetricEncryptor::setPassword(const QString& password)
 {
-    Q3CString pwUtf8 = password.utf8();
+    QByteArray pwUtf8 = password.toUtf8();
     EVP_BytesToKey(m_cipher_algorithm, HASH_ALGORITHM, 0,
-        (unsigned char *)pwUtf8.operator const char*(), pwUtf8.length(), 1, m_key, m_iv);
+        (const unsigned char *)pwUtf8.constData(), pwUtf8.length(), 1, m_key, m_iv);
+    SecureArena::smash(pwUtf8.data(), pwUtf8.length());
 }
 
 
@@ -27,6 +27,7 @@ class SymmetricEncryptor : public AbstractEncryptor
 {
     public:
         SymmetricEncryptor(const QString& algorithm, const QString& password);
+        ~SymmetricEncryptor();
 
         virtual QString getCurrentAlgorithm() const;
         static QStringList getAlgorithms();
@@ -0,0 +1,249 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#include <QMutexLocker>
+#include <QDebug>
+
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+
+#include "vaultkey.h"
+
+/**
+ * @class VaultKey
+ *
+ * @brief The key of a data file, used to encrypt and decrypt the passwords.
+ *
+ * This is a StringEncryptor that uses a SymmetricEncryptor. In addition, it knows whether
+ * another VaultKey encrypts in the same way, so a value that is still encrypted (see
+ * PropertyValue::setCiphertext()) can be written without decrypting it first.
+ *
+ * The key is shared between the properties whose values are decrypted on demand, and it's
+ * used by the GUI thread and the AutoSaver at the same time. Therefore all operations are
+ * serialized with a mutex.
+ *
+ * While the session is locked, the key material and the fingerprint are destroyed with
+ * lock(). Values that are encrypted with the key cannot be decrypted until unlock() is called
+ * with the password. Before the key material is destroyed, a random text is encrypted, and
+ * unlock() checks the password by decrypting it. So no extra hash of the password is needed
+ * that could be attacked more cheaply than the encrypted values themselves.
+ *
+ * @ingroup security
+ * @author Bernhard Walle
+ */
+
+/**
+ * @brief Creates a new VaultKey.
+ *
+ * @param algorithm the cipher algorithm
+ * @param password the password
+ * @exception NoSuchAlgorithmException if the algorithm is not available
+ */
+VaultKey::VaultKey(const QString& algorithm, const QString& password)
+    : m_encryptor(new SymmetricEncryptor(algorithm, password))
+    , m_algorithm(algorithm)
+    , m_fingerprint(fingerprint(algorithm, password))
+{}
+
+
+/**
+ * @brief Returns the cipher algorithm.
+ *
+ * @return the name of the algorithm
+ */
+QString VaultKey::getAlgorithm() const
+{
+    return m_algorithm;
+}
+
+
+/**
+ * @brief Checks if @p other produces the same ciphertext as this key.
+ *
+ * @param other the other key
+ * @return @c true if the algorithm and the password are the same, @c false otherwise or if
+ *         one of the keys is locked
+ */
+bool VaultKey::hasSameKey(const VaultKey& other) const
+{
+    if (this == &other)
+        return true;
+
+    // never hold both mutexes, two threads could compare in the opposite order
+    QByteArray fingerprint;
+    {
+        QMutexLocker locker(&m_mutex);
+        fingerprint = m_fingerprint;
+    }
+
+    QMutexLocker locker(&other.m_mutex);
+    return !fingerprint.isEmpty() && fingerprint == other.m_fingerprint;
+}
+
+
+/**
+ * @brief Returns a random text for the password check of unlock().
+ *
+ * @return 16 random bytes in hex
+ */
+static QString randomCheckText()
+{
+    QByteArray bytes(16, '\0');
+    if (RAND_bytes(reinterpret_cast<unsigned char*>(bytes.data()), bytes.size()) != 1)
+        qWarning() << "VaultKey: RAND_bytes() failed, using a weak check text";
+    return QString::fromLatin1(bytes.toHex());
+}
+
+
+/**
+ * @brief Destroys the key material and the fingerprint.
+ *
+ * Until unlock() is called, encryption and decryption return a null string.
+ */
+void VaultKey::lock()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_encryptor)
+        return;
+
+    m_checkText = randomCheckText();
+    m_check = m_encryptor->encryptStrToStr(m_checkText);
+    m_encryptor.reset();
+    m_fingerprint.fill('\0');
+    m_fingerprint.clear();
+}
+
+
+/**
+ * @brief Restores the key material after lock().
+ *
+ * The password is checked by decrypting the text that has been encrypted in lock().
+ *
+ * @param password the password that has been passed to the constructor
+ * @return @c true if the password is correct or the key is not locked, @c false if the
+ *         password is wrong and the key stays locked
+ */
+bool VaultKey::unlock(const QString& password)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_encryptor)
+        return true;
+
+    QScopedPointer<SymmetricEncryptor> encryptor(new SymmetricEncryptor(m_algorithm, password));
+    if (encryptor->decryptStrFromStr(m_check) != m_checkText)
+        return false;
+
+    m_encryptor.reset(encryptor.take());
+    m_fingerprint = fingerprint(m_algorithm, password);
+    m_check = QString::null;
+    m_checkText = QString::null;
+    return true;
+}
+
+
+/**
+ * @brief Checks if the key material has been destroyed with lock().
+ *
+ * @return @c true if the key is locked, @c false otherwise
+ */
+bool VaultKey::isLocked() const
+{
+    QMutexLocker locker(&m_mutex);
+    return !m_encryptor;
+}
+
+
+/**
+ * @copydoc StringEncryptor::encryptStrToStr
+ */
+QString VaultKey::encryptStrToStr(const QString& string)
+{
+    QMutexLocker locker(&m_mutex);
+    return m_encryptor ? m_encryptor->encryptStrToStr(string) : QString::null;
+}
+
+
+/**
+ * @copydoc StringEncryptor::encryptUtf8ToStr
+ */
+QString VaultKey::encryptUtf8ToStr(const char* utf8, size_t size)
+{
+    QMutexLocker locker(&m_mutex);
+    return m_encryptor ? m_encryptor->encryptUtf8ToStr(utf8, size) : QString::null;
+}
+
+
+/**
+ * @copydoc StringEncryptor::decryptStrFromStr
+ */
+QString VaultKey::decryptStrFromStr(const QString& string)
+{
+    QMutexLocker locker(&m_mutex);
+    return m_encryptor ? m_encryptor->decryptStrFromStr(string) : QString::null;
+}
+
+
+/**
+ * @copydoc StringEncryptor::decryptSecureFromStr
+ */
+SecureString VaultKey::decryptSecureFromStr(const QString& string)
+{
+    QMutexLocker locker(&m_mutex);
+    return m_encryptor ? m_encryptor->decryptSecureFromStr(string) : SecureString();
+}
+
+
+/**
+ * @brief Returns the random key for fingerprint() that only lives in this process.
+ *
+ * @return the key
+ */
+static QByteArray fingerprintKey()
+{
+    QByteArray key(32, '\0');
+    if (RAND_bytes(reinterpret_cast<unsigned char*>(key.data()), key.size()) != 1)
+        qWarning() << "VaultKey: RAND_bytes() failed, using a weak fingerprint key";
+    return key;
+}
+
+
+/**
+ * @brief Computes the value that identifies a key.
+ *
+ * The fingerprint is keyed with a random key of the process, so it cannot be used to check
+ * guesses of the password outside of the process.
+ *
+ * @param algorithm the cipher algorithm
+ * @param password the password
+ * @return the HMAC-SHA256 of both
+ */
+QByteArray VaultKey::fingerprint(const QString& algorithm, const QString& password)
+{
+    static const QByteArray key = fingerprintKey();
+
+    QByteArray data = algorithm.toUtf8();
+    data.append('\0');
+    data.append(password.toUtf8());
+
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int length = 0;
+    HMAC(EVP_sha256(), key.constData(), key.size(),
+         reinterpret_cast<const unsigned char*>(data.constData()), data.size(), digest, &length);
+    data.fill('\0');
+
+    return QByteArray(reinterpret_cast<const char*>(digest), length);
+}
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
@@ -0,0 +1,62 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#ifndef VAULTKEY_H
+#define VAULTKEY_H
+
+#include <QString>
+#include <QByteArray>
+#include <QMutex>
+#include <QScopedPointer>
+
+#include "global.h"
+#include "encryptor.h"
+#include "symmetricencryptor.h"
+
+class VaultKey : public StringEncryptor
+{
+    public:
+        VaultKey(const QString& algorithm, const QString& password);
+
+        QString getAlgorithm() const;
+        bool hasSameKey(const VaultKey& other) const;
+
+        void lock();
+        bool unlock(const QString& password);
+        bool isLocked() const;
+
+        QString encryptStrToStr(const QString& string);
+        QString encryptUtf8ToStr(const char* utf8, size_t size);
+        QString decryptStrFromStr(const QString& string);
+        SecureString decryptSecureFromStr(const QString& string);
+
+    private:
+        static QByteArray fingerprint(const QString& algorithm, const QString& password);
+
+    private:
+        QScopedPointer<SymmetricEncryptor>  m_encryptor;
+        const QString                       m_algorithm;
+        QByteArray                          m_fingerprint;
+        QString                             m_checkText;
+        QString                             m_check;
+        mutable QMutex                      m_mutex;
+
+    private:
+        VaultKey(const VaultKey&);
+        VaultKey& operator=(const VaultKey&);
+};
+
+#endif // VAULTKEY_H
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
@@ -20,69 +20,149 @@
 #include "qpamat.h"
 #include "security/symmetricencryptor.h"
 #include "security/passwordgeneratorfactory.h"
+#include "security/passwordcheckerfactory.h"
 #include "settings.h"
 #include "security/encryptor.h"
 
+/**
+ * @brief The registry of all settings.
+ *
+ * Indexed by Settings::Key. The name is the key in QSettings, the type is the type of the
+ * value in the cache.
+ */
+static const struct {
+    Settings::Key   key;
+    const char      *name;
+    QVariant::Type  type;
+} s_registry[] = {
+    { Settings::MainWindowMaximized,           "Main Window/maximized", QVariant::Bool },
+    { Settings::MainWindowSearchHistory,       "Main Window/SearchHistory", QVariant::String },
+    { Settings::MainWindowLayout,              "Main Window/layout", QVariant::ByteArray },
+    { Settings::MainWindowWidth,               "Main Window/width", QVariant::Int },
+    { Settings::MainWindowHeight,              "Main Window/height", QVariant::Int },
+    { Settings::MainWindowRightPanelLayout,    "Main Window/rightpanelLayout", QVariant::String },
+    { Settings::GeneralDatafile,               "General/Datafile", QVariant::String },
+    { Settings::GeneralAutoLogin,              "General/AutoLogin", QVariant::Bool },
+    { Settings::GeneralAutoSaveInterval,       "General/AutoSaveInterval", QVariant::Int },
+    { Settings::AutoTextMisc,                  "AutoText/Misc", QVariant::String },
+    { Settings::AutoTextUsername,              "AutoText/Username", QVariant::String },
+    { Settings::AutoTextPassword,              "AutoText/Password", QVariant::String },
+    { Settings::AutoTextURL,                   "AutoText/URL", QVariant::String },
+    { Settings::SecurityCipherAlgorithm,       "Security/CipherAlgorithm", QVariant::String },
+    { Settings::SecurityLength,                "Security/Length", QVariant::Int },
+    { Settings::SecurityAllowedCharacters,     "Security/AllowedCharacters", QVariant::String },
+    { Settings::SecurityWeakPasswordLimit,     "Security/WeakPasswordLimit", QVariant::Double },
+    { Settings::SecurityStrongPasswordLimit,   "Security/StrongPasswordLimit", QVariant::Double },
+    { Settings::SecurityDictionaryFile,        "Security/DictionaryFile", QVariant::String },
+    { Settings::SecurityPasswordChecker,       "Security/PasswordChecker", QVariant::String },
+    { Settings::SecurityBreachCorpus,          "Security/BreachCorpus", QVariant::String },
+    { Settings::SecurityPasswordGenerator,     "Security/PasswordGenerator", QVariant::String },
+    { Settings::SecurityPasswordGenAdditional, "Security/PasswordGenAdditional", QVariant::String },
+    { Settings::SecurityAutoLogout,            "Security/AutoLogout", QVariant::Int },
+    { Settings::SecurityLazyDecryption,        "Security/LazyDecryption", QVariant::Bool },
+    { Settings::PasswordNoGrabbing,            "Password/NoGrabbing", QVariant::Bool },
+    { Settings::PresentationNormalFont,        "Presentation/NormalFont", QVariant::String },
+    { Settings::PresentationFooterFont,        "Presentation/FooterFont", QVariant::String },
+    { Settings::PresentationHideRandomPass,    "Presentation/HideRandomPass", QVariant::Bool },
+    { Settings::PresentationSystemTrayIcon,    "Presentation/SystemTrayIcon", QVariant::Bool },
+    { Settings::PresentationStartHidden,       "Presentation/StartHidden", QVariant::Bool }
+};
+
 
 /**
  * @class Settings
  *
  * @brief Singleton for storing settings in registry (MS Windows) or ini-file (Unix).
  *
+ * Each setting is identified by a Settings::Key, so a misspelled key is a compile error.
+ * All values are read once in the constructor and cached, so reading a setting is only an
+ * array access. Writing updates the cache and QSettings and remembers the key, so after the
+ * configuration dialog has been closed, QpamatWindow::settingsChanged() can tell which
+ * settings have been changed (see takeChangedKeys()).
+ *
  * @ingroup gui
  * @author Bernhard Walle
  */
 
+/**
+ * @enum Settings::Key
+ *
+ * @brief The settings, see keyName() for the key in QSettings.
+ */
+
+/**
+ * @typedef Settings::KeySet
+ *
+ * @brief A set of settings, see takeChangedKeys().
+ */
+
 /**
  * @brief Creates a new instance of the settings object.
  *
- * The default values are initialized.
+ * The default values are initialized and the stored values are read.
  */
 Settings::Settings()
+    : m_values(KeyCount)
 {
     m_qSettings.setPath( "qpamat", "qpamat", QSettings::User );
 
-#define DEF_STRING(a, b) ( m_stringMap.insert( (a), (b) ) )
-#define DEF_INTEGE(a, b) ( m_intMap.insert( (a), (b) ) )
-#define DEF_DOUBLE(a, b) ( m_doubleMap.insert( (a), (b) ) )
-#define DEF_BOOLEA(a, b) ( m_boolMap.insert( (a), (b) ) )
-
-    DEF_BOOLEA("Main Window/maximized",          false);
-    DEF_STRING("Main Window/SearchHistory",      "");
-    DEF_STRING("Main Window/Layout",             "");
-    DEF_STRING("General/Datafile",               QDir::homeDirPath() + "/.qpamat");
-    DEF_BOOLEA("General/AutoLogin",              true);
-    DEF_STRING("AutoText/Misc",                  "");
-    DEF_STRING("AutoText/Username",              "Username");
-    DEF_STRING("AutoText/Password",              "Password");
-    DEF_STRING("AutoText/URL",                   "URL");
-    DEF_STRING("Security/CipherAlgorithm",       SymmetricEncryptor::getSuggestedAlgorithm());
-    DEF_INTEGE("Security/Length",                8);
-    DEF_STRING("Security/AllowedCharacters",     "a-zA-Z0-9@$#");
-    DEF_DOUBLE("Security/WeakPasswordLimit",     3.0);
-    DEF_DOUBLE("Security/StrongPasswordLimit",   15.0);
-    DEF_STRING("Security/DictionaryFile",        QDir(Qpamat::basePath() + "/share/qpamat/dicts")
+    setDefault(MainWindowMaximized,             false);
+    setDefault(MainWindowSearchHistory,         QString(""));
+    setDefault(MainWindowLayout,                QByteArray());
+    setDefault(MainWindowWidth,                 0);
+    setDefault(MainWindowHeight,                0);
+    setDefault(MainWindowRightPanelLayout,      QString());
+    setDefault(GeneralDatafile,                 QDir::homeDirPath() + "/.qpamat");
+    setDefault(GeneralAutoLogin,                true);
+    setDefault(GeneralAutoSaveInterval,         0);
+    setDefault(AutoTextMisc,                    QString(""));
+    setDefault(AutoTextUsername,                QString("Username"));
+    setDefault(AutoTextPassword,                QString("Password"));
+    setDefault(AutoTextURL,                     QString("URL"));
+    setDefault(SecurityCipherAlgorithm,         SymmetricEncryptor::getSuggestedAlgorithm());
+    setDefault(SecurityLength,                  8);
+    setDefault(SecurityAllowedCharacters,       QString("a-zA-Z0-9@$#"));
+    setDefault(SecurityWeakPasswordLimit,       3.0);
+    setDefault(SecurityStrongPasswordLimit,     15.0);
+    setDefault(SecurityDictionaryFile,          QDir(Qpamat::basePath() + "/share/qpamat/dicts")
                                                     .canonicalPath() + "/default.txt");
-    DEF_STRING("Security/PasswordGenerator",     PasswordGeneratorFactory::DEFAULT_GENERATOR_STRING);
-    DEF_STRING("Security/PasswordGenAdditional", "");
-    DEF_INTEGE("Security/AutoLogout",            0);
-    DEF_BOOLEA("Password/NoGrabbing",            false);
+    setDefault(SecurityPasswordChecker,
+               QString(PasswordCheckerFactory::HYBRID_CHECKER_STRING));
+    setDefault(SecurityBreachCorpus,            QString(""));
+    setDefault(SecurityPasswordGenerator,
+               QString(PasswordGeneratorFactory::DEFAULT_GENERATOR_STRING));
+    setDefault(SecurityPasswordGenAdditional,   QString(""));
+    setDefault(SecurityAutoLogout,              0);
+    setDefault(SecurityLazyDecryption,          false);
+    setDefault(PasswordNoGrabbing,              false);
 #ifdef Q_WS_WIN
-    DEF_STRING("Presentation/NormalFont",        "Times New Roman,10");
-    DEF_STRING("Presentation/FooterFont",        "Arial,9");
+    setDefault(PresentationNormalFont,          QString("Times New Roman,10"));
+    setDefault(PresentationFooterFont,          QString("Arial,9"));
 #else
-    DEF_STRING("Presentation/NormalFont",        "Times,10");
-    DEF_STRING("Presentation/FooterFont",        "Helvetica,9");
+    setDefault(PresentationNormalFont,          QString("Times,10"));
+    setDefault(PresentationFooterFont,          QString("Helvetica,9"));
 #endif
-    DEF_BOOLEA("Presentation/HideRandomPass",    false);
-    DEF_BOOLEA("Presentation/SystemTrayIcon",    false);
-    DEF_BOOLEA("Presentation/StartHidden",       false);
-
-
-#undef DEF_STRING
-#undef DEF_INTEGE
-#undef DEF_DOUBLE
-#undef DEF_BOOLEA
+    setDefault(PresentationHideRandomPass,      false);
+    setDefault(PresentationSystemTrayIcon,      false);
+    setDefault(PresentationStartHidden,         false);
+
+    for (int i = 0; i < KeyCount; ++i) {
+        Q_ASSERT(s_registry[i].key == i);
+        Q_ASSERT(m_values[i].type() == s_registry[i].type);
+
+        const QString name = QLatin1String(s_registry[i].name);
+        if (!m_qSettings.contains(name))
+            continue;
+
+        QVariant value = m_qSettings.value(name);
+        if (s_registry[i].type == QVariant::ByteArray)
+            value = QByteArray::fromBase64(value.toString().toUtf8());
+        else if (!value.convert(s_registry[i].type)) {
+            qDebug() << CURRENT_FUNCTION << "Invalid value for" << name << "- using default";
+            continue;
+        }
+        m_values[i] = value;
+    }
 }
 
 
@@ -92,6 +172,57 @@ Settings::Settings()
  * Destructor
  */
 
+/**
+ * @brief Returns the name of the key in QSettings.
+ *
+ * @param key the setting
+ * @return the name, e.g. <tt>"General/Datafile"</tt>
+ */
+QString Settings::keyName(Key key)
+{
+    Q_ASSERT(key >= 0 && key < KeyCount);
+
+    return QLatin1String(s_registry[key].name);
+}
+
+
+/**
+ * @brief Sets the default value of a setting.
+ *
+ * @param key the setting
+ * @param value the default value, the type must match the registry
+ */
+void Settings::setDefault(Key key, const QVariant& value)
+{
+    m_values[key] = value;
+}
+
+
+/**
+ * @brief Writes a value into the cache and into QSettings.
+ *
+ * @param key the setting
+ * @param value the value
+ * @return if the entry was written
+ */
+bool Settings::write(Key key, const QVariant& value)
+{
+    Q_ASSERT(value.type() == s_registry[key].type);
+
+    if (m_values[key] != value) {
+        m_values[key] = value;
+        m_changedKeys.insert(key);
+    }
+
+    if (value.type() == QVariant::ByteArray)
+        m_qSettings.setValue(keyName(key), QString::fromUtf8(value.toByteArray().toBase64()));
+    else
+        m_qSettings.setValue(keyName(key), value);
+
+    return m_qSettings.status() == QSettings::NoError;
+}
+
+
 /**
  * @brief Writes an entry into the settings.
  *
@@ -99,9 +230,9 @@ Settings::Settings()
  * @param value the value
  * @return if the entry was written
  */
-bool Settings::writeEntry(const QString & key, const QString & value)
+bool Settings::writeEntry(Key key, const QString & value)
 {
-    return m_qSettings.writeEntry(key, value);
+    return write(key, value);
 }
 
 
@@ -113,9 +244,9 @@ bool Settings::writeEntry(const QString & key, const QString & value)
  *
  * @return if the entry was written
  */
-bool Settings::writeEntry(const QString & key, double value)
+bool Settings::writeEntry(Key key, double value)
 {
-    return m_qSettings.writeEntry(key, value);
+    return write(key, value);
 }
 
 
@@ -126,9 +257,9 @@ bool Settings::writeEntry(const QString & key, double value)
  * @param value the value
  * @return if the entry was written
  */
-bool Settings::writeEntry(const QString & key, int value)
+bool Settings::writeEntry(Key key, int value)
 {
-    return m_qSettings.writeEntry(key, value);
+    return write(key, value);
 }
 
 
@@ -140,9 +271,9 @@ bool Settings::writeEntry(const QString & key, int value)
  *
  * @return if the entry was written
  */
-bool Settings::writeEntry(const QString & key, bool value)
+bool Settings::writeEntry(Key key, bool value)
 {
-    return m_qSettings.writeEntry(key, value);
+    return write(key, value);
 }
 
 
@@ -154,115 +285,125 @@ bool Settings::writeEntry(const QString & key, bool value)
  *
  * @return if the entry was written
  */
-bool Settings::writeEntry(const QString& key, const QByteArray& bytes)
+bool Settings::writeEntry(Key key, const QByteArray& bytes)
 {
-    return m_qSettings.writeEntry(key, QString::fromUtf8(bytes.toBase64()));
-
+    return write(key, bytes);
 }
 
 
 /**
  * @brief Reads the entry.
  *
- * If the entry does not exist there's a automatic default value that is
- * returned.
+ * If the entry does not exist the default value is returned.
  *
  * @return the entry
  */
-QString Settings::readEntry(const QString & key, const QString& def)
+QString Settings::readEntry(Key key) const
 {
-    bool read = false;
-    QString string = m_qSettings.readEntry(key, def, &read);
+    Q_ASSERT(s_registry[key].type == QVariant::String);
 
-    if (!read && m_stringMap.contains(key))
-        return m_stringMap[key];
-    else if (!read && def.isNull())
-        qDebug() << CURRENT_FUNCTION << "Implicit default returned, key =" << key;
-
-    return string;
+    return m_values[key].toString();
 }
 
 
 /**
  * @brief Reads a number entry.
  *
- * If the entry does not exist there's a automatic default value that is
- * returned.
+ * If the entry does not exist the default value is returned.
  *
  * @return the entry
  */
-int Settings::readNumEntry (const QString & key, int def)
+int Settings::readNumEntry(Key key) const
 {
-    bool read = m_qSettings.contains(key);
-    int number = m_qSettings.value(key, def).toInt();
-    if (!read && m_intMap.contains(key))
-        return m_intMap[key];
-    else if (!read && def == 0)
-        qDebug() << CURRENT_FUNCTION << "Implicit default returned, key =" << key;
-
-    return number;
+    Q_ASSERT(s_registry[key].type == QVariant::Int);
+
+    return m_values[key].toInt();
 }
 
 
 /**
  * @brief Reads a double entry.
  *
- * If the entry does not exist there's a automatic default value that is returned.
+ * If the entry does not exist the default value is returned.
  *
  * @return the entry
  */
-double Settings::readDoubleEntry(const QString & key, double def) const
+double Settings::readDoubleEntry(Key key) const
 {
-    bool read = m_qSettings.contains(key);
-    double number = m_qSettings.value(key, def).toDouble();
-    if (!read && m_doubleMap.contains(key))
-        return m_doubleMap[key];
-    else if (!read && def == 0.0)
-        qDebug() << CURRENT_FUNCTION << "Implicit default returned, key = %s" << key;
-
-    return number;
+    Q_ASSERT(s_registry[key].type == QVariant::Double);
+
+    return m_values[key].toDouble();
 }
 
 
 /**
  * @brief Reads a boolean entry.
  *
- * If the entry does not exist there's a automatic default value that
- * is returned.
+ * If the entry does not exist the default value is returned.
  *
  * @return the entry
  */
-bool Settings::readBoolEntry(const QString & key, bool def) const
+bool Settings::readBoolEntry(Key key) const
 {
-    bool read = m_qSettings.contains(key);
-    bool res = m_qSettings.value(key, def).toBool();
-    if (!read && m_boolMap.contains(key))
-        return m_boolMap[key];
-    else if (!read && !def)
-        qDebug() << CURRENT_FUNCTION << "Implicit default returned, key =" << key;
-
-    return res;
+    Q_ASSERT(s_registry[key].type == QVariant::Bool);
+
+    return m_values[key].toBool();
 }
 
 
 /**
- * @brief  Writes a QByteArray entry.
+ * @brief Reads a QByteArray entry.
  *
- * If the entry does not exist, the default value is returned.    There's no
- * automatic default value for QByteArrays.
+ * If the entry does not exist, an empty byte array is returned.
  *
  * @param key the key to look for
- * @param def the default value if the key does not exist
- *
  * @return the entry
  */
-QByteArray Settings::readByteArrayEntry(const QString& key, const QByteArray& def)
+QByteArray Settings::readByteArrayEntry(Key key) const
 {
-    if (m_qSettings.contains(key))
-        return QByteArray::fromBase64(m_qSettings.value(key).toString().toUtf8());
-    else
-        return def;
+    Q_ASSERT(s_registry[key].type == QVariant::ByteArray);
+
+    return m_values[key].toByteArray();
+}
+
+
+/**
+ * @brief Returns the settings that have been changed since the last call.
+ *
+ * Only settings whose value is different are reported, so writing all settings of a dialog
+ * is fine.
+ *
+ * @return the changed settings
+ */
+Settings::KeySet Settings::takeChangedKeys()
+{
+    KeySet keys = m_changedKeys;
+    m_changedKeys.clear();
+    return keys;
 }
 
 
+/**
+ * @brief Reads the configuration of the data file and of the password checks.
+ *
+ * The result should be kept until the settings are changed, so the settings are not
+ * looked up each time the data file is accessed or a password is checked.
+ *
+ * @return the configuration
+ */
+VaultConfig Settings::vaultConfig() const
+{
+    VaultConfig config;
+    config.setDataFile(readEntry(GeneralDatafile));
+    config.setCipherAlgorithm(readEntry(SecurityCipherAlgorithm));
+    config.setLazyDecryption(readBoolEntry(SecurityLazyDecryption));
+    config.setDictionaryFile(readEntry(SecurityDictionaryFile));
+    config.setPasswordChecker(readEntry(SecurityPasswordChecker));
+    config.setBreachCorpusFile(readEntry(SecurityBreachCorpus));
+    config.setWeakPasswordLimit(readDoubleEntry(SecurityWeakPasswordLimit));
+    config.setStrongPasswordLimit(readDoubleEntry(SecurityStrongPasswordLimit));
+
+    return config;
+}
+
 // vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
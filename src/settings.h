@@ -16,32 +16,83 @@
 #define SETTINGS_H
 
 #include <QSettings>
-#include <QMap>
+#include <QVariant>
+#include <QVector>
+#include <QSet>
+
+#include "vaultconfig.h"
 
 class Settings
 {
+    public:
+        enum Key {
+            MainWindowMaximized,
+            MainWindowSearchHistory,
+            MainWindowLayout,
+            MainWindowWidth,
+            MainWindowHeight,
+            MainWindowRightPanelLayout,
+            GeneralDatafile,
+            GeneralAutoLogin,
+            GeneralAutoSaveInterval,
+            AutoTextMisc,
+            AutoTextUsername,
+            AutoTextPassword,
+            AutoTextURL,
+            SecurityCipherAlgorithm,
+            SecurityLength,
+            SecurityAllowedCharacters,
+            SecurityWeakPasswordLimit,
+            SecurityStrongPasswordLimit,
+            SecurityDictionaryFile,
+            SecurityPasswordChecker,
+            SecurityBreachCorpus,
+            SecurityPasswordGenerator,
+            SecurityPasswordGenAdditional,
+            SecurityAutoLogout,
+            SecurityLazyDecryption,
+            PasswordNoGrabbing,
+            PresentationNormalFont,
+            PresentationFooterFont,
+            PresentationHideRandomPass,
+            PresentationSystemTrayIcon,
+            PresentationStartHidden,
+            KeyCount
+        };
+
+        typedef QSet<Key> KeySet;
+
     public:
         Settings();
         virtual ~Settings() { }
 
-        bool writeEntry(const QString& key, const QString & value);
-        bool writeEntry(const QString& key, int value);
-        bool writeEntry(const QString& key, bool value);
-        bool writeEntry(const QString& key, double value);
-        bool writeEntry(const QString& key, const QByteArray& bytes);
+        bool writeEntry(Key key, const QString& value);
+        bool writeEntry(Key key, int value);
+        bool writeEntry(Key key, bool value);
+        bool writeEntry(Key key, double value);
+        bool writeEntry(Key key, const QByteArray& bytes);
+
+        QString readEntry(Key key) const;
+        int readNumEntry(Key key) const;
+        double readDoubleEntry(Key key) const;
+        bool readBoolEntry(Key key) const;
+        QByteArray readByteArrayEntry(Key key) const;
 
-        QString readEntry(const QString & key, const QString& def = QString::null);
-        int readNumEntry (const QString & key, int def = 0);
-        double readDoubleEntry(const QString & key, double def = 0.0) const;
-        bool readBoolEntry(const QString & key, bool def = false) const;
-        QByteArray readByteArrayEntry(const QString& key, const QByteArray& def = QByteArray());
+        KeySet takeChangedKeys();
+
+        VaultConfig vaultConfig() const;
+
+    public:
+        static QString keyName(Key key);
+
+    private:
+        void setDefault(Key key, const QVariant& value);
+        bool write(Key key, const QVariant& value);
 
     private:
         QSettings               m_qSettings;
-        QMap<QString, QString>  m_stringMap;
-        QMap<QString, int>      m_intMap;
-        QMap<QString, bool>     m_boolMap;
-        QMap<QString, double>   m_doubleMap;
+        QVector<QVariant>       m_values;
+        KeySet                  m_changedKeys;
 
     private:
         Settings(const Settings&);
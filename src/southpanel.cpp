@@ -30,6 +30,10 @@
 #include "qpamat.h"
 #include "southpanel.h"
 #include "settings.h"
+#include "reuseindex.h"
+#include "strengthevaluator.h"
+#include "security/passwordcheckerfactory.h"
+#include "undocommands.h"
 #include "util/stringdisplay.h"
 
 
@@ -88,7 +92,7 @@ SouthPanel::SouthPanel(QWidget* parent)
     QHBoxLayout* hLayout = new QHBoxLayout(this, 0, 10, "SouthPanel-QHBoxLayout");
     Q3GroupBox* group = new Q3GroupBox(2, Qt::Horizontal, tr("&Properties"), this, "SouthPanel-GroupBox");
 
-    m_updatePasswordQualityTimer = new QTimer(this, "Timer");
+    m_strengthEvaluator = new StrengthEvaluator(this);
 
     // Type
     QLabel* typeLabel = new QLabel(tr("&Type"), group);
@@ -110,6 +114,11 @@ SouthPanel::SouthPanel(QWidget* parent)
     m_valueLineEdit = new FocusLineEdit(group);
     valueLabel->setBuddy(m_valueLineEdit);
 
+    // reuse of the password, the first column stays empty
+    new QWidget(group);
+    m_reuseLabel = new QLabel(group);
+    m_reuseLabel->hide();
+
     hLayout->addWidget(group);
 
     // button group box
@@ -155,7 +164,10 @@ SouthPanel::SouthPanel(QWidget* parent)
     connect(m_typeCombo, SIGNAL(activated(int)), SIGNAL(stateModified()));
     connect(m_keyLineEdit, SIGNAL(textChanged(const QString&)), SIGNAL(stateModified()));
     connect(m_valueLineEdit, SIGNAL(textChanged(const QString&)), SIGNAL(stateModified()));
-    connect(m_updatePasswordQualityTimer, SIGNAL(timeout()), SLOT(updateIndicatorLabel()));
+    connect(m_strengthEvaluator, SIGNAL(evaluated(double)),
+        SLOT(passwordStrengthEvaluated(double)));
+    connect(m_strengthEvaluator, SIGNAL(failed(const QString&)),
+        SLOT(showPasswordCheckError(const QString&)));
     connect(this, SIGNAL(stateModified()), SIGNAL(passwordStrengthUpdated()));
 }
 
@@ -167,9 +179,11 @@ void SouthPanel::clear()
 {
     m_currentProperty = 0;
     m_lastStrength = Property::PUndefined;
+    m_strengthEvaluator->cancel();
     m_indicatorLabel->setPixmap(QPixmap());
     m_indicatorLabel->repaint(true);
     QToolTip::remove(m_indicatorLabel);
+    m_reuseLabel->hide();
     blockSignals(true);
     m_keyLineEdit->setText(QString::null);
     m_valueLineEdit->setText(QString::null);
@@ -200,7 +214,7 @@ void SouthPanel::setItem (Property* property)
         insertAutoText();
     }
     m_currentProperty = property;
-    updateIndicatorLabel(false);
+    updateIndicatorLabel();
 
     setEnabled(property != 0);
 }
@@ -209,18 +223,17 @@ void SouthPanel::setItem (Property* property)
 /**
  * Updates the traffic light.
  *
- * @param recompute whether recomputation of the password strength should take place
+ * The password strength is not computed again, that is done by evaluatePasswordStrength() in
+ * the background while the user types.
  */
-void SouthPanel::updateIndicatorLabel(bool recompute)
+void SouthPanel::updateIndicatorLabel()
 {
     if (m_currentProperty && m_currentProperty->getType() == Property::PASSWORD) {
         try {
-            if (recompute)
-                m_currentProperty->updatePasswordStrength();
-
-            if (m_currentProperty->getPasswordStrength() != m_lastStrength) {
+            const VaultConfig& config = Qpamat::instance()->getWindow()->getVaultConfig();
+            if (m_currentProperty->getPasswordStrength(config) != m_lastStrength) {
                 emit passwordStrengthUpdated();
-                m_lastStrength = m_currentProperty->getPasswordStrength();
+                m_lastStrength = m_currentProperty->getPasswordStrength(config);
                 switch (m_lastStrength) {
                     case Property::PWeak:
                         m_indicatorLabel->setPixmap(QPixmap(":/images/traffic_red_22.png"));
@@ -245,22 +258,107 @@ void SouthPanel::updateIndicatorLabel(bool recompute)
             QToolTip::add(m_indicatorLabel, tooltipString);
 
         } catch (const PasswordCheckException& e) {
-            // possible workaround to prevent multiple selection in the list this time
-            // A bit unclean ???
-            /* QMessageBox* mb = new QMessageBox("QPaMaT", tr("<qt><nobr>Failed to calculate the password "
-                "strength. The error message</nobr> was:<p>%1<p>Check your configuration!</qt>")
-                .arg(e.what()), QMessageBox::Warning, QMessageBox::Ok, QMessageBox::NoButton,
-                QMessageBox::NoButton, this, 0, true, WDestructiveClose);
-            mb->show(); */
-            QMessageBox::warning(this, "QPaMaT", tr("<qt><nobr>Failed to calculate the password "
-                "strength. The error message</nobr> was:<p>%1<p>Check your configuration!</qt>")
-                .arg(e.what()), QMessageBox::Ok, QMessageBox::NoButton);
+            showPasswordCheckError(e.what());
         }
     } else {
         m_indicatorLabel->setPixmap(QPixmap());
         m_indicatorLabel->repaint(true);
         QToolTip::remove(m_indicatorLabel);
     }
+
+    updateReuseLabel();
+}
+
+
+/**
+ * Checks the current password in the background.
+ *
+ * The StrengthEvaluator waits until the user stops typing and drops results of passwords
+ * that have been changed meanwhile, so passwordStrengthEvaluated() always gets the strength
+ * of the current value. The checker is created only once and kept until
+ * resetPasswordChecker() is called.
+ */
+void SouthPanel::evaluatePasswordStrength()
+{
+    if (!m_currentProperty || m_currentProperty->getType() != Property::PASSWORD) {
+        m_strengthEvaluator->cancel();
+        return;
+    }
+
+    if (!m_strengthEvaluator->hasChecker()) {
+        try {
+            const VaultConfig& config = Qpamat::instance()->getWindow()->getVaultConfig();
+            m_strengthEvaluator->setChecker(PasswordCheckerFactory::getChecker(config));
+        } catch (const PasswordCheckException& e) {
+            showPasswordCheckError(e.what());
+            return;
+        }
+    }
+
+    m_strengthEvaluator->evaluate(m_valueLineEdit->text());
+}
+
+
+/**
+ * Stores the result of evaluatePasswordStrength() in the property and updates the traffic
+ * light.
+ *
+ * @param days the days to crack the current value
+ */
+void SouthPanel::passwordStrengthEvaluated(double days)
+{
+    if (!m_currentProperty)
+        return;
+
+    m_currentProperty->setDaysToCrack(days, Qpamat::instance()->getWindow()->getVaultConfig());
+    updateIndicatorLabel();
+}
+
+
+/**
+ * Drops the checker of evaluatePasswordStrength(), e.g. because the dictionary has changed.
+ *
+ * A running check is waited for, so the next checker can load its dictionary safely. The
+ * next checker is created when the user changes the password.
+ */
+void SouthPanel::resetPasswordChecker()
+{
+    m_strengthEvaluator->setChecker(0);
+}
+
+
+/**
+ * Tells the user that the password strength could not be computed.
+ *
+ * @param message the message of the PasswordCheckException
+ */
+void SouthPanel::showPasswordCheckError(const QString& message)
+{
+    QMessageBox::warning(this, "QPaMaT", tr("<qt><nobr>Failed to calculate the password "
+        "strength. The error message</nobr> was:<p>%1<p>Check your configuration!</qt>")
+        .arg(message), QMessageBox::Ok, QMessageBox::NoButton);
+}
+
+
+/**
+ * Shows in how many other entries the current password is used.
+ *
+ * The lookup in the ReuseIndex is cheap, so this is done each time the indicator is updated.
+ */
+void SouthPanel::updateReuseLabel()
+{
+    int count = 0;
+    if (m_currentProperty && m_currentProperty->getType() == Property::PASSWORD)
+        count = ReuseIndex::instance()->reuseCount(m_currentProperty);
+
+    if (count > 0) {
+        QString text = count == 1
+            ? tr("Also used in one other entry")
+            : tr("Also used in %1 other entries").arg(count);
+        m_reuseLabel->setText(QString("<qt><font color=\"#c00000\">%1</font></qt>").arg(text));
+        m_reuseLabel->show();
+    } else
+        m_reuseLabel->hide();
 }
 
 
@@ -270,12 +368,17 @@ void SouthPanel::updateIndicatorLabel(bool recompute)
 void SouthPanel::updateData()
 {
     if (m_currentProperty != 0) {
-        m_currentProperty->setType(Property::Type(m_typeCombo->currentItem()));
-        m_currentProperty->setHidden(m_typeCombo->currentItem() == Property::PASSWORD);
-        m_currentProperty->setEncrypted(m_typeCombo->currentItem() == Property::PASSWORD);
-        m_currentProperty->setValue(m_valueLineEdit->text());
-        m_updatePasswordQualityTimer->start(200, true);
-        m_currentProperty->setKey(m_keyLineEdit->text());
+        EditPropertyCommand::State state;
+        state.type = Property::Type(m_typeCombo->currentItem());
+        state.hidden = state.type == Property::PASSWORD;
+        state.encrypted = state.type == Property::PASSWORD;
+        state.value.set(m_valueLineEdit->text(), state.hidden);
+        state.key = m_keyLineEdit->text();
+
+        // consecutive keystrokes are merged to one undo step
+        Qpamat::instance()->getWindow()->undoStack().push(
+            new EditPropertyCommand(m_currentProperty, state));
+        evaluatePasswordStrength();
         m_valueLineEdit->setEchoMode(
             m_currentProperty->isHidden()
                 ? QLineEdit::Password
@@ -297,7 +400,7 @@ void SouthPanel::comboBoxChanged(int newChoice)
             m_valueLineEdit->setText("");
         }
 
-        updateIndicatorLabel(false);
+        updateIndicatorLabel();
     }
     m_oldComboValue = newChoice;
 }
@@ -309,31 +412,21 @@ void SouthPanel::comboBoxChanged(int newChoice)
 void SouthPanel::insertAutoText()
 {
     if (m_keyLineEdit->text().isEmpty()) {
-        QString newTxt;
-        QpamatWindow *win = Qpamat::instance()->getWindow();
-        switch ( Property::Type(m_typeCombo->currentItem()) ) {
-            case Property::MISC:
-                newTxt = win->set().readEntry("AutoText/Misc");
-                break;
-
-            case Property::USERNAME:
-                newTxt = win->set().readEntry("AutoText/Username");
-                break;
-
-            case Property::PASSWORD:
-                newTxt = win->set().readEntry("AutoText/Password");
-                break;
-
-            case Property::URL:
-                newTxt = win->set().readEntry("AutoText/URL");
-                break;
-
-            default:
-                qDebug() << CURRENT_FUNCTION << "Value is out of range:"
-                         << m_typeCombo->currentItem();
-                break;
+        static const Settings::Key autoTextKeys[] = {
+            Settings::AutoTextMisc,         // Property::MISC
+            Settings::AutoTextUsername,     // Property::USERNAME
+            Settings::AutoTextPassword,     // Property::PASSWORD
+            Settings::AutoTextURL           // Property::URL
+        };
+
+        unsigned int type = m_typeCombo->currentItem();
+        if (type >= ARRAY_SIZE(autoTextKeys)) {
+            qDebug() << CURRENT_FUNCTION << "Value is out of range:" << type;
+            return;
         }
-        m_keyLineEdit->setText(newTxt);
+
+        QpamatWindow *win = Qpamat::instance()->getWindow();
+        m_keyLineEdit->setText(win->set().readEntry(autoTextKeys[type]));
         m_valueLineEdit->setFocus();
     }
 }
@@ -21,11 +21,12 @@
 #include <Q3Frame>
 #include <QEvent>
 #include <QToolButton>
-#include <QTimer>
 
 #include "widgets/focuslineedit.h"
 #include "property.h"
 
+class StrengthEvaluator;
+
 class SouthPanel : public Q3Frame
 {
     Q_OBJECT
@@ -41,6 +42,7 @@ class SouthPanel : public Q3Frame
         void clear();
         void setMovingEnabled(bool up, bool down);
         void insertPassword(const QString& password);
+        void resetPasswordChecker();
 
     signals:
         void moveUp();
@@ -51,11 +53,15 @@ class SouthPanel : public Q3Frame
 
     protected:
         void insertAutoText();
+        void updateReuseLabel();
+        void evaluatePasswordStrength();
 
     private slots:
         void focusInValueHandler();
         void focusOutValueHandler();
-        void updateIndicatorLabel(bool recompute = true);
+        void updateIndicatorLabel();
+        void passwordStrengthEvaluated(double days);
+        void showPasswordCheckError(const QString& message);
 
     private:
         Property*                   m_currentProperty;
@@ -65,9 +71,10 @@ class SouthPanel : public Q3Frame
         QToolButton*                m_upButton;
         QToolButton*                m_downButton;
         QLabel*                     m_indicatorLabel;
+        QLabel*                     m_reuseLabel;
         Property::PasswordStrength  m_lastStrength;
         int                         m_oldComboValue;
-        QTimer*                     m_updatePasswordQualityTimer;
+        StrengthEvaluator*          m_strengthEvaluator;
 };
 
 #endif // SOUTHPANEL_H
@@ -0,0 +1,292 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#include <QScopedPointer>
+#include <QtConcurrentRun>
+
+#include "global.h"
+#include "strengthevaluator.h"
+
+/**
+ * @class StrengthJob
+ *
+ * @brief Computes the quality of one password.
+ *
+ * The checker is only used for reading, so run() can be executed in a worker thread while the
+ * GUI thread keeps the checker. Errors are not reported with an exception but can be
+ * retrieved with isSuccessful() and getErrorMessage().
+ *
+ * @ingroup gui
+ * @author Bernhard Walle
+ */
+
+/**
+ * @brief Creates a new job.
+ *
+ * @param checker the checker, must live longer than the job
+ * @param password the password to check
+ * @param serial identifies the input at the time the job was created, it's not interpreted
+ *        by the job
+ */
+StrengthJob::StrengthJob(PasswordChecker* checker, const QString& password, quint32 serial)
+    : m_checker(checker)
+    , m_password(password)
+    , m_serial(serial)
+    , m_days(-1.0)
+    , m_success(false)
+{}
+
+
+/**
+ * @brief Checks the password, this is called in a worker thread.
+ */
+void StrengthJob::run()
+{
+    try {
+        m_days = m_checker->passwordQuality(m_password);
+        m_success = true;
+    } catch (const PasswordCheckException& e) {
+        m_errorMessage = e.what();
+    }
+}
+
+
+/**
+ * @brief Returns whether the password has been checked successfully.
+ *
+ * @return @c true on success, @c false otherwise
+ */
+bool StrengthJob::isSuccessful() const
+{
+    return m_success;
+}
+
+
+/**
+ * @brief Returns the days that a cracker needs according to the checker.
+ *
+ * @return the days or a negative value if the job was not successful
+ */
+double StrengthJob::getDays() const
+{
+    return m_days;
+}
+
+
+/**
+ * @brief Returns the error message if the job was not successful.
+ *
+ * @return the message of the PasswordCheckException
+ */
+QString StrengthJob::getErrorMessage() const
+{
+    return m_errorMessage;
+}
+
+
+/**
+ * @brief Returns the serial that has been passed to the constructor.
+ *
+ * @return the serial
+ */
+quint32 StrengthJob::getSerial() const
+{
+    return m_serial;
+}
+
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * @class StrengthEvaluator
+ *
+ * @brief Rates a password while the user types it.
+ *
+ * Each call of evaluate() restarts a timer, so a password is only checked if the user stopped
+ * typing for a moment. The check runs in the thread pool of QtConcurrent with the checker
+ * that has been set with setChecker(); that checker and the dictionary that it has loaded
+ * are kept for all following passwords.
+ *
+ * Only one check runs at a time. A running check cannot be interrupted, but its result is
+ * dropped if evaluate() or cancel() has been called meanwhile, and only the most recent
+ * password is checked afterwards. So evaluated() and failed() always refer to the last
+ * input.
+ *
+ * @ingroup gui
+ * @author Bernhard Walle
+ */
+
+/**
+ * @fn StrengthEvaluator::evaluated(double)
+ *
+ * @brief Emitted in the GUI thread if the last password has been checked.
+ *
+ * @param days the days that a cracker needs according to the checker
+ */
+
+/**
+ * @fn StrengthEvaluator::failed(const QString&)
+ *
+ * @brief Emitted in the GUI thread if the checker threw a PasswordCheckException.
+ *
+ * @param message the error message
+ */
+
+/**
+ * @brief Creates a new StrengthEvaluator without a checker.
+ *
+ * @param parent the parent object
+ * @param delay the time in milliseconds the user must stop typing before the password is
+ *        checked
+ */
+StrengthEvaluator::StrengthEvaluator(QObject* parent, int delay)
+    : QObject(parent)
+    , m_job(0)
+    , m_serial(0)
+    , m_pending(false)
+{
+    m_timer.setSingleShot(true);
+    m_timer.setInterval(delay);
+
+    connect(&m_timer, SIGNAL(timeout()), SLOT(startJob()));
+    connect(&m_watcher, SIGNAL(finished()), SLOT(jobFinished()));
+}
+
+
+/**
+ * @brief Waits for a running check and deletes the StrengthEvaluator.
+ */
+StrengthEvaluator::~StrengthEvaluator()
+{
+    m_watcher.waitForFinished();
+    delete m_job;
+}
+
+
+/**
+ * @brief Checks if a checker has been set.
+ *
+ * @return @c true if there's a checker, @c false otherwise
+ */
+bool StrengthEvaluator::hasChecker() const
+{
+    return !m_checker.isNull();
+}
+
+
+/**
+ * @brief Sets the checker that is used for the following passwords.
+ *
+ * A running check is waited for and its result is dropped, so the old checker can be deleted.
+ * Call setChecker(0) before a new checker is created, because the constructor of a checker
+ * may load a dictionary that a running check reads. A password that has been passed to
+ * evaluate() before is checked with the new checker.
+ *
+ * @param checker the checker, the StrengthEvaluator takes ownership, may be 0
+ */
+void StrengthEvaluator::setChecker(PasswordChecker* checker)
+{
+    if (m_job) {
+        m_watcher.waitForFinished();
+        delete m_job;
+        m_job = 0;
+    }
+
+    m_checker.reset(checker);
+    if (m_pending && !m_timer.isActive())
+        startJob();
+}
+
+
+/**
+ * @brief Checks @p password after the delay.
+ *
+ * The result of a check that is running is dropped.
+ *
+ * @param password the password
+ */
+void StrengthEvaluator::evaluate(const QString& password)
+{
+    m_password = password;
+    m_pending = true;
+    ++m_serial;
+    m_timer.start();
+}
+
+
+/**
+ * @brief Drops the password that has been passed to evaluate() and the result of a running
+ *        check.
+ *
+ * Nothing is emitted until evaluate() is called again.
+ */
+void StrengthEvaluator::cancel()
+{
+    m_timer.stop();
+    m_password = QString::null;
+    m_pending = false;
+    ++m_serial;
+}
+
+
+/**
+ * @brief Checks if a check is running in a worker thread.
+ *
+ * @return @c true if a check is running, @c false otherwise
+ */
+bool StrengthEvaluator::isRunning() const
+{
+    return m_job != 0;
+}
+
+
+/**
+ * @brief Starts the check of the last password if no other check is running.
+ *
+ * If a check is running, jobFinished() starts the next one.
+ */
+void StrengthEvaluator::startJob()
+{
+    if (!m_pending || m_job || !m_checker)
+        return;
+
+    m_pending = false;
+    m_job = new StrengthJob(m_checker.data(), m_password, m_serial);
+    m_watcher.setFuture(QtConcurrent::run(m_job, &StrengthJob::run));
+}
+
+
+/**
+ * @brief Emits the result if it's still current and starts the next check.
+ */
+void StrengthEvaluator::jobFinished()
+{
+    // the notification of the watcher may arrive after setChecker() dropped the job
+    if (!m_job || !m_watcher.isFinished())
+        return;
+
+    QScopedPointer<StrengthJob> job(m_job);
+    m_job = 0;
+
+    if (job->getSerial() == m_serial) {
+        if (job->isSuccessful())
+            emit evaluated(job->getDays());
+        else
+            emit failed(job->getErrorMessage());
+    }
+
+    if (m_pending && !m_timer.isActive())
+        startJob();
+}
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
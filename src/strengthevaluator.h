@@ -0,0 +1,85 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#ifndef STRENGTHEVALUATOR_H
+#define STRENGTHEVALUATOR_H
+
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <QFutureWatcher>
+#include <QScopedPointer>
+
+#include "security/passwordchecker.h"
+
+class StrengthJob
+{
+    public:
+        StrengthJob(PasswordChecker* checker, const QString& password, quint32 serial);
+
+        void run();
+
+        bool isSuccessful() const;
+        double getDays() const;
+        QString getErrorMessage() const;
+        quint32 getSerial() const;
+
+    private:
+        PasswordChecker*    m_checker;
+        const QString       m_password;
+        const quint32       m_serial;
+        double              m_days;
+        QString             m_errorMessage;
+        bool                m_success;
+
+    private:
+        StrengthJob(const StrengthJob&);
+        StrengthJob& operator=(const StrengthJob&);
+};
+
+class StrengthEvaluator : public QObject
+{
+    Q_OBJECT
+
+    public:
+        StrengthEvaluator(QObject* parent = 0, int delay = 150);
+        ~StrengthEvaluator();
+
+        bool hasChecker() const;
+        void setChecker(PasswordChecker* checker);
+        void evaluate(const QString& password);
+        void cancel();
+        bool isRunning() const;
+
+    signals:
+        void evaluated(double days);
+        void failed(const QString& message);
+
+    private slots:
+        void startJob();
+        void jobFinished();
+
+    private:
+        QScopedPointer<PasswordChecker> m_checker;
+        QTimer                          m_timer;
+        QFutureWatcher<void>            m_watcher;
+        StrengthJob*                    m_job;
+        QString                         m_password;
+        quint32                         m_serial;
+        bool                            m_pending;
+};
+
+#endif // STRENGTHEVALUATOR_H
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
@@ -0,0 +1,193 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#include <QObject>
+#include <QBuffer>
+#include <QDir>
+#include <QFile>
+#include <QCoreApplication>
+#include <QtTest/QtTest>
+
+#include <security/breachcorpus.h>
+#include <tests/breachcorpus.h>
+
+/**
+ * @brief The size of the header of the hash file, see BreachCorpus
+ */
+static const int HEADER_SIZE = 64;
+
+/**
+ * @brief The number of entries of the fanout table, see BreachCorpus
+ */
+static const int FANOUT_SIZE = 65536 + 1;
+
+/**
+ * @brief A dump with three hashes, the second one is the SHA-1 of <tt>"password"</tt>
+ */
+static const char DUMP[] =
+    "0000000000000000000000000000000000000001:3\n"
+    "5BAA61E4C9B93F3F0682250B6CF8331B7EE68FD8:3730471\n"
+    "5baa61e4c9b93f3f0682250b6cf8331b7ee68fd8:3730471\n"
+    "FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF:1\n";
+
+/**
+ * @class TestBreachCorpus
+ *
+ * @brief Tests for the BreachCorpus and BreachCorpusBuilder classes
+ *
+ * @ingroup unittest
+ * @author Bernhard Walle
+ */
+
+/**
+ * @brief Builds the corpus @p fileName from DUMP.
+ *
+ * @param fileName the name of the Bloom filter
+ * @return @c true on success, @c false otherwise
+ */
+static bool buildCorpus(const QString& fileName)
+{
+    QByteArray dump(DUMP);
+    QBuffer input(&dump);
+    input.open(QIODevice::ReadOnly);
+
+    BreachCorpusBuilder builder(fileName);
+    return builder.build(input) && builder.size() == 3;
+}
+
+/**
+ * @brief Overwrites an entry of the fanout table of the corpus @p fileName.
+ *
+ * @param fileName the name of the Bloom filter
+ * @param index the index in the table
+ * @param value the new value
+ * @return @c true on success, @c false otherwise
+ */
+static bool patchFanout(const QString& fileName, int index, quint64 value)
+{
+    QFile file(BreachCorpus::hashFileName(fileName));
+    return file.open(QIODevice::ReadWrite) &&
+        file.seek(HEADER_SIZE + index * sizeof(quint64)) &&
+        file.write(reinterpret_cast<const char*>(&value), sizeof(value)) == sizeof(value);
+}
+
+/**
+ * @brief Creates the directory for the corpus files.
+ */
+void TestBreachCorpus::initTestCase()
+{
+    m_directory = QString("%1/qpamat-breachcorpus-%2").arg(QDir::tempPath())
+        .arg(QCoreApplication::applicationPid());
+    QVERIFY(QDir().mkpath(m_directory));
+}
+
+/**
+ * @brief Removes the corpus files.
+ */
+void TestBreachCorpus::cleanupTestCase()
+{
+    QDir directory(m_directory);
+    foreach (const QString& name, directory.entryList(QDir::Files | QDir::System))
+        directory.remove(name);
+    QDir().rmdir(m_directory);
+}
+
+/**
+ * @brief Tests the lookup in a corpus that has been built.
+ */
+void TestBreachCorpus::testLookup() const
+{
+    const QString fileName = m_directory + "/lookup.bloom";
+    QVERIFY(buildCorpus(fileName));
+
+    BreachCorpus corpus(fileName);
+    QCOMPARE(corpus.size(), Q_UINT64_C(3));
+    QVERIFY(corpus.contains("password"));
+    QVERIFY(!corpus.contains("Password"));
+    QVERIFY(!corpus.contains("correct horse battery staple"));
+}
+
+/**
+ * @brief The entries of the fanout table that are damaged.
+ */
+void TestBreachCorpus::testDamagedFanout_data() const
+{
+    QTest::addColumn<int>("index");
+    QTest::addColumn<quint64>("value");
+
+    QTest::newRow("first entry not 0") << 0 << Q_UINT64_C(1);
+    QTest::newRow("last entry not the count") << FANOUT_SIZE - 1 << Q_UINT64_C(4);
+    QTest::newRow("decreasing") << 100 << Q_UINT64_C(2);
+}
+
+/**
+ * @brief Tests that a corpus with a damaged fanout table is rejected.
+ */
+void TestBreachCorpus::testDamagedFanout() const
+{
+    QFETCH(int, index);
+    QFETCH(quint64, value);
+
+    const QString fileName = m_directory + "/damaged.bloom";
+    QVERIFY(buildCorpus(fileName));
+    QVERIFY(patchFanout(fileName, index, value));
+
+    bool rejected = false;
+    try {
+        BreachCorpus corpus(fileName);
+    } catch (const PasswordCheckException&) {
+        rejected = true;
+    }
+    QVERIFY(rejected);
+}
+
+/**
+ * @brief Tests that the builder fails if the hash file cannot be created.
+ */
+void TestBreachCorpus::testOpenError() const
+{
+    QByteArray dump(DUMP);
+    QBuffer input(&dump);
+    input.open(QIODevice::ReadOnly);
+
+    BreachCorpusBuilder builder(m_directory + "/missing/corpus.bloom");
+    QVERIFY(!builder.build(input));
+    QVERIFY(!builder.errorString().isEmpty());
+}
+
+/**
+ * @brief Tests that the builder fails if writing the hash file fails.
+ *
+ * The hash file is a link to <tt>/dev/full</tt>, where every write fails.
+ */
+void TestBreachCorpus::testWriteError() const
+{
+    if (!QFile::exists("/dev/full"))
+        QSKIP("/dev/full is not available", SkipSingle);
+
+    const QString fileName = m_directory + "/full.bloom";
+    QVERIFY(QFile::link("/dev/full", BreachCorpus::hashFileName(fileName)));
+
+    QByteArray dump(DUMP);
+    QBuffer input(&dump);
+    input.open(QIODevice::ReadOnly);
+
+    BreachCorpusBuilder builder(fileName);
+    QVERIFY(!builder.build(input));
+    QVERIFY(builder.errorString().startsWith(BreachCorpus::hashFileName(fileName)));
+}
+
+QTEST_MAIN(TestBreachCorpus)
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
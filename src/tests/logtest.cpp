@@ -65,6 +65,34 @@ int main(int argc, char *argv[])
     qpCritical(DEFAULT_COMPONENT) << "Fatal";
     qpCritical("Component") << "Fatal";
 
+    std::cerr << "Console, asynchronous" << std::endl;
+
+    qpDebug->setFilterComponents(QStringList());
+    qpDebug->setAsynchronous(true);
+    for (int i = 0; i < 5000; ++i)
+        qpDebug("Component") << "Message" << i;
+    qpCritical(DEFAULT_COMPONENT) << "Fatal";
+    qpDebug->setAsynchronous(false);
+
+    std::cerr << "File 'bla.qplog', binary" << std::endl;
+
+    qpDebug->redirectBinaryFile("bla.qplog");
+    qpDebug("Component") << "Bla";
+    qpDebug->log(QtDebugMsg, "Component", "Message %1 of %2", 1, 2);
+    qpDebug->log(QtWarningMsg, DEFAULT_COMPONENT, "%1 took %2 ms", "Warning", 1.5);
+    qpDebug->log(QtCriticalMsg, "Component", "Fatal %1", QString("Fatal"));
+    qpDebug->redirectConsole();
+
+    BinaryLogReader reader("bla.qplog");
+    if (!reader.open()) {
+        std::cerr << reader.errorString().toLocal8Bit().data() << std::endl;
+        return EXIT_FAILURE;
+    }
+    QString line;
+    while (reader.readRecord(line))
+        std::cerr << line.toLocal8Bit().data() << std::endl;
+    qpDebug->log(QtDebugMsg, "Component", "Message %1 of %2", 2, 2);
+
     return EXIT_SUCCESS;
 }
 
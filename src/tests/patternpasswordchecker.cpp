@@ -0,0 +1,95 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#include <QObject>
+#include <QTemporaryFile>
+#include <QtTest/QtTest>
+
+#include <security/patternpasswordchecker.h>
+#include <tests/patternpasswordchecker.h>
+
+/**
+ * @class TestPatternPasswordChecker
+ *
+ * @brief Tests for the PatternPasswordChecker class
+ *
+ * @ingroup unittest
+ * @author Bernhard Walle
+ */
+
+/**
+ * @brief Writes a small dictionary.
+ */
+void TestPatternPasswordChecker::initTestCase()
+{
+    QVERIFY(m_dictionary.open());
+    m_dictionary.write("cat\napple\nzebra\n");
+    QVERIFY(m_dictionary.flush());
+}
+
+/**
+ * @brief Tests the rank of common passwords and dictionary words.
+ *
+ * One match for the whole password needs its guesses plus one.
+ */
+void TestPatternPasswordChecker::testRank() const
+{
+    PatternPasswordChecker checker(m_dictionary.fileName());
+
+    // "password" is the second of the common passwords, reversed it's twice as much
+    QCOMPARE(checker.guesses("password"), 3.0);
+    QCOMPARE(checker.guesses("drowssap"), 5.0);
+
+    // the dictionary is ranked after the common passwords, case adds variations
+    const double zebra = checker.guesses("zebra");
+    QVERIFY(zebra > checker.guesses("password"));
+    QCOMPARE(checker.guesses("Zebra") - 1, 2 * (zebra - 1));
+
+    // a second instance shares the table
+    PatternPasswordChecker other(m_dictionary.fileName());
+    QCOMPARE(other.guesses("zebra"), zebra);
+}
+
+/**
+ * @brief Tests the guesses of sequences.
+ */
+void TestPatternPasswordChecker::testSequence() const
+{
+    PatternPasswordChecker checker(m_dictionary.fileName());
+
+    // starting at 'a': 4 per character
+    QCOMPARE(checker.guesses("abcdefgh"), 33.0);
+
+    // other start, descending counts twice
+    QCOMPARE(checker.guesses("hgfedcba"), 417.0);
+}
+
+/**
+ * @brief Tests the l33t substitutions.
+ */
+void TestPatternPasswordChecker::testL33t() const
+{
+    PatternPasswordChecker checker(m_dictionary.fileName());
+
+    // each substitution without unsubstituted letters doubles the guesses
+    QCOMPARE(checker.guesses("p4ssw0rd"), 9.0);
+    QCOMPARE(checker.guesses("p4ssword"), 5.0);
+
+    // an l33t character is only a substitution in a word
+    QVERIFY(checker.guesses("4pple") < checker.guesses("4xyzq"));
+}
+
+QTEST_MAIN(TestPatternPasswordChecker)
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
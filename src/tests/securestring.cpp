@@ -16,6 +16,7 @@
 #include <QtTest/QtTest>
 
 #include <util/securestring.h>
+#include <util/securearena.h>
 #include <tests/securestring.h>
 
 /**
@@ -123,6 +124,84 @@ void TestSecureString::testSize() const
     QVERIFY(s.size() == 5);
 }
 
+/**
+ * @brief Checks that the SecureArena reuses and zeroes released blocks.
+ */
+void TestSecureString::testArenaReuse() const
+{
+    const char *first;
+    {
+        SecureString s("secret");
+        first = s.utf8();
+    }
+
+    // the block is on top of the free list of its size class now
+    SecureString t("bla");
+    QVERIFY(t.utf8() == first);
+    QVERIFY(strcmp(t.utf8(), "bla") == 0);
+
+    // the rest of the old password must be gone
+    QVERIFY(first[4] == '\0');
+    QVERIFY(first[5] == '\0');
+
+    // many small strings must not need many chunks
+    size_t chunks = SecureArena::instance()->chunkCount();
+    for (int i = 0; i < 1000; i++) {
+        SecureString tmp("password");
+    }
+    QVERIFY(SecureArena::instance()->chunkCount() == chunks);
+}
+
+/**
+ * @brief Checks that an empty SecureString behaves like an empty string.
+ */
+void TestSecureString::testEmpty() const
+{
+    SecureString a;
+    SecureString b("");
+
+    QVERIFY(a == b);
+    QVERIFY(a.size() == 0);
+    QVERIFY(a.length() == 0);
+    QVERIFY(a.qString().isEmpty());
+}
+
+/**
+ * @brief Tests compare() and the relational operators.
+ */
+void TestSecureString::testCompare() const
+{
+    SecureString a("abc");
+    SecureString b("abcd");
+    SecureString c("abd");
+
+    QVERIFY(a.compare(a) == 0);
+    QVERIFY(a.compare(b) < 0);
+    QVERIFY(b.compare(a) > 0);
+    QVERIFY(b.compare(c) < 0);
+    QVERIFY(a < b);
+    QVERIFY(c >= b);
+    QVERIFY(a <= a);
+}
+
+/**
+ * @brief Tests that swap() exchanges contents and the cached lengths.
+ */
+void TestSecureString::testSwap() const
+{
+    SecureString a("\124\303\244\163\164"); // "Täst" in UTF-8
+    SecureString b("bla");
+    const char *aText = a.utf8();
+
+    a.swap(b);
+
+    QVERIFY(b.utf8() == aText);
+    QVERIFY(b.length() == 4);
+    QVERIFY(b.size() == 5);
+    QVERIFY(a == "bla");
+    QVERIFY(a.length() == 3);
+}
+
 QTEST_MAIN(TestSecureString)
 
 // vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
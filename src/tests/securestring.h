@@ -29,6 +29,10 @@ class TestSecureString : public QObject
         void testCopyCtor() const;
         void testLocking() const;
         void testSize() const;
+        void testArenaReuse() const;
+        void testEmpty() const;
+        void testCompare() const;
+        void testSwap() const;
 };
 
 // vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
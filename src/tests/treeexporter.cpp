@@ -0,0 +1,143 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#include <QObject>
+#include <QBuffer>
+#include <QtTest/QtTest>
+
+#include <treeexporter.h>
+#include <tests/treeexporter.h>
+
+/**
+ * @brief The number of entries of a large tree, more than the export renders at once
+ */
+static const int LARGE_TREE_SIZE = 50000;
+
+/**
+ * @class TestTreeExporter
+ *
+ * @brief Tests for the TreeExporter class
+ *
+ * @ingroup unittest
+ * @author Bernhard Walle
+ */
+
+/**
+ * @brief Creates @p count entries with two properties each.
+ *
+ * @param count the number of entries
+ * @return the entries, named <tt>entry0</tt>, <tt>entry1</tt> and so on
+ */
+static QVector<TreeSnapshot::Entry> createEntries(int count)
+{
+    QVector<TreeSnapshot::Entry> entries(count);
+
+    for (int i = 0; i < count; ++i) {
+        TreeSnapshot::Entry& entry = entries[i];
+        entry.category = QString("category%1").arg(i / 100);
+        entry.name = QString("entry%1").arg(i);
+
+        TreeSnapshot::PropertyData username;
+        username.key = "Username";
+        username.value = PropertyValue(QString("user%1").arg(i));
+        username.type = Property::USERNAME;
+        username.hidden = false;
+        username.encrypted = false;
+        entry.properties.append(username);
+
+        TreeSnapshot::PropertyData password;
+        password.key = "Password";
+        password.value = PropertyValue(QString("secret%1").arg(i), true);
+        password.type = Property::PASSWORD;
+        password.hidden = true;
+        password.encrypted = true;
+        entry.properties.append(password);
+    }
+
+    return entries;
+}
+
+/**
+ * @brief Exports @p entries into a buffer.
+ *
+ * @param entries the entries
+ * @param format the format
+ * @return the exported bytes
+ */
+static QByteArray exportEntries(const QVector<TreeSnapshot::Entry>& entries,
+                                TreeExporter::Format format)
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    TreeExporter(entries, format).write(&buffer);
+    return buffer.data();
+}
+
+/**
+ * @brief Tests the export of an empty tree.
+ */
+void TestTreeExporter::testEmpty() const
+{
+    const QVector<TreeSnapshot::Entry> entries;
+
+    QCOMPARE(exportEntries(entries, TreeExporter::Csv),
+        QByteArray("Category,Entry,Key,Value,Type\r\n"));
+    QCOMPARE(exportEntries(entries, TreeExporter::Json), QByteArray("[\n]\n"));
+}
+
+/**
+ * @brief Tests that all rows of a large tree are written in the order of the tree.
+ */
+void TestTreeExporter::testCsvOrder() const
+{
+    const QByteArray output = exportEntries(createEntries(LARGE_TREE_SIZE), TreeExporter::Csv);
+    const QList<QByteArray> rows = output.split('\n');
+
+    // header, two rows per entry and the empty string after the last line break
+    QCOMPARE(rows.size(), 2 + 2*LARGE_TREE_SIZE);
+    QCOMPARE(rows.first(), QByteArray("Category,Entry,Key,Value,Type\r"));
+    QVERIFY(rows.last().isEmpty());
+
+    for (int i = 0; i < LARGE_TREE_SIZE; ++i) {
+        const QByteArray prefix = QString("category%1,entry%2,").arg(i / 100).arg(i).toUtf8();
+        QCOMPARE(rows[1 + 2*i], prefix + QString("Username,user%1,USERNAME\r").arg(i).toUtf8());
+        QCOMPARE(rows[2 + 2*i], prefix + QString("Password,secret%1,PASSWORD\r").arg(i).toUtf8());
+    }
+}
+
+/**
+ * @brief Tests that the JSON export of a large tree is one array in the order of the tree.
+ */
+void TestTreeExporter::testJsonOrder() const
+{
+    const QByteArray output = exportEntries(createEntries(LARGE_TREE_SIZE), TreeExporter::Json);
+
+    QVERIFY(output.startsWith("[\n"));
+    QVERIFY(output.endsWith("\n]\n"));
+
+    int position = 0;
+    for (int i = 0; i < LARGE_TREE_SIZE; ++i) {
+        const QByteArray name = QString("\"name\": \"entry%1\"").arg(i).toUtf8();
+        const int found = output.indexOf(name, position);
+        QVERIFY(found > position);
+        position = found + name.size();
+    }
+
+    // the separator is only written between two objects
+    QCOMPARE(output.count("]},\n  {"), LARGE_TREE_SIZE - 1);
+}
+
+QTEST_MAIN(TestTreeExporter)
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
@@ -40,10 +40,13 @@
 #include "qpamat.h"
 #include "tree.h"
 #include "treeentry.h"
+#include "treeentrydrag.h"
+#include "undocommands.h"
 #include "security/passwordhash.h"
 #include "security/encryptor.h"
 #include "security/symmetricencryptor.h"
 #include "dialogs/waitdialog.h"
+#include "util/trace.h"
 #include "settings.h"
 
 
@@ -151,13 +154,39 @@ void Tree::keyPressEvent(QKeyEvent* evt)
 }
 
 
+/**
+ * @brief Replaces the secret values of all entries by their ciphertext.
+ *
+ * See Property::encryptValue(). The structure of the tree is kept.
+ *
+ * @param key the key that is used for encryption
+ */
+void Tree::encryptSecrets(const QSharedPointer<VaultKey>& key)
+{
+    for (Q3ListViewItemIterator it(this); it.current(); ++it) {
+        TreeEntry* entry = dynamic_cast<TreeEntry*>(it.current());
+        TreeEntry::PropertyIterator properties = entry->propertyIterator();
+        Property* property;
+        while ( (property = properties.current()) != 0 ) {
+            ++properties;
+            property->encryptValue(key);
+        }
+    }
+}
+
+
 /**
  * @brief Reads and updates the tree from the given XML file.
  *
  * @param rootElement the XML element which represents the <tt>\<qpamat\></tt> tag
+ * @param vaultKey if not null, the passwords in @p rootElement are still encrypted with this
+ *        key and are decrypted on demand, see DataReadWriter::readXML()
  */
-void Tree::readFromXML(const QDomElement& rootElement)
+void Tree::readFromXML(const QDomElement& rootElement, const QSharedPointer<VaultKey>& vaultKey)
 {
+    TraceSpan span("tree build", "Tree");
+    ChangeBatch batch;
+
     // delete the old tree
     if (childCount() > 0)
         clear();
@@ -166,7 +195,7 @@ void Tree::readFromXML(const QDomElement& rootElement)
     while (!n.isNull()) {
         QDomElement e = n.toElement(); // try to convert the node to an element.
         if (!e.isNull())
-            TreeEntry::appendFromXML(this, e);
+            TreeEntry::appendFromXML(this, e, vaultKey);
         n = n.nextSibling();
     }
 
@@ -181,9 +210,10 @@ void Tree::readFromXML(const QDomElement& rootElement)
  *
  * @param doc the QDomDocument to which the tree is appended. If the tree is empty,
  *            nothing is appended
+ * @param encryptor the encryptor for passwords or @c NULL, see Property::appendXML()
  * @exception std::invalid_argument if the given document does not met the described requirements
 */
-void Tree::appendXML(QDomDocument& doc) const
+void Tree::appendXML(QDomDocument& doc, StringEncryptor* encryptor) const
 {
     QDomElement docElem = doc.documentElement();
     QDomNode passwords = docElem.namedItem("passwords");
@@ -195,7 +225,7 @@ void Tree::appendXML(QDomDocument& doc) const
     // XML so we have to find the children of the child
     TreeEntry* currentItem = dynamic_cast<TreeEntry*>(firstChild());
     while (currentItem) {
-        currentItem->appendXML(doc, passwords);
+        currentItem->appendXML(doc, passwords, encryptor);
         currentItem = dynamic_cast<TreeEntry*>(currentItem->nextSibling());
     }
 }
@@ -211,10 +241,7 @@ Q3DragObject* Tree::dragObject()
     Q3ListViewItem* current = currentItem();
     emit stateModified();
     if (current) {
-        QString xml = dynamic_cast<TreeEntry*>(current)->toXML();
-        Q3StoredDrag* drag = new Q3StoredDrag("application/x-qpamat", this);
-        drag->setEncodedData(xml.utf8());
-        return drag;
+        return new TreeEntryDrag(dynamic_cast<TreeEntry*>(current), this);
     }
     return 0;
 }
@@ -305,6 +332,8 @@ void Tree::insertItem(TreeEntry* item, bool category)
             newItem = new TreeEntry( item, name, category);
     } else
         newItem = new TreeEntry( this, name, category);
+    Qpamat::instance()->getWindow()->undoStack().push(
+        new InsertEntryCommand(dynamic_cast<TreeEntry*>(newItem)));
     setSelected(newItem, true);
     newItem->startRename(0);
     emit stateModified();
@@ -339,7 +368,9 @@ void Tree::deleteCurrent()
                 }
             } while ( (p = p->parent()) );
 
-            delete selected;
+            // the command keeps the item, so the deletion can be undone
+            Qpamat::instance()->getWindow()->undoStack().push(
+                new RemoveEntryCommand(dynamic_cast<TreeEntry*>(selected)));
 
             if (below) {
                 qDebug() << CURRENT_FUNCTION << "setSelected:" << below->text(0);
@@ -364,53 +395,6 @@ void Tree::insertAtCurrentPos()
 }
 
 
-/**
- * @brief Converts the tree to Rich text (HTML).
- *
- * This function is for printing.
- * @return the text
- */
-QString Tree::toRichTextForPrint()
-{
-    Q3ListViewItemIterator it(this);
-    Q3ListViewItem* current;
-    QString ret;
-    ret += "<qt>";
-    while ( (current = it.current()) ) {
-        ret += dynamic_cast<TreeEntry*>(current)->toRichTextForPrint();
-        ++it;
-    }
-    ret += "</qt>";
-    return ret;
-}
-
-
-/**
- * @brief Appends the tree as text representation to the given stream.
- *
- * The text is formatted for export.
- *
- * @param stream the stream where the text is appended
- */
-void Tree::appendTextForExport(QTextStream& stream)
-{
-    Q3ListViewItemIterator it(this);
-    Q3ListViewItem* current;
-
-    stream.setf(QTextStream::left);
-    stream << qSetFieldWidth(20) << tr("QPaMaT") << qSetFieldWidth(0)
-           << tr("password managing tool for Unix, Windows and MacOS X")  << "\n";
-    stream << qSetFieldWidth(20) << tr("Export date:") << qSetFieldWidth(0)
-           << QDateTime::currentDateTime().date().toString(Qt::ISODate) << "\n";
-    stream << "================================================================================\n";
-
-    while ( (current = it.current()) ) {
-        dynamic_cast<TreeEntry*>(current)->appendTextForExport(stream);
-        ++it;
-    }
-}
-
-
 /**
  * @brief Performs a search operation.
  *
@@ -479,18 +463,83 @@ void Tree::currentChangedHandler(Q3ListViewItem*)
  */
 void Tree::droppedHandler(QDropEvent* evt)
 {
-    if (evt->provides("application/x-qpamat")) {
-        evt->accept();
-        QString xml = QString::fromUtf8(evt->encodedData("application/x-qpamat"));
+    dropEntry(evt, 0);
+}
+
+
+/**
+ * @brief Handles a drop of a TreeEntryDrag.
+ *
+ * If the drag comes from this process, the dragged item is moved. Otherwise, a copy is
+ * created from the XML data.
+ *
+ * @param evt the event
+ * @param target the item on which the drop happened or @c NULL for the white space
+ */
+void Tree::dropEntry(QDropEvent* evt, TreeEntry* target)
+{
+    if (!TreeEntryDrag::canDecode(evt))
+        return;
+
+    ChangeBatch batch;
+    evt->accept();
+
+    TreeEntry* category = target;
+    if (target && !target->isCategory())
+        category = dynamic_cast<TreeEntry*>(target->Q3ListViewItem::parent());
+
+    TreeEntry* appended = 0;
+    TreeEntry* src = TreeEntryDrag::decodeLocal(evt);
+    if (src) {
+        if (src == target || (category && (src == category || src->isAncestorOf(category)))) {
+            Qpamat::instance()->getWindow()->message(tr("Cannot drag to itself."));
+            return;
+        }
+        Qpamat::instance()->getWindow()->undoStack().push(new MoveEntryCommand(src, category));
+        appended = src;
+    } else {
         QDomDocument doc;
-        doc.setContent(xml);
+        if (!TreeEntryDrag::decodeXML(evt, doc))
+            return;
+
         QDomElement elem = doc.documentElement();
-        Q3ListViewItem* src = reinterpret_cast<TreeEntry*>(elem.attribute("memoryAddress").toLong());
-        Q3ListViewItem* appended = TreeEntry::appendFromXML(this, elem);
-        setSelected(appended, true);
-        delete src;
-        updatePasswordStrengthView();
+        if (category)
+            appended = TreeEntry::appendFromXML(category, elem);
+        else
+            appended = TreeEntry::appendFromXML(this, elem);
+        Qpamat::instance()->getWindow()->undoStack().push(new InsertEntryCommand(appended));
     }
+
+    if (target && !target->isOpen())
+        target->setOpen(true);
+
+    setSelected(appended, true);
+    updatePasswordStrengthView();
+}
+
+
+/**
+ * @brief Returns the configuration that is used for the password strength.
+ *
+ * @return the configuration
+ */
+const VaultConfig& Tree::getVaultConfig() const
+{
+    return m_vaultConfig;
+}
+
+
+/**
+ * @brief Sets the configuration that is used for the password strength.
+ *
+ * Call recomputePasswordStrength() afterwards if the dictionary or the limits have been
+ * changed.
+ *
+ * @param config the configuration
+ */
+void Tree::setVaultConfig(const VaultConfig& config)
+{
+    m_vaultConfig = config;
 }
 
 
@@ -513,6 +562,7 @@ void Tree::recomputePasswordStrength(bool* error)
         *error = true;
     }
 
+    TraceSpan span("strength recompute", "Security");
     QApplication::setOverrideCursor( QCursor(Qt::WaitCursor) );
     int num = 0;
 
@@ -543,7 +593,7 @@ void Tree::recomputePasswordStrength(bool* error)
             TreeEntry::PropertyIterator propIt = current->propertyIterator();
             while (propIt.current()) {
                 if (propIt.current()->getType() == Property::PASSWORD) {
-                    propIt.current()->updatePasswordStrength();
+                    propIt.current()->updatePasswordStrength(m_vaultConfig);
                     progress.setProgress(progr++);
                     qDebug() << CURRENT_FUNCTION << "progr =" << progr;
                     qApp->processEvents();
@@ -592,7 +642,7 @@ void Tree::updatePasswordStrengthView()
             Q3ListViewItemIterator it(this);
             while (it.current()) {
                 Property::PasswordStrength strength =
-                    dynamic_cast<TreeEntry*>(it.current())->weakestChildrenPassword();
+                    dynamic_cast<TreeEntry*>(it.current())->weakestChildrenPassword(m_vaultConfig);
 
                 switch (strength) {
                     case Property::PWeak:
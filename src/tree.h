@@ -27,6 +27,7 @@
 
 #include "treeentry.h"
 #include "security/encryptor.h"
+#include "vaultconfig.h"
 
 class Tree : public Q3ListView
 {
@@ -43,11 +44,15 @@ class Tree : public Q3ListView
     public:
         Tree(QWidget* parent);
 
-        void readFromXML(const QDomElement& document);
-        void appendXML(QDomDocument& doc) const;
+        void encryptSecrets(const QSharedPointer<VaultKey>& key);
+        void readFromXML(const QDomElement& document,
+            const QSharedPointer<VaultKey>& vaultKey = QSharedPointer<VaultKey>());
+        void appendXML(QDomDocument& doc, StringEncryptor* encryptor = 0) const;
 
-        QString toRichTextForPrint();
-        void appendTextForExport(QTextStream& stream);
+        void dropEntry(QDropEvent* evt, TreeEntry* target);
+
+        const VaultConfig& getVaultConfig() const;
+        void setVaultConfig(const VaultConfig& config);
 
     public slots:
         void searchFor(const QString& word);
@@ -78,6 +83,7 @@ class Tree : public Q3ListView
     private:
         Q3PopupMenu*  m_contextMenu;
         bool         m_showPasswordStrength;
+        VaultConfig  m_vaultConfig;
 };
 
 
@@ -23,6 +23,8 @@
 #include "treeentry.h"
 #include "settings.h"
 #include "tree.h"
+#include "treeentrydrag.h"
+#include "undocommands.h"
 
 
 /**
@@ -40,10 +42,17 @@
  * The iterator for the proeprties
  */
 
+/**
+ * @enum TreeEntry::Change
+ *
+ * @brief Bits that tell what has changed, see BatchedNotifier.
+ */
+
 /**
  * @fn TreeEntry::propertyAppended()
  *
- * Fired is a property was added.
+ * Fired is a property was added. Inside a ChangeBatch, it's fired once for all properties
+ * that have been appended in the batch.
  */
 
 /**
@@ -52,18 +61,19 @@
  * All password strength should be computed because of speed issues (in other
  * words, no wait cursor or something else is displayed in this function).
  *
+ * @param config the configuration that is used if recomputing is necessary
  * @return the password strength, Property::PUndefined should be never returned
  * @exception PasswordCheckException if recomputing is necessary and the PasswordChecker
  *            threw a PasswordCheckException
  */
-Property::PasswordStrength TreeEntry::weakestChildrenPassword() const
+Property::PasswordStrength TreeEntry::weakestChildrenPassword(const VaultConfig& config) const
 {
     Property::PasswordStrength lowest = Property::PUndefined;
 
     if (m_isCategory) {
         TreeEntry* item = dynamic_cast<TreeEntry*>(firstChild());
         while (item) {
-            Property::PasswordStrength strength = item->weakestChildrenPassword();
+            Property::PasswordStrength strength = item->weakestChildrenPassword(config);
             if (strength < lowest) {
                 lowest = strength;
                 if (lowest == Property::PWeak)
@@ -77,7 +87,7 @@ Property::PasswordStrength TreeEntry::weakestChildrenPassword() const
         while ( (current = it.current()) != 0 ) {
             ++it;
             if (current->getType() == Property::PASSWORD) {
-                Property::PasswordStrength strength = current->getPasswordStrength();
+                Property::PasswordStrength strength = current->getPasswordStrength(config);
                 if (strength < lowest) {
                     lowest = strength;
                     if (lowest == Property::PWeak)
@@ -91,6 +101,9 @@ Property::PasswordStrength TreeEntry::weakestChildrenPassword() const
 }
 
 
+quint64 TreeEntry::s_generation = 0;
+
+
 /**
  * @brief Returns the name of the entry.
  */
@@ -100,6 +113,54 @@ QString TreeEntry::getName() const
 }
 
 
+/**
+ * @brief Returns the unique ID of the entry.
+ *
+ * The ID is stored in the XML file and identifies the entry in the Journal.
+ *
+ * @return the ID
+ */
+QString TreeEntry::getId() const
+{
+    return m_id;
+}
+
+
+/**
+ * @brief Returns the generation of the last modification.
+ *
+ * Each modification of the entry or one of its properties sets the generation to a new
+ * value of a global counter. Compare it with lastGeneration() to find out what has changed
+ * since a given point of time.
+ *
+ * @return the generation
+ */
+quint64 TreeEntry::getGeneration() const
+{
+    return m_generation;
+}
+
+
+/**
+ * @brief Returns the generation of the newest modification of any entry.
+ *
+ * @return the generation
+ */
+quint64 TreeEntry::lastGeneration()
+{
+    return s_generation;
+}
+
+
+/**
+ * @brief Marks the entry as modified.
+ */
+void TreeEntry::touch()
+{
+    m_generation = ++s_generation;
+}
+
+
 /**
  * @brief  Returns whether the entry is a categroy.
  */
@@ -139,7 +200,8 @@ QString TreeEntry::text(int column) const
 /**
  * @brief Sets the text of the entry.
  *
- * Sets the name internally.
+ * Sets the name internally. This is called when the user has renamed the item, so the
+ * change can be undone.
  *
  * @param column the column
  * @param text the new text
@@ -149,9 +211,27 @@ void TreeEntry::setText(int column, const QString& text)
     UNUSED(column);
     Q_ASSERT(column == 0);
 
-    m_name = text;
-    listView()->sort();
-    listView()->triggerUpdate();
+    if (text == m_name)
+        return;
+
+    Qpamat::instance()->getWindow()->undoStack().push(
+        new RenameEntryCommand(this, m_name, text));
+}
+
+
+/**
+ * @brief Sets the name without recording an undo step.
+ *
+ * @param name the new name
+ */
+void TreeEntry::setName(const QString& name)
+{
+    m_name = name;
+    touch();
+    if (listView()) {
+        listView()->sort();
+        listView()->triggerUpdate();
+    }
 }
 
 
@@ -169,6 +249,7 @@ void TreeEntry::movePropertyOneUp(unsigned int index)
     m_properties.insert(index, h);
     m_properties.remove(index+2);
     m_properties.setAutoDelete(true);
+    touch();
 }
 
 
@@ -186,6 +267,7 @@ void TreeEntry::movePropertyOneDown(unsigned int index)
     m_properties.insert(index-1, h);
     m_properties.remove(index+1);
     m_properties.setAutoDelete(true);
+    touch();
 }
 
 
@@ -198,6 +280,7 @@ void TreeEntry::deleteProperty(unsigned int index)
 {
     Q_ASSERT( index < m_properties.count() );
     m_properties.remove(index);
+    touch();
 }
 
 
@@ -207,6 +290,7 @@ void TreeEntry::deleteProperty(unsigned int index)
 void TreeEntry::deleteAllProperties()
 {
     m_properties.clear();
+    touch();
 }
 
 
@@ -218,144 +302,151 @@ void TreeEntry::deleteAllProperties()
 void TreeEntry::appendProperty(Property* property)
 {
     m_properties.append(property);
-    emit propertyAppended();
+    property->m_entry = this;
+    connect(property, SIGNAL(propertyChanged(Property*)), SLOT(touch()));
+    touch();
+    notifyChanged(PropertiesAppended);
 }
 
 
 /**
- * @brief Returns an iterator for the list
+ * @brief Inserts a property at the given position.
+ *
+ * @param index the index, must not be greater than the number of properties
+ * @param property the property, the entry takes the ownership
  */
-TreeEntry::PropertyIterator TreeEntry::propertyIterator() const
+void TreeEntry::insertProperty(unsigned int index, Property* property)
 {
-    return PropertyIterator(m_properties);
+    Q_ASSERT(index <= m_properties.count());
+
+    m_properties.insert(index, property);
+    property->m_entry = this;
+    connect(property, SIGNAL(propertyChanged(Property*)), SLOT(touch()));
+    touch();
+    if (index == m_properties.count() - 1)
+        notifyChanged(PropertiesAppended);
 }
 
 
 /**
- * @brief Returns the full name including the category.
- *
- * This is required for the printout and for the label on the top.
+ * @brief Removes the property with the specified index without deleting it.
  *
- * @return the full name with category
+ * @param index the index
+ * @return the property, the caller takes the ownership
  */
-QString TreeEntry::getFullName() const
+Property* TreeEntry::takeProperty(unsigned int index)
 {
-    QString catString;
-    const Q3ListViewItem* item = this;
-    while ((item = item->parent()))
-        catString = catString.prepend(dynamic_cast<const TreeEntry*>(item)->getName() + ": ");
-    return catString + m_name;
+    Q_ASSERT(index < m_properties.count());
+
+    Property* property = m_properties.take(index);
+    disconnect(property, 0, this, 0);
+    property->m_entry = 0;
+    touch();
+    return property;
 }
 
+
 /**
- * @brief This function converts a tree entry to HTML for printing.
+ * @brief Emits the signals for the changes.
  *
- * A TreeEntry represents one big table.
- *
- * @return the RichText
+ * @param changes the combined TreeEntry::Change bits
  */
-QString TreeEntry::toRichTextForPrint() const
+void TreeEntry::flushChanges(int changes)
 {
-    if (m_isCategory)
-        return QString("");
-
-    QString catString;
-
-
-    QString ret;
-    ret += QString("<table width=\"100%\"><tr><td bgcolor=grey cellpadding=\"3\">"
-            "&nbsp;<b>%1</b></td></tr><tr><td>"
-            "<table border=\"0\">").arg(getFullName());
+    if (changes & PropertiesAppended)
+        emit propertyAppended();
+}
 
-    PropertyIterator it = propertyIterator();
-    Property* current;
-    while ( (current = it.current()) != 0 ) {
-        ++it;
-        ret += current->toRichTextForPrint();
-    }
 
-    ret += "</table></td></tr></table<p>&nbsp;<p>";
-    return ret;
+/**
+ * @brief Returns an iterator for the list
+ */
+TreeEntry::PropertyIterator TreeEntry::propertyIterator() const
+{
+    return PropertyIterator(m_properties);
 }
 
 
 /**
- * @brief Appends the tree entry as text representation to the given stream.
+ * @brief Returns the full name including the category.
  *
- * The text is formatted for export.
+ * This is required for the printout and for the label on the top.
  *
- * @param stream the stream where the text is appended
+ * @return the full name with category
  */
-void TreeEntry::appendTextForExport(QTextStream& stream)
+QString TreeEntry::getFullName() const
 {
-    if (m_isCategory) {
-        return;
-    }
-
     QString catString;
     const Q3ListViewItem* item = this;
-    while ((item = item->parent())) {
+    while ((item = item->parent()))
         catString = catString.prepend(dynamic_cast<const TreeEntry*>(item)->getName() + ": ");
-    }
-
-    stream << "--------------------------------------------------------------------------------\n";
-    stream << catString + m_name << "\n";
-    stream << "--------------------------------------------------------------------------------\n";
-    stream << "\n";
-
-    PropertyIterator it = propertyIterator();
-    Property* current;
-    while ((current = it.current()) != 0) {
-        ++it;
-        current->appendTextForExport(stream);
-    }
-
-    stream << "\n\n";
+    return catString + m_name;
 }
 
-
 /**
  * @brief Appends the treeentry as \c category or \c entry tag in the XML structure.
  *
  * @param document the document needed to create new elements
  * @param parent the parent to which the new created element should be attached
+ * @param encryptor the encryptor for passwords or @c NULL, see Property::appendXML()
+ * @param recursive @c true if the children of a category should be appended, too
  */
-void TreeEntry::appendXML(QDomDocument& document, QDomNode& parent) const
+void TreeEntry::appendXML(QDomDocument& document, QDomNode& parent,
+                          StringEncryptor* encryptor, bool recursive) const
 {
-    QDomElement newElement;
+    QDomElement newElement = createXMLElement(document, m_isCategory, m_name, m_id, isOpen(),
+        isSelected());
     if (m_isCategory) {
-        newElement = document.createElement("category");
-        newElement.setAttribute("wasOpen", isOpen());
-        TreeEntry* child = dynamic_cast<TreeEntry*>(firstChild());
+        TreeEntry* child = recursive ? dynamic_cast<TreeEntry*>(firstChild()) : 0;
 
         while(child) {
-            child->appendXML(document, newElement);
+            child->appendXML(document, newElement, encryptor);
             child = dynamic_cast<TreeEntry*>(child->nextSibling());
         }
     } else {
-        newElement = document.createElement("entry");
-
         PropertyIterator it(m_properties);
         Property* property;
         while ( (property = it.current()) != 0 ) {
             ++it;
-            property->appendXML(document, newElement);
+            property->appendXML(document, newElement, encryptor);
         }
     }
-    newElement.setAttribute("name", m_name);
-    newElement.setAttribute("isSelected", isSelected());
     parent.appendChild(newElement);
 }
 
 
+/**
+ * @brief Creates the \c category or \c entry tag without children.
+ *
+ * This is shared by appendXML() and TreeSnapshot, so both write the same attributes.
+ *
+ * @param document the document needed to create new elements
+ * @param isCategory @c true for a \c category tag, @c false for an \c entry tag
+ * @param name the name of the entry
+ * @param id the ID of the entry
+ * @param wasOpen whether the category is open, ignored for entries
+ * @param isSelected whether the entry is selected
+ * @return the element, not appended to any parent yet
+ */
+QDomElement TreeEntry::createXMLElement(QDomDocument& document, bool isCategory,
+                                        const QString& name, const QString& id, bool wasOpen,
+                                        bool isSelected)
+{
+    QDomElement element = document.createElement(isCategory ? "category" : "entry");
+    if (isCategory)
+        element.setAttribute("wasOpen", wasOpen);
+    element.setAttribute("name", name);
+    element.setAttribute("id", id);
+    element.setAttribute("isSelected", isSelected);
+    return element;
+}
+
+
 /**
  * @brief Converts this TreeEntry to XML.
  *
- * This XML is used for drag and drop. It contains one \<entry\> or
- * \<category\> tag and this tag contains also an attribute named \c
- * memoryAddress which holds the memory address for this item. This can be
- * used for deleting the object or for determine whether the user is dragging
- * to iself.
+ * This XML is used for drag and drop between different processes, see TreeEntryDrag. It
+ * contains one \<entry\> or \<category\> tag.
  *
  * @return the XML string
  */
@@ -363,7 +454,6 @@ QString TreeEntry::toXML() const
 {
     QDomDocument doc;
     appendXML(doc, doc);
-    doc.documentElement().setAttribute(QString("memoryAddress"), (qlonglong)this);
 
     return doc.toString();
 }
@@ -372,7 +462,7 @@ QString TreeEntry::toXML() const
 /**
  * @brief Checks if the item can accept drops of the type QMimeSource.
  *
- * The MIME type accepted is <tt>application/x-qpamat</tt>. Only categories accept drops.
+ * The MIME types of TreeEntryDrag are accepted.
  *
  * @param mime the QMimeSource object
  * @return \c true if the item can accept drops of type QMimeSource mime; otherwise
@@ -380,46 +470,58 @@ QString TreeEntry::toXML() const
  */
 bool TreeEntry::acceptDrop(const QMimeSource* mime) const
 {
-    return mime->provides("application/x-qpamat");
+    return TreeEntryDrag::canDecode(mime);
 }
 
 
 /**
- * @brief Overwritten drop handler
+ * @brief Checks if @p item is somewhere below this item.
  *
- * @param evt the event
+ * @param item the item to check
+ * @return @c true if this item is a (direct or indirect) parent of @p item
  */
-void TreeEntry::dropped(QDropEvent *evt)
+bool TreeEntry::isAncestorOf(const Q3ListViewItem* item) const
 {
-    if (evt->provides("application/x-qpamat")) {
-        evt->accept();
-        QString xml = QString::fromUtf8(evt->encodedData("application/x-qpamat"));
-        QDomDocument doc;
-        doc.setContent(xml);
-        QDomElement elem = doc.documentElement();
-
-        Q3ListViewItem* src = reinterpret_cast<TreeEntry*>(elem.attribute("memoryAddress").toLong());
-
-        QpamatWindow *win = Qpamat::instance()->getWindow();
-        if (src == this) {
-            win->message(tr("Cannot dray to itself."));
-            return;
-        }
+    for (const Q3ListViewItem* it = item ? item->parent() : 0; it; it = it->parent())
+        if (it == this)
+            return true;
 
-        TreeEntry* item = m_isCategory ? this : dynamic_cast<TreeEntry*>(parent());
-        TreeEntry* appended = 0;
-        if (item)
-            appended = appendFromXML(item, elem);
-        else
-            appended = appendFromXML(listView(), elem);
+    return false;
+}
 
-        if (!isOpen())
-            setOpen(true);
 
-        listView()->setSelected(appended, true);
-        dynamic_cast<Tree*>(listView())->updatePasswordStrengthView();
-        delete src;
-    }
+/**
+ * @brief Moves the item (with all children) to another parent in the same tree.
+ *
+ * The items are not recreated, so the properties and everything that's cached in them
+ * survive the move.
+ *
+ * @param newParent the new parent or @c NULL to move the item to the top level
+ */
+void TreeEntry::moveTo(TreeEntry* newParent)
+{
+    Q3ListView* view = listView();
+
+    if (parent())
+        parent()->takeItem(this);
+    else
+        view->takeItem(this);
+
+    if (newParent)
+        newParent->insertItem(this);
+    else
+        view->insertItem(this);
+}
+
+
+/**
+ * @brief Overwritten drop handler
+ *
+ * @param evt the event
+ */
+void TreeEntry::dropped(QDropEvent *evt)
+{
+    dynamic_cast<Tree*>(listView())->dropEntry(evt, this);
 }
 
 // vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
@@ -22,12 +22,13 @@
 #include <QTextStream>
 #include <QDropEvent>
 #include <Q3ValueList>
+#include <QUuid>
 
 #include "property.h"
 
 typedef Q3PtrList<Property> PropertyPtrList;
 
-class TreeEntry : public QObject, public Q3ListViewItem
+class TreeEntry : public QObject, public Q3ListViewItem, public BatchedNotifier
 {
     Q_OBJECT
 
@@ -36,34 +37,49 @@ class TreeEntry : public QObject, public Q3ListViewItem
     public:
         typedef Q3PtrListIterator<Property> PropertyIterator;
 
+        enum Change {
+            PropertiesAppended  = 1 << 0
+        };
+
     public:
         template<class T>
         TreeEntry(T* parent, const QString& name = QString::null, bool isCategory = false);
 
         QString getName() const;
+        void setName(const QString& name);
+        QString getId() const;
+        quint64 getGeneration() const;
         bool isCategory() const;
 
         Property* getProperty(unsigned int index);
         void appendProperty(Property* property);
+        void insertProperty(unsigned int index, Property* property);
+        Property* takeProperty(unsigned int index);
         PropertyIterator propertyIterator() const;
 
-        Property::PasswordStrength weakestChildrenPassword() const;
+        Property::PasswordStrength weakestChildrenPassword(const VaultConfig& config) const;
 
-        void appendXML(QDomDocument& document, QDomNode& parent) const;
+        void appendXML(QDomDocument& document, QDomNode& parent,
+            StringEncryptor* encryptor = 0, bool recursive = true) const;
+        static QDomElement createXMLElement(QDomDocument& document, bool isCategory,
+            const QString& name, const QString& id, bool wasOpen, bool isSelected);
 
         QString text(int column) const;
         void setText(int column, const QString& text);
 
         QString getFullName() const;
-        QString toRichTextForPrint() const;
-        void appendTextForExport(QTextStream& stream);
         QString toXML() const;
 
+        bool isAncestorOf(const Q3ListViewItem* item) const;
+        void moveTo(TreeEntry* newParent);
+
         bool acceptDrop(const QMimeSource* mime) const;
 
     public:
         template<class T>
-        static TreeEntry* appendFromXML(T* parent, QDomElement& element);
+        static TreeEntry* appendFromXML(T* parent, QDomElement& element,
+            const QSharedPointer<VaultKey>& vaultKey = QSharedPointer<VaultKey>());
+        static quint64 lastGeneration();
 
     public slots:
         void movePropertyOneUp(unsigned int index);
@@ -74,14 +90,22 @@ class TreeEntry : public QObject, public Q3ListViewItem
     signals:
         void propertyAppended();
 
+    private slots:
+        void touch();
+
     protected:
         void dropped(QDropEvent *evt);
+        void flushChanges(int changes);
 
     private:
         QString             m_name;
+        QString             m_id;
         PropertyPtrList     m_properties;
         bool                m_isCategory;
         bool                m_weak;
+        quint64             m_generation;
+
+        static quint64      s_generation;
 
     private:
         void init();
@@ -24,8 +24,10 @@ template<class T>
 TreeEntry::TreeEntry(T* parent, const QString& name, bool isCategory)
     : Q3ListViewItem(parent)
     , m_name(name)
+    , m_id(QUuid::createUuid().toString())
     , m_isCategory(isCategory)
     , m_weak(false)
+    , m_generation(++s_generation)
 {
     setRenameEnabled(0, true);
     setDragEnabled(true);
@@ -39,14 +41,21 @@ TreeEntry::TreeEntry(T* parent, const QString& name, bool isCategory)
  *
  * @param parent the parent
  * @param element the \c property or \c element tag
+ * @param vaultKey the key for passwords that are still encrypted, see
+ *        Property::appendFromXML()
  * @return the appended value
  */
 template<class T>
-TreeEntry* TreeEntry::appendFromXML(T* parent, QDomElement& element)
+TreeEntry* TreeEntry::appendFromXML(T* parent, QDomElement& element,
+                                    const QSharedPointer<VaultKey>& vaultKey)
 {
+    ChangeBatch batch;
+
     QString name = element.attribute("name");
     bool isCategory = element.tagName() == "category";
     TreeEntry* returnvalue = new TreeEntry(parent, name, isCategory);
+    if (element.hasAttribute("id"))
+        returnvalue->m_id = element.attribute("id");
     QDomNode node = element.firstChild();
     QDomElement childElement;
 
@@ -55,10 +64,10 @@ TreeEntry* TreeEntry::appendFromXML(T* parent, QDomElement& element)
             childElement = node.toElement();
 
             if (isCategory) {
-                TreeEntry::appendFromXML(returnvalue, childElement);
+                TreeEntry::appendFromXML(returnvalue, childElement, vaultKey);
                 returnvalue->setOpen(element.attribute("wasOpen", "0") == "1");
             } else
-                Property::appendFromXML(returnvalue, childElement);
+                Property::appendFromXML(returnvalue, childElement, vaultKey);
 
             node = node.nextSibling();
         }
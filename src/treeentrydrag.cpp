@@ -0,0 +1,181 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#include <QCoreApplication>
+#include <QString>
+#include <QStringList>
+
+#include "treeentry.h"
+#include "treeentrydrag.h"
+
+#define MIME_INTERNAL   "application/x-qpamat-internal"
+#define MIME_XML        "application/x-qpamat"
+
+/**
+ * @class TreeEntryDrag
+ *
+ * @brief Drag object for TreeEntry objects.
+ *
+ * The drag provides two formats:
+ *
+ *  - <tt>application/x-qpamat-internal</tt> which only identifies the drag by the process ID
+ *    and a serial number. If the drop happens in the same process, decodeLocal() returns the
+ *    dragged item and it can be moved in the tree without any serialisation.
+ *  - <tt>application/x-qpamat</tt> which is the XML representation of the dragged item (see
+ *    TreeEntry::toXML()). It's only built if another process asks for the data.
+ *
+ * @ingroup gui
+ * @author Bernhard Walle
+ */
+
+QPointer<TreeEntry> TreeEntryDrag::s_source;
+uint TreeEntryDrag::s_serial = 0;
+
+
+/**
+ * @brief Creates a new drag object.
+ *
+ * @param entry the entry that is dragged
+ * @param dragSource the widget where the drag started
+ */
+TreeEntryDrag::TreeEntryDrag(TreeEntry* entry, QWidget* dragSource)
+    : Q3DragObject(dragSource)
+    , m_entry(entry)
+    , m_serial(++s_serial)
+{
+    s_source = entry;
+}
+
+
+/**
+ * @brief Deletes the drag object.
+ */
+TreeEntryDrag::~TreeEntryDrag()
+{
+    if (s_serial == m_serial)
+        s_source = 0;
+}
+
+
+/**
+ * @brief Returns the provided MIME types.
+ *
+ * @param i the index
+ * @return the MIME type or @c NULL if @p i is out of range
+ */
+const char* TreeEntryDrag::format(int i) const
+{
+    switch (i) {
+        case 0:
+            return MIME_INTERNAL;
+        case 1:
+            return MIME_XML;
+        default:
+            return 0;
+    }
+}
+
+
+/**
+ * @brief Returns the data for the given MIME type.
+ *
+ * @param mimeType the MIME type
+ * @return the data or an empty byte array if the MIME type is not provided
+ */
+QByteArray TreeEntryDrag::encodedData(const char* mimeType) const
+{
+    if (qstrcmp(mimeType, MIME_INTERNAL) == 0)
+        return QString("%1 %2").arg(QCoreApplication::applicationPid()).arg(m_serial).toLatin1();
+    else if (qstrcmp(mimeType, MIME_XML) == 0) {
+        if (m_xml.isEmpty() && m_entry)
+            m_xml = m_entry->toXML().toUtf8();
+        return m_xml;
+    }
+
+    return QByteArray();
+}
+
+
+/**
+ * @brief Checks if @p mime contains something that can be dropped on the tree.
+ *
+ * @param mime the MIME source
+ * @return @c true if it can be decoded, @c false otherwise
+ */
+bool TreeEntryDrag::canDecode(const QMimeSource* mime)
+{
+    return mime->provides(MIME_INTERNAL) || mime->provides(MIME_XML);
+}
+
+
+/**
+ * @brief Returns the dragged item if the drag was started in this process.
+ *
+ * @param mime the MIME source
+ * @return the dragged item or @c NULL if the drag comes from another process or if the
+ *         item has been deleted in the meantime
+ */
+TreeEntry* TreeEntryDrag::decodeLocal(const QMimeSource* mime)
+{
+    if (!mime->provides(MIME_INTERNAL))
+        return 0;
+
+    QStringList parts = QString::fromLatin1(mime->encodedData(MIME_INTERNAL)).split(' ');
+    if (parts.size() != 2)
+        return 0;
+
+    if (parts[0].toLongLong() != QCoreApplication::applicationPid() ||
+            parts[1].toUInt() != s_serial)
+        return 0;
+
+    return s_source;
+}
+
+
+/**
+ * @brief Removes the IDs from @p element and all children.
+ *
+ * @param element the element
+ */
+static void removeIds(QDomElement element)
+{
+    element.removeAttribute("id");
+    for (QDomElement child = element.firstChildElement(); !child.isNull();
+            child = child.nextSiblingElement())
+        removeIds(child);
+}
+
+
+/**
+ * @brief Parses the XML representation of the dragged item.
+ *
+ * The entry IDs are removed, since the dropped items are copies that need their own IDs.
+ *
+ * @param mime the MIME source
+ * @param doc the document that is filled
+ * @return @c true on success, @c false if there's no (valid) XML
+ */
+bool TreeEntryDrag::decodeXML(const QMimeSource* mime, QDomDocument& doc)
+{
+    if (!mime->provides(MIME_XML))
+        return false;
+
+    if (!doc.setContent(QString::fromUtf8(mime->encodedData(MIME_XML))))
+        return false;
+
+    removeIds(doc.documentElement());
+    return true;
+}
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
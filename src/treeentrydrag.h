@@ -0,0 +1,50 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#ifndef TREEENTRYDRAG_H
+#define TREEENTRYDRAG_H
+
+#include <QByteArray>
+#include <QPointer>
+#include <QDomDocument>
+#include <Q3DragObject>
+
+class TreeEntry;
+
+class TreeEntryDrag : public Q3DragObject
+{
+    public:
+        TreeEntryDrag(TreeEntry* entry, QWidget* dragSource = 0);
+        virtual ~TreeEntryDrag();
+
+        const char* format(int i = 0) const;
+        QByteArray encodedData(const char* mimeType) const;
+
+    public:
+        static bool canDecode(const QMimeSource* mime);
+        static TreeEntry* decodeLocal(const QMimeSource* mime);
+        static bool decodeXML(const QMimeSource* mime, QDomDocument& doc);
+
+    private:
+        QPointer<TreeEntry>         m_entry;
+        uint                        m_serial;
+        mutable QByteArray          m_xml;
+
+        static QPointer<TreeEntry>  s_source;
+        static uint                 s_serial;
+};
+
+#endif // TREEENTRYDRAG_H
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
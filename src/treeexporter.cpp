@@ -0,0 +1,375 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#include <QIODevice>
+#include <QDateTime>
+#include <QTextCodec>
+#include <QCoreApplication>
+#include <QThread>
+#include <QtConcurrentMap>
+
+#include "datareadwriter.h"
+#include "treeexporter.h"
+
+/**
+ * @brief The number of entries that are rendered together by one thread
+ */
+static const int EXPORT_CHUNK_SIZE = 256;
+
+/**
+ * @brief The number of chunks per thread that are rendered before they are written
+ */
+static const int EXPORT_CHUNKS_PER_THREAD = 2;
+
+/**
+ * @brief The width of the key column in the text format
+ */
+static const int EXPORT_KEY_WIDTH = 20;
+
+/**
+ * @class TreeExporter
+ *
+ * @brief Exports a TreeSnapshot with cleartext passwords as text, CSV or JSON.
+ *
+ * The category paths are built once per category by TreeSnapshot::getEntries(). The entries
+ * are rendered in chunks of EXPORT_CHUNK_SIZE entries by the threads of QtConcurrent, and the
+ * chunks are written in their order as soon as they are ready. So the export of a big vault
+ * mostly waits for the disk. Only a window of EXPORT_CHUNKS_PER_THREAD chunks per thread is
+ * submitted at once, and the next window is rendered while the current one is written. So
+ * at most two windows of cleartext are in memory, regardless of the size of the vault.
+ *
+ * The text format is the same as in older versions and uses the encoding of the locale. CSV
+ * (RFC 4180, one row per property) and JSON (an array of entries) are written in UTF-8.
+ *
+ * @ingroup gui
+ * @author Bernhard Walle
+ */
+
+/**
+ * @brief Creates a new exporter.
+ *
+ * The entries are copied, so @p snapshot may be deleted afterwards.
+ *
+ * @param snapshot the snapshot of the tree
+ * @param format the output format
+ */
+TreeExporter::TreeExporter(const TreeSnapshot& snapshot, Format format)
+    : m_format(format)
+    , m_entries(snapshot.getEntries(format == Text ? ": " : "/"))
+    , m_codec(format == Text ? QTextCodec::codecForLocale() : QTextCodec::codecForName("UTF-8"))
+{}
+
+
+/**
+ * @brief Creates a new exporter for entries that have been taken from a snapshot already.
+ *
+ * @param entries the entries, see TreeSnapshot::getEntries()
+ * @param format the output format
+ */
+TreeExporter::TreeExporter(const QVector<TreeSnapshot::Entry>& entries, Format format)
+    : m_format(format)
+    , m_entries(entries)
+    , m_codec(format == Text ? QTextCodec::codecForLocale() : QTextCodec::codecForName("UTF-8"))
+{}
+
+
+/**
+ * @brief Writes the export to @p device.
+ *
+ * @param device the device which must be open for writing
+ * @exception ReadWriteException if writing fails
+ */
+void TreeExporter::write(QIODevice* device) const
+{
+    QList<Chunk> chunks;
+    for (int begin = 0; begin < m_entries.size(); begin += EXPORT_CHUNK_SIZE) {
+        Chunk chunk;
+        chunk.exporter = this;
+        chunk.begin = begin;
+        chunk.end = qMin(begin + EXPORT_CHUNK_SIZE, m_entries.size());
+        chunks.append(chunk);
+    }
+
+    writeBytes(device, header());
+
+    const int window = qMax(1, QThread::idealThreadCount()) * EXPORT_CHUNKS_PER_THREAD;
+    QFuture<QByteArray> current = QtConcurrent::mapped(chunks.mid(0, window), renderChunk);
+    for (int begin = 0; begin < chunks.size(); begin += window) {
+        // render the next window while this one is written
+        QFuture<QByteArray> next;
+        if (begin + window < chunks.size())
+            next = QtConcurrent::mapped(chunks.mid(begin + window, window), renderChunk);
+
+        try {
+            // resultAt() waits for the chunk, so the order is kept
+            for (int i = 0; i < qMin(window, chunks.size() - begin); ++i)
+                writeBytes(device, current.resultAt(i));
+        } catch (const ReadWriteException&) {
+            current.cancel();
+            next.cancel();
+            current.waitForFinished();
+            next.waitForFinished();
+            throw;
+        }
+
+        // releases the results of the written window
+        current = next;
+    }
+
+    writeBytes(device, footer());
+}
+
+
+/**
+ * @brief Renders the entries of one chunk, called by the threads of QtConcurrent.
+ *
+ * @param chunk the chunk
+ * @return the encoded text
+ */
+QByteArray TreeExporter::renderChunk(const Chunk& chunk)
+{
+    const TreeExporter* exporter = chunk.exporter;
+    QString out;
+
+    for (int i = chunk.begin; i < chunk.end; ++i) {
+        const TreeSnapshot::Entry& entry = exporter->m_entries[i];
+        switch (exporter->m_format) {
+            case Text:
+                exporter->appendText(entry, out);
+                break;
+            case Csv:
+                exporter->appendCsv(entry, out);
+                break;
+            case Json:
+                if (i > 0)
+                    out += ",\n";
+                exporter->appendJson(entry, out);
+                break;
+        }
+    }
+
+    return exporter->encode(out);
+}
+
+
+/**
+ * @brief Returns the text before the entries.
+ *
+ * @return the encoded text
+ */
+QByteArray TreeExporter::header() const
+{
+    switch (m_format) {
+        case Text: {
+            // the translations are still in the context of the tree which exported the text
+            QString title = QCoreApplication::translate("Tree", "QPaMaT");
+            QString date = QCoreApplication::translate("Tree", "Export date:");
+            return encode(title.leftJustified(EXPORT_KEY_WIDTH) +
+                QCoreApplication::translate("Tree",
+                    "password managing tool for Unix, Windows and MacOS X") + "\n" +
+                date.leftJustified(EXPORT_KEY_WIDTH) +
+                QDateTime::currentDateTime().date().toString(Qt::ISODate) + "\n" +
+                QString(80, '=') + "\n");
+        }
+        case Csv:
+            return encode("Category,Entry,Key,Value,Type\r\n");
+        case Json:
+            return encode("[\n");
+    }
+
+    return QByteArray();
+}
+
+
+/**
+ * @brief Returns the text after the entries.
+ *
+ * @return the encoded text
+ */
+QByteArray TreeExporter::footer() const
+{
+    if (m_format == Json)
+        return encode(m_entries.isEmpty() ? "]\n" : "\n]\n");
+
+    return QByteArray();
+}
+
+
+/**
+ * @brief Appends @p entry in the text format.
+ *
+ * @param entry the entry
+ * @param out the string where the text is appended
+ */
+void TreeExporter::appendText(const TreeSnapshot::Entry& entry, QString& out) const
+{
+    const QString separator(80, '-');
+
+    out += separator + "\n";
+    if (!entry.category.isEmpty())
+        out += entry.category + ": ";
+    out += entry.name + "\n";
+    out += separator + "\n\n";
+
+    for (QList<TreeSnapshot::PropertyData>::const_iterator it = entry.properties.begin();
+            it != entry.properties.end(); ++it) {
+        out += QString(it->key + ": ").leftJustified(EXPORT_KEY_WIDTH);
+        out += it->value.get() + "\n";
+    }
+
+    out += "\n\n";
+}
+
+
+/**
+ * @brief Appends @p entry as CSV, one row per property.
+ *
+ * An entry without properties gets one row with empty key, value and type.
+ *
+ * @param entry the entry
+ * @param out the string where the rows are appended
+ */
+void TreeExporter::appendCsv(const TreeSnapshot::Entry& entry, QString& out) const
+{
+    const QString prefix = quoteCsv(entry.category) + "," + quoteCsv(entry.name) + ",";
+
+    if (entry.properties.isEmpty()) {
+        out += prefix + ",,\r\n";
+        return;
+    }
+
+    for (QList<TreeSnapshot::PropertyData>::const_iterator it = entry.properties.begin();
+            it != entry.properties.end(); ++it) {
+        out += prefix + quoteCsv(it->key) + "," + quoteCsv(it->value.get()) + "," +
+            Property::typeToString(it->type) + "\r\n";
+    }
+}
+
+
+/**
+ * @brief Appends @p entry as JSON object.
+ *
+ * @param entry the entry
+ * @param out the string where the object is appended
+ */
+void TreeExporter::appendJson(const TreeSnapshot::Entry& entry, QString& out) const
+{
+    out += "  {\"category\": " + quoteJson(entry.category) +
+        ", \"name\": " + quoteJson(entry.name) + ", \"properties\": [";
+
+    for (QList<TreeSnapshot::PropertyData>::const_iterator it = entry.properties.begin();
+            it != entry.properties.end(); ++it) {
+        if (it != entry.properties.begin())
+            out += ",";
+        out += "\n    {\"key\": " + quoteJson(it->key) +
+            ", \"value\": " + quoteJson(it->value.get()) +
+            ", \"type\": \"" + Property::typeToString(it->type) + "\"}";
+    }
+
+    out += entry.properties.isEmpty() ? "]}" : "\n  ]}";
+}
+
+
+/**
+ * @brief Encodes @p string with the codec of the format.
+ *
+ * @param string the string
+ * @return the bytes
+ */
+QByteArray TreeExporter::encode(const QString& string) const
+{
+    return m_codec->fromUnicode(string);
+}
+
+
+/**
+ * @brief Quotes a CSV field if necessary.
+ *
+ * @param string the field
+ * @return the field, in double quotes if it contains a comma, a quote or a line break
+ */
+QString TreeExporter::quoteCsv(const QString& string)
+{
+    for (int i = 0; i < string.length(); ++i) {
+        const QChar c = string[i];
+        if (c == ',' || c == '"' || c == '\n' || c == '\r') {
+            QString quoted = string;
+            quoted.replace("\"", "\"\"");
+            return "\"" + quoted + "\"";
+        }
+    }
+
+    return string;
+}
+
+
+/**
+ * @brief Quotes a JSON string.
+ *
+ * @param string the string
+ * @return the string in double quotes with the special characters escaped
+ */
+QString TreeExporter::quoteJson(const QString& string)
+{
+    QString quoted;
+    quoted.reserve(string.length() + 2);
+    quoted += '"';
+
+    for (int i = 0; i < string.length(); ++i) {
+        const ushort c = string[i].unicode();
+        switch (c) {
+            case '"':
+                quoted += "\\\"";
+                break;
+            case '\\':
+                quoted += "\\\\";
+                break;
+            case '\n':
+                quoted += "\\n";
+                break;
+            case '\r':
+                quoted += "\\r";
+                break;
+            case '\t':
+                quoted += "\\t";
+                break;
+            default:
+                if (c < 0x20)
+                    quoted += QString("\\u%1").arg(c, 4, 16, QChar('0'));
+                else
+                    quoted += string[i];
+                break;
+        }
+    }
+
+    quoted += '"';
+    return quoted;
+}
+
+
+/**
+ * @brief Writes @p bytes to @p device.
+ *
+ * @param device the device
+ * @param bytes the bytes
+ * @exception ReadWriteException if not all bytes could be written
+ */
+void TreeExporter::writeBytes(QIODevice* device, const QByteArray& bytes)
+{
+    if (device->write(bytes) != bytes.size())
+        throw ReadWriteException(QObject::tr("An error occured while saving the file: %1")
+            .arg(device->errorString()), ReadWriteException::CIOError);
+}
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
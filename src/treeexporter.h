@@ -0,0 +1,69 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#ifndef TREEEXPORTER_H
+#define TREEEXPORTER_H
+
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+
+#include "treesnapshot.h"
+
+class QIODevice;
+class QTextCodec;
+
+class TreeExporter
+{
+    public:
+        enum Format {
+            Text,
+            Csv,
+            Json
+        };
+
+    public:
+        TreeExporter(const TreeSnapshot& snapshot, Format format);
+        TreeExporter(const QVector<TreeSnapshot::Entry>& entries, Format format);
+
+        void write(QIODevice* device) const;
+
+    private:
+        struct Chunk {
+            const TreeExporter* exporter;
+            int                 begin;
+            int                 end;
+        };
+
+    private:
+        static QByteArray renderChunk(const Chunk& chunk);
+        QByteArray header() const;
+        QByteArray footer() const;
+        void appendText(const TreeSnapshot::Entry& entry, QString& out) const;
+        void appendCsv(const TreeSnapshot::Entry& entry, QString& out) const;
+        void appendJson(const TreeSnapshot::Entry& entry, QString& out) const;
+        QByteArray encode(const QString& string) const;
+        static QString quoteCsv(const QString& string);
+        static QString quoteJson(const QString& string);
+        static void writeBytes(QIODevice* device, const QByteArray& bytes);
+
+    private:
+        Format                          m_format;
+        QVector<TreeSnapshot::Entry>    m_entries;
+        QTextCodec*                     m_codec;
+};
+
+#endif // TREEEXPORTER_H
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
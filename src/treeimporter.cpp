@@ -0,0 +1,233 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#include "tree.h"
+#include "treeentry.h"
+#include "changebatch.h"
+#include "datareadwriter.h"
+#include "util/trace.h"
+#include "import/importer.h"
+#include "treeimporter.h"
+
+/**
+ * @class TreeImporter
+ *
+ * @brief Adds the records of an Importer to the Tree.
+ *
+ * Missing categories are created. An entry is skipped if the tree (or the import itself)
+ * already has an entry with the same full name and the same user name. For that, the tree
+ * is indexed once before the import, and the categories are looked up in a hash.
+ *
+ * All changes are made in one ChangeBatch and the list view is not updated until the end,
+ * so the tree is updated only once. The importer reads the file record by record, so only
+ * the index grows with the size of the vault. The import is not recorded in the UndoStack.
+ *
+ * @ingroup import
+ * @author Bernhard Walle
+ */
+
+/**
+ * @brief Creates a new TreeImporter.
+ *
+ * @param tree the tree where the entries are added
+ */
+TreeImporter::TreeImporter(Tree* tree)
+    : m_tree(tree)
+    , m_imported(0)
+    , m_duplicates(0)
+{}
+
+
+/**
+ * @brief Reads all records of @p importer and adds them to the tree.
+ *
+ * If reading fails, the entries that have been read before the error are kept.
+ *
+ * @param importer the importer which must be open
+ * @exception ReadWriteException if reading fails
+ */
+void TreeImporter::import(Importer& importer)
+{
+    TraceSpan span("import", "Tree");
+
+    m_categories.clear();
+    m_entries.clear();
+    TreeEntry* entry = dynamic_cast<TreeEntry*>(m_tree->firstChild());
+    while (entry) {
+        index(entry, QString(""));
+        entry = dynamic_cast<TreeEntry*>(entry->nextSibling());
+    }
+
+    ChangeBatch batch;
+    m_tree->setUpdatesEnabled(false);
+
+    try {
+        ImportRecord record;
+        while (importer.readRecord(record))
+            add(record);
+    } catch (const ReadWriteException&) {
+        m_tree->setUpdatesEnabled(true);
+        m_tree->triggerUpdate();
+        throw;
+    }
+
+    m_tree->setUpdatesEnabled(true);
+    m_tree->triggerUpdate();
+}
+
+
+/**
+ * @brief Returns the number of entries that have been added by import().
+ *
+ * @return the number of entries
+ */
+int TreeImporter::getImportedCount() const
+{
+    return m_imported;
+}
+
+
+/**
+ * @brief Returns the number of records that have been skipped because the entry exists.
+ *
+ * @return the number of records
+ */
+int TreeImporter::getDuplicateCount() const
+{
+    return m_duplicates;
+}
+
+
+/**
+ * @brief Adds @p entry and its children to the index.
+ *
+ * @param entry the entry
+ * @param path the path of the category that contains @p entry, see childPath()
+ */
+void TreeImporter::index(TreeEntry* entry, const QString& path)
+{
+    const QString entryPath = childPath(path, entry->getName());
+
+    if (entry->isCategory()) {
+        if (!m_categories.contains(entryPath))
+            m_categories.insert(entryPath, entry);
+
+        TreeEntry* child = dynamic_cast<TreeEntry*>(entry->firstChild());
+        while (child) {
+            index(child, entryPath);
+            child = dynamic_cast<TreeEntry*>(child->nextSibling());
+        }
+    } else {
+        QString username("");
+        TreeEntry::PropertyIterator it = entry->propertyIterator();
+        Property* property;
+        while ( (property = it.current()) != 0 ) {
+            ++it;
+            if (property->getType() == Property::USERNAME) {
+                username = property->getValue();
+                break;
+            }
+        }
+        m_entries.insert(entryKey(entryPath, username));
+    }
+}
+
+
+/**
+ * @brief Adds one record unless it's a duplicate.
+ *
+ * @param record the record
+ */
+void TreeImporter::add(const ImportRecord& record)
+{
+    QString path;
+    TreeEntry* parent = category(record.category, path);
+
+    const QString key = entryKey(childPath(path, record.name), record.username());
+    if (m_entries.contains(key)) {
+        m_duplicates++;
+        return;
+    }
+    m_entries.insert(key);
+
+    TreeEntry* entry = parent
+        ? new TreeEntry(parent, record.name)
+        : new TreeEntry(m_tree, record.name);
+
+    for (QList<ImportProperty>::const_iterator it = record.properties.begin();
+            it != record.properties.end(); ++it) {
+        const bool password = it->type == Property::PASSWORD;
+        entry->appendProperty(new Property(it->key, it->value, it->type, password, password));
+    }
+
+    m_imported++;
+}
+
+
+/**
+ * @brief Returns the category with the path @p names, missing categories are created.
+ *
+ * @param names the names of the categories from the top
+ * @param path the path of the category, see childPath()
+ * @return the category or @c 0 for the top level
+ */
+TreeEntry* TreeImporter::category(const QStringList& names, QString& path)
+{
+    TreeEntry* parent = 0;
+    path = QString("");
+
+    for (QStringList::const_iterator it = names.begin(); it != names.end(); ++it) {
+        path = childPath(path, *it);
+
+        QHash<QString, TreeEntry*>::const_iterator found = m_categories.find(path);
+        if (found != m_categories.end())
+            parent = found.value();
+        else {
+            parent = parent
+                ? new TreeEntry(parent, *it, true)
+                : new TreeEntry(m_tree, *it, true);
+            m_categories.insert(path, parent);
+        }
+    }
+
+    return parent;
+}
+
+
+/**
+ * @brief Returns the path of a child, the names are separated by a line break.
+ *
+ * @param path the path of the category or an empty string for the top level
+ * @param name the name of the child
+ * @return the path
+ */
+QString TreeImporter::childPath(const QString& path, const QString& name)
+{
+    return path.isEmpty() ? name : path + '\n' + name;
+}
+
+
+/**
+ * @brief Returns the key that identifies duplicates.
+ *
+ * @param path the path of the entry, see childPath()
+ * @param username the user name of the entry
+ * @return the key
+ */
+QString TreeImporter::entryKey(const QString& path, const QString& username)
+{
+    return path + QChar('\0') + username;
+}
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
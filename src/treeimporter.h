@@ -0,0 +1,55 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#ifndef TREEIMPORTER_H
+#define TREEIMPORTER_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QSet>
+
+class Tree;
+class TreeEntry;
+class Importer;
+struct ImportRecord;
+
+class TreeImporter
+{
+    public:
+        TreeImporter(Tree* tree);
+
+        void import(Importer& importer);
+
+        int getImportedCount() const;
+        int getDuplicateCount() const;
+
+    private:
+        void index(TreeEntry* entry, const QString& path);
+        void add(const ImportRecord& record);
+        TreeEntry* category(const QStringList& names, QString& path);
+        static QString childPath(const QString& path, const QString& name);
+        static QString entryKey(const QString& path, const QString& username);
+
+    private:
+        Tree*                       m_tree;
+        QHash<QString, TreeEntry*>  m_categories;
+        QSet<QString>               m_entries;
+        int                         m_imported;
+        int                         m_duplicates;
+};
+
+#endif // TREEIMPORTER_H
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
@@ -0,0 +1,275 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#include <QDomElement>
+
+#include "tree.h"
+#include "treeentry.h"
+#include "treesnapshot.h"
+
+/**
+ * @class TreeSnapshot
+ *
+ * @brief Copy of the data of a Tree that can be written in another thread.
+ *
+ * The tree and its entries are QObjects that live in the GUI thread and change while the
+ * user edits them. A snapshot copies only the values. Secret values stay in secure memory or
+ * encrypted.
+ *
+ * The data of each entry is immutable after the copy and shared between snapshots. With a
+ * Cache, only the entries whose generation (see TreeEntry::getGeneration()) has changed
+ * since the previous snapshot are copied again, the others only cost a reference count.
+ * That keeps the periodic snapshots of the AutoSaver cheap, also for the secure memory.
+ * The cache must be cleared when secret values are encrypted without a new generation,
+ * e.g. when the session is locked.
+ *
+ * The snapshot is independent from the tree after construction. It can be passed to a
+ * worker thread which builds the XML document from it with appendXML(), see AutoSaver.
+ *
+ * @ingroup gui
+ * @author Bernhard Walle
+ */
+
+/**
+ * @brief Copies the data of @p tree.
+ *
+ * Must be called in the GUI thread.
+ *
+ * @param tree the tree
+ * @param cache if not 0, the data of unchanged entries is taken from there, and afterwards
+ *        it contains the data of this snapshot for the next one
+ */
+TreeSnapshot::TreeSnapshot(const Tree* tree, Cache* cache)
+    : m_generation(TreeEntry::lastGeneration())
+{
+    Cache newCache;
+    TreeEntry* entry = dynamic_cast<TreeEntry*>(tree->firstChild());
+    while (entry) {
+        copy(entry, m_nodes, QString(""), cache, cache ? &newCache : 0);
+        entry = dynamic_cast<TreeEntry*>(entry->nextSibling());
+    }
+
+    // entries that have been deleted are dropped from the cache
+    if (cache)
+        cache->swap(newCache);
+}
+
+
+/**
+ * @brief Copies @p root and its children.
+ *
+ * The categories above @p root are only kept as names for getEntries(). Must be called in
+ * the GUI thread.
+ *
+ * @param root the entry or category
+ */
+TreeSnapshot::TreeSnapshot(TreeEntry* root)
+    : m_generation(TreeEntry::lastGeneration())
+{
+    for (TreeEntry* parent = dynamic_cast<TreeEntry*>(root->Q3ListViewItem::parent()); parent;
+            parent = dynamic_cast<TreeEntry*>(parent->Q3ListViewItem::parent()))
+        m_rootCategory.prepend(parent->getName());
+
+    copy(root, m_nodes, QString(""), 0, 0);
+}
+
+
+/**
+ * @brief Appends the copied entries to the XML document.
+ *
+ * The result is the same as with Tree::appendXML() at the time when the snapshot has been
+ * taken. This function may be called in any thread.
+ *
+ * @param document the document which must have a <tt>\<passwords\></tt> tag
+ * @param encryptor if not 0, passwords are encrypted with it
+ */
+void TreeSnapshot::appendXML(QDomDocument& document, StringEncryptor* encryptor) const
+{
+    QDomNode passwords = document.documentElement().namedItem("passwords");
+    Q_ASSERT(!passwords.isNull());
+
+    for (QList<Node>::const_iterator it = m_nodes.begin(); it != m_nodes.end(); ++it)
+        appendXML(*it, document, passwords, encryptor);
+}
+
+
+/**
+ * @brief Returns the ID of the parent for each entry, see Journal::attach().
+ *
+ * @return a hash that maps the entry ID to the ID of the parent, top-level entries map to
+ *         an empty string
+ */
+QHash<QString, QString> TreeSnapshot::getParents() const
+{
+    return m_parents;
+}
+
+
+/**
+ * @brief Returns the value of TreeEntry::lastGeneration() at the time of the snapshot.
+ *
+ * @return the generation
+ */
+quint64 TreeSnapshot::getGeneration() const
+{
+    return m_generation;
+}
+
+
+/**
+ * @brief Returns the entries in the order of the tree, without the categories.
+ *
+ * The category path is built once for each category and shared by its entries. This
+ * function may be called in any thread.
+ *
+ * @param separator the separator between the names of the categories in Entry::category
+ * @return the entries
+ */
+QVector<TreeSnapshot::Entry> TreeSnapshot::getEntries(const QString& separator) const
+{
+    QVector<Entry> entries;
+    entries.reserve(m_parents.size());
+    appendEntries(m_nodes, m_rootCategory.join(separator), separator, entries);
+    return entries;
+}
+
+
+/**
+ * @brief Copies @p entry and its children recursively.
+ *
+ * @param entry the entry to copy
+ * @param list the list where the copy is appended
+ * @param parentId the ID of the parent entry
+ * @param oldCache the data of the previous snapshot or 0
+ * @param newCache the cache where the data is stored for the next snapshot or 0
+ */
+void TreeSnapshot::copy(TreeEntry* entry, QList<Node>& list, const QString& parentId,
+                        const Cache* oldCache, Cache* newCache)
+{
+    list.append(Node());
+    Node& node = list.last();
+
+    const QString id = entry->getId();
+    if (oldCache) {
+        Cache::const_iterator cached = oldCache->constFind(id);
+        if (cached != oldCache->constEnd() &&
+                cached.value()->generation == entry->getGeneration())
+            node.data = cached.value();
+    }
+    if (!node.data)
+        node.data = copyData(entry);
+    if (newCache)
+        newCache->insert(id, node.data);
+
+    node.wasOpen = entry->isOpen();
+    node.isSelected = entry->isSelected();
+    m_parents.insert(id, parentId);
+
+    if (node.data->isCategory) {
+        TreeEntry* child = dynamic_cast<TreeEntry*>(entry->firstChild());
+        while (child) {
+            copy(child, node.children, id, oldCache, newCache);
+            child = dynamic_cast<TreeEntry*>(child->nextSibling());
+        }
+    }
+}
+
+
+/**
+ * @brief Copies the data of @p entry without its children.
+ *
+ * @param entry the entry
+ * @return the data that is not changed any more
+ */
+QSharedPointer<const TreeSnapshot::EntryData> TreeSnapshot::copyData(TreeEntry* entry)
+{
+    EntryData* data = new EntryData;
+    data->name = entry->getName();
+    data->id = entry->getId();
+    data->isCategory = entry->isCategory();
+    data->generation = entry->getGeneration();
+
+    TreeEntry::PropertyIterator it = entry->propertyIterator();
+    Property* property;
+    while ( (property = it.current()) != 0 ) {
+        ++it;
+        PropertyData propertyData;
+        propertyData.key = property->getKey();
+        propertyData.value = property->getPropertyValue();
+        propertyData.type = property->getType();
+        propertyData.hidden = property->isHidden();
+        propertyData.encrypted = property->isEncrypted();
+        data->properties.append(propertyData);
+    }
+
+    return QSharedPointer<const EntryData>(data);
+}
+
+
+/**
+ * @brief Appends the XML of one node with the serialization of TreeEntry::createXMLElement()
+ *        and Property::appendXML().
+ *
+ * @param node the node
+ * @param document the document
+ * @param parent the parent XML node
+ * @param encryptor if not 0, passwords are encrypted with it
+ */
+void TreeSnapshot::appendXML(const Node& node, QDomDocument& document, QDomNode& parent,
+                             StringEncryptor* encryptor)
+{
+    const EntryData& data = *node.data;
+    QDomElement newElement = TreeEntry::createXMLElement(document, data.isCategory, data.name,
+        data.id, node.wasOpen, node.isSelected);
+
+    for (QList<Node>::const_iterator it = node.children.begin(); it != node.children.end(); ++it)
+        appendXML(*it, document, newElement, encryptor);
+
+    for (QList<PropertyData>::const_iterator it = data.properties.begin();
+            it != data.properties.end(); ++it)
+        Property::appendXML(document, newElement, it->key, it->value, it->type, it->hidden,
+            it->encrypted, encryptor);
+
+    parent.appendChild(newElement);
+}
+
+
+/**
+ * @brief Appends the entries of @p nodes and of their subcategories, see getEntries().
+ *
+ * @param nodes the nodes
+ * @param category the path of the category that contains @p nodes
+ * @param separator the separator between the names of the categories
+ * @param entries the list where the entries are appended
+ */
+void TreeSnapshot::appendEntries(const QList<Node>& nodes, const QString& category,
+                                 const QString& separator, QVector<Entry>& entries)
+{
+    for (QList<Node>::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+        const EntryData& data = *it->data;
+        if (data.isCategory) {
+            appendEntries(it->children,
+                category.isEmpty() ? data.name : category + separator + data.name,
+                separator, entries);
+        } else {
+            Entry entry;
+            entry.category = category;
+            entry.name = data.name;
+            entry.properties = data.properties;
+            entries.append(entry);
+        }
+    }
+}
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
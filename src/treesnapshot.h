@@ -0,0 +1,97 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#ifndef TREESNAPSHOT_H
+#define TREESNAPSHOT_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QVector>
+#include <QHash>
+#include <QSharedPointer>
+#include <QDomDocument>
+
+#include "property.h"
+#include "security/encryptor.h"
+
+class Tree;
+class TreeEntry;
+
+class TreeSnapshot
+{
+    public:
+        struct PropertyData {
+            QString         key;
+            PropertyValue   value;
+            Property::Type  type;
+            bool            hidden;
+            bool            encrypted;
+        };
+
+        struct Entry {
+            QString             category;
+            QString             name;
+            QList<PropertyData> properties;
+        };
+
+    private:
+        struct EntryData {
+            QString             name;
+            QString             id;
+            bool                isCategory;
+            quint64             generation;
+            QList<PropertyData> properties;
+        };
+
+    public:
+        typedef QHash<QString, QSharedPointer<const EntryData> > Cache;
+
+    public:
+        TreeSnapshot(const Tree* tree, Cache* cache = 0);
+        TreeSnapshot(TreeEntry* root);
+
+        void appendXML(QDomDocument& document, StringEncryptor* encryptor = 0) const;
+
+        QHash<QString, QString> getParents() const;
+        quint64 getGeneration() const;
+        QVector<Entry> getEntries(const QString& separator) const;
+
+    private:
+        struct Node {
+            QSharedPointer<const EntryData> data;
+            bool                            wasOpen;
+            bool                            isSelected;
+            QList<Node>                     children;
+        };
+
+    private:
+        void copy(TreeEntry* entry, QList<Node>& list, const QString& parentId,
+            const Cache* oldCache, Cache* newCache);
+        static QSharedPointer<const EntryData> copyData(TreeEntry* entry);
+        static void appendXML(const Node& node, QDomDocument& document, QDomNode& parent,
+            StringEncryptor* encryptor);
+        static void appendEntries(const QList<Node>& nodes, const QString& category,
+            const QString& separator, QVector<Entry>& entries);
+
+    private:
+        QList<Node>             m_nodes;
+        QStringList             m_rootCategory;
+        QHash<QString, QString> m_parents;
+        quint64                 m_generation;
+};
+
+#endif // TREESNAPSHOT_H
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
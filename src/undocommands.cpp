@@ -0,0 +1,703 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#include <Q3ListView>
+
+#include "global.h"
+#include "changebatch.h"
+#include "treeentry.h"
+#include "undocommands.h"
+
+#define MERGE_INTERVAL 1000
+#define MERGE_MAX_DURATION 10000
+
+/**
+ * @brief Estimates the memory that is used by a tree entry including all children.
+ *
+ * @param entry the entry
+ * @return the size in bytes
+ */
+static size_t subtreeSize(const TreeEntry* entry)
+{
+    size_t size = sizeof(TreeEntry) +
+        (entry->getName().capacity() + entry->getId().capacity()) * sizeof(QChar);
+
+    TreeEntry::PropertyIterator it = entry->propertyIterator();
+    Property* property;
+    while ( (property = it.current()) != 0 ) {
+        size += property->memorySize();
+        ++it;
+    }
+
+    const Q3ListViewItem* child = entry->firstChild();
+    while (child) {
+        size += subtreeSize(dynamic_cast<const TreeEntry*>(child));
+        child = child->nextSibling();
+    }
+
+    return size;
+}
+
+/**
+ * @class EntryCommand
+ *
+ * @brief Base class for commands that insert or remove a TreeEntry.
+ *
+ * If the entry is not in the tree, it's owned by the command and deleted together with it.
+ *
+ * @ingroup gui
+ * @author Bernhard Walle
+ */
+
+/**
+ * @brief Creates a new EntryCommand.
+ *
+ * @param text the text of the command
+ * @param entry the entry, must be in the tree when the command is created
+ * @param attached @c true if the entry should be in the tree after redo(), @c false if it
+ *        should be removed from the tree
+ */
+EntryCommand::EntryCommand(const QString& text, TreeEntry* entry, bool attached)
+    : UndoCommand(text)
+    , m_view(entry->listView())
+    , m_parent(dynamic_cast<TreeEntry*>(entry->Q3ListViewItem::parent()))
+    , m_entry(entry)
+    , m_detached(false)
+    , m_subtreeSize(attached ? 0 : subtreeSize(entry))
+{}
+
+
+/**
+ * @brief Deletes the command and the entry if it is not in the tree.
+ */
+EntryCommand::~EntryCommand()
+{
+    if (m_detached)
+        delete m_entry;
+}
+
+
+/**
+ * @copydoc UndoCommand::memorySize()
+ */
+size_t EntryCommand::memorySize() const
+{
+    return sizeof(EntryCommand) + m_subtreeSize;
+}
+
+
+/**
+ * @brief Puts the entry back to its parent.
+ */
+void EntryCommand::attach()
+{
+    if (!m_detached)
+        return;
+
+    if (m_parent)
+        m_parent->insertItem(m_entry);
+    else
+        m_view->insertItem(m_entry);
+    m_detached = false;
+
+    m_view->setSelected(m_entry, true);
+    m_view->ensureItemVisible(m_entry);
+}
+
+
+/**
+ * @brief Removes the entry from the tree without deleting it.
+ */
+void EntryCommand::detach()
+{
+    if (m_detached)
+        return;
+
+    if (m_parent)
+        m_parent->takeItem(m_entry);
+    else
+        m_view->takeItem(m_entry);
+    m_detached = true;
+}
+
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * @class InsertEntryCommand
+ *
+ * @brief Command for a TreeEntry that has been inserted into the tree.
+ *
+ * @ingroup gui
+ * @author Bernhard Walle
+ */
+
+/**
+ * @brief Creates a new InsertEntryCommand.
+ *
+ * @param entry the entry that has already been inserted into the tree
+ */
+InsertEntryCommand::InsertEntryCommand(TreeEntry* entry)
+    : EntryCommand(entry->isCategory()
+        ? QObject::tr("Insert category") : QObject::tr("Insert item"), entry, true)
+{}
+
+
+/**
+ * @copydoc UndoCommand::undo()
+ */
+void InsertEntryCommand::undo()
+{
+    detach();
+}
+
+
+/**
+ * @copydoc UndoCommand::redo()
+ */
+void InsertEntryCommand::redo()
+{
+    attach();
+}
+
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * @class RemoveEntryCommand
+ *
+ * @brief Command that removes a TreeEntry with all children from the tree.
+ *
+ * @ingroup gui
+ * @author Bernhard Walle
+ */
+
+/**
+ * @brief Creates a new RemoveEntryCommand.
+ *
+ * @param entry the entry that should be removed
+ */
+RemoveEntryCommand::RemoveEntryCommand(TreeEntry* entry)
+    : EntryCommand(QObject::tr("Delete \"%1\"").arg(entry->getName()), entry, false)
+{}
+
+
+/**
+ * @copydoc UndoCommand::undo()
+ */
+void RemoveEntryCommand::undo()
+{
+    attach();
+}
+
+
+/**
+ * @copydoc UndoCommand::redo()
+ */
+void RemoveEntryCommand::redo()
+{
+    detach();
+}
+
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * @class RenameEntryCommand
+ *
+ * @brief Command that changes the name of a TreeEntry.
+ *
+ * @ingroup gui
+ * @author Bernhard Walle
+ */
+
+/**
+ * @brief Creates a new RenameEntryCommand.
+ *
+ * @param entry the entry
+ * @param oldName the name before
+ * @param newName the new name
+ */
+RenameEntryCommand::RenameEntryCommand(TreeEntry* entry, const QString& oldName,
+                                       const QString& newName)
+    : UndoCommand(QObject::tr("Rename \"%1\"").arg(oldName))
+    , m_entry(entry)
+    , m_oldName(oldName)
+    , m_newName(newName)
+{}
+
+
+/**
+ * @copydoc UndoCommand::undo()
+ */
+void RenameEntryCommand::undo()
+{
+    m_entry->setName(m_oldName);
+}
+
+
+/**
+ * @copydoc UndoCommand::redo()
+ */
+void RenameEntryCommand::redo()
+{
+    m_entry->setName(m_newName);
+}
+
+
+/**
+ * @copydoc UndoCommand::memorySize()
+ */
+size_t RenameEntryCommand::memorySize() const
+{
+    return sizeof(RenameEntryCommand) +
+        (m_oldName.capacity() + m_newName.capacity()) * sizeof(QChar);
+}
+
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * @class MoveEntryCommand
+ *
+ * @brief Command that moves a TreeEntry to another category, e.g. by drag and drop.
+ *
+ * @ingroup gui
+ * @author Bernhard Walle
+ */
+
+/**
+ * @brief Creates a new MoveEntryCommand.
+ *
+ * @param entry the entry
+ * @param newParent the new parent or @c NULL for the top level
+ */
+MoveEntryCommand::MoveEntryCommand(TreeEntry* entry, TreeEntry* newParent)
+    : UndoCommand(QObject::tr("Move \"%1\"").arg(entry->getName()))
+    , m_entry(entry)
+    , m_oldParent(dynamic_cast<TreeEntry*>(entry->Q3ListViewItem::parent()))
+    , m_newParent(newParent)
+{}
+
+
+/**
+ * @copydoc UndoCommand::undo()
+ */
+void MoveEntryCommand::undo()
+{
+    m_entry->moveTo(m_oldParent);
+}
+
+
+/**
+ * @copydoc UndoCommand::redo()
+ */
+void MoveEntryCommand::redo()
+{
+    m_entry->moveTo(m_newParent);
+}
+
+
+/**
+ * @copydoc UndoCommand::isObsolete()
+ */
+bool MoveEntryCommand::isObsolete() const
+{
+    return m_oldParent == m_newParent;
+}
+
+
+/**
+ * @copydoc UndoCommand::memorySize()
+ */
+size_t MoveEntryCommand::memorySize() const
+{
+    return sizeof(MoveEntryCommand);
+}
+
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * @class PropertyCommand
+ *
+ * @brief Base class for commands that insert or remove a Property of a TreeEntry.
+ *
+ * If the property is not part of the entry, it's owned by the command.
+ *
+ * @ingroup gui
+ * @author Bernhard Walle
+ */
+
+/**
+ * @brief Creates a new PropertyCommand.
+ *
+ * @param text the text of the command
+ * @param entry the entry
+ * @param index the index of the property in @p entry
+ * @param property the property if it's not part of @p entry, @c NULL otherwise
+ */
+PropertyCommand::PropertyCommand(const QString& text, TreeEntry* entry, unsigned int index,
+                                 Property* property)
+    : UndoCommand(text)
+    , m_entry(entry)
+    , m_index(index)
+    , m_property(property)
+{}
+
+
+/**
+ * @brief Deletes the command and the property if it's not part of the entry.
+ */
+PropertyCommand::~PropertyCommand()
+{
+    delete m_property;
+}
+
+
+/**
+ * @copydoc UndoCommand::memorySize()
+ */
+size_t PropertyCommand::memorySize() const
+{
+    size_t size = sizeof(PropertyCommand);
+    if (m_property)
+        size += m_property->memorySize();
+    return size;
+}
+
+
+/**
+ * @brief Inserts the property into the entry.
+ */
+void PropertyCommand::attach()
+{
+    if (!m_property)
+        return;
+
+    m_entry->insertProperty(m_index, m_property);
+    m_property = 0;
+}
+
+
+/**
+ * @brief Removes the property from the entry without deleting it.
+ */
+void PropertyCommand::detach()
+{
+    if (m_property)
+        return;
+
+    m_property = m_entry->takeProperty(m_index);
+}
+
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * @class InsertPropertyCommand
+ *
+ * @brief Command that appends a new Property to a TreeEntry.
+ *
+ * @ingroup gui
+ * @author Bernhard Walle
+ */
+
+/**
+ * @brief Creates a new InsertPropertyCommand.
+ *
+ * @param entry the entry
+ * @param property the new property, the command takes the ownership
+ */
+InsertPropertyCommand::InsertPropertyCommand(TreeEntry* entry, Property* property)
+    : PropertyCommand(QObject::tr("Insert property"), entry,
+        entry->propertyIterator().count(), property)
+{}
+
+
+/**
+ * @copydoc UndoCommand::undo()
+ */
+void InsertPropertyCommand::undo()
+{
+    detach();
+}
+
+
+/**
+ * @copydoc UndoCommand::redo()
+ */
+void InsertPropertyCommand::redo()
+{
+    attach();
+}
+
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * @class RemovePropertyCommand
+ *
+ * @brief Command that removes a Property from a TreeEntry.
+ *
+ * @ingroup gui
+ * @author Bernhard Walle
+ */
+
+/**
+ * @brief Creates a new RemovePropertyCommand.
+ *
+ * @param entry the entry
+ * @param index the index of the property
+ */
+RemovePropertyCommand::RemovePropertyCommand(TreeEntry* entry, unsigned int index)
+    : PropertyCommand(QObject::tr("Delete \"%1\"").arg(entry->getProperty(index)->getKey()),
+        entry, index, 0)
+{}
+
+
+/**
+ * @copydoc UndoCommand::undo()
+ */
+void RemovePropertyCommand::undo()
+{
+    attach();
+}
+
+
+/**
+ * @copydoc UndoCommand::redo()
+ */
+void RemovePropertyCommand::redo()
+{
+    detach();
+}
+
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * @class SwapPropertiesCommand
+ *
+ * @brief Command that swaps two neighbouring properties of a TreeEntry.
+ *
+ * @ingroup gui
+ * @author Bernhard Walle
+ */
+
+/**
+ * @brief Creates a new SwapPropertiesCommand.
+ *
+ * @param entry the entry
+ * @param index the property with @p index is swapped with the property at <tt>index+1</tt>
+ */
+SwapPropertiesCommand::SwapPropertiesCommand(TreeEntry* entry, unsigned int index)
+    : UndoCommand(QObject::tr("Move property"))
+    , m_entry(entry)
+    , m_index(index)
+{}
+
+
+/**
+ * @copydoc UndoCommand::undo()
+ */
+void SwapPropertiesCommand::undo()
+{
+    m_entry->movePropertyOneUp(m_index);
+}
+
+
+/**
+ * @copydoc UndoCommand::redo()
+ */
+void SwapPropertiesCommand::redo()
+{
+    m_entry->movePropertyOneUp(m_index);
+}
+
+
+/**
+ * @copydoc UndoCommand::memorySize()
+ */
+size_t SwapPropertiesCommand::memorySize() const
+{
+    return sizeof(SwapPropertiesCommand);
+}
+
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * @class EditPropertyCommand
+ *
+ * @brief Command that changes the attributes of a Property.
+ *
+ * Only the attributes that have changed are stored. Hidden values are stored in a
+ * SecureString, so they stay in locked memory. Edits of the same property that follow each
+ * other within one second are merged, so undo doesn't revert single keystrokes. A merged
+ * command covers at most ten seconds of typing, so continuous typing doesn't end up in one
+ * command that cannot be undone step by step.
+ *
+ * @ingroup gui
+ * @author Bernhard Walle
+ */
+
+/**
+ * @brief Creates a new EditPropertyCommand.
+ *
+ * @param property the property
+ * @param newState the new attributes
+ */
+EditPropertyCommand::EditPropertyCommand(Property* property, const State& newState)
+    : UndoCommand(QObject::tr("Edit \"%1\"").arg(property->getKey()))
+    , m_property(property)
+    , m_changes(0)
+    , m_old(stateOf(property))
+    , m_new(newState)
+{
+    m_changes = diff(m_new);
+
+    // keep only the delta
+    if (!(m_changes & Property::KeyChanged))
+        m_old.key = m_new.key = QString::null;
+    if (!(m_changes & Property::ValueChanged))
+        m_old.value = m_new.value = PropertyValue();
+
+    m_firstEdit.start();
+    m_lastEdit = m_firstEdit;
+}
+
+
+/**
+ * @copydoc UndoCommand::undo()
+ */
+void EditPropertyCommand::undo()
+{
+    apply(m_old);
+}
+
+
+/**
+ * @copydoc UndoCommand::redo()
+ */
+void EditPropertyCommand::redo()
+{
+    apply(m_new);
+}
+
+
+/**
+ * @copydoc UndoCommand::mergeWith()
+ */
+bool EditPropertyCommand::mergeWith(const UndoCommand* other)
+{
+    const EditPropertyCommand* edit = dynamic_cast<const EditPropertyCommand*>(other);
+    if (!edit || edit->m_property != m_property || m_lastEdit.elapsed() > MERGE_INTERVAL ||
+            m_firstEdit.elapsed() > MERGE_MAX_DURATION)
+        return false;
+
+    if (edit->m_changes & Property::KeyChanged) {
+        if (!(m_changes & Property::KeyChanged))
+            m_old.key = edit->m_old.key;
+        m_new.key = edit->m_new.key;
+    }
+    if (edit->m_changes & Property::ValueChanged) {
+        if (!(m_changes & Property::ValueChanged))
+            m_old.value = edit->m_old.value;
+        m_new.value = edit->m_new.value;
+    }
+    m_new.type = edit->m_new.type;
+    m_new.hidden = edit->m_new.hidden;
+    m_new.encrypted = edit->m_new.encrypted;
+
+    m_changes |= edit->m_changes;
+    m_lastEdit.start();
+
+    return true;
+}
+
+
+/**
+ * @copydoc UndoCommand::isObsolete()
+ */
+bool EditPropertyCommand::isObsolete() const
+{
+    return m_changes == 0;
+}
+
+
+/**
+ * @copydoc UndoCommand::memorySize()
+ */
+size_t EditPropertyCommand::memorySize() const
+{
+    return sizeof(EditPropertyCommand) - 2 * sizeof(PropertyValue) +
+        (m_old.key.capacity() + m_new.key.capacity()) * sizeof(QChar) +
+        m_old.value.memorySize() + m_new.value.memorySize();
+}
+
+
+/**
+ * @brief Returns the current attributes of a property.
+ *
+ * @param property the property
+ * @return the attributes
+ */
+EditPropertyCommand::State EditPropertyCommand::stateOf(Property* property)
+{
+    State state;
+    state.key = property->getKey();
+    state.value = property->getPropertyValue();
+    state.type = property->getType();
+    state.hidden = property->isHidden();
+    state.encrypted = property->isEncrypted();
+    return state;
+}
+
+
+/**
+ * @brief Sets the changed attributes of the property.
+ *
+ * @param state the attributes
+ */
+void EditPropertyCommand::apply(const State& state)
+{
+    ChangeBatch batch;
+
+    m_property->setType(state.type);
+    m_property->setHidden(state.hidden);
+    m_property->setEncrypted(state.encrypted);
+    if (m_changes & Property::ValueChanged)
+        m_property->setPropertyValue(state.value);
+    if (m_changes & Property::KeyChanged)
+        m_property->setKey(state.key);
+}
+
+
+/**
+ * @brief Computes which attributes differ between the current state and @p newState.
+ *
+ * @param newState the new attributes
+ * @return a combination of Property::Change bits
+ */
+int EditPropertyCommand::diff(const State& newState) const
+{
+    int changes = 0;
+
+    if (m_old.key != newState.key)
+        changes |= Property::KeyChanged;
+    if (m_old.value != newState.value)
+        changes |= Property::ValueChanged;
+    if (m_old.type != newState.type)
+        changes |= Property::TypeChanged;
+    if (m_old.hidden != newState.hidden)
+        changes |= Property::HiddenChanged;
+    if (m_old.encrypted != newState.encrypted)
+        changes |= Property::EncryptedChanged;
+
+    return changes;
+}
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
@@ -0,0 +1,185 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#ifndef UNDOCOMMANDS_H
+#define UNDOCOMMANDS_H
+
+#include <QString>
+#include <QTime>
+
+#include "undostack.h"
+#include "property.h"
+
+class Q3ListView;
+class TreeEntry;
+
+class EntryCommand : public UndoCommand
+{
+    public:
+        EntryCommand(const QString& text, TreeEntry* entry, bool attached);
+        ~EntryCommand();
+
+        size_t memorySize() const;
+
+    protected:
+        void attach();
+        void detach();
+
+    private:
+        Q3ListView  *m_view;
+        TreeEntry   *m_parent;
+        TreeEntry   *m_entry;
+        bool        m_detached;
+        size_t      m_subtreeSize;
+};
+
+class InsertEntryCommand : public EntryCommand
+{
+    public:
+        InsertEntryCommand(TreeEntry* entry);
+
+        void undo();
+        void redo();
+};
+
+class RemoveEntryCommand : public EntryCommand
+{
+    public:
+        RemoveEntryCommand(TreeEntry* entry);
+
+        void undo();
+        void redo();
+};
+
+class RenameEntryCommand : public UndoCommand
+{
+    public:
+        RenameEntryCommand(TreeEntry* entry, const QString& oldName, const QString& newName);
+
+        void undo();
+        void redo();
+        size_t memorySize() const;
+
+    private:
+        TreeEntry   *m_entry;
+        QString     m_oldName;
+        QString     m_newName;
+};
+
+class MoveEntryCommand : public UndoCommand
+{
+    public:
+        MoveEntryCommand(TreeEntry* entry, TreeEntry* newParent);
+
+        void undo();
+        void redo();
+        bool isObsolete() const;
+        size_t memorySize() const;
+
+    private:
+        TreeEntry   *m_entry;
+        TreeEntry   *m_oldParent;
+        TreeEntry   *m_newParent;
+};
+
+class PropertyCommand : public UndoCommand
+{
+    public:
+        PropertyCommand(const QString& text, TreeEntry* entry, unsigned int index,
+            Property* property);
+        ~PropertyCommand();
+
+        size_t memorySize() const;
+
+    protected:
+        void attach();
+        void detach();
+
+    private:
+        TreeEntry       *m_entry;
+        unsigned int    m_index;
+        Property        *m_property;
+};
+
+class InsertPropertyCommand : public PropertyCommand
+{
+    public:
+        InsertPropertyCommand(TreeEntry* entry, Property* property);
+
+        void undo();
+        void redo();
+};
+
+class RemovePropertyCommand : public PropertyCommand
+{
+    public:
+        RemovePropertyCommand(TreeEntry* entry, unsigned int index);
+
+        void undo();
+        void redo();
+};
+
+class SwapPropertiesCommand : public UndoCommand
+{
+    public:
+        SwapPropertiesCommand(TreeEntry* entry, unsigned int index);
+
+        void undo();
+        void redo();
+        size_t memorySize() const;
+
+    private:
+        TreeEntry       *m_entry;
+        unsigned int    m_index;
+};
+
+class EditPropertyCommand : public UndoCommand
+{
+    public:
+        struct State {
+            QString         key;
+            PropertyValue   value;
+            Property::Type  type;
+            bool            hidden;
+            bool            encrypted;
+        };
+
+    public:
+        EditPropertyCommand(Property* property, const State& newState);
+
+        void undo();
+        void redo();
+        bool mergeWith(const UndoCommand* other);
+        bool isObsolete() const;
+        size_t memorySize() const;
+
+    public:
+        static State stateOf(Property* property);
+
+    private:
+        void apply(const State& state);
+        int diff(const State& newState) const;
+
+    private:
+        Property    *m_property;
+        int         m_changes;
+        State       m_old;
+        State       m_new;
+        QTime       m_firstEdit;
+        QTime       m_lastEdit;
+};
+
+#endif // UNDOCOMMANDS_H
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
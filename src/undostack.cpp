@@ -0,0 +1,395 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#include "global.h"
+#include "undostack.h"
+
+/**
+ * @class UndoCommand
+ *
+ * @brief Base class for all changes of the data that can be undone.
+ *
+ * A command stores only the delta that is needed to go back and forth, not a snapshot of
+ * the data. Objects that are removed from the tree are not deleted but owned by the command
+ * until the command itself is deleted.
+ *
+ * @ingroup gui
+ * @author Bernhard Walle
+ */
+
+/**
+ * @fn UndoCommand::undo()
+ *
+ * @brief Reverts the change.
+ */
+
+/**
+ * @fn UndoCommand::redo()
+ *
+ * @brief Applies the change. This is called when the command is pushed on the UndoStack.
+ */
+
+/**
+ * @brief Creates a new command.
+ *
+ * @param text the text that is displayed in the menu, e.g. <i>Delete item</i>
+ */
+UndoCommand::UndoCommand(const QString& text)
+    : m_text(text)
+{}
+
+
+/**
+ * @brief Deletes the command.
+ */
+UndoCommand::~UndoCommand()
+{}
+
+
+/**
+ * @brief Returns the text of the command.
+ *
+ * @return the text
+ */
+QString UndoCommand::text() const
+{
+    return m_text;
+}
+
+
+/**
+ * @brief Merges a command that has been executed directly after this command into this one.
+ *
+ * This is used to coalesce keystroke-level edits to one undo step. The default
+ * implementation doesn't merge anything.
+ *
+ * @param other the newer command, it has already been executed
+ * @return @c true if @p other was merged and can be deleted, @c false otherwise
+ */
+bool UndoCommand::mergeWith(const UndoCommand* other)
+{
+    UNUSED(other);
+    return false;
+}
+
+
+/**
+ * @brief Checks if the command doesn't change anything.
+ *
+ * Obsolete commands are not recorded by the UndoStack.
+ *
+ * @return @c false in the default implementation
+ */
+bool UndoCommand::isObsolete() const
+{
+    return false;
+}
+
+
+/**
+ * @brief Returns the memory that is held by the command.
+ *
+ * This is an estimation that is used for the memory limit of the UndoStack. Subclasses that
+ * hold more than their own members must add that.
+ *
+ * @return the size in bytes
+ */
+size_t UndoCommand::memorySize() const
+{
+    return sizeof(UndoCommand) + m_text.size() * sizeof(QChar);
+}
+
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * @class UndoStack
+ *
+ * @brief Stack of UndoCommand objects.
+ *
+ * The commands are stored in a ring buffer of fixed size. If the buffer is full or if the
+ * commands use more memory than allowed, the oldest commands are deleted. So the history
+ * is bounded for long sessions and each operation is O(1) (amortised, since each command is
+ * deleted exactly once).
+ *
+ * The commands <tt>[0, m_index)</tt> can be undone, the commands <tt>[m_index, m_count)</tt>
+ * can be redone. Pushing a new command deletes the commands that could be redone.
+ *
+ * @ingroup gui
+ * @author Bernhard Walle
+ */
+
+/**
+ * @fn UndoStack::changed()
+ *
+ * @brief Emitted if the result of canUndo(), canRedo(), undoText() or redoText() may have
+ *        changed.
+ */
+
+/**
+ * @brief Creates a new UndoStack.
+ *
+ * @param parent the parent object
+ * @param capacity the maximum number of commands, must be positive
+ * @param memoryLimit the maximum memory that the commands may use (see
+ *        UndoCommand::memorySize()), the most recent command is always kept
+ */
+UndoStack::UndoStack(QObject* parent, int capacity, size_t memoryLimit)
+    : QObject(parent)
+    , m_ring(capacity, 0)
+    , m_first(0)
+    , m_count(0)
+    , m_index(0)
+    , m_memoryUsage(0)
+    , m_memoryLimit(memoryLimit)
+    , m_replaying(false)
+{
+    Q_ASSERT(capacity > 0);
+}
+
+
+/**
+ * @brief Deletes the stack and all commands.
+ */
+UndoStack::~UndoStack()
+{
+    clear();
+}
+
+
+/**
+ * @brief Executes @p command and puts it on the stack.
+ *
+ * The stack takes the ownership of @p command. If the command can be merged with the last
+ * one or if it doesn't change anything, it's deleted immediately.
+ *
+ * Commands pushed while an undo or redo is in progress are only executed because they are
+ * part of the command that is replayed.
+ *
+ * @param command the command
+ */
+void UndoStack::push(UndoCommand* command)
+{
+    command->redo();
+
+    if (m_replaying || command->isObsolete()) {
+        delete command;
+        return;
+    }
+
+    dropRedo();
+
+    if (m_index > 0) {
+        UndoCommand* top = at(m_index - 1);
+        size_t oldSize = top->memorySize();
+        if (top->mergeWith(command)) {
+            delete command;
+            m_memoryUsage = m_memoryUsage - oldSize + top->memorySize();
+            emit changed();
+            return;
+        }
+    }
+
+    if (m_count == m_ring.size())
+        dropOldest();
+
+    at(m_count++) = command;
+    m_index = m_count;
+    m_memoryUsage += command->memorySize();
+
+    while (m_memoryUsage > m_memoryLimit && m_count > 1)
+        dropOldest();
+
+    emit changed();
+}
+
+
+/**
+ * @brief Checks if there's something to undo.
+ *
+ * @return @c true if undo() does something, @c false otherwise
+ */
+bool UndoStack::canUndo() const
+{
+    return m_index > 0;
+}
+
+
+/**
+ * @brief Checks if there's something to redo.
+ *
+ * @return @c true if redo() does something, @c false otherwise
+ */
+bool UndoStack::canRedo() const
+{
+    return m_index < m_count;
+}
+
+
+/**
+ * @brief Returns the text of the command that would be undone.
+ *
+ * @return the text or an empty string if there's nothing to undo
+ */
+QString UndoStack::undoText() const
+{
+    return canUndo() ? at(m_index - 1)->text() : QString();
+}
+
+
+/**
+ * @brief Returns the text of the command that would be redone.
+ *
+ * @return the text or an empty string if there's nothing to redo
+ */
+QString UndoStack::redoText() const
+{
+    return canRedo() ? at(m_index)->text() : QString();
+}
+
+
+/**
+ * @brief Returns the number of commands on the stack (undo and redo).
+ *
+ * @return the number of commands
+ */
+int UndoStack::count() const
+{
+    return m_count;
+}
+
+
+/**
+ * @brief Returns the estimated memory that all commands use.
+ *
+ * @return the memory usage in bytes
+ */
+size_t UndoStack::memoryUsage() const
+{
+    return m_memoryUsage;
+}
+
+
+/**
+ * @brief Reverts the last command.
+ */
+void UndoStack::undo()
+{
+    if (!canUndo())
+        return;
+
+    m_replaying = true;
+    at(--m_index)->undo();
+    m_replaying = false;
+
+    emit changed();
+}
+
+
+/**
+ * @brief Applies the last command that was undone again.
+ */
+void UndoStack::redo()
+{
+    if (!canRedo())
+        return;
+
+    m_replaying = true;
+    at(m_index++)->redo();
+    m_replaying = false;
+
+    emit changed();
+}
+
+
+/**
+ * @brief Deletes all commands.
+ *
+ * Must be called if the data is replaced without using commands, e.g. on logout.
+ */
+void UndoStack::clear()
+{
+    if (m_count == 0)
+        return;
+
+    for (int i = 0; i < m_count; ++i) {
+        delete at(i);
+        at(i) = 0;
+    }
+
+    m_first = 0;
+    m_count = 0;
+    m_index = 0;
+    m_memoryUsage = 0;
+
+    emit changed();
+}
+
+
+/**
+ * @brief Returns the command at the logical position @p index.
+ *
+ * @param index the index where 0 is the oldest command
+ * @return a reference to the slot in the ring buffer
+ */
+UndoCommand*& UndoStack::at(int index)
+{
+    return m_ring[(m_first + index) % m_ring.size()];
+}
+
+
+/**
+ * @brief Returns the command at the logical position @p index.
+ *
+ * @param index the index where 0 is the oldest command
+ * @return the command
+ */
+UndoCommand* UndoStack::at(int index) const
+{
+    return m_ring[(m_first + index) % m_ring.size()];
+}
+
+
+/**
+ * @brief Deletes the oldest command.
+ */
+void UndoStack::dropOldest()
+{
+    Q_ASSERT(m_count > 0);
+
+    UndoCommand*& oldest = at(0);
+    m_memoryUsage -= oldest->memorySize();
+    delete oldest;
+    oldest = 0;
+
+    m_first = (m_first + 1) % m_ring.size();
+    --m_count;
+    if (m_index > 0)
+        --m_index;
+}
+
+
+/**
+ * @brief Deletes all commands that could be redone.
+ */
+void UndoStack::dropRedo()
+{
+    while (m_count > m_index) {
+        UndoCommand*& newest = at(--m_count);
+        m_memoryUsage -= newest->memorySize();
+        delete newest;
+        newest = 0;
+    }
+}
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
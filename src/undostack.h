@@ -0,0 +1,94 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#ifndef UNDOSTACK_H
+#define UNDOSTACK_H
+
+#include <cstddef>
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+class UndoCommand
+{
+    public:
+        UndoCommand(const QString& text);
+        virtual ~UndoCommand();
+
+        QString text() const;
+
+        virtual void undo() = 0;
+        virtual void redo() = 0;
+        virtual bool mergeWith(const UndoCommand* other);
+        virtual bool isObsolete() const;
+        virtual size_t memorySize() const;
+
+    private:
+        QString m_text;
+
+    private:
+        UndoCommand(const UndoCommand&);
+        UndoCommand& operator=(const UndoCommand&);
+};
+
+class UndoStack : public QObject
+{
+    Q_OBJECT
+
+    public:
+        UndoStack(QObject* parent = 0, int capacity = 256, size_t memoryLimit = 1024*1024);
+        ~UndoStack();
+
+        void push(UndoCommand* command);
+
+        bool canUndo() const;
+        bool canRedo() const;
+        QString undoText() const;
+        QString redoText() const;
+
+        int count() const;
+        size_t memoryUsage() const;
+
+    public slots:
+        void undo();
+        void redo();
+        void clear();
+
+    signals:
+        void changed();
+
+    private:
+        UndoCommand*& at(int index);
+        UndoCommand* at(int index) const;
+        void dropOldest();
+        void dropRedo();
+
+    private:
+        QVector<UndoCommand*>   m_ring;
+        int                     m_first;
+        int                     m_count;
+        int                     m_index;
+        size_t                  m_memoryUsage;
+        size_t                  m_memoryLimit;
+        bool                    m_replaying;
+
+    private:
+        UndoStack(const UndoStack&);
+        UndoStack& operator=(const UndoStack&);
+};
+
+#endif // UNDOSTACK_H
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
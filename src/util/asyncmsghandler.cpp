@@ -0,0 +1,410 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#include <QDateTime>
+
+#include "asyncmsghandler.h"
+#include "debug.h"
+
+/**
+ * @brief The maximum number of messages that are written before the sink is flushed
+ */
+static const int WRITER_BATCH_SIZE = 256;
+
+/**
+ * @brief The time flush() waits before it checks again whether the writer is still running
+ */
+static const int FLUSH_RECHECK_MSECS = 100;
+
+
+/**
+ * @class AsyncMsgHandler
+ *
+ * @brief Message handler that writes the messages in a separate thread
+ *
+ * The messages are put in a ring buffer with a fixed capacity and written by
+ * a writer thread to another message handler, the sink. The threads that log
+ * never wait for the sink and don't lock a mutex to put a message into the
+ * ring buffer: that's the bounded multi-producer/single-consumer queue of
+ * Dmitry Vyukov, each cell has a sequence number that tells whether it may be
+ * written or read.
+ *
+ * The writer thread is the only thread that reads the ring buffer. It writes
+ * up to 256 messages, then it flushes the sink once. If the ring buffer is
+ * empty, it sleeps on a wait condition. Only the logging thread that finds
+ * the writer sleeping wakes it up, so the wait condition costs nothing while
+ * the writer is busy.
+ *
+ * If the ring buffer is full, the policy decides: with DropMessage, the message
+ * is dropped and counted, the writer thread reports the number of dropped
+ * messages later. With Wait, the logging thread waits until there's space.
+ * Critical and fatal messages are never dropped, and the thread that logs a
+ * fatal message waits with flush() until it has been written since the
+ * application terminates after it.
+ *
+ * In the application, don't use that class directly. Instead, use
+ * QpamatDebug::setAsynchronous().
+ *
+ * @author Bernhard Walle <bernhard@bwalle.de>
+ * @ingroup misc
+ */
+
+/**
+ * @enum AsyncMsgHandler::OverflowPolicy
+ *
+ * @brief What happens to a message if the ring buffer is full.
+ */
+
+/**
+ * @var AsyncMsgHandler::OverflowPolicy AsyncMsgHandler::DropMessage
+ * The message is dropped, see droppedMessages().
+ */
+
+/**
+ * @var AsyncMsgHandler::OverflowPolicy AsyncMsgHandler::Wait
+ * The logging thread waits until the writer thread made space.
+ */
+
+
+/**
+ * @brief Constructor
+ *
+ * Creates a new instance of AsyncMsgHandler. The writer thread is started in
+ * open().
+ *
+ * @param[in] sink the message handler that writes the messages, the
+ *            AsyncMsgHandler takes the ownership
+ * @param[in] capacity the number of messages in the ring buffer, rounded up to
+ *            a power of two
+ * @param[in] policy what happens if the ring buffer is full
+ */
+AsyncMsgHandler::AsyncMsgHandler(MsgHandler *sink, int capacity, OverflowPolicy policy)
+    : m_sink(sink)
+    , m_cells(NULL)
+    , m_mask(0)
+    , m_policy(policy)
+    , m_enqueuePos(0)
+    , m_dequeuePos(0)
+    , m_written(0)
+    , m_dropped(0)
+    , m_reportedDrops(0)
+    , m_stop(0)
+    , m_idle(0)
+    , m_writer(this)
+{
+    int size = 2;
+    while (size < capacity) {
+        size *= 2;
+    }
+
+    m_cells = new Cell[size];
+    m_mask = size - 1;
+    for (int i = 0; i < size; ++i) {
+        m_cells[i].sequence = i;
+    }
+}
+
+
+/**
+ * @brief Destructor
+ *
+ * Stops the writer thread, which writes the remaining messages before, and
+ * deletes the sink.
+ */
+AsyncMsgHandler::~AsyncMsgHandler()
+{
+    m_stop.fetchAndStoreOrdered(1);
+    wakeWriter(true);
+    m_writer.wait();
+
+    // only if open() has not been called, nobody else can read the ring buffer now
+    while (drain(WRITER_BATCH_SIZE) > 0)
+        ;
+
+    delete[] m_cells;
+    delete m_sink;
+}
+
+
+/**
+ * @brief Opens the sink and starts the writer thread.
+ *
+ * @return @c true if the sink was opened, @c false otherwise.
+ */
+bool AsyncMsgHandler::open()
+{
+    if (!m_sink->open()) {
+        return false;
+    }
+
+    m_writer.start(QThread::LowPriority);
+    return true;
+}
+
+
+/**
+ * @brief Puts the message in the ring buffer.
+ *
+ * This function may be called from any thread at the same time.
+ *
+ * @param[in] type the severity of the message handler
+ * @param[in] context the function name and/or line number from where the
+ *            message has been printed
+ * @param[in] date the date (already formatted)
+ * @param[in] component the component of the message handler
+ * @param[in] msg the real message
+ */
+void AsyncMsgHandler::output(QtMsgType       type,
+                             const QString   &context,
+                             const QString   &date,
+                             const QString   &component,
+                             const QString   &msg)
+{
+    Record record;
+    record.type = type;
+    record.context = context;
+    record.date = date;
+    record.component = component;
+    record.msg = msg;
+
+    bool wait = m_policy == Wait || type == QtCriticalMsg || type == QtFatalMsg;
+    while (!enqueue(record)) {
+        if (!wait || !m_writer.isRunning()) {
+            m_dropped.fetchAndAddRelaxed(1);
+            wakeWriter();
+            return;
+        }
+        wakeWriter();
+        QThread::yieldCurrentThread();
+    }
+    wakeWriter();
+
+    if (type == QtFatalMsg) {
+        flush();
+    }
+}
+
+
+/**
+ * @brief Waits until all messages have been written.
+ *
+ * All messages that have been put in the ring buffer before the call are
+ * written by the writer thread and the sink has been flushed when the
+ * function returns. If the writer thread is not running, the function
+ * returns immediately, the messages are written by the destructor then.
+ */
+void AsyncMsgHandler::flush()
+{
+    const unsigned int target = int(m_enqueuePos);
+
+    QMutexLocker locker(&m_flushMutex);
+    while (m_writer.isRunning() &&
+            int(unsigned(m_written.fetchAndAddAcquire(0)) - target) < 0) {
+        wakeWriter(true);
+        m_flushed.wait(&m_flushMutex, FLUSH_RECHECK_MSECS);
+    }
+}
+
+
+/**
+ * @brief Returns @c true
+ *
+ * The logging threads don't share any data besides the ring buffer.
+ *
+ * @return @c true
+ */
+bool AsyncMsgHandler::isThreadSafe() const
+{
+    return true;
+}
+
+
+/**
+ * @brief Returns the number of messages that have been dropped
+ *
+ * @return the number of messages that have been dropped because the ring
+ *         buffer was full
+ */
+int AsyncMsgHandler::droppedMessages() const
+{
+    return m_dropped;
+}
+
+
+/**
+ * @brief Puts a record in the ring buffer
+ *
+ * @param[in] record the record
+ * @return @c true on success, @c false if the ring buffer is full
+ */
+bool AsyncMsgHandler::enqueue(const Record &record)
+{
+    Cell *cell;
+    int pos = m_enqueuePos;
+
+    for (;;) {
+        cell = &m_cells[pos & m_mask];
+        int seq = cell->sequence.fetchAndAddAcquire(0);
+        int diff = int(unsigned(seq) - unsigned(pos));
+
+        if (diff == 0) {
+            // the cell is free, reserve it
+            if (m_enqueuePos.testAndSetRelaxed(pos, int(unsigned(pos) + 1))) {
+                break;
+            }
+        } else if (diff < 0) {
+            // the writer thread has not read the cell of the last round
+            return false;
+        }
+        pos = m_enqueuePos;
+    }
+
+    cell->record = record;
+    cell->sequence.fetchAndStoreRelease(int(unsigned(pos) + 1));
+    return true;
+}
+
+
+/**
+ * @brief Writes messages from the ring buffer to the sink
+ *
+ * Must only be called from one thread at a time, normally the writer thread.
+ *
+ * @param[in] max the maximum number of messages
+ * @return the number of messages that have been written
+ */
+int AsyncMsgHandler::drain(int max)
+{
+    int count = 0;
+
+    while (count < max) {
+        Cell *cell = &m_cells[m_dequeuePos & m_mask];
+        int seq = cell->sequence.fetchAndAddAcquire(0);
+        if (int(unsigned(seq) - (unsigned(m_dequeuePos) + 1)) < 0) {
+            break;
+        }
+
+        Record record = cell->record;
+        cell->record = Record();
+        cell->sequence.fetchAndStoreRelease(int(unsigned(m_dequeuePos) + m_mask + 1));
+        m_dequeuePos = int(unsigned(m_dequeuePos) + 1);
+
+        m_sink->output(record.type, record.context, record.date, record.component, record.msg);
+        ++count;
+    }
+
+    bool reported = false;
+    int dropped = m_dropped;
+    if (dropped != m_reportedDrops) {
+        m_sink->output(QtWarningMsg, QString::null,
+                       QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss"),
+                       DEFAULT_COMPONENT,
+                       QString("%1 messages have been dropped").arg(dropped - m_reportedDrops));
+        m_reportedDrops = dropped;
+        reported = true;
+    }
+
+    if (count > 0 || reported) {
+        m_sink->flush();
+    }
+
+    if (count > 0) {
+        m_written.fetchAndAddRelease(count);
+
+        QMutexLocker locker(&m_flushMutex);
+        m_flushed.wakeAll();
+    }
+
+    return count;
+}
+
+
+/**
+ * @brief Checks if the next cell of the ring buffer contains a message
+ *
+ * Must only be called by the thread that calls drain().
+ *
+ * @return @c true if drain() would write a message, @c false otherwise
+ */
+bool AsyncMsgHandler::hasMessages()
+{
+    Cell *cell = &m_cells[m_dequeuePos & m_mask];
+    int seq = cell->sequence.fetchAndAddAcquire(0);
+    return int(unsigned(seq) - (unsigned(m_dequeuePos) + 1)) >= 0;
+}
+
+
+/**
+ * @brief Lets the writer thread sleep until there's a message or it's stopped
+ *
+ * The idle flag is set before the ring buffer is checked again, and the
+ * logging threads check the flag after they have put their message into the
+ * ring buffer. So either the writer sees the message or the logging thread
+ * sees the flag and wakes the writer.
+ */
+void AsyncMsgHandler::waitForMessages()
+{
+    QMutexLocker locker(&m_wakeMutex);
+    m_idle.fetchAndStoreOrdered(1);
+    if (!m_stop && !hasMessages() && m_dropped == m_reportedDrops) {
+        m_wakeup.wait(&m_wakeMutex);
+    }
+    m_idle.fetchAndStoreOrdered(0);
+}
+
+
+/**
+ * @brief Wakes the writer thread if it's sleeping
+ *
+ * Without @p force, nothing is locked if the writer thread is busy, and only
+ * one of the logging threads that find it sleeping wakes it up.
+ *
+ * @param[in] force @c true if the writer should be woken up even if it has
+ *            not been marked as idle yet, e.g. to stop it
+ */
+void AsyncMsgHandler::wakeWriter(bool force)
+{
+    if (m_idle.testAndSetOrdered(1, 0) || force) {
+        QMutexLocker locker(&m_wakeMutex);
+        m_wakeup.wakeOne();
+    }
+}
+
+
+/**
+ * @brief Constructor of the writer thread
+ *
+ * @param[in] handler the handler whose ring buffer is written
+ */
+AsyncMsgHandler::WriterThread::WriterThread(AsyncMsgHandler *handler)
+    : m_handler(handler)
+{}
+
+
+/**
+ * @brief Writes the messages until the handler is deleted
+ */
+void AsyncMsgHandler::WriterThread::run()
+{
+    while (!m_handler->m_stop) {
+        if (m_handler->drain(WRITER_BATCH_SIZE) == 0) {
+            m_handler->waitForMessages();
+        }
+    }
+
+    while (m_handler->drain(WRITER_BATCH_SIZE) > 0)
+        ;
+}
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
@@ -0,0 +1,109 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#ifndef ASYNCMSGHANDLER_H
+#define ASYNCMSGHANDLER_H
+
+#include <QString>
+#include <QThread>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include "msghandler.h"
+
+class AsyncMsgHandler : public MsgHandler
+{
+    public:
+        enum OverflowPolicy {
+            DropMessage,
+            Wait
+        };
+
+    public:
+        AsyncMsgHandler(MsgHandler *sink, int capacity = 1024,
+                        OverflowPolicy policy = DropMessage);
+        ~AsyncMsgHandler();
+
+    public:
+        bool open();
+        void output(QtMsgType       type,
+                    const QString   &context,
+                    const QString   &date,
+                    const QString   &component,
+                    const QString   &msg);
+        void flush();
+        bool isThreadSafe() const;
+
+        int droppedMessages() const;
+
+    private:
+        struct Record {
+            QtMsgType   type;
+            QString     context;
+            QString     date;
+            QString     component;
+            QString     msg;
+        };
+
+        struct Cell {
+            QAtomicInt  sequence;
+            Record      record;
+        };
+
+        class WriterThread : public QThread
+        {
+            public:
+                WriterThread(AsyncMsgHandler *handler);
+
+            protected:
+                void run();
+
+            private:
+                AsyncMsgHandler *m_handler;
+        };
+
+    private:
+        bool enqueue(const Record &record);
+        int drain(int max);
+        bool hasMessages();
+        void waitForMessages();
+        void wakeWriter(bool force = false);
+
+    private:
+        MsgHandler      *m_sink;
+        Cell            *m_cells;
+        int             m_mask;
+        OverflowPolicy  m_policy;
+        QAtomicInt      m_enqueuePos;
+        int             m_dequeuePos;
+        QAtomicInt      m_written;
+        QAtomicInt      m_dropped;
+        int             m_reportedDrops;
+        QAtomicInt      m_stop;
+        QAtomicInt      m_idle;
+        QMutex          m_wakeMutex;
+        QWaitCondition  m_wakeup;
+        QMutex          m_flushMutex;
+        QWaitCondition  m_flushed;
+        WriterThread    m_writer;
+
+    private:
+        AsyncMsgHandler(const AsyncMsgHandler&);
+        AsyncMsgHandler& operator=(const AsyncMsgHandler&);
+};
+
+#endif // ASYNCMSGHANDLER_H
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
@@ -0,0 +1,864 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#include <cstring>
+#include <climits>
+
+#include <QDateTime>
+
+#include "binarylog.h"
+#include "platformhelpers.h"
+#include "debug.h"
+
+/**
+ * @brief The magic bytes at the beginning of the file
+ */
+static const char BINARY_LOG_MAGIC[] = "QPBLOG01";
+
+/**
+ * @brief Marks the byte order of the writer
+ */
+static const quint16 BINARY_LOG_BYTE_ORDER = 0x0102;
+
+/**
+ * @brief The size of the header
+ */
+static const int BINARY_LOG_HEADER_SIZE = 16;
+
+/**
+ * @brief The file is extended and mapped in chunks of this size
+ */
+static const qint64 BINARY_LOG_CHUNK_SIZE = 1024 * 1024;
+
+/**
+ * @brief The alignment of the mapped chunks, the allocation granularity of Windows
+ */
+static const qint64 BINARY_LOG_MAP_ALIGNMENT = 64 * 1024;
+
+/**
+ * @brief The kinds of records
+ */
+enum RecordKind {
+    RecordEnd       = 0,
+    RecordSession   = 1,
+    RecordComponent = 2,
+    RecordFormat    = 3,
+    RecordMessage   = 4
+};
+
+/* LogArg {{{ */
+
+/**
+ * @class LogArg
+ *
+ * @brief An argument of QpamatDebug::log()
+ *
+ * The argument is stored as it is, it's not converted to a string. A string
+ * literal is only stored as pointer, so it must not be a temporary buffer.
+ *
+ * @author Bernhard Walle <bernhard@bwalle.de>
+ * @ingroup misc
+ */
+
+/**
+ * @brief Creates an integer argument
+ *
+ * @param[in] value the value
+ */
+LogArg::LogArg(int value)
+    : m_type(Integer)
+{
+    m_value.integer = value;
+}
+
+/**
+ * @brief Creates an integer argument
+ *
+ * @param[in] value the value
+ */
+LogArg::LogArg(qint64 value)
+    : m_type(Integer)
+{
+    m_value.integer = value;
+}
+
+/**
+ * @brief Creates a floating point argument
+ *
+ * @param[in] value the value
+ */
+LogArg::LogArg(double value)
+    : m_type(Double)
+{
+    m_value.real = value;
+}
+
+/**
+ * @brief Creates an argument from a string literal
+ *
+ * @param[in] value the string in Latin1, only the pointer is stored
+ */
+LogArg::LogArg(const char *value)
+    : m_type(Latin1)
+{
+    m_value.latin1 = value;
+}
+
+/**
+ * @brief Creates a string argument
+ *
+ * @param[in] value the value, it's shared and not copied
+ */
+LogArg::LogArg(const QString &value)
+    : m_type(String)
+    , m_string(value)
+{
+    m_value.integer = 0;
+}
+
+/**
+ * @brief Returns the type
+ *
+ * @return the type
+ */
+LogArg::Type LogArg::type() const
+{
+    return m_type;
+}
+
+/**
+ * @brief Returns the value of an integer argument
+ *
+ * @return the value
+ */
+qint64 LogArg::toInteger() const
+{
+    return m_value.integer;
+}
+
+/**
+ * @brief Returns the value of a floating point argument
+ *
+ * @return the value
+ */
+double LogArg::toDouble() const
+{
+    return m_value.real;
+}
+
+/**
+ * @brief Returns the value of an argument that has been created from a literal
+ *
+ * @return the value
+ */
+const char *LogArg::toLatin1() const
+{
+    return m_value.latin1;
+}
+
+/**
+ * @brief Converts the argument to a string
+ *
+ * @return the value as string
+ */
+QString LogArg::toString() const
+{
+    switch (m_type) {
+        case Integer:
+            return QString::number(m_value.integer);
+        case Double:
+            return QString::number(m_value.real);
+        case Latin1:
+            return QString::fromLatin1(m_value.latin1);
+        default:
+            return m_string;
+    }
+}
+
+/* }}} */
+/* BinaryMsgHandler {{{ */
+
+/**
+ * @class BinaryMsgHandler
+ *
+ * @brief Message handler that writes compact binary records
+ *
+ * Nothing is formatted when a message is logged with QpamatDebug::log(): the
+ * record contains the time as integer, the component and the format as IDs and
+ * the arguments in binary form. The component and the format are string
+ * literals, they are looked up by their address and written only once per
+ * session as definition record. Messages from qDebug() and friends are written
+ * with the format <tt>"%1"</tt>.
+ *
+ * The file is extended in chunks of 1 MiB which are memory mapped, so writing a
+ * record is only a copy. When the handler is deleted, the file is truncated to
+ * the records and the end is stored in the header. New records are appended to
+ * an existing file at that position. Only if the file has not been closed
+ * properly, the records have to be scanned to find the end. The file can be
+ * converted to text with <tt>qpamat-logdecode</tt>, see BinaryLogReader.
+ *
+ * The format, all numbers in the byte order of the writer:
+ *
+ *  - header: <tt>"QPBLOG01"</tt>, the byte order mark @c 0x0102 as 16 bit
+ *    integer, the version 1 as 16 bit integer and the end of the records as
+ *    32 bit integer, which is 0 while the file is written
+ *  - records, each starting with one byte for the kind:
+ *     - 0: end of the file, the rest of the chunk is zero
+ *     - 1, session: 64 bit time in microseconds since 1970, IDs start again
+ *     - 2, component: 16 bit ID, string
+ *     - 3, format: 16 bit ID, string
+ *     - 4, message: 8 bit QtMsgType, 64 bit time, 16 bit component ID,
+ *       16 bit format ID, 8 bit number of arguments, arguments
+ *  - string: 16 bit length, UTF-8 bytes
+ *  - argument: 8 bit LogArg::Type, then a 64 bit integer, a @c double or a
+ *    string
+ *
+ * The handler is not thread-safe, QpamatDebug serializes the calls.
+ *
+ * In the application, don't use that class directly. Instead, use
+ * QpamatDebug::redirectBinaryFile().
+ *
+ * @author Bernhard Walle <bernhard@bwalle.de>
+ * @ingroup misc
+ */
+
+
+/**
+ * @brief Constructor
+ *
+ * Creates a new instance of BinaryMsgHandler.
+ *
+ * @param[in] filename the name of the file
+ */
+BinaryMsgHandler::BinaryMsgHandler(const QString &filename)
+    : m_file(filename)
+    , m_map(NULL)
+    , m_mapOffset(0)
+    , m_mapSize(0)
+    , m_pos(0)
+    , m_nextComponent(0)
+    , m_nextFormat(0)
+{}
+
+
+/**
+ * @brief Destructor
+ *
+ * Truncates the file to the records and stores their end in the header.
+ */
+BinaryMsgHandler::~BinaryMsgHandler()
+{
+    if (m_map) {
+        m_file.unmap(m_map);
+    }
+    if (m_file.isOpen()) {
+        m_file.resize(m_pos);
+        if (m_pos <= qint64(0xffffffff)) {
+            writeEnd(quint32(m_pos));
+        }
+        m_file.close();
+    }
+}
+
+
+/// @copydoc MsgHandler::open()
+bool BinaryMsgHandler::open()
+{
+    const bool exists = m_file.exists() && m_file.size() > 0;
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        return false;
+    }
+
+    // find the end of the records of an existing file
+    if (exists) {
+        m_pos = findEnd();
+        if (m_pos < 0) {
+            m_pos = 0;
+            m_file.close();
+            return false;
+        }
+
+        // the end is only valid again when the file is closed
+        if (!writeEnd(0)) {
+            m_file.close();
+            return false;
+        }
+    }
+
+    if (m_pos == 0) {
+        char header[BINARY_LOG_HEADER_SIZE];
+        std::memset(header, 0, sizeof(header));
+        std::memcpy(header, BINARY_LOG_MAGIC, 8);
+        const quint16 version = 1;
+        std::memcpy(header + 8, &BINARY_LOG_BYTE_ORDER, 2);
+        std::memcpy(header + 10, &version, 2);
+        write(header, sizeof(header));
+    }
+
+    const quint8 kind = RecordSession;
+    const qint64 time = PlatformHelpers::currentMicroseconds();
+    write(&kind, 1);
+    write(&time, 8);
+
+    return m_map != NULL;
+}
+
+
+/// @copydoc MsgHandler::output()
+void BinaryMsgHandler::output(QtMsgType       type,
+                              const QString   &context,
+                              const QString   &date,
+                              const QString   &component,
+                              const QString   &msg)
+{
+    Q_UNUSED(date);
+
+    quint16 componentNumber = componentId(component);
+    if (context.isNull()) {
+        quint16 format = formatId("%1");
+        writeMessageHeader(type, componentNumber, format, 1);
+    } else {
+        quint16 format = formatId("%1 ||| %2");
+        writeMessageHeader(type, componentNumber, format, 2);
+        writeArg(context);
+    }
+    writeArg(msg);
+}
+
+
+/// @copydoc MsgHandler::outputRecord()
+bool BinaryMsgHandler::outputRecord(QtMsgType     type,
+                                    const char    *component,
+                                    const char    *format,
+                                    const LogArg  *args,
+                                    int           argCount)
+{
+    quint16 componentNumber = componentId(component);
+    quint16 formatNumber = formatId(format);
+
+    writeMessageHeader(type, componentNumber, formatNumber, argCount);
+    for (int i = 0; i < argCount; ++i) {
+        writeArg(args[i]);
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief Returns the end of the records of the file that has been opened
+ *
+ * That's the end in the header if the file has been closed properly and has
+ * not been changed since. Otherwise, the records are read up to the first one
+ * that is incomplete.
+ *
+ * @return the offset, or -1 if the file is not a binary log in the byte order
+ *         of this machine
+ */
+qint64 BinaryMsgHandler::findEnd()
+{
+    char header[BINARY_LOG_HEADER_SIZE];
+    quint16 byteOrder;
+    quint32 end;
+    if (m_file.read(header, sizeof(header)) != sizeof(header) ||
+            std::memcmp(header, BINARY_LOG_MAGIC, 8) != 0) {
+        return -1;
+    }
+    std::memcpy(&byteOrder, header + 8, 2);
+    std::memcpy(&end, header + 12, 4);
+    if (byteOrder != BINARY_LOG_BYTE_ORDER) {
+        return -1;
+    }
+
+    if (end >= quint32(BINARY_LOG_HEADER_SIZE) && end == m_file.size()) {
+        return end;
+    }
+
+    BinaryLogReader reader(m_file.fileName());
+    if (!reader.open()) {
+        return -1;
+    }
+    QString line;
+    while (reader.readRecord(line))
+        ;
+    return reader.position();
+}
+
+
+/**
+ * @brief Stores the end of the records in the header
+ *
+ * @param[in] end the offset, 0 while the file is written
+ * @return @c true on success, @c false otherwise
+ */
+bool BinaryMsgHandler::writeEnd(quint32 end)
+{
+    return m_file.seek(12) && m_file.write(reinterpret_cast<const char *>(&end), 4) == 4 &&
+        m_file.flush();
+}
+
+
+/**
+ * @brief Returns the ID of a component literal, writes the definition on first use
+ *
+ * @param[in] component the component
+ * @return the ID
+ */
+quint16 BinaryMsgHandler::componentId(const char *component)
+{
+    QHash<const char *, quint16>::const_iterator it = m_literalComponents.find(component);
+    if (it != m_literalComponents.end()) {
+        return it.value();
+    }
+
+    quint16 id = m_nextComponent++;
+    m_literalComponents.insert(component, id);
+    writeDefinition(RecordComponent, id, QByteArray(component));
+    return id;
+}
+
+
+/**
+ * @brief Returns the ID of a component, writes the definition on first use
+ *
+ * @param[in] component the component
+ * @return the ID
+ */
+quint16 BinaryMsgHandler::componentId(const QString &component)
+{
+    QHash<QString, quint16>::const_iterator it = m_stringComponents.find(component);
+    if (it != m_stringComponents.end()) {
+        return it.value();
+    }
+
+    quint16 id = m_nextComponent++;
+    m_stringComponents.insert(component, id);
+    writeDefinition(RecordComponent, id, component.toUtf8());
+    return id;
+}
+
+
+/**
+ * @brief Returns the ID of a format literal, writes the definition on first use
+ *
+ * @param[in] format the format
+ * @return the ID
+ */
+quint16 BinaryMsgHandler::formatId(const char *format)
+{
+    QHash<const char *, quint16>::const_iterator it = m_formats.find(format);
+    if (it != m_formats.end()) {
+        return it.value();
+    }
+
+    quint16 id = m_nextFormat++;
+    m_formats.insert(format, id);
+    writeDefinition(RecordFormat, id, QByteArray(format));
+    return id;
+}
+
+
+/**
+ * @brief Writes a definition record
+ *
+ * @param[in] kind RecordComponent or RecordFormat
+ * @param[in] id the ID
+ * @param[in] text the text in UTF-8
+ */
+void BinaryMsgHandler::writeDefinition(quint8 kind, quint16 id, const QByteArray &text)
+{
+    write(&kind, 1);
+    write(&id, 2);
+    writeString(text);
+}
+
+
+/**
+ * @brief Writes a message record without the arguments
+ *
+ * @param[in] type the severity
+ * @param[in] component the ID of the component
+ * @param[in] format the ID of the format
+ * @param[in] argCount the number of arguments that follow
+ */
+void BinaryMsgHandler::writeMessageHeader(QtMsgType type, quint16 component, quint16 format,
+                                          int argCount)
+{
+    const quint8 kind = RecordMessage;
+    const quint8 msgType = type;
+    const qint64 time = PlatformHelpers::currentMicroseconds();
+    const quint8 count = argCount;
+
+    write(&kind, 1);
+    write(&msgType, 1);
+    write(&time, 8);
+    write(&component, 2);
+    write(&format, 2);
+    write(&count, 1);
+}
+
+
+/**
+ * @brief Writes an argument
+ *
+ * @param[in] arg the argument
+ */
+void BinaryMsgHandler::writeArg(const LogArg &arg)
+{
+    const quint8 type = arg.type();
+    write(&type, 1);
+
+    switch (arg.type()) {
+        case LogArg::Integer: {
+            const qint64 value = arg.toInteger();
+            write(&value, 8);
+            break;
+        }
+        case LogArg::Double: {
+            const double value = arg.toDouble();
+            write(&value, 8);
+            break;
+        }
+        case LogArg::Latin1: {
+            const char *value = arg.toLatin1();
+            writeString(QByteArray::fromRawData(value, int(std::strlen(value))));
+            break;
+        }
+        default:
+            writeString(arg.toString().toUtf8());
+            break;
+    }
+}
+
+
+/**
+ * @brief Writes a string, at most 65535 bytes
+ *
+ * @param[in] bytes the string
+ */
+void BinaryMsgHandler::writeString(const QByteArray &bytes)
+{
+    const quint16 length = quint16(qMin(bytes.size(), 0xffff));
+    write(&length, 2);
+    write(bytes.constData(), length);
+}
+
+
+/**
+ * @brief Copies bytes to the end of the records
+ *
+ * @param[in] data the bytes
+ * @param[in] size the number of bytes
+ */
+void BinaryMsgHandler::write(const void *data, int size)
+{
+    if (m_pos + size > m_mapOffset + m_mapSize || !m_map) {
+        if (!remap(size)) {
+            return;
+        }
+    }
+
+    std::memcpy(m_map + (m_pos - m_mapOffset), data, size);
+    m_pos += size;
+}
+
+
+/**
+ * @brief Extends the file and maps the next chunk
+ *
+ * @param[in] minimumSize the number of bytes that must be available
+ * @return @c true on success, @c false otherwise
+ */
+bool BinaryMsgHandler::remap(qint64 minimumSize)
+{
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = NULL;
+    }
+
+    m_mapOffset = m_pos - m_pos % BINARY_LOG_MAP_ALIGNMENT;
+    m_mapSize = qMax(BINARY_LOG_CHUNK_SIZE, m_pos - m_mapOffset + minimumSize);
+
+    // the new part of the file is zero, i.e. RecordEnd
+    if (m_file.size() < m_mapOffset + m_mapSize && !m_file.resize(m_mapOffset + m_mapSize)) {
+        return false;
+    }
+
+    m_map = m_file.map(m_mapOffset, m_mapSize);
+    return m_map != NULL;
+}
+
+/* }}} */
+/* BinaryLogReader {{{ */
+
+/**
+ * @class BinaryLogReader
+ *
+ * @brief Reads the files of BinaryMsgHandler and formats the records as text
+ *
+ * The lines have the same format as the lines of FileMsgHandler.
+ *
+ * @author Bernhard Walle <bernhard@bwalle.de>
+ * @ingroup misc
+ */
+
+/**
+ * @brief Constructor
+ *
+ * @param[in] filename the name of the file
+ */
+BinaryLogReader::BinaryLogReader(const QString &filename)
+    : m_file(filename)
+    , m_data(NULL)
+    , m_size(0)
+    , m_pos(0)
+{}
+
+
+/**
+ * @brief Maps the file and checks the header
+ *
+ * The file is not copied into memory, it stays mapped until the reader is
+ * deleted.
+ *
+ * @return @c true on success, @c false otherwise, see errorString()
+ */
+bool BinaryLogReader::open()
+{
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_error = m_file.errorString();
+        return false;
+    }
+    if (m_file.size() < BINARY_LOG_HEADER_SIZE || m_file.size() > INT_MAX) {
+        m_error = "Not a binary log file";
+        return false;
+    }
+    m_size = int(m_file.size());
+    m_data = reinterpret_cast<const char *>(m_file.map(0, m_size));
+    if (!m_data) {
+        m_error = m_file.errorString();
+        return false;
+    }
+
+    quint16 byteOrder;
+    if (std::memcmp(m_data, BINARY_LOG_MAGIC, 8) != 0) {
+        m_error = "Not a binary log file";
+        return false;
+    }
+    std::memcpy(&byteOrder, m_data + 8, 2);
+    if (byteOrder != BINARY_LOG_BYTE_ORDER) {
+        m_error = "The byte order of the file is different";
+        return false;
+    }
+
+    m_pos = BINARY_LOG_HEADER_SIZE;
+    return true;
+}
+
+
+/**
+ * @brief Returns the description of the last error
+ *
+ * @return the description
+ */
+QString BinaryLogReader::errorString() const
+{
+    return m_error;
+}
+
+
+/**
+ * @brief Returns the position after the last record that has been read
+ *
+ * @return the offset in the file
+ */
+int BinaryLogReader::position() const
+{
+    return m_pos;
+}
+
+
+/**
+ * @brief Reads the next message or session
+ *
+ * The definitions are read on the way.
+ *
+ * @param[out] line the formatted message
+ * @return @c true on success, @c false at the end or if the file is damaged, see
+ *         errorString()
+ */
+bool BinaryLogReader::readRecord(QString &line)
+{
+    int start = m_pos;
+    for (;;) {
+        start = m_pos;
+        quint8 kind;
+        if (!readBytes(&kind, 1) || kind == RecordEnd) {
+            m_pos = start;
+            return false;
+        }
+
+        if (kind == RecordSession) {
+            qint64 time;
+            if (!readBytes(&time, 8)) {
+                break;
+            }
+            m_components.clear();
+            m_formats.clear();
+            line = "--- Session started at " + QDateTime::fromTime_t(uint(time / 1000000))
+                .toString("yyyy-MM-dd hh:mm:ss") + " ---";
+            return true;
+
+        } else if (kind == RecordComponent || kind == RecordFormat) {
+            quint16 id;
+            QString text;
+            if (!readBytes(&id, 2) || !readString(text)) {
+                break;
+            }
+            QVector<QString> &table = kind == RecordComponent ? m_components : m_formats;
+            if (table.size() <= id) {
+                table.resize(id + 1);
+            }
+            table[id] = text;
+
+        } else if (kind == RecordMessage) {
+            quint8 type, argCount;
+            qint64 time;
+            quint16 component, format;
+            if (!readBytes(&type, 1) || !readBytes(&time, 8) || !readBytes(&component, 2) ||
+                    !readBytes(&format, 2) || !readBytes(&argCount, 1)) {
+                break;
+            }
+
+            QString msg = m_formats.value(format);
+            for (int i = 0; i < argCount; ++i) {
+                QString arg;
+                if (!readArg(arg)) {
+                    m_pos = start;
+                    m_error = "Damaged message record";
+                    return false;
+                }
+                msg = msg.arg(arg);
+            }
+
+            QString date = QDateTime::fromTime_t(uint(time / 1000000))
+                .toString("yyyy-MM-dd hh:mm:ss");
+            QString typeString = "[" + QpamatDebug::typeToString(QtMsgType(type)) + "]";
+
+            line = QString();
+            QTextStream stream(&line, QIODevice::WriteOnly);
+            stream.setFieldAlignment(QTextStream::AlignLeft);
+            stream.setFieldWidth(21);
+            stream << date;
+            stream.setFieldWidth(11);
+            stream << typeString;
+            stream.setFieldWidth(15);
+            stream << m_components.value(component);
+            stream.setFieldWidth(0);
+            stream << msg;
+            return true;
+
+        } else {
+            m_pos = start;
+            m_error = QString("Unknown record %1 at offset %2").arg(kind).arg(start);
+            return false;
+        }
+    }
+
+    // the next call fails at the same record again
+    m_pos = start;
+    m_error = "The last record is incomplete";
+    return false;
+}
+
+
+/**
+ * @brief Reads bytes
+ *
+ * @param[out] data the buffer
+ * @param[in] size the number of bytes
+ * @return @c true on success, @c false if the file is too short
+ */
+bool BinaryLogReader::readBytes(void *data, int size)
+{
+    if (m_pos + size > m_size) {
+        return false;
+    }
+
+    std::memcpy(data, m_data + m_pos, size);
+    m_pos += size;
+    return true;
+}
+
+
+/**
+ * @brief Reads a string
+ *
+ * @param[out] string the string
+ * @return @c true on success, @c false if the file is too short
+ */
+bool BinaryLogReader::readString(QString &string)
+{
+    quint16 length;
+    if (!readBytes(&length, 2) || m_pos + length > m_size) {
+        return false;
+    }
+
+    string = QString::fromUtf8(m_data + m_pos, length);
+    m_pos += length;
+    return true;
+}
+
+
+/**
+ * @brief Reads an argument and converts it to a string
+ *
+ * @param[out] string the argument
+ * @return @c true on success, @c false if the file is damaged
+ */
+bool BinaryLogReader::readArg(QString &string)
+{
+    quint8 type;
+    if (!readBytes(&type, 1)) {
+        return false;
+    }
+
+    switch (type) {
+        case LogArg::Integer: {
+            qint64 value;
+            if (!readBytes(&value, 8)) {
+                return false;
+            }
+            string = QString::number(value);
+            return true;
+        }
+        case LogArg::Double: {
+            double value;
+            if (!readBytes(&value, 8)) {
+                return false;
+            }
+            string = QString::number(value);
+            return true;
+        }
+        case LogArg::Latin1:
+        case LogArg::String:
+            return readString(string);
+        default:
+            return false;
+    }
+}
+
+/* }}} */
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
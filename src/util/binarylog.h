@@ -0,0 +1,132 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#ifndef BINARYLOG_H
+#define BINARYLOG_H
+
+#include <QString>
+#include <QFile>
+#include <QHash>
+#include <QVector>
+#include <QTextStream>
+
+#include "msghandler.h"
+
+class LogArg
+{
+    public:
+        enum Type {
+            Integer,
+            Double,
+            Latin1,
+            String
+        };
+
+    public:
+        LogArg(int value);
+        LogArg(qint64 value);
+        LogArg(double value);
+        LogArg(const char *value);
+        LogArg(const QString &value);
+
+        Type type() const;
+        qint64 toInteger() const;
+        double toDouble() const;
+        const char *toLatin1() const;
+        QString toString() const;
+
+    private:
+        Type m_type;
+        union {
+            qint64      integer;
+            double      real;
+            const char  *latin1;
+        } m_value;
+        QString m_string;
+};
+
+class BinaryMsgHandler : public MsgHandler
+{
+    public:
+        BinaryMsgHandler(const QString &filename);
+        ~BinaryMsgHandler();
+
+    public:
+        bool open();
+        void output(QtMsgType       type,
+                    const QString   &context,
+                    const QString   &date,
+                    const QString   &component,
+                    const QString   &msg);
+        bool outputRecord(QtMsgType     type,
+                          const char    *component,
+                          const char    *format,
+                          const LogArg  *args,
+                          int           argCount);
+
+    private:
+        qint64 findEnd();
+        bool writeEnd(quint32 end);
+        quint16 componentId(const char *component);
+        quint16 componentId(const QString &component);
+        quint16 formatId(const char *format);
+        void writeDefinition(quint8 kind, quint16 id, const QByteArray &text);
+        void writeMessageHeader(QtMsgType type, quint16 component, quint16 format,
+                                int argCount);
+        void writeArg(const LogArg &arg);
+        void writeString(const QByteArray &bytes);
+        void write(const void *data, int size);
+        bool remap(qint64 minimumSize);
+
+    private:
+        QFile m_file;
+        uchar *m_map;
+        qint64 m_mapOffset;
+        qint64 m_mapSize;
+        qint64 m_pos;
+        QHash<const char *, quint16> m_literalComponents;
+        QHash<QString, quint16> m_stringComponents;
+        QHash<const char *, quint16> m_formats;
+        quint16 m_nextComponent;
+        quint16 m_nextFormat;
+};
+
+class BinaryLogReader
+{
+    public:
+        BinaryLogReader(const QString &filename);
+
+        bool open();
+        QString errorString() const;
+        bool readRecord(QString &line);
+        int position() const;
+
+    private:
+        bool readBytes(void *data, int size);
+        bool readString(QString &string);
+        bool readArg(QString &string);
+
+    private:
+        QFile m_file;
+        const char *m_data;
+        int m_size;
+        int m_pos;
+        QString m_error;
+        QVector<QString> m_components;
+        QVector<QString> m_formats;
+};
+
+#endif // BINARYLOG_H
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
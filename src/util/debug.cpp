@@ -13,12 +13,31 @@
  * -------------------------------------------------------------------------------------------------
  */
 #include <iostream>
+#include <cstring>
 #include <QDateTime>
 #include <QFile>
+#include <QThreadStorage>
+#include <QMutexLocker>
 
 #include "platformhelpers.h"
 #include "debug.h"
 #include "msghandler.h"
+#include "asyncmsghandler.h"
+#include "binarylog.h"
+
+/**
+ * @brief The last formatted date of a thread
+ */
+struct DateCache
+{
+    uint time;
+    QString date;
+};
+
+/**
+ * @brief The date cache of each thread, so formatting needs no lock
+ */
+static QThreadStorage<DateCache *> s_dateCache;
 
 /**
  * @class QpamatDebug
@@ -50,6 +69,24 @@
  * QpamatDebug::instance()->setFilterComponents(l);
  * @endcode
  *
+ * Messages can be logged from any thread. To write them in a separate thread,
+ * so that the logging threads never wait for the file:
+ *
+ * @code
+ * QpamatDebug::instance()->setAsynchronous(true);
+ * @endcode
+ *
+ * The level and the components should be set before other threads are started.
+ *
+ * Messages that are logged often should use log(). The format and the arguments
+ * are only formatted if the handler needs text, the binary log stores them as
+ * they are:
+ *
+ * @code
+ * QpamatDebug::instance()->redirectBinaryFile("bla.qplog");
+ * QpamatDebug::instance()->log(QtDebugMsg, "tree", "%1 entries in %2 ms", count, ms);
+ * @endcode
+ *
  * And to redirect the logging to a file:
  *
  * @code
@@ -73,22 +110,29 @@
  * @author Bernhard Walle <bernhard@bwalle.de>
  */
 
-QpamatDebug *QpamatDebug::m_instance = NULL;
+QAtomicPointer<QpamatDebug> QpamatDebug::m_instance;
 
 
 /**
  * @brief Returns the only instance of a QpamatDebug class.
  *
- * Since QpamatDebug is a singleton, this is the access function.
+ * Since QpamatDebug is a singleton, this is the access function. It may be
+ * called from any thread.
  *
  * @return A pointer of the only instance. It cannot return @c NULL.
  */
 QpamatDebug *QpamatDebug::instance()
 {
-    if (!m_instance) {
-        m_instance = new QpamatDebug();
+    QpamatDebug *instance = m_instance;
+    if (!instance) {
+        instance = new QpamatDebug();
+        if (!m_instance.testAndSetOrdered(NULL, instance)) {
+            // another thread was faster
+            delete instance;
+            instance = m_instance;
+        }
     }
-    return m_instance;
+    return instance;
 }
 
 
@@ -144,15 +188,20 @@ void QpamatDebug::msgHandler(QtMsgType type, const char *msg)
 QpamatDebug::QpamatDebug()
     : m_msgHandler(new StderrMsgHandler)
     , m_msgLevel(QtWarningMsg)
+    , m_asynchronous(false)
+    , m_binary(false)
 {}
 
 
 /**
  * @brief Destructor
+ *
+ * Deletes the current and all replaced message handlers.
  */
 QpamatDebug::~QpamatDebug()
 {
-    delete m_msgHandler;
+    delete static_cast<MsgHandler *>(m_msgHandler);
+    qDeleteAll(m_retiredHandlers);
 }
 
 
@@ -164,6 +213,9 @@ QpamatDebug::~QpamatDebug()
  * want to use qDebug(), qWarning(), qCritical() or qFatal(). This Qt function
  * then calls QpamatDebug::msgHandler() which then calls this function.
  *
+ * The message is filtered before anything is copied or formatted, so filtered
+ * messages are cheap.
+ *
  * @param[in] type the severity of the Qt message
  * @param[in] msg the message
  */
@@ -174,22 +226,15 @@ void QpamatDebug::message(QtMsgType type, const char *msg)
         return;
     }
 
-    // get component and message
-    QString messagePart;
+    // find the component, that's the part before the last of max. two tabs
+    const char *firstTab = std::strchr(msg, '\t');
+    const char *secondTab = firstTab ? std::strchr(firstTab + 1, '\t') : NULL;
+
     QString componentPart(DEFAULT_COMPONENT);
-    QString contextPart(QString::null);
-    QString qmsg(msg);
-
-    int count = qmsg.count("\t");
-    if (count > 1) {
-        contextPart = qmsg.section('\t', 0, 0).trimmed();
-        componentPart = qmsg.section('\t', 1, 1).trimmed();
-        messagePart = qmsg.section('\t', 2).trimmed();
-    } else if (count == 1) {
-        componentPart = qmsg.section('\t', 0, 0).trimmed();
-        messagePart = qmsg.section('\t', 1).trimmed();
-    } else {
-        messagePart = qmsg;
+    if (secondTab) {
+        componentPart = QString::fromAscii(firstTab + 1, secondTab - firstTab - 1).trimmed();
+    } else if (firstTab) {
+        componentPart = QString::fromAscii(msg, firstTab - msg).trimmed();
     }
 
     // filter component
@@ -199,11 +244,213 @@ void QpamatDebug::message(QtMsgType type, const char *msg)
         }
     }
 
-    // format date
+    // get context and message
+    QString messagePart;
+    QString contextPart(QString::null);
+    if (secondTab) {
+        contextPart = QString::fromAscii(msg, firstTab - msg).trimmed();
+        messagePart = QString::fromAscii(secondTab + 1).trimmed();
+    } else if (firstTab) {
+        messagePart = QString::fromAscii(firstTab + 1).trimmed();
+    } else {
+        messagePart = QString::fromAscii(msg);
+    }
+
+    MsgHandler *handler = m_msgHandler;
+    if (handler->isThreadSafe()) {
+        handler->output(type, contextPart, currentDate(), componentPart, messagePart);
+    } else {
+        QMutexLocker locker(&m_outputMutex);
+        handler->output(type, contextPart, currentDate(), componentPart, messagePart);
+        handler->flush();
+    }
+}
+
+
+/**
+ * @brief Returns the formatted current date
+ *
+ * The date is formatted only once per second and thread.
+ *
+ * @return the date
+ */
+QString QpamatDebug::currentDate() const
+{
+    DateCache *cache = s_dateCache.localData();
+    if (!cache) {
+        cache = new DateCache;
+        cache->time = 0;
+        s_dateCache.setLocalData(cache);
+    }
+
     QDateTime current(QDateTime::currentDateTime());
-    QString date = current.toString("yyyy-MM-dd hh:mm:ss");
+    if (current.toTime_t() != cache->time) {
+        cache->time = current.toTime_t();
+        cache->date = current.toString("yyyy-MM-dd hh:mm:ss");
+    }
 
-    m_msgHandler->output(type, contextPart, date, componentPart, messagePart);
+    return cache->date;
+}
+
+
+/**
+ * @brief Checks if a message would be printed
+ *
+ * That's used by qpDebug(), qpWarning() and qpCritical() to skip formatting
+ * messages that would be filtered anyway.
+ *
+ * @param[in] type the severity of the Qt message
+ * @param[in] component the component name
+ * @return @c true if a message of @p type and @p component is printed, @c false
+ *         if it is filtered
+ */
+bool QpamatDebug::isEnabled(QtMsgType type, const char *component) const
+{
+    if (type < m_msgLevel) {
+        return false;
+    }
+
+    return m_components.isEmpty() || m_components.contains(QLatin1String(component));
+}
+
+
+/**
+ * @brief Logs a message without formatting it first
+ *
+ * The message is filtered like message(). Both @p component and @p format must
+ * be string literals, the binary log stores only their addresses until the
+ * first use. The placeholders of @p format are <tt>%1</tt> to <tt>%4</tt> like
+ * in QString::arg().
+ *
+ * @param[in] type the severity of the message, use qFatal() for fatal messages
+ * @param[in] component the component name (DEFAULT_COMPONENT may be used)
+ * @param[in] format the message
+ */
+void QpamatDebug::log(QtMsgType type, const char *component, const char *format)
+{
+    if (!isEnabled(type, component)) {
+        return;
+    }
+
+    logRecord(type, component, format, NULL, 0);
+}
+
+
+/**
+ * @brief Logs a message with one argument
+ *
+ * @param[in] type the severity of the message
+ * @param[in] component the component name
+ * @param[in] format the message
+ * @param[in] a1 the argument for <tt>%1</tt>
+ */
+void QpamatDebug::log(QtMsgType type, const char *component, const char *format,
+                      const LogArg &a1)
+{
+    if (!isEnabled(type, component)) {
+        return;
+    }
+
+    logRecord(type, component, format, &a1, 1);
+}
+
+
+/**
+ * @brief Logs a message with two arguments
+ *
+ * @param[in] type the severity of the message
+ * @param[in] component the component name
+ * @param[in] format the message
+ * @param[in] a1 the argument for <tt>%1</tt>
+ * @param[in] a2 the argument for <tt>%2</tt>
+ */
+void QpamatDebug::log(QtMsgType type, const char *component, const char *format,
+                      const LogArg &a1, const LogArg &a2)
+{
+    if (!isEnabled(type, component)) {
+        return;
+    }
+
+    const LogArg args[] = { a1, a2 };
+    logRecord(type, component, format, args, 2);
+}
+
+
+/**
+ * @brief Logs a message with three arguments
+ *
+ * @param[in] type the severity of the message
+ * @param[in] component the component name
+ * @param[in] format the message
+ * @param[in] a1 the argument for <tt>%1</tt>
+ * @param[in] a2 the argument for <tt>%2</tt>
+ * @param[in] a3 the argument for <tt>%3</tt>
+ */
+void QpamatDebug::log(QtMsgType type, const char *component, const char *format,
+                      const LogArg &a1, const LogArg &a2, const LogArg &a3)
+{
+    if (!isEnabled(type, component)) {
+        return;
+    }
+
+    const LogArg args[] = { a1, a2, a3 };
+    logRecord(type, component, format, args, 3);
+}
+
+
+/**
+ * @brief Logs a message with four arguments
+ *
+ * @param[in] type the severity of the message
+ * @param[in] component the component name
+ * @param[in] format the message
+ * @param[in] a1 the argument for <tt>%1</tt>
+ * @param[in] a2 the argument for <tt>%2</tt>
+ * @param[in] a3 the argument for <tt>%3</tt>
+ * @param[in] a4 the argument for <tt>%4</tt>
+ */
+void QpamatDebug::log(QtMsgType type, const char *component, const char *format,
+                      const LogArg &a1, const LogArg &a2, const LogArg &a3, const LogArg &a4)
+{
+    if (!isEnabled(type, component)) {
+        return;
+    }
+
+    const LogArg args[] = { a1, a2, a3, a4 };
+    logRecord(type, component, format, args, 4);
+}
+
+
+/**
+ * @brief Passes a message of log() to the message handler
+ *
+ * If the handler doesn't take the record, the message is formatted here. The
+ * caller has checked isEnabled() already.
+ *
+ * @param[in] type the severity of the message
+ * @param[in] component the component name
+ * @param[in] format the message
+ * @param[in] args the arguments
+ * @param[in] argCount the number of arguments
+ */
+void QpamatDebug::logRecord(QtMsgType type, const char *component, const char *format,
+                            const LogArg *args, int argCount)
+{
+    MsgHandler *handler = m_msgHandler;
+    QMutexLocker locker(handler->isThreadSafe() ? NULL : &m_outputMutex);
+
+    if (!handler->outputRecord(type, component, format, args, argCount)) {
+        QString msg = QString::fromLatin1(format);
+        for (int i = 0; i < argCount; ++i) {
+            msg = msg.arg(args[i].toString());
+        }
+        handler->output(type, QString::null, currentDate(),
+                        QString::fromLatin1(component), msg);
+    }
+
+    if (!handler->isThreadSafe()) {
+        handler->flush();
+    }
 }
 
 /**
@@ -245,8 +492,9 @@ void QpamatDebug::setFilterComponents(const QStringList &components)
  */
 void QpamatDebug::redirectConsole()
 {
-    delete m_msgHandler;
-    m_msgHandler = new StderrMsgHandler;
+    m_filename = QString::null;
+    m_binary = false;
+    setMsgHandler(new StderrMsgHandler);
 }
 
 
@@ -266,13 +514,103 @@ void QpamatDebug::redirectFile(const QString &filename)
         return;
     }
 
-    m_msgHandler = new FileMsgHandler(filename);
-    if (!m_msgHandler->open()) {
-        std::cerr << "(debug) Opening file '" << filename.toLocal8Bit().data()
-                  << "' failed. Using stderr." << std::endl;
-        delete m_msgHandler;
+    m_filename = filename;
+    m_binary = false;
+    setMsgHandler(new FileMsgHandler(filename.toLocal8Bit().data()));
+}
+
+
+/**
+ * @brief Redirects the log messages to a binary file
+ *
+ * The file is written by a BinaryMsgHandler and can be converted to text with
+ * <tt>qpamat-logdecode</tt>. Writing a record is cheap, so the handler is never
+ * wrapped in an AsyncMsgHandler. If the file cannot be opened, the fallback is
+ * console logging.
+ *
+ * @param[in] filename the file name, relative to the working directory of the
+ *                     application. If @p filename is QString::null, then
+ *                     redirectConsole() is called internally.
+ */
+void QpamatDebug::redirectBinaryFile(const QString &filename)
+{
+    if (filename.isNull()) {
+        redirectConsole();
+        return;
+    }
+
+    m_filename = filename;
+    m_binary = true;
+    setMsgHandler(new BinaryMsgHandler(filename));
+}
+
+
+/**
+ * @brief Writes the log messages in a separate thread
+ *
+ * The current and all following redirections use an AsyncMsgHandler. Messages
+ * are dropped if the ring buffer is full, critical and fatal messages are
+ * never dropped.
+ *
+ * @param[in] async @c true if the messages should be written in a separate
+ *                  thread, @c false if they should be written by the thread
+ *                  that logs
+ */
+void QpamatDebug::setAsynchronous(bool async)
+{
+    if (async == m_asynchronous) {
+        return;
+    }
+
+    m_asynchronous = async;
+    if (m_binary) {
+        return;
+    } else if (m_filename.isNull()) {
         redirectConsole();
+    } else {
+        redirectFile(m_filename);
+    }
+}
+
+
+/**
+ * @brief Replaces the message handler
+ *
+ * The handler is wrapped in an AsyncMsgHandler if setAsynchronous() has been
+ * called. If it cannot be opened, the fallback is console logging.
+ *
+ * The handler is published with an atomic pointer, so the logging threads
+ * never lock a mutex to find it. A thread may still write to the old handler
+ * after it has been replaced, that's why the old handler is only flushed here
+ * and deleted in the destructor. The handler is rarely replaced, so keeping
+ * the old ones costs nearly nothing.
+ *
+ * @param[in] handler the new message handler, QpamatDebug takes the ownership
+ */
+void QpamatDebug::setMsgHandler(MsgHandler *handler)
+{
+    if (m_asynchronous && !m_binary) {
+        handler = new AsyncMsgHandler(handler);
+    }
+
+    if (!handler->open()) {
+        std::cerr << "(debug) Opening file '" << m_filename.toLocal8Bit().data()
+                  << "' failed. Using stderr." << std::endl;
+        delete handler;
+        m_filename = QString::null;
+        m_binary = false;
+        handler = new StderrMsgHandler;
+        if (m_asynchronous) {
+            handler = new AsyncMsgHandler(handler);
+        }
+        handler->open();
     }
+
+    MsgHandler *oldHandler = m_msgHandler.fetchAndStoreOrdered(handler);
+
+    QMutexLocker locker(&m_outputMutex);
+    oldHandler->flush();
+    m_retiredHandlers.append(oldHandler);
 }
 
 // vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
@@ -17,6 +17,11 @@
 
 #include <QApplication>
 #include <QDebug>
+#include <QMutex>
+#include <QAtomicPointer>
+#include <QList>
+
+#include "binarylog.h"
 
 /**
  * @file debug.h
@@ -38,6 +43,19 @@
  */
 #define DEFAULT_COMPONENT "default"
 
+/**
+ * @brief Executes the following statement only if the message is not filtered
+ *
+ * Used by qpDebug(), qpWarning() and qpCritical(). This is a loop and not an @c if, so
+ * that a following @c else cannot belong to it.
+ *
+ * @param[in] type the severity of the Qt message
+ * @param[in] component the component name
+ */
+#define QP_LOG_IF_ENABLED(type, component) \
+    for (bool qp_enabled = QpamatDebug::instance()->isEnabled((type), (component)); \
+            qp_enabled; qp_enabled = false)
+
 /**
  * @brief Prints a debugging message
  *
@@ -52,11 +70,14 @@
  * qpDebug("Security") << "Bla is" << bla;
  * @endcode
  *
+ * Nothing is formatted if the message would be filtered, see QpamatDebug::isEnabled().
+ *
  * @param[in] component the component name (DEFAULT_COMPONENT may be used)
  * @return a QDebug object
  */
 #define qpDebug(component) \
-    (qDebug() << Q_FUNC_INFO << __LINE__ << "\t" << (component) << "\t")
+    QP_LOG_IF_ENABLED(QtDebugMsg, (component)) \
+        qDebug() << Q_FUNC_INFO << __LINE__ << "\t" << (component) << "\t"
 
 /**
  * @brief Prints a warning message
@@ -75,7 +96,8 @@
  * @return a QDebug object
  */
 #define qpWarning(component) \
-    (qWarning() << Q_FUNC_INFO << __LINE__ << "\t" << (component) << "\t")
+    QP_LOG_IF_ENABLED(QtWarningMsg, (component)) \
+        qWarning() << Q_FUNC_INFO << __LINE__ << "\t" << (component) << "\t"
 
 /**
  * @brief Prints a critical message
@@ -94,7 +116,8 @@
  * @return a QDebug object
  */
 #define qpCritical(component) \
-    (qCritical() << Q_FUNC_INFO << __LINE__ << "\t" << (component) << "\t")
+    QP_LOG_IF_ENABLED(QtCriticalMsg, (component)) \
+        qCritical() << Q_FUNC_INFO << __LINE__ << "\t" << (component) << "\t"
 
 /**
  * @brief Prints a fatal message
@@ -130,16 +153,39 @@ class QpamatDebug
 
     public:
         void message(QtMsgType type, const char *msg);
+        bool isEnabled(QtMsgType type, const char *component) const;
+        void log(QtMsgType type, const char *component, const char *format);
+        void log(QtMsgType type, const char *component, const char *format,
+                 const LogArg &a1);
+        void log(QtMsgType type, const char *component, const char *format,
+                 const LogArg &a1, const LogArg &a2);
+        void log(QtMsgType type, const char *component, const char *format,
+                 const LogArg &a1, const LogArg &a2, const LogArg &a3);
+        void log(QtMsgType type, const char *component, const char *format,
+                 const LogArg &a1, const LogArg &a2, const LogArg &a3, const LogArg &a4);
         void setMessageLevel(QtMsgType level);
         void setFilterComponents(const QStringList &components);
         void redirectConsole();
         void redirectFile(const QString &filename);
+        void redirectBinaryFile(const QString &filename);
+        void setAsynchronous(bool async);
+
+    private:
+        void setMsgHandler(MsgHandler *handler);
+        void logRecord(QtMsgType type, const char *component, const char *format,
+                       const LogArg *args, int argCount);
+        QString currentDate() const;
 
     private:
-        static QpamatDebug *m_instance;
-        MsgHandler *m_msgHandler;
+        static QAtomicPointer<QpamatDebug> m_instance;
+        QAtomicPointer<MsgHandler> m_msgHandler;
+        QList<MsgHandler *> m_retiredHandlers;
         QtMsgType m_msgLevel;
         QStringList m_components;
+        QString m_filename;
+        bool m_asynchronous;
+        bool m_binary;
+        QMutex m_outputMutex;
 };
 
 #endif // DEBUG_H
@@ -20,6 +20,7 @@
 #include "ansicolor.h"
 #include "platformhelpers.h"
 #include "debug.h"
+#include "binarylog.h"
 
 /**
  * @class MsgHandler
@@ -64,6 +65,55 @@
  * @param[in] msg the real message
  */
 
+/**
+ * @brief Output function for messages of QpamatDebug::log()
+ *
+ * A handler that stores the format and the arguments instead of the text
+ * reimplements that function. Filtering is already done.
+ *
+ * @param[in] type the severity of the message
+ * @param[in] component the component, a string literal
+ * @param[in] format the format with the placeholders <tt>%1</tt> and so on, a
+ *            string literal
+ * @param[in] args the arguments
+ * @param[in] argCount the number of arguments
+ * @return @c true if the message has been written, @c false if the caller has
+ *         to format the message and call output(), that's the default
+ */
+bool MsgHandler::outputRecord(QtMsgType     type,
+                              const char    *component,
+                              const char    *format,
+                              const LogArg  *args,
+                              int           argCount)
+{
+    Q_UNUSED(type);
+    Q_UNUSED(component);
+    Q_UNUSED(format);
+    Q_UNUSED(args);
+    Q_UNUSED(argCount);
+
+    return false;
+}
+
+/**
+ * @fn MsgHandler::flush()
+ *
+ * @brief Writes the messages that have been buffered
+ *
+ * QpamatDebug calls this function after each message, AsyncMsgHandler after
+ * a batch of messages.
+ */
+
+/**
+ * @fn MsgHandler::isThreadSafe()
+ *
+ * @brief Checks if output() may be called from several threads at the same time
+ *
+ * If not, QpamatDebug serializes the calls.
+ *
+ * @return @c true if the message handler is thread-safe, @c false otherwise
+ */
+
 /* StderrMsgHandler {{{ */
 
 /**
@@ -162,7 +212,14 @@ void StderrMsgHandler::output(QtMsgType       type,
     std::cerr << colorcode
               << outputstring.toLocal8Bit().constData()
               << endcolorcode
-              << std::endl;
+              << '\n';
+}
+
+
+/// @copydoc MsgHandler::flush()
+void StderrMsgHandler::flush()
+{
+    std::cerr.flush();
 }
 
 /* }}} */
@@ -197,6 +254,7 @@ FileMsgHandler::FileMsgHandler(const char *outputfile)
 /// Destructor
 FileMsgHandler::~FileMsgHandler()
 {
+    m_stream.flush();
     m_outputfile.close();
 }
 
@@ -204,11 +262,14 @@ FileMsgHandler::~FileMsgHandler()
 /// @copydoc MsgHandler::open()
 bool FileMsgHandler::open()
 {
-    return m_outputfile.open(QIODevice::WriteOnly |
-                             QIODevice::Append |
-                             QIODevice::Text |
-                             QIODevice::Unbuffered);
+    if (!m_outputfile.open(QIODevice::WriteOnly |
+                           QIODevice::Append |
+                           QIODevice::Text)) {
+        return false;
+    }
 
+    m_stream.setDevice(&m_outputfile);
+    return true;
 }
 
 
@@ -221,7 +282,7 @@ void FileMsgHandler::output(QtMsgType       type,
 {
     QString typeString = "[" + QpamatDebug::typeToString(type) + "]";
 
-    QTextStream stream(&m_outputfile);
+    QTextStream &stream = m_stream;
 
     // date
     stream.setFieldAlignment(QTextStream::AlignLeft);
@@ -239,10 +300,16 @@ void FileMsgHandler::output(QtMsgType       type,
     // context and msg
     stream.setFieldWidth(0);
     if (!context.isNull()) {
-        stream << context << " ||| ";\
+        stream << context << " ||| ";
     }
-    stream << msg;
-    stream << endl;
+    stream << msg << '\n';
+}
+
+
+/// @copydoc MsgHandler::flush()
+void FileMsgHandler::flush()
+{
+    m_stream.flush();
 }
 
 /* }}} */
@@ -17,6 +17,9 @@
 
 #include <QString>
 #include <QFile>
+#include <QTextStream>
+
+class LogArg;
 
 /* MsgHandler {{{ */
 
@@ -32,6 +35,13 @@ class MsgHandler
                             const QString   &date,
                             const QString   &component,
                             const QString   &msg) = 0;
+        virtual bool outputRecord(QtMsgType     type,
+                                  const char    *component,
+                                  const char    *format,
+                                  const LogArg  *args,
+                                  int           argCount);
+        virtual void flush() {}
+        virtual bool isThreadSafe() const { return false; }
 };
 
 /* }}} */
@@ -50,9 +60,11 @@ class FileMsgHandler : public MsgHandler
                     const QString   &date,
                     const QString   &component,
                     const QString   &msg);
+        void flush();
 
     private:
         QFile m_outputfile;
+        QTextStream m_stream;
 };
 
 /* }}} */
@@ -71,6 +83,7 @@ class StderrMsgHandler : public MsgHandler
                     const QString   &date,
                     const QString   &component,
                     const QString   &msg);
+        void flush();
 
     private:
         bool m_useColor;
@@ -85,6 +85,9 @@
 
 #endif // DOXYGEN
 
+#include <QtGlobal>
+#include <QString>
+
 class PlatformHelpers
 {
     public:
@@ -95,6 +98,9 @@ class PlatformHelpers
         };
 
         static bool isTerminal(FileChannel channel);
+        static qint64 monotonicMicroseconds();
+        static qint64 currentMicroseconds();
+        static bool replaceFile(const QString& source, const QString& destination);
 };
 
 #endif /* PLATFORMHELPERS_H */
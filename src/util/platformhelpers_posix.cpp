@@ -12,7 +12,13 @@
  *
  * -------------------------------------------------------------------------------------------------
  */
+#include <cstdio>
 #include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/time.h>
+
+#include <QFile>
 
 #include "platformhelpers.h"
 
@@ -86,4 +92,62 @@ bool PlatformHelpers::isTerminal(FileChannel channel)
     return isatty(fd);
 }
 
+/**
+ * @brief Returns the time of a monotonic clock
+ *
+ * The time doesn't jump if the system time is changed, so it can be used to
+ * measure durations. The start of the clock is unspecified.
+ *
+ * @return the time in microseconds
+ */
+qint64 PlatformHelpers::monotonicMicroseconds()
+{
+#if defined(_POSIX_MONOTONIC_CLOCK) && _POSIX_MONOTONIC_CLOCK >= 0
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0) {
+        return qint64(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+    }
+#endif
+
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return qint64(tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+
+/**
+ * @brief Returns the system time
+ *
+ * @return the time in microseconds since 1970-01-01 00:00 UTC
+ */
+qint64 PlatformHelpers::currentMicroseconds()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return qint64(tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+
+/**
+ * @brief Replaces @p destination by @p source atomically
+ *
+ * The contents of @p source are synced to the disk before, so after a crash either the old
+ * or the new file exists completely. This is rename() in POSIX.
+ *
+ * @param source the new file, must be on the same file system as @p destination
+ * @param destination the file to replace, may not exist
+ * @return @c true on success, @c false otherwise
+ */
+bool PlatformHelpers::replaceFile(const QString& source, const QString& destination)
+{
+    const QByteArray sourceName = QFile::encodeName(source);
+
+    int fd = open(sourceName.constData(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    bool synced = fsync(fd) == 0;
+    close(fd);
+
+    return synced &&
+        rename(sourceName.constData(), QFile::encodeName(destination).constData()) == 0;
+}
+
 // vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
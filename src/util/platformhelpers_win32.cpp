@@ -12,6 +12,8 @@
  *
  * -------------------------------------------------------------------------------------------------
  */
+#include <windows.h>
+
 #include "platformhelpers.h"
 
 bool PlatformHelpers::isTerminal(FileChannel channel)
@@ -19,4 +21,31 @@ bool PlatformHelpers::isTerminal(FileChannel channel)
     return false;
 }
 
+qint64 PlatformHelpers::monotonicMicroseconds()
+{
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    return counter.QuadPart / frequency.QuadPart * 1000000 +
+        counter.QuadPart % frequency.QuadPart * 1000000 / frequency.QuadPart;
+}
+
+qint64 PlatformHelpers::currentMicroseconds()
+{
+    FILETIME ft;
+    GetSystemTimeAsFileTime(&ft);
+
+    // 100 ns since 1601-01-01
+    qint64 time = (qint64(ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+    return time / 10 - Q_INT64_C(11644473600000000);
+}
+
+bool PlatformHelpers::replaceFile(const QString& source, const QString& destination)
+{
+    return MoveFileExW(reinterpret_cast<const wchar_t*>(source.utf16()),
+                       reinterpret_cast<const wchar_t*>(destination.utf16()),
+                       MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+}
+
 // vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
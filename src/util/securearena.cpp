@@ -0,0 +1,395 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#include <cstring>
+#include <cerrno>
+#include <new>
+
+// before the include of <sys/mman.h> to get the Q_WS_X11 define
+#include <QDebug>
+#include <QMutex>
+#include <QMutexLocker>
+
+#if defined(Q_WS_X11) || defined(Q_WS_MAC)
+#  include <unistd.h>
+#  include <sys/mman.h>
+#  define SECUREARENA_MMAP
+#endif
+
+#include "securearena.h"
+
+/**
+ * @class SecureArena
+ *
+ * @brief Allocator for memory that holds secrets.
+ *
+ * Calling mlock() for each secret has two problems: each lock and unlock is a system call, and
+ * the kernel accounts locked memory in pages, so thousands of small passwords quickly hit
+ * RLIMIT_MEMLOCK. The arena instead maps a few chunks of memory, locks each chunk once and
+ * excludes it from core dumps (@c MADV_DONTDUMP, where available). The chunks are carved up
+ * in blocks of a few size classes, each class with its own free list. Blocks are zeroed when
+ * they are released.
+ *
+ * Allocation and release are just free list operations once the chunks exist. The number of
+ * chunks is limited. Requests that don't fit in the biggest size class or that arrive after
+ * the arena is exhausted are served from the normal heap and locked individually, just as
+ * SecureString did before.
+ *
+ * The class is a thread-safe singleton.
+ *
+ * @ingroup misc
+ * @author Bernhard Walle
+ */
+
+SecureArena *SecureArena::m_instance = NULL;
+bool SecureArena::s_warned = false;
+
+/**
+ * @brief Block sizes of the arena, in bytes.
+ */
+const size_t SecureArena::m_sizeClasses[] = {
+    16, 32, 64, 128, 256, 512, 1024
+};
+
+/**
+ * @brief Protects the creation of the instance.
+ *
+ * A function-local static is not initialized thread-safely by C++98 compilers, and a plain
+ * global might not be constructed yet when a static SecureString needs the arena.
+ */
+Q_GLOBAL_STATIC(QMutex, instanceMutex)
+
+
+/**
+ * @brief Returns the only instance of the SecureArena.
+ *
+ * @return the instance, never @c NULL
+ */
+SecureArena *SecureArena::instance()
+{
+    QMutexLocker locker(instanceMutex());
+
+    if (!m_instance) {
+        m_instance = new SecureArena();
+    }
+    return m_instance;
+}
+
+
+/**
+ * @brief Creates a new SecureArena.
+ *
+ * No memory is mapped before the first allocation.
+ */
+SecureArena::SecureArena()
+    : m_current(NULL)
+    , m_currentEnd(NULL)
+{
+    for (int i = 0; i < m_numSizeClasses; i++)
+        m_freeLists[i] = NULL;
+}
+
+
+/**
+ * @brief Deletes the SecureArena.
+ *
+ * All chunks are zeroed, unlocked and unmapped.
+ */
+SecureArena::~SecureArena()
+{
+    for (QVector<Chunk>::iterator it = m_chunks.begin(); it != m_chunks.end(); ++it) {
+        smash(it->memory, it->size);
+        if (it->locked)
+            unlockMemory(it->memory, it->size);
+#ifdef SECUREARENA_MMAP
+        munmap(it->memory, it->size);
+#else
+        delete[] it->memory;
+#endif
+    }
+}
+
+
+/**
+ * @brief Allocates a block of at least @p size bytes.
+ *
+ * The block is filled with zeroes.
+ *
+ * @param[in] size the number of bytes that are needed
+ * @param[out] capacity the real size of the block, which must be passed to release()
+ * @param[out] locked @c true if the block is locked in memory, @c false otherwise
+ * @return the block
+ * @throw std::bad_alloc if the memory cannot be allocated
+ */
+char *SecureArena::allocate(size_t size, size_t &capacity, bool &locked)
+{
+    int index = sizeClass(size);
+    if (index < 0) {
+        capacity = size;
+        return allocateLarge(size, locked);
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    size_t blockSize = m_sizeClasses[index];
+    char *block = m_freeLists[index];
+    if (block) {
+        // the link to the next free block is stored in the block itself
+        m_freeLists[index] = *reinterpret_cast<char **>(block);
+        smash(block, sizeof(char *));
+    } else {
+        if (m_current + blockSize > m_currentEnd && !addChunk()) {
+            locker.unlock();
+            capacity = size;
+            return allocateLarge(size, locked);
+        }
+        block = m_current;
+        m_current += blockSize;
+    }
+
+    capacity = blockSize;
+    locked = findChunk(block)->locked;
+    return block;
+}
+
+
+/**
+ * @brief Releases a block that has been allocated with allocate().
+ *
+ * The whole block is zeroed before it's put back to the free list.
+ *
+ * @param[in] block the block, may be @c NULL
+ * @param[in] capacity the capacity that allocate() has returned for that block
+ */
+void SecureArena::release(char *block, size_t capacity)
+{
+    if (!block)
+        return;
+
+    smash(block, capacity);
+
+    QMutexLocker locker(&m_mutex);
+
+    int index = sizeClass(capacity);
+    if (index < 0 || m_sizeClasses[index] != capacity || !findChunk(block)) {
+        locker.unlock();
+        releaseLarge(block, capacity);
+        return;
+    }
+
+    *reinterpret_cast<char **>(block) = m_freeLists[index];
+    m_freeLists[index] = block;
+}
+
+
+/**
+ * @brief Returns the number of chunks that the arena has mapped.
+ *
+ * @return the number of chunks
+ */
+size_t SecureArena::chunkCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_chunks.size();
+}
+
+
+/**
+ * @brief Returns the amount of memory that the arena has locked.
+ *
+ * Large blocks that are locked individually are not included.
+ *
+ * @return the number of bytes
+ */
+size_t SecureArena::lockedBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    size_t bytes = 0;
+    for (QVector<Chunk>::const_iterator it = m_chunks.begin(); it != m_chunks.end(); ++it)
+        if (it->locked)
+            bytes += it->size;
+    return bytes;
+}
+
+
+/**
+ * @brief Overwrites memory with zeroes.
+ *
+ * Contrary to memset(), the compiler is not allowed to optimise that away.
+ *
+ * @param[in] block the memory
+ * @param[in] size the number of bytes
+ */
+void SecureArena::smash(char *block, size_t size)
+{
+    volatile char *p = block;
+    while (size--)
+        *p++ = '\0';
+}
+
+
+/**
+ * @brief Returns the index of the smallest size class that can hold @p size bytes.
+ *
+ * @param[in] size the number of bytes
+ * @return the index in m_sizeClasses or -1 if the block is too large for the arena
+ */
+int SecureArena::sizeClass(size_t size) const
+{
+    for (int i = 0; i < m_numSizeClasses; i++)
+        if (size <= m_sizeClasses[i])
+            return i;
+    return -1;
+}
+
+
+/**
+ * @brief Maps a new chunk and makes it the current chunk.
+ *
+ * The remainder of the old chunk is split in blocks and put on the free lists so that nothing
+ * is wasted. Must be called with m_mutex held.
+ *
+ * @return @c true on success, @c false if the arena is exhausted or no memory could be mapped
+ */
+bool SecureArena::addChunk()
+{
+    if (m_chunks.size() >= m_maxChunks)
+        return false;
+
+    // give the rest of the current chunk to the free lists, largest blocks first
+    for (int i = m_numSizeClasses - 1; i >= 0; i--) {
+        while (m_current && m_current + m_sizeClasses[i] <= m_currentEnd) {
+            *reinterpret_cast<char **>(m_current) = m_freeLists[i];
+            m_freeLists[i] = m_current;
+            m_current += m_sizeClasses[i];
+        }
+    }
+
+    Chunk chunk;
+    chunk.size = m_chunkSize;
+#ifdef SECUREARENA_MMAP
+    void *memory = mmap(NULL, chunk.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+    if (memory == MAP_FAILED) {
+        qWarning() << "Cannot map memory for secure arena:" << strerror(errno);
+        return false;
+    }
+    chunk.memory = static_cast<char *>(memory);
+#  ifdef MADV_DONTDUMP
+    madvise(chunk.memory, chunk.size, MADV_DONTDUMP);
+#  endif
+#else
+    chunk.memory = new (std::nothrow) char[chunk.size];
+    if (!chunk.memory)
+        return false;
+    smash(chunk.memory, chunk.size);
+#endif
+    chunk.locked = lockMemory(chunk.memory, chunk.size);
+
+    m_chunks.append(chunk);
+    m_current = chunk.memory;
+    m_currentEnd = chunk.memory + chunk.size;
+
+    return true;
+}
+
+
+/**
+ * @brief Returns the chunk that contains @p block.
+ *
+ * Must be called with m_mutex held.
+ *
+ * @param[in] block the block
+ * @return the chunk or @c NULL if the block is not in the arena
+ */
+const SecureArena::Chunk *SecureArena::findChunk(const char *block) const
+{
+    for (QVector<Chunk>::const_iterator it = m_chunks.begin(); it != m_chunks.end(); ++it)
+        if (block >= it->memory && block < it->memory + it->size)
+            return &*it;
+    return NULL;
+}
+
+
+/**
+ * @brief Allocates a block on the heap and locks it individually.
+ *
+ * @param[in] size the number of bytes
+ * @param[out] locked @c true if the block could be locked
+ * @return the zeroed block
+ * @throw std::bad_alloc if the memory cannot be allocated
+ */
+char *SecureArena::allocateLarge(size_t size, bool &locked)
+{
+    char *block = new char[size];
+    std::memset(block, 0, size);
+    locked = lockMemory(block, size);
+    return block;
+}
+
+
+/**
+ * @brief Releases a block that has been allocated with allocateLarge().
+ *
+ * The block must already be zeroed.
+ *
+ * @param[in] block the block
+ * @param[in] capacity the size of the block
+ */
+void SecureArena::releaseLarge(char *block, size_t capacity)
+{
+    unlockMemory(block, capacity);
+    delete[] block;
+}
+
+
+/**
+ * @brief Locks memory, i.e. prevents that it's swapped out.
+ *
+ * If the memory cannot be locked, a warning is printed once.
+ *
+ * @param[in] memory the start of the memory
+ * @param[in] size the number of bytes
+ * @return @c true if the memory is locked, @c false otherwise
+ */
+bool SecureArena::lockMemory(char *memory, size_t size)
+{
+#ifdef _POSIX_MEMLOCK_RANGE
+    if (mlock(memory, size) == 0)
+        return true;
+
+    if (!s_warned) {
+        s_warned = true;
+        qWarning() << "Cannot lock memory:" << strerror(errno);
+    }
+#endif
+    return false;
+}
+
+
+/**
+ * @brief Unlocks memory that has been locked with lockMemory().
+ *
+ * @param[in] memory the start of the memory
+ * @param[in] size the number of bytes
+ */
+void SecureArena::unlockMemory(char *memory, size_t size)
+{
+#ifdef _POSIX_MEMLOCK_RANGE
+    if (munlock(memory, size) != 0)
+        qDebug() << "Cannot unlock memory " << strerror(errno);
+#endif
+}
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
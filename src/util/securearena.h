@@ -0,0 +1,75 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#ifndef SECUREARENA_H
+#define SECUREARENA_H
+
+#include <cstddef>
+
+#include <QMutex>
+#include <QVector>
+
+class SecureArena
+{
+    public:
+        static SecureArena *instance();
+
+    private:
+        SecureArena();
+        ~SecureArena();
+
+    public:
+        char *allocate(size_t size, size_t &capacity, bool &locked);
+        void release(char *block, size_t capacity);
+
+        size_t chunkCount() const;
+        size_t lockedBytes() const;
+
+    public:
+        static void smash(char *block, size_t size);
+
+    private:
+        struct Chunk {
+            char    *memory;
+            size_t  size;
+            bool    locked;
+        };
+
+    private:
+        int sizeClass(size_t size) const;
+        bool addChunk();
+        const Chunk *findChunk(const char *block) const;
+        char *allocateLarge(size_t size, bool &locked);
+        void releaseLarge(char *block, size_t capacity);
+        static bool lockMemory(char *memory, size_t size);
+        static void unlockMemory(char *memory, size_t size);
+
+    private:
+        static SecureArena  *m_instance;
+        static const size_t m_sizeClasses[];
+        static const int    m_numSizeClasses = 7;
+        static const size_t m_chunkSize = 16 * 1024;
+        static const int    m_maxChunks = 64;
+
+        mutable QMutex      m_mutex;
+        QVector<Chunk>      m_chunks;
+        char                *m_freeLists[m_numSizeClasses];
+        char                *m_current;
+        char                *m_currentEnd;
+        static bool         s_warned;
+};
+
+#endif // SECUREARENA_H
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
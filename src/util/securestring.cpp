@@ -18,14 +18,15 @@
 #include <cerrno>
 #include <algorithm>
 
-// before the include of <sys/mman.h> to get the Q_WS_X11 define
+// before the include of <unistd.h> to get the Q_WS_X11 define
 #include <QDebug>
 
 #if defined(Q_WS_X11) || defined(Q_WS_MAC)
-#  include <sys/mman.h>
+#  include <unistd.h>
 #endif
 
 #include "securestring.h"
+#include "securearena.h"
 
 /**
  * \class SecureString
@@ -34,7 +35,8 @@
  *
  * This string class takes care that the data is not swapped out to disk but kept in memory.
  * How that is done depends on the operating system. Currently, only mlock() is supported
- * on Unix platforms.
+ * on Unix platforms. The memory comes from the SecureArena, so creating and deleting strings
+ * doesn't need a system call.
  *
  * This class is Unicode-aware because it uses UTF-8 internally to store the data. If you use
  * QString or a UTF-8 C-String, you can use Unicode. If you use a local 8-bit encoding like
@@ -44,7 +46,135 @@
  * @author Bernhard Walle
  */
 
-bool SecureString::s_warned = false;
+/**
+ * @class SecureStringReader
+ *
+ * @brief Callback interface to read the contents of a SecureString without copying it.
+ *
+ * Implement read() and pass the reader to SecureString::borrow(). The text passed to
+ * read() points into the locked memory of the SecureString. It's only valid during the call,
+ * don't keep a pointer to it.
+ *
+ * @ingroup misc
+ * @author Bernhard Walle
+ */
+
+/**
+ * @fn SecureStringReader::read(const char *, size_t)
+ *
+ * @brief Called with the contents of the borrowed string.
+ *
+ * @param [in] utf8 the UTF-8 representation, zero-terminated
+ * @param [in] size the number of bytes in @p utf8 without the terminating zero
+ */
+
+/**
+ * @class SecureQStringReader
+ *
+ * @brief A SecureStringReader for code that needs the text as QString.
+ *
+ * The UTF-8 text is decoded into a buffer that is allocated from the SecureArena, and
+ * readString() gets a QString that doesn't own its data but references that buffer (see
+ * QString::fromRawData()). After readString() returns, the buffer is smashed.
+ *
+ * This means: Don't keep a copy of the QString after readString() returned. Because QString
+ * is implicitly shared, a plain copy would still reference the smashed buffer. If you really
+ * need a copy, make a deep one with <tt>QString(text.unicode(), text.length())</tt>.
+ *
+ * @ingroup misc
+ * @author Bernhard Walle
+ */
+
+/**
+ * @fn SecureQStringReader::readString(const QString &)
+ *
+ * @brief Called with the contents of the borrowed string.
+ *
+ * @param [in] text the text which is only valid during the call
+ */
+
+/**
+ * @brief Decodes UTF-8 into UTF-16.
+ *
+ * Invalid sequences are replaced by U+FFFD.
+ *
+ * @param [in] utf8 the UTF-8 text
+ * @param [in] size the number of bytes in @p utf8
+ * @param [out] out the buffer for the result, must have space for @p size characters
+ * @return the number of UTF-16 code units written to @p out
+ */
+static int decodeUtf8(const char *utf8, size_t size, QChar *out)
+{
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(utf8);
+    const unsigned char *end = p + size;
+    int n = 0;
+
+    while (p < end) {
+        unsigned int c = *p++;
+        int extra;
+
+        if (c < 0x80) {
+            extra = 0;
+        } else if ((c & 0xE0) == 0xC0) {
+            c &= 0x1F;
+            extra = 1;
+        } else if ((c & 0xF0) == 0xE0) {
+            c &= 0x0F;
+            extra = 2;
+        } else if ((c & 0xF8) == 0xF0) {
+            c &= 0x07;
+            extra = 3;
+        } else {
+            out[n++] = QChar(ushort(0xFFFD));
+            continue;
+        }
+
+        while (extra > 0 && p < end && (*p & 0xC0) == 0x80) {
+            c = (c << 6) | (*p++ & 0x3F);
+            extra--;
+        }
+
+        if (extra > 0) {
+            out[n++] = QChar(ushort(0xFFFD));
+        } else if (c >= 0x10000) {
+            c -= 0x10000;
+            out[n++] = QChar(ushort(0xD800 + (c >> 10)));
+            out[n++] = QChar(ushort(0xDC00 + (c & 0x3FF)));
+        } else {
+            out[n++] = QChar(ushort(c));
+        }
+    }
+
+    return n;
+}
+
+
+/**
+ * @brief Decodes the text into locked memory and calls readString().
+ *
+ * @param [in] utf8 the UTF-8 representation
+ * @param [in] size the number of bytes in @p utf8
+ * @throw std::bad_alloc if the buffer cannot be allocated
+ */
+void SecureQStringReader::read(const char *utf8, size_t size)
+{
+    size_t capacity;
+    bool locked;
+    char *memory = SecureArena::instance()->allocate((size + 1) * sizeof(QChar), capacity, locked);
+    QChar *buffer = reinterpret_cast<QChar *>(memory);
+
+    try {
+        int length = decodeUtf8(utf8, size, buffer);
+        readString(QString::fromRawData(buffer, length));
+    } catch (...) {
+        SecureArena::instance()->release(memory, capacity);
+        throw;
+    }
+
+    SecureArena::instance()->release(memory, capacity);
+}
+
+// -------------------------------------------------------------------------------------------------
 
 /**
  * @brief Checks if the current platform (operating system) supports memory locking.
@@ -68,6 +198,9 @@ bool SecureString::platformSupportsLocking()
  */
 SecureString::SecureString()
     : m_text(NULL)
+    , m_capacity(0)
+    , m_size(0)
+    , m_length(0)
     , m_locked(false)
 {}
 
@@ -80,6 +213,9 @@ SecureString::SecureString()
  */
 SecureString::SecureString(const char *text)
     : m_text(NULL)
+    , m_capacity(0)
+    , m_size(0)
+    , m_length(0)
     , m_locked(false)
 {
     fromCString(text);
@@ -100,57 +236,135 @@ SecureString::SecureString(const char *text)
  * @throw std::bad_alloc if the memory of the string cannot be allocated
  */
 SecureString::SecureString(const std::string &text)
-    : m_text(0)
+    : m_text(NULL)
+    , m_capacity(0)
+    , m_size(0)
+    , m_length(0)
+    , m_locked(false)
+{
+    fromData(text.data(), text.size());
+}
+
+
+/**
+ * @brief Creates a new SecureString from UTF-8 encoded data that is not null-terminated.
+ *
+ * The caller is responsible to smash @p utf8 afterwards.
+ *
+ * @param[in] utf8 the UTF-8 encoded text
+ * @param[in] size the number of bytes in @p utf8
+ * @throw std::bad_alloc if the memory of the string cannot be allocated
+ */
+SecureString::SecureString(const char *utf8, size_t size)
+    : m_text(NULL)
+    , m_capacity(0)
+    , m_size(0)
+    , m_length(0)
     , m_locked(false)
 {
-    fromCString(text.c_str());
+    fromData(utf8, size);
 }
 
 
 /**
  * @brief Creates a SecureString from a QString.
  *
- * Internally, we call lock() after allocating the space for the string.
+ * The temporary UTF-8 representation is smashed afterwards.
  *
  * @param [in] text the QString representation of the string
  * @throw std::bad_alloc if the memory of the string cannot be allocated
  */
 SecureString::SecureString(const QString &text)
-    : m_text(0)
+    : m_text(NULL)
+    , m_capacity(0)
+    , m_size(0)
+    , m_length(0)
     , m_locked(false)
 {
-    fromCString(text.toUtf8().data());
+    QByteArray utf8 = text.toUtf8();
+    fromData(utf8.constData(), utf8.size());
+    SecureArena::smash(utf8.data(), utf8.size());
 }
 
 
 /**
  * @brief Creates a SecureString from another SecureString.
+ *
+ * @param [in] text the string to copy
+ * @throw std::bad_alloc if the memory of the string cannot be allocated
  */
 SecureString::SecureString(const SecureString &text)
-    : m_text(0)
+    : m_text(NULL)
+    , m_capacity(0)
+    , m_size(0)
+    , m_length(0)
     , m_locked(false)
 {
-    fromCString(text.utf8());
+    fromData(text.utf8(), text.m_size);
 }
 
 
+#ifdef Q_COMPILER_RVALUE_REFS
+
+/**
+ * @brief Moves a SecureString.
+ *
+ * The memory of @p text is taken over, @p text is empty afterwards. Only available if the
+ * compiler supports rvalue references.
+ *
+ * @param [in] text the string to move
+ */
+SecureString::SecureString(SecureString &&text)
+    : m_text(NULL)
+    , m_capacity(0)
+    , m_size(0)
+    , m_length(0)
+    , m_locked(false)
+{
+    swap(text);
+}
+
+
+/**
+ * @brief Move assignment.
+ *
+ * The old contents of this string end up in @p text which smashes them when it's destroyed.
+ *
+ * @param [in] text the string to move
+ * @return a reference to this string
+ */
+SecureString &SecureString::operator=(SecureString &&text)
+{
+    swap(text);
+    return *this;
+}
+
+#endif // Q_COMPILER_RVALUE_REFS
+
+
 /**
  * @brief Assignment of a SecureString to a SecureString.
  *
+ * If the new text fits in the current block, the block is reused.
+ *
  * @param [in] text SecureString the other SecureString that should be assigned
  *                  to the current SecureString
  * @throw std::bad_alloc if the memory of the string cannot be allocated
  */
 SecureString &SecureString::operator=(const SecureString& text)
 {
-    if (m_text) {
-        unlock();
-        smash();
-        delete[] m_text;
-        m_text = NULL;
+    if (this == &text)
+        return *this;
+
+    if (m_text && text.m_size < m_capacity) {
+        std::copy(text.utf8(), text.utf8() + text.m_size + 1, m_text);
+        SecureArena::smash(m_text + text.m_size + 1, m_capacity - text.m_size - 1);
+        m_size = text.m_size;
+        m_length = text.m_length;
+    } else {
+        SecureString(text).swap(*this);
     }
 
-    fromCString(text.utf8());
     return *this;
 }
 
@@ -170,7 +384,7 @@ SecureString &SecureString::operator=(const SecureString& text)
  */
 bool SecureString::operator<(const SecureString &text) const
 {
-    return strcmp(utf8(), text.utf8()) < 0;
+    return compare(text) < 0;
 }
 
 
@@ -189,7 +403,7 @@ bool SecureString::operator<(const SecureString &text) const
  */
 bool SecureString::operator<=(const SecureString &text) const
 {
-    return strcmp(utf8(), text.utf8()) <= 0;
+    return compare(text) <= 0;
 }
 
 
@@ -208,7 +422,7 @@ bool SecureString::operator<=(const SecureString &text) const
  */
 bool SecureString::operator>(const SecureString &text) const
 {
-    return strcmp(utf8(), text.utf8()) > 0;
+    return compare(text) > 0;
 }
 
 
@@ -227,7 +441,7 @@ bool SecureString::operator>(const SecureString &text) const
  */
 bool SecureString::operator>=(const SecureString &text) const
 {
-    return strcmp(utf8(), text.utf8()) >= 0;
+    return compare(text) >= 0;
 }
 
 
@@ -241,7 +455,7 @@ bool SecureString::operator>=(const SecureString &text) const
  */
 bool SecureString::operator==(const SecureString &text) const
 {
-    return strcmp(utf8(), text.utf8()) == 0;
+    return m_size == text.m_size && compare(text) == 0;
 }
 
 
@@ -255,19 +469,60 @@ bool SecureString::operator==(const SecureString &text) const
  */
 bool SecureString::operator!=(const SecureString &text) const
 {
-    return strcmp(utf8(), text.utf8()) != 0;
+    return !operator==(text);
 }
 
 
 /**
- * @brief Creates a new SecureString from a std::string representation.
+ * @brief Compares this string with @p text.
+ *
+ * The comparison is bytewise on the UTF-8 representation, like strcmp(), but it uses the cached
+ * sizes instead of scanning for the terminating zero.
+ *
+ * The method does not throw.
+ *
+ * @param [in] text the SecureString to compare with
+ * @return a negative value if this string is less than @p text, zero if both are equal and a
+ *         positive value if this string is greater than @p text
+ */
+int SecureString::compare(const SecureString &text) const
+{
+    int ret = memcmp(utf8(), text.utf8(), std::min(m_size, text.m_size));
+    if (ret != 0)
+        return ret;
+
+    return m_size < text.m_size ? -1 : (m_size > text.m_size ? 1 : 0);
+}
+
+
+/**
+ * @brief Exchanges the contents of this string and @p text.
+ *
+ * Nothing gets copied, so this is the cheap way to pass a secret along when the compiler
+ * doesn't support move semantics.
+ *
+ * The method does not throw.
+ *
+ * @param [in,out] text the other string
+ */
+void SecureString::swap(SecureString &text)
+{
+    std::swap(m_text, text.m_text);
+    std::swap(m_capacity, text.m_capacity);
+    std::swap(m_size, text.m_size);
+    std::swap(m_length, text.m_length);
+    std::swap(m_locked, text.m_locked);
+}
+
+
+/**
+ * @brief Deletes the SecureString.
+ *
+ * The memory is zeroed before it's given back to the SecureArena.
  */
 SecureString::~SecureString()
 {
-    unlock();
-    smash();
-    delete[] m_text;
-    m_text = NULL;
+    release();
 }
 
 
@@ -298,11 +553,11 @@ bool SecureString::isLocked() const
  * that the memory is valid as long as the SecureString is valid, but not longer. Don't
  * call free(), delete or delete[] on the returned string.
  *
- * @return the UTF-8 representation as zero-terminated string
+ * @return the UTF-8 representation as zero-terminated string, never @c NULL
  */
 const char *SecureString::utf8() const
 {
-    return m_text;
+    return m_text ? m_text : "";
 }
 
 
@@ -325,6 +580,20 @@ QString SecureString::qString() const
 }
 
 
+/**
+ * @brief Hands the contents of the string to @p reader.
+ *
+ * Contrary to utf8() and qString(), this makes it obvious where the secret is used, and
+ * together with SecureQStringReader it avoids an unprotected copy on the heap.
+ *
+ * @param [in] reader the reader that gets called once
+ */
+void SecureString::borrow(SecureStringReader &reader) const
+{
+    reader.read(utf8(), m_size);
+}
+
+
 /**
  * @brief Returns the number of characters that it takes to display that SecureString on
  *        the screen.
@@ -333,22 +602,13 @@ QString SecureString::qString() const
  * of user-visible characters. Of course, when you use UCS-4 (or practically: UCS-2), the
  * number is equal.
  *
+ * The value is computed once when the string is created.
+ *
  * @return the number of characters
  */
 size_t SecureString::length() const
 {
-    // according to the Unicode FAQ [http://www.cl.cam.ac.uk/~mgk25/unicode.html]
-    // we have to count characters not in the range [0x80; 0xBF].
-
-    int total = 0;
-    for (unsigned int i = 0; i < strlen(m_text); i++) {
-        if (static_cast<unsigned char>(m_text[i]) < 0x80 ||
-            static_cast<unsigned char>(m_text[i]) > 0xBF) {
-            total++;
-        }
-    }
-
-    return total;
+    return m_length;
 }
 
 
@@ -362,7 +622,7 @@ size_t SecureString::length() const
  */
 size_t SecureString::size() const
 {
-    return strlen(m_text);
+    return m_size;
 }
 
 
@@ -377,78 +637,50 @@ size_t SecureString::size() const
  */
 void SecureString::fromCString(const char *text)
 {
-    // don't use strdup() to be able to allocate with new[] instead of malloc()
-    size_t len = strlen(text);
-    m_text = new char[len+1];
-
-    std::copy(text, text+len+1, m_text);
-    lock();
+    fromData(text, strlen(text));
 }
 
 
 /**
- * @brief Locks the string in m_text into memory.
+ * @brief Copies @p size bytes of UTF-8 encoded text into newly allocated memory.
  *
- * If the string cannot be locked, the implementation does \b not throw any exception.
- * Instead, it issues a warning with qDebug(). If that is not sufficient for you, you can
- * check with SecureString::isLocked() if the memory is really locked.
+ * Both the size and the number of characters are computed here, in one pass.
  *
- * If m_isLocked is \c true which means that the string is already locked, the function
- * silently returns.
+ * @param [in] text the UTF-8 encoded text which doesn't need to be zero-terminated
+ * @param [in] size the number of bytes in @p text
+ * @throw std::bad_alloc if we couldn't allocate the necessary memory
  */
-void SecureString::lock()
+void SecureString::fromData(const char *text, size_t size)
 {
-    // do nothing if the string is already locked
-    if (m_locked)
-        return;
+    m_text = SecureArena::instance()->allocate(size+1, m_capacity, m_locked);
+    m_size = size;
+    m_length = 0;
 
-#ifdef _POSIX_MEMLOCK_RANGE
-    // lock the whole string including the trailing newline
-    int ret = mlock(m_text, strlen(m_text)+1);
-    if (ret != 0) {
-        if (!s_warned) {
-            s_warned = true;
-            qWarning() << "Cannot lock memory:" << strerror(errno);
-        }
-    } else {
-        m_locked = true;
+    // according to the Unicode FAQ [http://www.cl.cam.ac.uk/~mgk25/unicode.html]
+    // we have to count characters not in the range [0x80; 0xBF].
+    for (size_t i = 0; i < size; i++) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c < 0x80 || c > 0xBF)
+            m_length++;
+        m_text[i] = text[i];
     }
-#endif
-}
-
-
-/**
- * @brief Unlocks the string in m_text from memory.
- *
- * If m_isLocked is \c false which means that the string is not locked, the function
- * silently returns.
- */
-void SecureString::unlock()
-{
-    // do nothing if the string is not locked
-    if (!m_locked)
-        return;
-
-#ifdef _POSIX_MEMLOCK_RANGE
-    int ret = munlock(m_text, strlen(m_text)+1);
-    if (ret != 0)
-        qDebug() << "Cannot unlock memory " << strerror(errno);
-#endif
+    m_text[size] = '\0';
 }
 
 
 /**
- * @brief Overwrites the data with garbage.
+ * @brief Gives the memory back to the SecureArena.
  *
- * This function should be called before the data is delete[]'d. Currently we overwrite
- * the contents of the data with zeroes, but we could change that to random data. Should
- * not matter because it's not a hard disk but only memory contents.
+ * The arena zeroes the whole block. Afterwards, the string is empty.
  */
-void SecureString::smash()
+void SecureString::release()
 {
-    if (m_text) {
-        std::fill(m_text, m_text+strlen(m_text), '\0');
-    }
+    SecureArena::instance()->release(m_text, m_capacity);
+    m_text = NULL;
+    m_capacity = 0;
+    m_size = 0;
+    m_length = 0;
+    m_locked = false;
 }
 
 // vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
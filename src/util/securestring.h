@@ -20,6 +20,22 @@
 
 #include <QString>
 
+class SecureStringReader
+{
+    public:
+        virtual ~SecureStringReader() {}
+
+        virtual void read(const char *utf8, size_t size) = 0;
+};
+
+class SecureQStringReader : public SecureStringReader
+{
+    public:
+        void read(const char *utf8, size_t size);
+
+        virtual void readString(const QString &text) = 0;
+};
+
 class SecureString
 {
     public:
@@ -29,14 +45,24 @@ class SecureString
 
         SecureString(const std::string &text);
 
+        SecureString(const char *utf8, size_t size);
+
         SecureString(const QString &text);
 
         SecureString(const SecureString &text);
 
+#ifdef Q_COMPILER_RVALUE_REFS
+        SecureString(SecureString &&text);
+#endif
+
         virtual ~SecureString();
 
         SecureString &operator=(const SecureString &text);
 
+#ifdef Q_COMPILER_RVALUE_REFS
+        SecureString &operator=(SecureString &&text);
+#endif
+
         bool operator<(const SecureString &text) const;
 
         bool operator<=(const SecureString &text) const;
@@ -49,6 +75,10 @@ class SecureString
 
         bool operator!=(const SecureString &text) const;
 
+        int compare(const SecureString &text) const;
+
+        void swap(SecureString &text);
+
     public:
         static bool platformSupportsLocking();
 
@@ -59,6 +89,8 @@ class SecureString
 
         QString qString() const;
 
+        void borrow(SecureStringReader &reader) const;
+
         size_t length() const;
 
         size_t size() const;
@@ -66,16 +98,16 @@ class SecureString
     protected:
         void fromCString(const char *text);
 
-        void lock();
-
-        void unlock();
+        void fromData(const char *text, size_t size);
 
-        void smash();
+        void release();
 
     private:
         char *m_text;
+        size_t m_capacity;
+        size_t m_size;
+        size_t m_length;
         bool m_locked;
-        static bool s_warned;
 };
 
 #endif // SECURESTRING_H
@@ -0,0 +1,143 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#include "stringpool.h"
+
+#define MIN_PURGE_SIZE 64
+
+/**
+ * @class StringPool
+ *
+ * @brief Holds one shared instance of each distinct string that is handed in.
+ *
+ * Most properties of a password file use one of a few keys ("Username", "Password", "URL", ...)
+ * which normally come from the AutoText settings. Without interning, each Property would hold its
+ * own copy of that key. Because QString is implicitly shared, it's enough to return the copy
+ * that is stored in the pool: all users then reference the same data.
+ *
+ * Strings that are only referenced by the pool any more, e.g. the keys that have been typed
+ * while editing a property, are dropped with purge(). That happens automatically each time
+ * the pool has doubled its size since the last purge, so it doesn't grow with the number of
+ * edits.
+ *
+ * The pool is a singleton. It's not thread-safe, use it only from the GUI thread.
+ *
+ * @ingroup misc
+ * @author Bernhard Walle
+ */
+
+StringPool *StringPool::m_instance = NULL;
+
+
+/**
+ * @brief Returns the only instance of the StringPool.
+ *
+ * @return the instance, never @c NULL
+ */
+StringPool *StringPool::instance()
+{
+    if (!m_instance) {
+        m_instance = new StringPool();
+    }
+    return m_instance;
+}
+
+
+/**
+ * @brief Creates a new StringPool.
+ *
+ * Use instance() to get the singleton.
+ */
+StringPool::StringPool()
+    : m_sizeAfterPurge(0)
+{}
+
+
+/**
+ * @brief Returns the pooled instance of @p string.
+ *
+ * If the string is not yet in the pool, it gets added. Null and empty strings are returned
+ * unchanged.
+ *
+ * @param[in] string the string to intern
+ * @return a string that equals @p string and shares its data with all other strings that
+ *         have been interned with the same contents
+ */
+QString StringPool::intern(const QString &string)
+{
+    if (string.isEmpty())
+        return string;
+
+    QSet<QString>::const_iterator it = m_strings.constFind(string);
+    if (it != m_strings.constEnd())
+        return *it;
+
+    if (m_strings.size() >= 2 * m_sizeAfterPurge + MIN_PURGE_SIZE)
+        purge();
+
+    m_strings.insert(string);
+    return string;
+}
+
+
+/**
+ * @brief Returns the number of distinct strings in the pool.
+ *
+ * @return the number of strings
+ */
+int StringPool::size() const
+{
+    return m_strings.size();
+}
+
+
+/**
+ * @brief Removes the strings that are not used outside of the pool.
+ *
+ * QString is reference counted, so a string whose data is not shared is only held by the
+ * pool.
+ *
+ * @return the number of strings that have been removed
+ */
+int StringPool::purge()
+{
+    int removed = 0;
+
+    QSet<QString>::iterator it = m_strings.begin();
+    while (it != m_strings.end()) {
+        if (it->isDetached()) {
+            it = m_strings.erase(it);
+            removed++;
+        } else {
+            ++it;
+        }
+    }
+    m_sizeAfterPurge = m_strings.size();
+
+    return removed;
+}
+
+
+/**
+ * @brief Removes all strings from the pool.
+ *
+ * Strings that have been handed out stay valid since they are reference counted.
+ */
+void StringPool::clear()
+{
+    m_strings.clear();
+    m_sizeAfterPurge = 0;
+}
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
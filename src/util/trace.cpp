@@ -0,0 +1,235 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#include <QFile>
+#include <QTextStream>
+#include <QThread>
+#include <QMap>
+#include <QMutexLocker>
+
+#include "platformhelpers.h"
+#include "trace.h"
+
+/**
+ * @class QpamatTrace
+ *
+ * @brief Records the time of TraceSpan objects and saves them for the Chrome trace viewer
+ *
+ * Tracing is disabled by default. When an output file is set, each TraceSpan that ends is
+ * recorded, together with the thread it has been running in. save() writes the spans as
+ * trace events in JSON that can be loaded in <tt>chrome://tracing</tt>:
+ *
+ * @code
+ * QpamatTrace::instance()->setOutputFile("qpamat-trace.json");
+ * // ...
+ * QpamatTrace::instance()->save();
+ * @endcode
+ *
+ * @ingroup misc
+ * @author Bernhard Walle <bernhard@bwalle.de>
+ */
+
+QpamatTrace *QpamatTrace::m_instance = NULL;
+bool QpamatTrace::m_enabled = false;
+
+
+/**
+ * @brief Returns the only instance of a QpamatTrace class.
+ *
+ * @return A pointer of the only instance. It cannot return @c NULL.
+ */
+QpamatTrace *QpamatTrace::instance()
+{
+    if (!m_instance) {
+        m_instance = new QpamatTrace();
+    }
+    return m_instance;
+}
+
+
+/**
+ * @brief Constructor
+ *
+ * Since this is a singleton, this constructor is private. Always use
+ * QpamatTrace::instance() to access the object.
+ */
+QpamatTrace::QpamatTrace()
+    : m_start(PlatformHelpers::monotonicMicroseconds())
+{}
+
+
+/**
+ * @brief Sets the file where save() writes the trace and enables tracing
+ *
+ * @param[in] filename the file name. If @p filename is QString::null, tracing is
+ *                     disabled.
+ */
+void QpamatTrace::setOutputFile(const QString &filename)
+{
+    QMutexLocker locker(&m_mutex);
+    m_outputFile = filename;
+    m_enabled = !filename.isNull();
+}
+
+
+/**
+ * @brief Returns the file where save() writes the trace
+ *
+ * @return the file name or QString::null if tracing is disabled
+ */
+QString QpamatTrace::outputFile() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_outputFile;
+}
+
+
+/**
+ * @brief Records a span
+ *
+ * This is called by TraceSpan, it may be called from any thread.
+ *
+ * @param[in] name the name of the span, must be a string literal
+ * @param[in] component the component of the span, must be a string literal
+ * @param[in] begin the begin, see PlatformHelpers::monotonicMicroseconds()
+ * @param[in] duration the duration in microseconds
+ */
+void QpamatTrace::addSpan(const char *name, const char *component, qint64 begin,
+                          qint64 duration)
+{
+    Event event;
+    event.name = name;
+    event.component = component;
+    event.begin = begin - m_start;
+    event.duration = duration;
+    event.thread = QThread::currentThreadId();
+
+    QMutexLocker locker(&m_mutex);
+    m_events.append(event);
+}
+
+
+/**
+ * @brief Removes all recorded spans
+ */
+void QpamatTrace::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_events.clear();
+}
+
+
+/**
+ * @brief Writes the recorded spans to the output file
+ *
+ * The file contains one complete event (phase @c "X") per span. The threads are numbered
+ * in the order of their first span.
+ *
+ * @return @c true on success, @c false if tracing is disabled or the file could not be
+ *         written
+ */
+bool QpamatTrace::save() const
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_outputFile.isNull()) {
+        return false;
+    }
+
+    QFile file(m_outputFile);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    QTextStream stream(&file);
+    QMap<Qt::HANDLE, int> threads;
+
+    stream << "{\"traceEvents\":[";
+    for (int i = 0; i < m_events.size(); ++i) {
+        const Event &event = m_events[i];
+        if (!threads.contains(event.thread)) {
+            threads.insert(event.thread, threads.size() + 1);
+        }
+
+        // the names are string literals in the source, so they need no quoting
+        stream << (i == 0 ? "\n" : ",\n")
+               << "{\"name\":\"" << event.name << "\",\"cat\":\"" << event.component
+               << "\",\"ph\":\"X\",\"ts\":" << event.begin << ",\"dur\":" << event.duration
+               << ",\"pid\":1,\"tid\":" << threads.value(event.thread) << "}";
+    }
+    stream << "\n]}\n";
+
+    return stream.status() == QTextStream::Ok;
+}
+
+
+/**
+ * @class TraceSpan
+ *
+ * @brief Measures the time of a scope
+ *
+ * The span starts in the constructor and ends in the destructor:
+ *
+ * @code
+ * {
+ *     TraceSpan span("parse", "Storage");
+ *     doc.setContent(&file);
+ * }
+ * @endcode
+ *
+ * At the end, the span is recorded in QpamatTrace if tracing is enabled and the duration
+ * is printed as debugging message of @p component. If neither is enabled, the span doesn't
+ * read the clock at all.
+ *
+ * @ingroup misc
+ * @author Bernhard Walle <bernhard@bwalle.de>
+ */
+
+/**
+ * @brief Starts the span
+ *
+ * @param[in] name the name of the span, must be a string literal
+ * @param[in] component the component for the debugging message and for the trace, must
+ *                      be a string literal
+ */
+TraceSpan::TraceSpan(const char *name, const char *component)
+    : m_name(name)
+    , m_component(component)
+    , m_begin(-1)
+{
+    if (QpamatTrace::isEnabled() ||
+            QpamatDebug::instance()->isEnabled(QtDebugMsg, component)) {
+        m_begin = PlatformHelpers::monotonicMicroseconds();
+    }
+}
+
+
+/**
+ * @brief Ends the span
+ */
+TraceSpan::~TraceSpan()
+{
+    if (m_begin < 0) {
+        return;
+    }
+
+    qint64 duration = PlatformHelpers::monotonicMicroseconds() - m_begin;
+    if (QpamatTrace::isEnabled()) {
+        QpamatTrace::instance()->addSpan(m_name, m_component, m_begin, duration);
+    }
+
+    QpamatDebug::instance()->log(QtDebugMsg, m_component, "%1 took %2 ms",
+                                 m_name, duration / 1000.0);
+}
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
@@ -0,0 +1,84 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QString>
+#include <QVector>
+#include <QMutex>
+
+#include "debug.h"
+
+class QpamatTrace
+{
+    public:
+        static QpamatTrace *instance();
+
+        /**
+         * @brief Checks if the spans are recorded.
+         *
+         * That's only a variable, so it's cheap enough for every TraceSpan.
+         *
+         * @return @c true if the spans are recorded, @c false otherwise
+         */
+        static bool isEnabled() { return m_enabled; }
+
+    private:
+        QpamatTrace();
+
+    public:
+        void setOutputFile(const QString &filename);
+        QString outputFile() const;
+        void addSpan(const char *name, const char *component, qint64 begin, qint64 duration);
+        void clear();
+        bool save() const;
+
+    private:
+        struct Event {
+            const char  *name;
+            const char  *component;
+            qint64      begin;
+            qint64      duration;
+            Qt::HANDLE  thread;
+        };
+
+    private:
+        static QpamatTrace *m_instance;
+        static bool m_enabled;
+        QString m_outputFile;
+        qint64 m_start;
+        QVector<Event> m_events;
+        mutable QMutex m_mutex;
+};
+
+class TraceSpan
+{
+    public:
+        TraceSpan(const char *name, const char *component = DEFAULT_COMPONENT);
+        ~TraceSpan();
+
+    private:
+        const char *m_name;
+        const char *m_component;
+        qint64 m_begin;
+
+    private:
+        TraceSpan(const TraceSpan&);
+        TraceSpan& operator=(const TraceSpan&);
+};
+
+#endif // TRACE_H
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
@@ -0,0 +1,220 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#include "vaultconfig.h"
+
+/**
+ * @class VaultConfig
+ *
+ * @brief The configuration of the data file and of the password checks.
+ *
+ * DataReadWriter, Journal and Property get their configuration from this class instead of
+ * looking it up in the Settings of the main window. The main window reads it once with
+ * Settings::vaultConfig() and reads it again only when the settings have been changed. The
+ * command line client fills it from the command line.
+ *
+ * This is a value class, it can be copied, e.g. for a worker thread.
+ *
+ * @ingroup security
+ * @author Bernhard Walle
+ */
+
+/**
+ * @brief Creates a new configuration.
+ *
+ * The file names and the algorithm are empty, the limits are the defaults of the settings.
+ */
+VaultConfig::VaultConfig()
+    : m_lazyDecryption(false)
+    , m_weakPasswordLimit(3.0)
+    , m_strongPasswordLimit(15.0)
+{}
+
+
+/**
+ * @brief Returns the name of the data file.
+ *
+ * @return the file name
+ */
+QString VaultConfig::getDataFile() const
+{
+    return m_dataFile;
+}
+
+
+/**
+ * @brief Sets the name of the data file.
+ *
+ * @param dataFile the file name
+ */
+void VaultConfig::setDataFile(const QString& dataFile)
+{
+    m_dataFile = dataFile;
+}
+
+
+/**
+ * @brief Returns the cipher algorithm that is used for writing the data file.
+ *
+ * @return the algorithm, see SymmetricEncryptor::getAlgorithms()
+ */
+QString VaultConfig::getCipherAlgorithm() const
+{
+    return m_cipherAlgorithm;
+}
+
+
+/**
+ * @brief Sets the cipher algorithm that is used for writing the data file.
+ *
+ * @param algorithm the algorithm, see SymmetricEncryptor::getAlgorithms()
+ */
+void VaultConfig::setCipherAlgorithm(const QString& algorithm)
+{
+    m_cipherAlgorithm = algorithm;
+}
+
+
+/**
+ * @brief Checks if the passwords are decrypted on demand after reading.
+ *
+ * @return @c true if they are decrypted on demand, see DataReadWriter::readXML()
+ */
+bool VaultConfig::isLazyDecryption() const
+{
+    return m_lazyDecryption;
+}
+
+
+/**
+ * @brief Sets if the passwords are decrypted on demand after reading.
+ *
+ * @param lazy @c true if they should be decrypted on demand
+ */
+void VaultConfig::setLazyDecryption(bool lazy)
+{
+    m_lazyDecryption = lazy;
+}
+
+
+/**
+ * @brief Returns the dictionary for the HybridPasswordChecker.
+ *
+ * @return the file name
+ */
+QString VaultConfig::getDictionaryFile() const
+{
+    return m_dictionaryFile;
+}
+
+
+/**
+ * @brief Sets the dictionary for the HybridPasswordChecker.
+ *
+ * @param dictionaryFile the file name
+ */
+void VaultConfig::setDictionaryFile(const QString& dictionaryFile)
+{
+    m_dictionaryFile = dictionaryFile;
+}
+
+
+/**
+ * @brief Returns the password checker that rates the passwords.
+ *
+ * @return the checker, see PasswordCheckerFactory::getChecker()
+ */
+QString VaultConfig::getPasswordChecker() const
+{
+    return m_passwordChecker;
+}
+
+
+/**
+ * @brief Sets the password checker that rates the passwords.
+ *
+ * @param checker the checker, see PasswordCheckerFactory::getChecker()
+ */
+void VaultConfig::setPasswordChecker(const QString& checker)
+{
+    m_passwordChecker = checker;
+}
+
+
+/**
+ * @brief Returns the BreachCorpus for the BreachedPasswordChecker.
+ *
+ * @return the file name of the Bloom filter or an empty string if no corpus is used
+ */
+QString VaultConfig::getBreachCorpusFile() const
+{
+    return m_breachCorpusFile;
+}
+
+
+/**
+ * @brief Sets the BreachCorpus for the BreachedPasswordChecker.
+ *
+ * @param corpusFile the file name of the Bloom filter or an empty string
+ */
+void VaultConfig::setBreachCorpusFile(const QString& corpusFile)
+{
+    m_breachCorpusFile = corpusFile;
+}
+
+
+/**
+ * @brief Returns the limit for weak passwords.
+ *
+ * @return the days to crack below which a password is weak
+ */
+double VaultConfig::getWeakPasswordLimit() const
+{
+    return m_weakPasswordLimit;
+}
+
+
+/**
+ * @brief Sets the limit for weak passwords.
+ *
+ * @param days the days to crack below which a password is weak
+ */
+void VaultConfig::setWeakPasswordLimit(double days)
+{
+    m_weakPasswordLimit = days;
+}
+
+
+/**
+ * @brief Returns the limit for strong passwords.
+ *
+ * @return the days to crack from which on a password is strong
+ */
+double VaultConfig::getStrongPasswordLimit() const
+{
+    return m_strongPasswordLimit;
+}
+
+
+/**
+ * @brief Sets the limit for strong passwords.
+ *
+ * @param days the days to crack from which on a password is strong
+ */
+void VaultConfig::setStrongPasswordLimit(double days)
+{
+    m_strongPasswordLimit = days;
+}
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100:
@@ -0,0 +1,62 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; You may only use
+ * version 2 of the License, you have no option to use any other version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------------------------------
+ */
+#ifndef VAULTCONFIG_H
+#define VAULTCONFIG_H
+
+#include <QString>
+
+class VaultConfig
+{
+    public:
+        VaultConfig();
+
+        QString getDataFile() const;
+        void setDataFile(const QString& dataFile);
+
+        QString getCipherAlgorithm() const;
+        void setCipherAlgorithm(const QString& algorithm);
+
+        bool isLazyDecryption() const;
+        void setLazyDecryption(bool lazy);
+
+        QString getDictionaryFile() const;
+        void setDictionaryFile(const QString& dictionaryFile);
+
+        QString getPasswordChecker() const;
+        void setPasswordChecker(const QString& checker);
+
+        QString getBreachCorpusFile() const;
+        void setBreachCorpusFile(const QString& corpusFile);
+
+        double getWeakPasswordLimit() const;
+        void setWeakPasswordLimit(double days);
+
+        double getStrongPasswordLimit() const;
+        void setStrongPasswordLimit(double days);
+
+    private:
+        QString     m_dataFile;
+        QString     m_cipherAlgorithm;
+        bool        m_lazyDecryption;
+        QString     m_dictionaryFile;
+        QString     m_passwordChecker;
+        QString     m_breachCorpusFile;
+        double      m_weakPasswordLimit;
+        double      m_strongPasswordLimit;
+};
+
+#endif // VAULTCONFIG_H
+
+// vim: set sw=4 ts=4 et: :tabSize=4:indentSize=4:maxLineLen=100: